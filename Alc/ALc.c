@@ -370,6 +370,14 @@ static const struct {
     DECL(ALC_N3D_SOFT),
     DECL(ALC_SN3D_SOFT),
 
+    DECL(ALC_MAX_REAL_VOICES_SOFT),
+
+    DECL(ALC_HRTF_MODE_SOFT),
+    DECL(ALC_HRTF_FULL_SOFT),
+    DECL(ALC_HRTF_BASIC_SOFT),
+    DECL(ALC_HRTF_HYBRID_SOFT),
+    DECL(ALC_HRTF_DIRECT_VOICES_SOFT),
+
     DECL(ALC_OUTPUT_LIMITER_SOFT),
 
     DECL(ALC_NO_ERROR),
@@ -560,6 +568,7 @@ static const struct {
     DECL(AL_EFFECT_EQUALIZER),
     DECL(AL_EFFECT_DEDICATED_LOW_FREQUENCY_EFFECT),
     DECL(AL_EFFECT_DEDICATED_DIALOGUE),
+    DECL(AL_EFFECT_CONVOLUTION_REVERB_SOFT),
 
     DECL(AL_EFFECTSLOT_EFFECT),
     DECL(AL_EFFECTSLOT_GAIN),
@@ -660,11 +669,17 @@ static const struct {
     DECL(AL_SOURCE_SPATIALIZE_SOFT),
     DECL(AL_AUTO_SOFT),
 
+    DECL(AL_SOURCE_PRIORITY_SOFT),
+
     DECL(AL_MAP_READ_BIT_SOFT),
     DECL(AL_MAP_WRITE_BIT_SOFT),
     DECL(AL_MAP_PERSISTENT_BIT_SOFT),
     DECL(AL_PRESERVE_DATA_BIT_SOFT),
 
+    DECL(AL_FLOAT_CACHE_SOFT),
+
+    DECL(AL_EFFECTSLOT_MEMORY_SIZE_SOFT),
+
     DECL(AL_EVENT_CALLBACK_FUNCTION_SOFT),
     DECL(AL_EVENT_CALLBACK_USER_PARAM_SOFT),
     DECL(AL_EVENT_TYPE_BUFFER_COMPLETED_SOFT),
@@ -949,6 +964,9 @@ static void alc_initconfig(void)
 #elif defined(HAVE_SSE)
     capfilter |= CPU_CAP_SSE;
 #endif
+#ifdef HAVE_AVX2
+    capfilter |= CPU_CAP_AVX2 | CPU_CAP_FMA;
+#endif
 #ifdef HAVE_NEON
     capfilter |= CPU_CAP_NEON;
 #endif
@@ -981,6 +999,10 @@ static void alc_initconfig(void)
                     capfilter &= ~CPU_CAP_SSE3;
                 else if(len == 6 && strncasecmp(str, "sse4.1", len) == 0)
                     capfilter &= ~CPU_CAP_SSE4_1;
+                else if(len == 4 && strncasecmp(str, "avx2", len) == 0)
+                    capfilter &= ~CPU_CAP_AVX2;
+                else if(len == 3 && strncasecmp(str, "fma", len) == 0)
+                    capfilter &= ~CPU_CAP_FMA;
                 else if(len == 4 && strncasecmp(str, "neon", len) == 0)
                     capfilter &= ~CPU_CAP_NEON;
                 else
@@ -1667,7 +1689,15 @@ void ALCcontext_ProcessUpdates(ALCcontext *context)
         if(!ATOMIC_FLAG_TEST_AND_SET(&context->PropsClean, almemory_order_acq_rel))
             UpdateContextProps(context);
         if(!ATOMIC_FLAG_TEST_AND_SET(&context->Listener->PropsClean, almemory_order_acq_rel))
+        {
             UpdateListenerProps(context);
+            /* Voice HRTF filters are looked up along with the source
+             * properties, so the sources need updating for the new listener
+             * position.
+             */
+            if(context->Device->HrtfHandle)
+                RefreshAllSourceProps(context);
+        }
         UpdateAllEffectSlotProps(context);
         UpdateAllSourceProps(context);
 
@@ -1708,7 +1738,7 @@ static void alcSetError(ALCdevice *device, ALCenum errorCode)
 struct Compressor *CreateDeviceLimiter(const ALCdevice *device)
 {
     return CompressorInit(0.0f, 0.0f, AL_FALSE, AL_TRUE, 0.0f, 0.0f, 0.5f, 2.0f,
-                          0.0f, -3.0f, 3.0f, device->Frequency);
+                          0.0f, -3.0f, 3.0f, device->Frequency, device->MixQuantum);
 }
 
 /* UpdateClockBase
@@ -1736,6 +1766,8 @@ static ALCenum UpdateDeviceParams(ALCdevice *device, const ALCint *attrList)
     enum HrtfRequestMode hrtf_userreq = Hrtf_Default;
     enum HrtfRequestMode hrtf_appreq = Hrtf_Default;
     ALCenum gainLimiter = device->Limiter ? ALC_TRUE : ALC_FALSE;
+    ALCenum hrtf_mode = ALC_DONT_CARE_SOFT;
+    ALCint hrtf_voices = -1;
     const ALsizei old_sends = device->NumAuxSends;
     ALsizei new_sends = device->NumAuxSends;
     enum DevFmtChannels oldChans;
@@ -1744,7 +1776,10 @@ static ALCenum UpdateDeviceParams(ALCdevice *device, const ALCint *attrList)
     ALCsizei hrtf_id = -1;
     ALCcontext *context;
     ALCuint oldFreq;
-    size_t size;
+    ALuint num_threads = 1;
+    ALuint min_voices = 64;
+    ALuint quantum = 0;
+    ALsizei num_chans;
     ALCsizei i;
     int val;
 
@@ -1855,6 +1890,16 @@ static ALCenum UpdateDeviceParams(ALCdevice *device, const ALCint *attrList)
                     TRACE_ATTR(ALC_OUTPUT_LIMITER_SOFT, gainLimiter);
                     break;
 
+                case ALC_HRTF_MODE_SOFT:
+                    hrtf_mode = attrList[attrIdx + 1];
+                    TRACE_ATTR(ALC_HRTF_MODE_SOFT, hrtf_mode);
+                    break;
+
+                case ALC_HRTF_DIRECT_VOICES_SOFT:
+                    hrtf_voices = attrList[attrIdx + 1];
+                    TRACE_ATTR(ALC_HRTF_DIRECT_VOICES_SOFT, hrtf_voices);
+                    break;
+
                 default:
                     TRACE("Loopback 0x%04X = %d (0x%x)\n", attrList[attrIdx],
                           attrList[attrIdx + 1], attrList[attrIdx + 1]);
@@ -1982,6 +2027,16 @@ static ALCenum UpdateDeviceParams(ALCdevice *device, const ALCint *attrList)
                     TRACE_ATTR(ALC_OUTPUT_LIMITER_SOFT, gainLimiter);
                     break;
 
+                case ALC_HRTF_MODE_SOFT:
+                    hrtf_mode = attrList[attrIdx + 1];
+                    TRACE_ATTR(ALC_HRTF_MODE_SOFT, hrtf_mode);
+                    break;
+
+                case ALC_HRTF_DIRECT_VOICES_SOFT:
+                    hrtf_voices = attrList[attrIdx + 1];
+                    TRACE_ATTR(ALC_HRTF_DIRECT_VOICES_SOFT, hrtf_voices);
+                    break;
+
                 default:
                     TRACE("0x%04X = %d (0x%x)\n", attrList[attrIdx],
                           attrList[attrIdx + 1], attrList[attrIdx + 1]);
@@ -2042,9 +2097,13 @@ static ALCenum UpdateDeviceParams(ALCdevice *device, const ALCint *attrList)
         device->ChannelDelay[i].Buffer = NULL;
     }
 
+    aluDeinitMixThreads(device);
+
     al_free(device->Dry.Buffer);
     device->Dry.Buffer = NULL;
     device->Dry.NumChannels = 0;
+    al_free(device->TempBuffer);
+    device->TempBuffer = NULL;
     device->FOAOut.Buffer = NULL;
     device->FOAOut.NumChannels = 0;
     device->RealOut.Buffer = NULL;
@@ -2077,7 +2136,7 @@ static ALCenum UpdateDeviceParams(ALCdevice *device, const ALCint *attrList)
             if(VECTOR_SIZE(device->HrtfList) == 0)
             {
                 VECTOR_DEINIT(device->HrtfList);
-                device->HrtfList = EnumerateHrtf(device->DeviceName);
+                device->HrtfList = GetCachedHrtfList(device->DeviceName);
             }
             if(VECTOR_SIZE(device->HrtfList) > 0)
             {
@@ -2150,19 +2209,34 @@ static ALCenum UpdateDeviceParams(ALCdevice *device, const ALCint *attrList)
         device->Frequency, device->UpdateSize, device->NumUpdates
     );
 
-    aluInitRenderer(device, hrtf_id, hrtf_appreq, hrtf_userreq);
+    /* Mixing in smaller blocks can keep the working set in the CPU cache,
+     * while larger blocks reduce the per-iteration overhead.
+     */
+    device->MixQuantum = BUFFERSIZE;
+    if(ConfigValueUInt(alstr_get_cstr(device->DeviceName), NULL, "mix-quantum", &quantum) &&
+       quantum > 0)
+        device->MixQuantum = (ALsizei)((clampu(quantum, MIN_MIX_QUANTUM, MAX_MIX_QUANTUM)+3)&~3u);
+    TRACE("Mixing quantum: %d samples\n", device->MixQuantum);
+
+    aluInitRenderer(device, hrtf_id, hrtf_appreq, hrtf_userreq, hrtf_mode, hrtf_voices);
+    aluInitPanningCache(device);
     TRACE("Channel config, Dry: %d, FOA: %d, Real: %d\n", device->Dry.NumChannels,
           device->FOAOut.NumChannels, device->RealOut.NumChannels);
 
-    /* Allocate extra channels for any post-filter output. */
-    size = (device->Dry.NumChannels + device->FOAOut.NumChannels +
-            device->RealOut.NumChannels)*sizeof(device->Dry.Buffer[0]);
-
-    TRACE("Allocating "SZFMT" channels, "SZFMT" bytes\n", size/sizeof(device->Dry.Buffer[0]), size);
-    device->Dry.Buffer = al_calloc(16, size);
-    if(!device->Dry.Buffer)
-    {
-        ERR("Failed to allocate "SZFMT" bytes for mix buffer\n", size);
+    /* Allocate extra channels for any post-filter output, followed by the
+     * temp buffers. Voices load up to BUFFERSIZE source samples at a time, so
+     * the temp buffers are never shorter than that.
+     */
+    num_chans = device->Dry.NumChannels + device->FOAOut.NumChannels +
+                device->RealOut.NumChannels;
+    TRACE("Allocating %d channels, %d samples each\n", num_chans, device->MixQuantum);
+    device->Dry.Buffer = aluAllocBufferLines(num_chans, device->MixQuantum);
+    if(device->Dry.Buffer)
+        device->TempBuffer = aluAllocBufferLines(NUM_TEMP_BUFFERS,
+                                                 maxi(device->MixQuantum, BUFFERSIZE));
+    if(!device->Dry.Buffer || !device->TempBuffer)
+    {
+        ERR("Failed to allocate mix buffers\n");
         return ALC_INVALID_DEVICE;
     }
 
@@ -2183,6 +2257,12 @@ static ALCenum UpdateDeviceParams(ALCdevice *device, const ALCint *attrList)
         device->FOAOut.NumChannels = device->Dry.NumChannels;
     }
 
+    if(ConfigValueUInt(alstr_get_cstr(device->DeviceName), NULL, "mix-threads", &num_threads))
+        num_threads = clampu(num_threads, 1, MAX_MIX_THREADS);
+    ConfigValueUInt(alstr_get_cstr(device->DeviceName), NULL, "mix-thread-min-voices",
+                    &min_voices);
+    aluInitMixThreads(device, num_threads, minu(min_voices, INT_MAX));
+
     device->NumAuxSends = new_sends;
     TRACE("Max sources: %d (%d + %d), effect slots: %d, sends: %d\n",
           device->SourcesMax, device->NumMonoSources, device->NumStereoSources,
@@ -2229,7 +2309,8 @@ static ALCenum UpdateDeviceParams(ALCdevice *device, const ALCint *attrList)
      */
     if(gainLimiter != ALC_FALSE)
     {
-        if(!device->Limiter || device->Frequency != GetCompressorSampleRate(device->Limiter))
+        if(!device->Limiter || device->Frequency != GetCompressorSampleRate(device->Limiter) ||
+           device->MixQuantum != GetCompressorBufferSize(device->Limiter))
         {
             al_free(device->Limiter);
             device->Limiter = CreateDeviceLimiter(device);
@@ -2263,7 +2344,8 @@ static ALCenum UpdateDeviceParams(ALCdevice *device, const ALCint *attrList)
 
             state->OutBuffer = device->Dry.Buffer;
             state->OutChannels = device->Dry.NumChannels;
-            if(V(state,deviceUpdate)(device) == AL_FALSE)
+            if(ResizeEffectSlotBuffer(slot, device) != AL_NO_ERROR ||
+               V(state,deviceUpdate)(device) == AL_FALSE)
                 update_failed = AL_TRUE;
             else
                 UpdateEffectSlotProps(slot, context);
@@ -2278,7 +2360,8 @@ static ALCenum UpdateDeviceParams(ALCdevice *device, const ALCint *attrList)
 
             state->OutBuffer = device->Dry.Buffer;
             state->OutChannels = device->Dry.NumChannels;
-            if(V(state,deviceUpdate)(device) == AL_FALSE)
+            if(ResizeEffectSlotBuffer(slot, device) != AL_NO_ERROR ||
+               V(state,deviceUpdate)(device) == AL_FALSE)
                 update_failed = AL_TRUE;
             else
                 UpdateEffectSlotProps(slot, context);
@@ -2337,6 +2420,7 @@ static ALCenum UpdateDeviceParams(ALCdevice *device, const ALCint *attrList)
         while(vprops)
         {
             struct ALvoiceProps *next = ATOMIC_LOAD(&vprops->next, almemory_order_relaxed);
+            ReleaseVoicePropsHrtf(vprops);
             al_free(vprops);
             vprops = next;
         }
@@ -2346,11 +2430,31 @@ static ALCenum UpdateDeviceParams(ALCdevice *device, const ALCint *attrList)
         {
             ALvoice *voice = context->Voices[pos];
 
-            al_free(ATOMIC_EXCHANGE_PTR(&voice->Update, NULL, almemory_order_acq_rel));
+            vprops = ATOMIC_EXCHANGE_PTR(&voice->Update, NULL, almemory_order_acq_rel);
+            if(vprops) ReleaseVoicePropsHrtf(vprops);
+            al_free(vprops);
 
             if(ATOMIC_LOAD(&voice->Source, almemory_order_acquire) == NULL)
                 continue;
 
+            /* The output and sends may have changed, so everything needs to
+             * be recalculated.
+             */
+            voice->Flags |= VOICE_NEEDS_UPDATE;
+
+            /* Restart FFT convolution with the new HRTF, switching to or from
+             * direct convolution along with the device.
+             */
+            for(i = 0;i < voice->NumHrtfFFT;i++)
+                ResetHrtfFFTState(&voice->HrtfFFT[i]);
+            voice->Flags &= ~VOICE_HRTF_FFT;
+            InitVoiceHrtfFFT(voice, device);
+
+            /* Voices are ranked again for hybrid HRTF rendering, starting
+             * from the ambisonic mix.
+             */
+            voice->Flags &= ~(VOICE_HRTF_DIRECT | VOICE_HRTF_SWITCHING);
+
             if(device->AvgSpeakerDist > 0.0f)
             {
                 /* Reinitialize the NFC filters for new parameters. */
@@ -2397,6 +2501,7 @@ static void InitDevice(ALCdevice *device, enum DeviceType type)
 
     device->Flags = 0;
     device->Render_Mode = NormalRender;
+    device->HrtfDirectVoices = 0;
     device->AvgSpeakerDist = 0.0f;
 
     ATOMIC_INIT(&device->ContextList, NULL);
@@ -2414,6 +2519,10 @@ static void InitDevice(ALCdevice *device, enum DeviceType type)
     device->FOAOut.NumChannels = 0;
     device->RealOut.Buffer = NULL;
     device->RealOut.NumChannels = 0;
+    device->TempBuffer = NULL;
+
+    device->MixThreads = NULL;
+    device->MixQuantum = BUFFERSIZE;
 
     AL_STRING_INIT(device->DeviceName);
 
@@ -2434,9 +2543,14 @@ static void InitDevice(ALCdevice *device, enum DeviceType type)
     device->AmbiUp = NULL;
     device->Stablizer = NULL;
     device->Limiter = NULL;
+    device->PanCache = NULL;
 
     VECTOR_INIT(device->BufferList);
     almtx_init(&device->BufferLock, almtx_plain);
+    device->FloatCacheLimit = 0;
+    device->FloatCacheSize = 0;
+    device->FloatCacheClock = 0;
+    device->PlanarBuffers = AL_FALSE;
 
     VECTOR_INIT(device->EffectList);
     almtx_init(&device->EffectLock, almtx_plain);
@@ -2490,6 +2604,7 @@ static ALCvoid FreeDevice(ALCdevice *device)
 
     AL_STRING_DEINIT(device->HrtfName);
     FreeHrtfList(&device->HrtfList);
+    ReclaimHrtfFilters();
     if(device->HrtfHandle)
         Hrtf_DecRef(device->HrtfHandle);
     device->HrtfHandle = NULL;
@@ -2511,6 +2626,8 @@ static ALCvoid FreeDevice(ALCdevice *device)
     al_free(device->Limiter);
     device->Limiter = NULL;
 
+    aluFreePanningCache(device);
+
     al_free(device->ChannelDelay[0].Buffer);
     for(i = 0;i < MAX_OUTPUT_CHANNELS;i++)
     {
@@ -2521,9 +2638,13 @@ static ALCvoid FreeDevice(ALCdevice *device)
 
     AL_STRING_DEINIT(device->DeviceName);
 
+    aluDeinitMixThreads(device);
+
     al_free(device->Dry.Buffer);
     device->Dry.Buffer = NULL;
     device->Dry.NumChannels = 0;
+    al_free(device->TempBuffer);
+    device->TempBuffer = NULL;
     device->FOAOut.Buffer = NULL;
     device->FOAOut.NumChannels = 0;
     device->RealOut.Buffer = NULL;
@@ -2742,6 +2863,7 @@ static void FreeContext(ALCcontext *context)
     while(vprops)
     {
         struct ALvoiceProps *next = ATOMIC_LOAD(&vprops->next, almemory_order_relaxed);
+        ReleaseVoicePropsHrtf(vprops);
         al_free(vprops);
         vprops = next;
         ++count;
@@ -2750,8 +2872,13 @@ static void FreeContext(ALCcontext *context)
 
     for(i = 0;i < context->VoiceCount;i++)
         DeinitVoice(context->Voices[i]);
+    /* Give the released HRTF filters back now, rather than holding on to
+     * the HRTF until the next lookup.
+     */
+    ReclaimHrtfFilters();
     al_free(context->Voices);
     context->Voices = NULL;
+    context->VoiceRanks = NULL;
     context->VoiceCount = 0;
     context->MaxVoices = 0;
 
@@ -2926,6 +3053,7 @@ void AllocateVoices(ALCcontext *context, ALsizei num_voices, ALsizei old_sends)
     struct ALvoiceProps *props;
     size_t sizeof_props;
     size_t sizeof_voice;
+    VoiceRank *ranks;
     ALvoice **voices;
     ALvoice *voice;
     ALsizei v = 0;
@@ -2934,19 +3062,21 @@ void AllocateVoices(ALCcontext *context, ALsizei num_voices, ALsizei old_sends)
     if(num_voices == context->MaxVoices && num_sends == old_sends)
         return;
 
-    /* Allocate the voice pointers, voices, and the voices' stored source
-     * property set (including the dynamically-sized Send[] array) in one
-     * chunk.
+    /* Allocate the voice pointers, the voice ranking storage, voices, and the
+     * voices' stored source property set (including the dynamically-sized
+     * Send[] array) in one chunk.
      */
     sizeof_voice = RoundUp(FAM_SIZE(ALvoice, Send, num_sends), 16);
     sizeof_props = RoundUp(FAM_SIZE(struct ALvoiceProps, Send, num_sends), 16);
-    size = sizeof(ALvoice*) + sizeof_voice + sizeof_props;
+    size = RoundUp(num_voices*sizeof(ALvoice*), 16) + RoundUp(num_voices*sizeof(VoiceRank), 16) +
+           (sizeof_voice+sizeof_props)*num_voices;
 
-    voices = al_calloc(16, RoundUp(size*num_voices, 16));
+    voices = al_calloc(16, size);
+    ranks = (VoiceRank*)((char*)voices + RoundUp(num_voices*sizeof(ALvoice*), 16));
     /* The voice and property objects are stored interleaved since they're
      * paired together.
      */
-    voice = (ALvoice*)((char*)voices + RoundUp(num_voices*sizeof(ALvoice*), 16));
+    voice = (ALvoice*)((char*)ranks + RoundUp(num_voices*sizeof(VoiceRank), 16));
     props = (struct ALvoiceProps*)((char*)voice + sizeof_voice);
 
     if(context->Voices)
@@ -2999,6 +3129,7 @@ void AllocateVoices(ALCcontext *context, ALsizei num_voices, ALsizei old_sends)
 
     al_free(context->Voices);
     context->Voices = voices;
+    context->VoiceRanks = ranks;
     context->MaxVoices = num_voices;
     context->VoiceCount = mini(context->VoiceCount, num_voices);
 }
@@ -3197,13 +3328,25 @@ ALC_API const ALCchar* ALC_APIENTRY alcGetString(ALCdevice *Device, ALCenum para
 }
 
 
+/* Gets the HRTF rendering mode in use, or ALC_FALSE without HRTF. */
+static ALCenum GetHrtfMode(const ALCdevice *device)
+{
+    if(!device->HrtfHandle)
+        return ALC_FALSE;
+    if(device->Render_Mode == HrtfRender)
+        return ALC_HRTF_FULL_SOFT;
+    if(device->HrtfDirectVoices > 0)
+        return ALC_HRTF_HYBRID_SOFT;
+    return ALC_HRTF_BASIC_SOFT;
+}
+
 static inline ALCsizei NumAttrsForDevice(ALCdevice *device)
 {
     if(device->Type == Capture) return 9;
-    if(device->Type != Loopback) return 29;
+    if(device->Type != Loopback) return 33;
     if(device->FmtChans == DevFmtAmbi3D)
-        return 35;
-    return 29;
+        return 39;
+    return 33;
 }
 
 static ALCsizei GetIntegerv(ALCdevice *device, ALCenum param, ALCsizei size, ALCint *values)
@@ -3379,6 +3522,12 @@ static ALCsizei GetIntegerv(ALCdevice *device, ALCenum param, ALCsizei size, ALC
             values[i++] = ALC_OUTPUT_LIMITER_SOFT;
             values[i++] = device->Limiter ? ALC_TRUE : ALC_FALSE;
 
+            values[i++] = ALC_HRTF_MODE_SOFT;
+            values[i++] = GetHrtfMode(device);
+
+            values[i++] = ALC_HRTF_DIRECT_VOICES_SOFT;
+            values[i++] = device->HrtfDirectVoices;
+
             values[i++] = ALC_MAX_AMBISONIC_ORDER_SOFT;
             values[i++] = MAX_AMBI_ORDER;
             almtx_unlock(&device->BackendLock);
@@ -3507,6 +3656,14 @@ static ALCsizei GetIntegerv(ALCdevice *device, ALCenum param, ALCsizei size, ALC
             values[0] = device->Limiter ? ALC_TRUE : ALC_FALSE;
             return 1;
 
+        case ALC_HRTF_MODE_SOFT:
+            values[0] = GetHrtfMode(device);
+            return 1;
+
+        case ALC_HRTF_DIRECT_VOICES_SOFT:
+            values[0] = device->HrtfDirectVoices;
+            return 1;
+
         case ALC_MAX_AMBISONIC_ORDER_SOFT:
             values[0] = MAX_AMBI_ORDER;
             return 1;
@@ -3618,6 +3775,12 @@ ALC_API void ALC_APIENTRY alcGetInteger64vSOFT(ALCdevice *device, ALCenum pname,
                     values[i++] = ALC_OUTPUT_LIMITER_SOFT;
                     values[i++] = device->Limiter ? ALC_TRUE : ALC_FALSE;
 
+                    values[i++] = ALC_HRTF_MODE_SOFT;
+                    values[i++] = GetHrtfMode(device);
+
+                    values[i++] = ALC_HRTF_DIRECT_VOICES_SOFT;
+                    values[i++] = device->HrtfDirectVoices;
+
                     clock = V0(device->Backend,getClockLatency)();
                     values[i++] = ALC_DEVICE_CLOCK_SOFT;
                     values[i++] = clock.ClockTime;
@@ -3783,6 +3946,7 @@ ALC_API ALCenum ALC_APIENTRY alcGetEnumValue(ALCdevice *device, const ALCchar *e
 ALC_API ALCcontext* ALC_APIENTRY alcCreateContext(ALCdevice *device, const ALCint *attrList)
 {
     ALCcontext *ALContext;
+    ALuint maxvoices;
     ALfloat valf;
     ALCenum err;
 
@@ -3824,6 +3988,8 @@ ALC_API ALCcontext* ALC_APIENTRY alcCreateContext(ALCdevice *device, const ALCin
     ALContext->Voices = NULL;
     ALContext->VoiceCount = 0;
     ALContext->MaxVoices = 0;
+    ALContext->MaxRealVoices = 0;
+    ALContext->VoiceRanks = NULL;
     ATOMIC_INIT(&ALContext->ActiveAuxSlots, NULL);
     ALContext->Device = device;
     ATOMIC_INIT(&ALContext->next, NULL);
@@ -3850,7 +4016,7 @@ ALC_API ALCcontext* ALC_APIENTRY alcCreateContext(ALCdevice *device, const ALCin
     if(DefaultEffect.type != AL_EFFECT_NULL && device->Type == Playback)
     {
         ALContext->DefaultSlot = (ALeffectslot*)(ALContext->_listener_mem + sizeof(ALlistener));
-        if(InitEffectSlot(ALContext->DefaultSlot) == AL_NO_ERROR)
+        if(InitEffectSlot(ALContext->DefaultSlot, device) == AL_NO_ERROR)
             aluInitEffectPanning(ALContext->DefaultSlot);
         else
         {
@@ -3877,6 +4043,21 @@ ALC_API ALCcontext* ALC_APIENTRY alcCreateContext(ALCdevice *device, const ALCin
     }
     UpdateListenerProps(ALContext);
 
+    if(attrList)
+    {
+        ALCsizei attrIdx = 0;
+        while(attrList[attrIdx])
+        {
+            if(attrList[attrIdx] == ALC_MAX_REAL_VOICES_SOFT)
+                ALContext->MaxRealVoices = maxi(attrList[attrIdx + 1], 0);
+            attrIdx += 2;
+        }
+    }
+    if(ConfigValueUInt(alstr_get_cstr(device->DeviceName), NULL, "max-real-voices", &maxvoices))
+        ALContext->MaxRealVoices = minu(maxvoices, INT_MAX);
+    if(ALContext->MaxRealVoices > 0)
+        TRACE("Mixing at most %d voices\n", ALContext->MaxRealVoices);
+
     {
         ALCcontext *head = ATOMIC_LOAD_SEQ(&device->ContextList);
         do {
@@ -4033,6 +4214,7 @@ ALC_API ALCdevice* ALC_APIENTRY alcOpenDevice(const ALCchar *deviceName)
     const ALCchar *fmt;
     ALCdevice *device;
     ALCenum err;
+    ALuint cachesize;
 
     DO_INITCONFIG();
 
@@ -4159,6 +4341,11 @@ ALC_API ALCdevice* ALC_APIENTRY alcOpenDevice(const ALCchar *deviceName)
     ConfigValueUInt(deviceName, NULL, "sources", &device->SourcesMax);
     if(device->SourcesMax == 0) device->SourcesMax = 256;
 
+    if(ConfigValueUInt(deviceName, NULL, "float-cache-size", &cachesize))
+        device->FloatCacheLimit = minz(cachesize, SIZE_MAX>>20) << 20;
+    if(GetConfigValueBool(deviceName, NULL, "planar-buffers", 0))
+        device->PlanarBuffers = AL_TRUE;
+
     ConfigValueUInt(deviceName, NULL, "slots", &device->AuxiliaryEffectSlotMax);
     if(device->AuxiliaryEffectSlotMax == 0) device->AuxiliaryEffectSlotMax = 64;
     else device->AuxiliaryEffectSlotMax = minu(device->AuxiliaryEffectSlotMax, INT_MAX);
@@ -4470,6 +4657,7 @@ ALC_API ALCdevice* ALC_APIENTRY alcLoopbackOpenDeviceSOFT(const ALCchar *deviceN
 {
     ALCbackendFactory *factory;
     ALCdevice *device;
+    ALuint cachesize;
 
     DO_INITCONFIG();
 
@@ -4508,6 +4696,11 @@ ALC_API ALCdevice* ALC_APIENTRY alcLoopbackOpenDeviceSOFT(const ALCchar *deviceN
     ConfigValueUInt(NULL, NULL, "sources", &device->SourcesMax);
     if(device->SourcesMax == 0) device->SourcesMax = 256;
 
+    if(ConfigValueUInt(NULL, NULL, "float-cache-size", &cachesize))
+        device->FloatCacheLimit = minz(cachesize, SIZE_MAX>>20) << 20;
+    if(GetConfigValueBool(NULL, NULL, "planar-buffers", 0))
+        device->PlanarBuffers = AL_TRUE;
+
     ConfigValueUInt(NULL, NULL, "slots", &device->AuxiliaryEffectSlotMax);
     if(device->AuxiliaryEffectSlotMax == 0) device->AuxiliaryEffectSlotMax = 64;
     else device->AuxiliaryEffectSlotMax = minu(device->AuxiliaryEffectSlotMax, INT_MAX);
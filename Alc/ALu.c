@@ -79,6 +79,8 @@ extern inline size_t clampz(size_t val, size_t min, size_t max);
 extern inline ALfloat lerp(ALfloat val1, ALfloat val2, ALfloat mu);
 extern inline ALfloat cubic(ALfloat val1, ALfloat val2, ALfloat val3, ALfloat val4, ALfloat mu);
 
+extern inline size_t FloatDataStride(const ALbuffer *buffer);
+
 extern inline void aluVectorSet(aluVector *restrict vector, ALfloat x, ALfloat y, ALfloat z, ALfloat w);
 
 extern inline void aluMatrixfSetRow(aluMatrixf *matrix, ALuint row,
@@ -114,11 +116,84 @@ struct ChanMap {
 };
 
 static HrtfDirectMixerFunc MixDirectHrtf = MixDirectHrtf_C;
+static VoiceBatchFunc CalcVoiceBatchVectors = CalcVoiceBatchVectors_C;
 
 
 void DeinitVoice(ALvoice *voice)
 {
-    al_free(ATOMIC_EXCHANGE_PTR_SEQ(&voice->Update, NULL));
+    struct ALvoiceProps *props = ATOMIC_EXCHANGE_PTR_SEQ(&voice->Update, NULL);
+    if(props) ReleaseVoicePropsHrtf(props);
+    al_free(props);
+    ReleaseVoicePropsHrtf(voice->Props);
+    ReleaseVoiceHrtf(voice);
+    al_free(voice->HrtfFFT);
+    voice->HrtfFFT = NULL;
+    voice->NumHrtfFFT = 0;
+}
+
+void ReleaseVoiceHrtf(ALvoice *voice)
+{
+    ALsizei c;
+
+    for(c = 0;c < MAX_INPUT_CHANNELS;c++)
+    {
+        DirectParams *parms = &voice->Direct.Params[c];
+
+        HrtfFilter_DecRef(parms->Hrtf.Refs[0]);
+        HrtfFilter_DecRef(parms->Hrtf.Refs[1]);
+        parms->Hrtf.Refs[0] = NULL;
+        parms->Hrtf.Refs[1] = NULL;
+        parms->Hrtf.Old.Filter = NULL;
+        parms->Hrtf.Target.Filter = NULL;
+    }
+    for(c = 0;c < voice->NumHrtfFFT;c++)
+        ResetHrtfFFTState(&voice->HrtfFFT[c]);
+}
+
+void InitVoiceHrtfFFT(ALvoice *voice, const ALCdevice *device)
+{
+    if(!device->HrtfFFT || (device->Render_Mode != HrtfRender && device->HrtfDirectVoices == 0))
+        return;
+
+    if(voice->NumHrtfFFT < voice->NumChannels)
+    {
+        al_free(voice->HrtfFFT);
+        voice->HrtfFFT = al_calloc(16, sizeof(voice->HrtfFFT[0])*voice->NumChannels);
+        voice->NumHrtfFFT = voice->HrtfFFT ? voice->NumChannels : 0;
+        if(!voice->HrtfFFT)
+        {
+            ERR("Failed to allocate HRTF FFT state\n");
+            return;
+        }
+    }
+    voice->Flags |= VOICE_HRTF_FFT;
+}
+
+void ReleaseVoicePropsHrtf(struct ALvoiceProps *props)
+{
+    ALsizei c;
+
+    for(c = 0;c < MAX_INPUT_CHANNELS;c++)
+    {
+        HrtfFilter_DecRef(props->Hrtf[c]);
+        props->Hrtf[c] = NULL;
+    }
+}
+
+/* Sets the target filter for a voice channel's HRTF, with the silent filter
+ * for NULL. The mixer fades from the old filter, so the voice keeps that one
+ * referenced too.
+ */
+static void SetHrtfTargetFilter(DirectParams *parms, HrtfFilter *filter)
+{
+    if(!filter) filter = GetSilentHrtfFilter();
+    HrtfFilter_IncRef(parms->Hrtf.Old.Filter);
+    HrtfFilter_IncRef(filter);
+    HrtfFilter_DecRef(parms->Hrtf.Refs[0]);
+    HrtfFilter_DecRef(parms->Hrtf.Refs[1]);
+    parms->Hrtf.Refs[0] = parms->Hrtf.Old.Filter;
+    parms->Hrtf.Refs[1] = filter;
+    parms->Hrtf.Target.Filter = filter;
 }
 
 
@@ -128,6 +203,10 @@ static inline HrtfDirectMixerFunc SelectHrtfMixer(void)
     if((CPUCapFlags&CPU_CAP_NEON))
         return MixDirectHrtf_Neon;
 #endif
+#ifdef HAVE_AVX2
+    if((CPUCapFlags&(CPU_CAP_AVX2|CPU_CAP_FMA)) == (CPU_CAP_AVX2|CPU_CAP_FMA))
+        return MixDirectHrtf_AVX2;
+#endif
 #ifdef HAVE_SSE
     if((CPUCapFlags&CPU_CAP_SSE))
         return MixDirectHrtf_SSE;
@@ -136,6 +215,16 @@ static inline HrtfDirectMixerFunc SelectHrtfMixer(void)
     return MixDirectHrtf_C;
 }
 
+static inline VoiceBatchFunc SelectVoiceBatchFunc(void)
+{
+#ifdef HAVE_SSE
+    if((CPUCapFlags&CPU_CAP_SSE))
+        return CalcVoiceBatchVectors_SSE;
+#endif
+
+    return CalcVoiceBatchVectors_C;
+}
+
 
 /* Prior to VS2013, MSVC lacks the round() family of functions. */
 #if defined(_MSC_VER) && _MSC_VER < 1800
@@ -206,9 +295,47 @@ static aluVector aluMatrixfVector(const aluMatrixf *mtx, const aluVector *vec)
 void aluInit(void)
 {
     MixDirectHrtf = SelectHrtfMixer();
+    CalcVoiceBatchVectors = SelectVoiceBatchFunc();
+}
+
+
+ALfloat **aluAllocBufferLines(ALsizei numlines, ALsizei length)
+{
+    /* Pad each line to a multiple of 4 samples to keep them all aligned. */
+    const size_t stride = RoundUp(length, 4);
+    const size_t tablesize = RoundUp(numlines*sizeof(ALfloat*), 16);
+    ALfloat **lines;
+    ALfloat *samples;
+    ALsizei i;
+
+    lines = al_calloc(16, tablesize + numlines*stride*sizeof(ALfloat));
+    if(!lines) return NULL;
+
+    samples = (ALfloat*)((char*)lines + tablesize);
+    for(i = 0;i < numlines;i++)
+        lines[i] = samples + i*stride;
+    return lines;
 }
 
 
+static void SendBufferCompletedEvent(ALCcontext *context, ALuint id, ALsizei count)
+{
+    ALbitfieldSOFT enabledevt;
+    AsyncEvent evt;
+
+    enabledevt = ATOMIC_LOAD(&context->EnabledEvts, almemory_order_acquire);
+    if(!(enabledevt&EventType_BufferCompleted)) return;
+
+    evt.EnumType = EventType_BufferCompleted;
+    evt.Type = AL_EVENT_TYPE_BUFFER_COMPLETED_SOFT;
+    evt.ObjectId = id;
+    evt.Param = count;
+    strcpy(evt.Message, "Buffer completed");
+
+    if(ll_ringbuffer_write(context->AsyncEvents, (const char*)&evt, 1) == 1)
+        alsem_post(&context->EventSem);
+}
+
 static void SendSourceStoppedEvent(ALCcontext *context, ALuint id)
 {
     ALbitfieldSOFT enabledevt;
@@ -371,13 +498,29 @@ void BsincPrepare(const ALuint increment, BsincState *state, const BSincTable *t
 }
 
 
-static bool CalcContextParams(ALCcontext *Context)
+/* Listener and context changes, for deciding which voices they affect. */
+#define LISTENER_CHANGED_POSE     (1u<<0)
+#define LISTENER_CHANGED_VELOCITY (1u<<1)
+#define LISTENER_CHANGED_GAIN     (1u<<2)
+#define LISTENER_CHANGED_CONTEXT  (1u<<3)
+#define LISTENER_CHANGED_SLOTS    (1u<<4)
+
+/* Voice property changes. Pitch changes only need the stepping value
+ * recalculated, and gain changes can reuse the voice's listener-relative
+ * geometry and HRTF coefficients.
+ */
+#define VOICE_CHANGED_PITCH   (1u<<0)
+#define VOICE_CHANGED_GAIN    (1u<<1)
+#define VOICE_CHANGED_SPATIAL (1u<<2)
+#define VOICE_CHANGED_ALL     (VOICE_CHANGED_PITCH|VOICE_CHANGED_GAIN|VOICE_CHANGED_SPATIAL)
+
+static ALuint CalcContextParams(ALCcontext *Context)
 {
     ALlistener *Listener = Context->Listener;
     struct ALcontextProps *props;
 
     props = ATOMIC_EXCHANGE_PTR(&Context->Update, NULL, almemory_order_acq_rel);
-    if(!props) return false;
+    if(!props) return 0;
 
     Listener->Params.MetersPerUnit = props->MetersPerUnit;
 
@@ -391,44 +534,56 @@ static bool CalcContextParams(ALCcontext *Context)
     Listener->Params.DistanceModel = props->DistanceModel;
 
     ATOMIC_REPLACE_HEAD(struct ALcontextProps*, &Context->FreeContextProps, props);
-    return true;
+    return LISTENER_CHANGED_CONTEXT;
 }
 
-static bool CalcListenerParams(ALCcontext *Context)
+/* Calculates the matrix transforming world space to listener space. */
+static void CalcListenerMatrix(aluMatrixf *matrix, const ALfloat *forward, const ALfloat *up,
+                               const ALfloat *position)
 {
-    ALlistener *Listener = Context->Listener;
     ALfloat N[3], V[3], U[3], P[3];
-    struct ALlistenerProps *props;
-    aluVector vel;
-
-    props = ATOMIC_EXCHANGE_PTR(&Listener->Update, NULL, almemory_order_acq_rel);
-    if(!props) return false;
 
     /* AT then UP */
-    N[0] = props->Forward[0];
-    N[1] = props->Forward[1];
-    N[2] = props->Forward[2];
+    N[0] = forward[0];
+    N[1] = forward[1];
+    N[2] = forward[2];
     aluNormalize(N);
-    V[0] = props->Up[0];
-    V[1] = props->Up[1];
-    V[2] = props->Up[2];
+    V[0] = up[0];
+    V[1] = up[1];
+    V[2] = up[2];
     aluNormalize(V);
     /* Build and normalize right-vector */
     aluCrossproduct(N, V, U);
     aluNormalize(U);
 
-    aluMatrixfSet(&Listener->Params.Matrix,
+    aluMatrixfSet(matrix,
         U[0], V[0], -N[0], 0.0,
         U[1], V[1], -N[1], 0.0,
         U[2], V[2], -N[2], 0.0,
          0.0,  0.0,   0.0, 1.0
     );
 
-    P[0] = props->Position[0];
-    P[1] = props->Position[1];
-    P[2] = props->Position[2];
-    aluMatrixfFloat3(P, 1.0, &Listener->Params.Matrix);
-    aluMatrixfSetRow(&Listener->Params.Matrix, 3, -P[0], -P[1], -P[2], 1.0f);
+    P[0] = position[0];
+    P[1] = position[1];
+    P[2] = position[2];
+    aluMatrixfFloat3(P, 1.0, matrix);
+    aluMatrixfSetRow(matrix, 3, -P[0], -P[1], -P[2], 1.0f);
+}
+
+static ALuint CalcListenerParams(ALCcontext *Context)
+{
+    ALlistener *Listener = Context->Listener;
+    const aluMatrixf OldMatrix = Listener->Params.Matrix;
+    const aluVector OldVelocity = Listener->Params.Velocity;
+    const ALfloat OldGain = Listener->Params.Gain;
+    struct ALlistenerProps *props;
+    ALuint changes = 0;
+    aluVector vel;
+
+    props = ATOMIC_EXCHANGE_PTR(&Listener->Update, NULL, almemory_order_acq_rel);
+    if(!props) return 0;
+
+    CalcListenerMatrix(&Listener->Params.Matrix, props->Forward, props->Up, props->Position);
 
     aluVectorSet(&vel, props->Velocity[0], props->Velocity[1], props->Velocity[2], 0.0f);
     Listener->Params.Velocity = aluMatrixfVector(&Listener->Params.Matrix, &vel);
@@ -436,7 +591,14 @@ static bool CalcListenerParams(ALCcontext *Context)
     Listener->Params.Gain = props->Gain * Context->GainBoost;
 
     ATOMIC_REPLACE_HEAD(struct ALlistenerProps*, &Context->FreeListenerProps, props);
-    return true;
+
+    if(memcmp(&OldMatrix, &Listener->Params.Matrix, sizeof(OldMatrix)) != 0)
+        changes |= LISTENER_CHANGED_POSE;
+    if(memcmp(&OldVelocity, &Listener->Params.Velocity, sizeof(OldVelocity)) != 0)
+        changes |= LISTENER_CHANGED_VELOCITY;
+    if(OldGain != Listener->Params.Gain)
+        changes |= LISTENER_CHANGED_GAIN;
+    return changes;
 }
 
 static bool CalcEffectSlotParams(ALeffectslot *slot, ALCcontext *context, bool force)
@@ -525,13 +687,54 @@ static const struct ChanMap MonoMap[1] = {
     { SideRight,   DEG2RAD(  90.0f), DEG2RAD(0.0f) }
 };
 
+static_assert(MAX_OUTPUT_CHANNELS <= 32, "Too many output channels for the gain masks!");
+
+static ALuint GetGainMask(const ALfloat *gains, ALsizei numchans)
+{
+    ALuint mask = 0;
+    ALsizei i;
+    for(i = 0;i < numchans;i++)
+    {
+        if(fabsf(gains[i]) > GAIN_SILENCE_THRESHOLD)
+            mask |= 1u<<i;
+    }
+    return mask;
+}
+
+/* Updates the masks of which output channels the mixer needs to touch, given
+ * the new target gains. Channels that are currently audible stay active until
+ * the mixer finishes fading them.
+ */
+static void UpdateGainMasks(ALvoice *voice, ALsizei num_channels, ALsizei num_sends)
+{
+    ALsizei c, i;
+
+    for(c = 0;c < num_channels;c++)
+    {
+        DirectParams *parms = &voice->Direct.Params[c];
+        parms->Gains.TargetMask = GetGainMask(parms->Gains.Target, voice->Direct.Channels);
+        parms->Gains.ActiveMask = parms->Gains.TargetMask |
+                                  GetGainMask(parms->Gains.Current, voice->Direct.Channels);
+        for(i = 0;i < num_sends;i++)
+        {
+            SendParams *sparms = &voice->Send[i].Params[c];
+            sparms->Gains.TargetMask = GetGainMask(sparms->Gains.Target,
+                                                   voice->Send[i].Channels);
+            sparms->Gains.ActiveMask = sparms->Gains.TargetMask |
+                                       GetGainMask(sparms->Gains.Current,
+                                                   voice->Send[i].Channels);
+        }
+    }
+}
+
 static void CalcPanningAndFilters(ALvoice *voice, const ALfloat Distance, const ALfloat *Dir,
                                   const ALfloat Spread, const ALfloat DryGain,
                                   const ALfloat DryGainHF, const ALfloat DryGainLF,
                                   const ALfloat *WetGain, const ALfloat *WetGainLF,
                                   const ALfloat *WetGainHF, ALeffectslot **SendSlots,
                                   const ALbuffer *Buffer, const struct ALvoiceProps *props,
-                                  const ALlistener *Listener, const ALCdevice *Device)
+                                  const ALlistener *Listener, const ALCdevice *Device,
+                                  const bool KeepHrtfCoeffs)
 {
     struct ChanMap StereoMap[2] = {
         { FrontLeft,  DEG2RAD(-30.0f), DEG2RAD(0.0f) },
@@ -611,6 +814,10 @@ static void CalcPanningAndFilters(ALvoice *voice, const ALfloat Distance, const
         break;
     }
 
+    /* B-Format and direct channel voices don't use HRTF filters, so they
+     * aren't ranked for them.
+     */
+    voice->DirectGain = (isbformat || DirectChannels) ? 0.0f : DryGain;
     voice->Flags &= ~(VOICE_HAS_HRTF | VOICE_HAS_NFC);
     if(isbformat)
     {
@@ -622,7 +829,8 @@ static void CalcPanningAndFilters(ALvoice *voice, const ALfloat Distance, const
              * the first (W) channel as a normal mono sound and silence the
              * others.
              */
-            ALfloat coeffs[MAX_AMBI_COEFFS];
+            PanningParams pan_storage;
+            const PanningParams *pan;
 
             if(Device->AvgSpeakerDist > 0.0f)
             {
@@ -644,18 +852,10 @@ static void CalcPanningAndFilters(ALvoice *voice, const ALfloat Distance, const
                 voice->Flags |= VOICE_HAS_NFC;
             }
 
-            if(Device->Render_Mode == StereoPair)
-            {
-                ALfloat ev = asinf(Dir[1]);
-                ALfloat az = atan2f(Dir[0], -Dir[2]);
-                CalcAnglePairwiseCoeffs(az, ev, Spread, coeffs);
-            }
-            else
-                CalcDirectionCoeffs(Dir, Spread, coeffs);
+            pan = GetDirectionPanning(Device, Dir, Spread, &pan_storage);
 
             /* NOTE: W needs to be scaled by sqrt(2) due to FuMa normalization. */
-            ComputeDryPanGains(&Device->Dry, coeffs, DryGain*1.414213562f,
-                               voice->Direct.Params[0].Gains.Target);
+            ApplyPanningGains(pan, DryGain*1.414213562f, voice->Direct.Params[0].Gains.Target);
             for(c = 1;c < num_channels;c++)
             {
                 for(j = 0;j < MAX_OUTPUT_CHANNELS;j++)
@@ -667,7 +867,7 @@ static void CalcPanningAndFilters(ALvoice *voice, const ALfloat Distance, const
                 const ALeffectslot *Slot = SendSlots[i];
                 if(Slot)
                     ComputePanningGainsBF(Slot->ChanMap, Slot->NumChannels,
-                        coeffs, WetGain[i]*1.414213562f, voice->Send[i].Params[0].Gains.Target
+                        pan->Coeffs, WetGain[i]*1.414213562f, voice->Send[i].Params[0].Gains.Target
                     );
                 else
                     for(j = 0;j < MAX_EFFECT_CHANNELS;j++)
@@ -793,10 +993,11 @@ static void CalcPanningAndFilters(ALvoice *voice, const ALfloat Distance, const
             }
         }
     }
-    else if(Device->Render_Mode == HrtfRender)
+    else if(Device->Render_Mode == HrtfRender || (voice->Flags&VOICE_HRTF_DIRECT))
     {
-        /* Full HRTF rendering. Skip the virtual channels and render to the
-         * real outputs.
+        /* Full HRTF rendering, or a voice ranked high enough for its own
+         * filters with hybrid rendering. Skip the virtual channels and render
+         * to the real outputs.
          */
         voice->Direct.Buffer = Device->RealOut.Buffer;
         voice->Direct.Channels = Device->RealOut.NumChannels;
@@ -804,29 +1005,19 @@ static void CalcPanningAndFilters(ALvoice *voice, const ALfloat Distance, const
         if(Distance > FLT_EPSILON)
         {
             ALfloat coeffs[MAX_AMBI_COEFFS];
-            ALfloat ev, az;
-
-            ev = asinf(Dir[1]);
-            az = atan2f(Dir[0], -Dir[2]);
 
-            /* Get the HRIR coefficients and delays just once, for the given
-             * source direction.
+            /* The update has the HRIR filter for the source direction, shared
+             * by the channels besides LFE. It's kept as-is when only the gain
+             * changed.
              */
-            GetHrtfCoeffs(Device->HrtfHandle, ev, az, Spread,
-                          voice->Direct.Params[0].Hrtf.Target.Coeffs,
-                          voice->Direct.Params[0].Hrtf.Target.Delay);
-            voice->Direct.Params[0].Hrtf.Target.Gain = DryGain * downmix_gain;
-
-            /* Remaining channels use the same results as the first. */
-            for(c = 1;c < num_channels;c++)
+            if(!KeepHrtfCoeffs)
             {
-                /* Skip LFE */
-                if(chans[c].channel == LFE)
-                    memset(&voice->Direct.Params[c].Hrtf.Target, 0,
-                           sizeof(voice->Direct.Params[c].Hrtf.Target));
-                else
-                    voice->Direct.Params[c].Hrtf.Target = voice->Direct.Params[0].Hrtf.Target;
+                for(c = 0;c < num_channels;c++)
+                    SetHrtfTargetFilter(&voice->Direct.Params[c], props->Hrtf[c]);
             }
+            for(c = 0;c < num_channels;c++)
+                voice->Direct.Params[c].Hrtf.Target.Gain =
+                    (chans[c].channel == LFE) ? 0.0f : DryGain * downmix_gain;
 
             /* Calculate the directional coefficients once, which apply to all
              * input channels of the source sends.
@@ -867,8 +1058,9 @@ static void CalcPanningAndFilters(ALvoice *voice, const ALfloat Distance, const
                 if(chans[c].channel == LFE)
                 {
                     /* Skip LFE */
-                    memset(&voice->Direct.Params[c].Hrtf.Target, 0,
-                           sizeof(voice->Direct.Params[c].Hrtf.Target));
+                    if(!KeepHrtfCoeffs)
+                        SetHrtfTargetFilter(&voice->Direct.Params[c], NULL);
+                    voice->Direct.Params[c].Hrtf.Target.Gain = 0.0f;
                     for(i = 0;i < NumSends;i++)
                     {
                         for(j = 0;j < MAX_EFFECT_CHANNELS;j++)
@@ -877,14 +1069,9 @@ static void CalcPanningAndFilters(ALvoice *voice, const ALfloat Distance, const
                     continue;
                 }
 
-                /* Get the HRIR coefficients and delays for this channel
-                 * position.
-                 */
-                GetHrtfCoeffs(Device->HrtfHandle,
-                    chans[c].elevation, chans[c].angle, Spread,
-                    voice->Direct.Params[c].Hrtf.Target.Coeffs,
-                    voice->Direct.Params[c].Hrtf.Target.Delay
-                );
+                /* The update has the HRIR filter for this channel position. */
+                if(!KeepHrtfCoeffs)
+                    SetHrtfTargetFilter(&voice->Direct.Params[c], props->Hrtf[c]);
                 voice->Direct.Params[c].Hrtf.Target.Gain = DryGain;
 
                 /* Normal panning for auxiliary sends. */
@@ -912,7 +1099,8 @@ static void CalcPanningAndFilters(ALvoice *voice, const ALfloat Distance, const
 
         if(Distance > FLT_EPSILON)
         {
-            ALfloat coeffs[MAX_AMBI_COEFFS];
+            PanningParams pan_storage;
+            const PanningParams *pan;
             ALfloat w0 = 0.0f;
 
             /* Calculate NFC filter coefficient if needed. */
@@ -937,17 +1125,10 @@ static void CalcPanningAndFilters(ALvoice *voice, const ALfloat Distance, const
                 voice->Flags |= VOICE_HAS_NFC;
             }
 
-            /* Calculate the directional coefficients once, which apply to all
-             * input channels.
+            /* Get the directional coefficients and gains once, which apply to
+             * all input channels.
              */
-            if(Device->Render_Mode == StereoPair)
-            {
-                ALfloat ev = asinf(Dir[1]);
-                ALfloat az = atan2f(Dir[0], -Dir[2]);
-                CalcAnglePairwiseCoeffs(az, ev, Spread, coeffs);
-            }
-            else
-                CalcDirectionCoeffs(Dir, Spread, coeffs);
+            pan = GetDirectionPanning(Device, Dir, Spread, &pan_storage);
 
             for(c = 0;c < num_channels;c++)
             {
@@ -964,9 +1145,8 @@ static void CalcPanningAndFilters(ALvoice *voice, const ALfloat Distance, const
                     continue;
                 }
 
-                ComputeDryPanGains(&Device->Dry,
-                    coeffs, DryGain * downmix_gain, voice->Direct.Params[c].Gains.Target
-                );
+                ApplyPanningGains(pan, DryGain * downmix_gain,
+                                  voice->Direct.Params[c].Gains.Target);
             }
 
             for(i = 0;i < NumSends;i++)
@@ -981,7 +1161,7 @@ static void CalcPanningAndFilters(ALvoice *voice, const ALfloat Distance, const
                                 voice->Send[i].Params[c].Gains.Target[j] = 0.0f;
                         else
                             ComputePanningGainsBF(Slot->ChanMap,
-                                Slot->NumChannels, coeffs, WetGain[i] * downmix_gain,
+                                Slot->NumChannels, pan->Coeffs, WetGain[i] * downmix_gain,
                                 voice->Send[i].Params[c].Gains.Target
                             );
                     }
@@ -1017,7 +1197,8 @@ static void CalcPanningAndFilters(ALvoice *voice, const ALfloat Distance, const
 
             for(c = 0;c < num_channels;c++)
             {
-                ALfloat coeffs[MAX_AMBI_COEFFS];
+                PanningParams pan_storage;
+                const PanningParams *pan;
 
                 /* Special-case LFE */
                 if(chans[c].channel == LFE)
@@ -1038,20 +1219,16 @@ static void CalcPanningAndFilters(ALvoice *voice, const ALfloat Distance, const
                     continue;
                 }
 
-                if(Device->Render_Mode == StereoPair)
-                    CalcAnglePairwiseCoeffs(chans[c].angle, chans[c].elevation, Spread, coeffs);
-                else
-                    CalcAngleCoeffs(chans[c].angle, chans[c].elevation, Spread, coeffs);
-                ComputeDryPanGains(&Device->Dry,
-                    coeffs, DryGain, voice->Direct.Params[c].Gains.Target
-                );
+                pan = GetAnglePanning(Device, chans[c].angle, chans[c].elevation, Spread,
+                                      &pan_storage);
+                ApplyPanningGains(pan, DryGain, voice->Direct.Params[c].Gains.Target);
 
                 for(i = 0;i < NumSends;i++)
                 {
                     const ALeffectslot *Slot = SendSlots[i];
                     if(Slot)
                         ComputePanningGainsBF(Slot->ChanMap, Slot->NumChannels,
-                            coeffs, WetGain[i], voice->Send[i].Params[c].Gains.Target
+                            pan->Coeffs, WetGain[i], voice->Send[i].Params[c].Gains.Target
                         );
                     else
                         for(j = 0;j < MAX_EFFECT_CHANNELS;j++)
@@ -1112,9 +1289,190 @@ static void CalcPanningAndFilters(ALvoice *voice, const ALfloat Distance, const
                                      &voice->Send[i].Params[0].HighPass);
         }
     }
+
+    UpdateGainMasks(voice, num_channels, NumSends);
+}
+
+/* Calculates the fixed-point stepping value from the voice's pitch and
+ * doppler shift, and prepares the resampler for it.
+ */
+static void LoadVoicePropsHrtf(struct ALvoiceProps *props, const ALbuffer *buffer,
+                               const ALCcontext *context)
+{
+    struct ChanMap StereoMap[2] = {
+        { FrontLeft,  DEG2RAD(-30.0f), DEG2RAD(0.0f) },
+        { FrontRight, DEG2RAD( 30.0f), DEG2RAD(0.0f) }
+    };
+    const ALCdevice *device = context->Device;
+    const ALlistener *listener = context->Listener;
+    const struct ChanMap *chans = NULL;
+    ALsizei num_channels = 0;
+    ALfloat dir[3] = { 0.0f, 0.0f, -1.0f };
+    ALfloat distance = 0.0f;
+    ALfloat spread = 0.0f;
+    ALboolean spectrum;
+    ALfloat scale;
+    ALsizei c;
+
+    if(!device->HrtfHandle ||
+       (device->Render_Mode != HrtfRender && device->HrtfDirectVoices == 0))
+        return;
+
+    switch(buffer->FmtChannels)
+    {
+    case FmtMono:
+        chans = MonoMap;
+        num_channels = 1;
+        break;
+
+    case FmtStereo:
+        /* Convert counter-clockwise to clockwise. */
+        StereoMap[0].angle = -props->StereoPan[0];
+        StereoMap[1].angle = -props->StereoPan[1];
+        chans = StereoMap;
+        num_channels = 2;
+        break;
+
+    case FmtRear:
+        chans = RearMap;
+        num_channels = 2;
+        break;
+
+    case FmtQuad:
+        chans = QuadMap;
+        num_channels = 4;
+        break;
+
+    case FmtX51:
+        chans = X51Map;
+        num_channels = 6;
+        break;
+
+    case FmtX61:
+        chans = X61Map;
+        num_channels = 7;
+        break;
+
+    case FmtX71:
+        chans = X71Map;
+        num_channels = 8;
+        break;
+
+    case FmtBFormat2D:
+    case FmtBFormat3D:
+        /* B-Format voices don't use HRTF filters. */
+        return;
+    }
+    /* Neither do multi-channel voices playing direct. */
+    if(num_channels > 1 && props->DirectChannels)
+        return;
+
+    /* Find the listener-relative position the same way the mixer does, from
+     * the properties it will have along with this update.
+     */
+    if(props->SpatializeMode == SpatializeOn ||
+       (props->SpatializeMode == SpatializeAuto && buffer->FmtChannels == FmtMono))
+    {
+        aluVector pos;
+
+        aluVectorSet(&pos, props->Position[0], props->Position[1], props->Position[2], 1.0f);
+        if(!props->HeadRelative)
+        {
+            aluMatrixf matrix;
+            CalcListenerMatrix(&matrix, listener->Forward, listener->Up, listener->Position);
+            pos = aluMatrixfVector(&matrix, &pos);
+        }
+        distance = sqrtf(pos.v[0]*pos.v[0] + pos.v[1]*pos.v[1] + pos.v[2]*pos.v[2]);
+        if(distance > FLT_EPSILON)
+        {
+            const ALfloat invdist = 1.0f / distance;
+            dir[0] = pos.v[0] * invdist;
+            /* Clamp Y, in case rounding errors caused it to end up outside
+             * of -1...+1.
+             */
+            dir[1] = clampf(pos.v[1] * invdist, -1.0f, 1.0f);
+            dir[2] = pos.v[2] * invdist * ZScale;
+        }
+
+        if(props->Radius > distance)
+            spread = F_TAU - distance/props->Radius*F_PI;
+        else if(distance > FLT_EPSILON)
+            spread = asinf(props->Radius / distance) * 2.0f;
+    }
+
+    scale = device->PanCache ? device->PanCache->Scale : 0.0f;
+    spectrum = device->HrtfFFT;
+    if(distance > FLT_EPSILON)
+    {
+        /* One filter for the source direction, shared by the channels
+         * besides LFE.
+         */
+        HrtfFilter *filter = GetHrtfFilter(device->HrtfHandle, asinf(dir[1]),
+            atan2f(dir[0], -dir[2]), spread, scale, spectrum);
+        for(c = 0;c < num_channels;c++)
+        {
+            if(chans[c].channel == LFE)
+                continue;
+            HrtfFilter_IncRef(filter);
+            props->Hrtf[c] = filter;
+        }
+        /* Each channel took its own reference. */
+        HrtfFilter_DecRef(filter);
+    }
+    else
+    {
+        /* Local sources get a filter for each channel's position. */
+        for(c = 0;c < num_channels;c++)
+        {
+            if(chans[c].channel == LFE)
+                continue;
+            props->Hrtf[c] = GetHrtfFilter(device->HrtfHandle, chans[c].elevation,
+                                           chans[c].angle, spread, scale, spectrum);
+        }
+    }
+}
+
+void CalcVoicePropsHrtf(struct ALvoiceProps *props, const ALbuffer *buffer, ALCcontext *context)
+{
+    ReleaseVoicePropsHrtf(props);
+
+    /* Use the mixer's FPU mode, so the filters come out the same as if the
+     * mixer calculated them.
+     */
+    START_MIXER_MODE();
+    LoadVoicePropsHrtf(props, buffer, context);
+    END_MIXER_MODE();
+}
+
+static void CalcVoiceStep(ALvoice *voice, const struct ALvoiceProps *props, const ALbuffer *ALBuffer, const ALCdevice *Device)
+{
+    ALfloat Pitch;
+
+    /* A source moving toward the listener at the speed of sound bunches up
+     * to extreme frequencies, regardless of its own pitch.
+     */
+    if(voice->DopplerShift == HUGE_VALF)
+        Pitch = HUGE_VALF;
+    else
+        Pitch = props->Pitch * voice->DopplerShift;
+
+    /* Adjust pitch based on the buffer and output frequencies, and calculate
+     * fixed-point stepping value.
+     */
+    Pitch *= (ALfloat)ALBuffer->Frequency/(ALfloat)Device->Frequency;
+    if(Pitch > (ALfloat)MAX_PITCH)
+        voice->Step = MAX_PITCH<<FRACTIONBITS;
+    else
+        voice->Step = maxi(fastf2i(Pitch*FRACTIONONE + 0.5f), 1);
+    if(props->Resampler == BSinc24Resampler)
+        BsincPrepare(voice->Step, &voice->ResampleState.bsinc, &bsinc24);
+    else if(props->Resampler == BSinc12Resampler)
+        BsincPrepare(voice->Step, &voice->ResampleState.bsinc, &bsinc12);
+    voice->Resampler = SelectResampler(props->Resampler);
+    voice->ResamplerType = props->Resampler;
 }
 
-static void CalcNonAttnSourceParams(ALvoice *voice, const struct ALvoiceProps *props, const ALbuffer *ALBuffer, const ALCcontext *ALContext)
+static void CalcNonAttnSourceParams(ALvoice *voice, const struct ALvoiceProps *props, const ALbuffer *ALBuffer, const ALCcontext *ALContext, ALuint changes)
 {
     static const ALfloat dir[3] = { 0.0f, 0.0f, -1.0f };
     const ALCdevice *Device = ALContext->Device;
@@ -1124,7 +1482,6 @@ static void CalcNonAttnSourceParams(ALvoice *voice, const struct ALvoiceProps *p
     ALfloat WetGainHF[MAX_SENDS];
     ALfloat WetGainLF[MAX_SENDS];
     ALeffectslot *SendSlots[MAX_SENDS];
-    ALfloat Pitch;
     ALsizei i;
 
     voice->Direct.Buffer = Device->Dry.Buffer;
@@ -1148,16 +1505,8 @@ static void CalcNonAttnSourceParams(ALvoice *voice, const struct ALvoiceProps *p
     }
 
     /* Calculate the stepping value */
-    Pitch = (ALfloat)ALBuffer->Frequency/(ALfloat)Device->Frequency * props->Pitch;
-    if(Pitch > (ALfloat)MAX_PITCH)
-        voice->Step = MAX_PITCH<<FRACTIONBITS;
-    else
-        voice->Step = maxi(fastf2i(Pitch*FRACTIONONE + 0.5f), 1);
-    if(props->Resampler == BSinc24Resampler)
-        BsincPrepare(voice->Step, &voice->ResampleState.bsinc, &bsinc24);
-    else if(props->Resampler == BSinc12Resampler)
-        BsincPrepare(voice->Step, &voice->ResampleState.bsinc, &bsinc12);
-    voice->Resampler = SelectResampler(props->Resampler);
+    voice->DopplerShift = 1.0f;
+    CalcVoiceStep(voice, props, ALBuffer, Device);
 
     /* Calculate gains */
     DryGain  = clampf(props->Gain, props->MinGain, props->MaxGain);
@@ -1175,32 +1524,126 @@ static void CalcNonAttnSourceParams(ALvoice *voice, const struct ALvoiceProps *p
     }
 
     CalcPanningAndFilters(voice, 0.0f, dir, 0.0f, DryGain, DryGainHF, DryGainLF, WetGain,
-                          WetGainLF, WetGainHF, SendSlots, ALBuffer, props, Listener, Device);
+                          WetGainLF, WetGainHF, SendSlots, ALBuffer, props, Listener, Device,
+                          !(changes&VOICE_CHANGED_SPATIAL));
 }
 
-static void CalcAttnSourceParams(ALvoice *voice, const struct ALvoiceProps *props, const ALbuffer *ALBuffer, const ALCcontext *ALContext)
+/* Transforms the batch's source vectors into listener space and calculates
+ * the listener-relative values used for attenuation, cones, and doppler.
+ */
+static void CalcVoiceBatchGeometry(VoiceBatch *restrict batch, const ALlistener *Listener)
 {
-    const ALCdevice *Device = ALContext->Device;
-    const ALlistener *Listener = ALContext->Listener;
-    const ALsizei NumSends = Device->NumAuxSends;
-    aluVector Position, Velocity, Direction, SourceToListener;
-    ALfloat Distance, ClampedDist, DopplerFactor;
-    ALeffectslot *SendSlots[MAX_SENDS];
-    ALfloat RoomRolloff[MAX_SENDS];
-    ALfloat DecayDistance[MAX_SENDS];
-    ALfloat DecayLFDistance[MAX_SENDS];
-    ALfloat DecayHFDistance[MAX_SENDS];
-    ALfloat DryGain, DryGainHF, DryGainLF;
-    ALfloat WetGain[MAX_SENDS];
-    ALfloat WetGainHF[MAX_SENDS];
-    ALfloat WetGainLF[MAX_SENDS];
-    bool directional;
-    ALfloat dir[3];
-    ALfloat spread;
-    ALfloat Pitch;
-    ALint i;
+    const ALfloat m00 = Listener->Params.Matrix.m[0][0];
+    const ALfloat m01 = Listener->Params.Matrix.m[0][1];
+    const ALfloat m02 = Listener->Params.Matrix.m[0][2];
+    const ALfloat m10 = Listener->Params.Matrix.m[1][0];
+    const ALfloat m11 = Listener->Params.Matrix.m[1][1];
+    const ALfloat m12 = Listener->Params.Matrix.m[1][2];
+    const ALfloat m20 = Listener->Params.Matrix.m[2][0];
+    const ALfloat m21 = Listener->Params.Matrix.m[2][1];
+    const ALfloat m22 = Listener->Params.Matrix.m[2][2];
+    const ALfloat m30 = Listener->Params.Matrix.m[3][0];
+    const ALfloat m31 = Listener->Params.Matrix.m[3][1];
+    const ALfloat m32 = Listener->Params.Matrix.m[3][2];
+    const ALfloat lvx = Listener->Params.Velocity.v[0];
+    const ALfloat lvy = Listener->Params.Velocity.v[1];
+    const ALfloat lvz = Listener->Params.Velocity.v[2];
+    const ALsizei relstart = VOICE_BATCH_SIZE - batch->NumRelative;
+    ALsizei i;
 
-    /* Set mixing buffers and get send parameters. */
+    /* Transform world-space voices to listener space. The position has a w
+     * of 1, while the velocity and direction have a w of 0.
+     */
+    for(i = 0;i < batch->NumWorld;i++)
+    {
+        ALfloat x = batch->PosX[i], y = batch->PosY[i], z = batch->PosZ[i];
+        batch->PosX[i] = x*m00 + y*m10 + z*m20 + 1.0f*m30;
+        batch->PosY[i] = x*m01 + y*m11 + z*m21 + 1.0f*m31;
+        batch->PosZ[i] = x*m02 + y*m12 + z*m22 + 1.0f*m32;
+
+        x = batch->VelX[i]; y = batch->VelY[i]; z = batch->VelZ[i];
+        batch->VelX[i] = x*m00 + y*m10 + z*m20 + 0.0f*m30;
+        batch->VelY[i] = x*m01 + y*m11 + z*m21 + 0.0f*m31;
+        batch->VelZ[i] = x*m02 + y*m12 + z*m22 + 0.0f*m32;
+
+        x = batch->DirX[i]; y = batch->DirY[i]; z = batch->DirZ[i];
+        batch->DirX[i] = x*m00 + y*m10 + z*m20 + 0.0f*m30;
+        batch->DirY[i] = x*m01 + y*m11 + z*m21 + 0.0f*m31;
+        batch->DirZ[i] = x*m02 + y*m12 + z*m22 + 0.0f*m32;
+    }
+
+    /* Head-relative voices are already in listener space, but their velocity
+     * is offset by the listener's.
+     */
+    for(i = relstart;i < VOICE_BATCH_SIZE;i++)
+    {
+        batch->VelX[i] += lvx;
+        batch->VelY[i] += lvy;
+        batch->VelZ[i] += lvz;
+    }
+
+    CalcVoiceBatchVectors(batch, 0, batch->NumWorld, Listener->Params.Velocity.v);
+    CalcVoiceBatchVectors(batch, relstart, VOICE_BATCH_SIZE, Listener->Params.Velocity.v);
+}
+
+/* Calculates the doppler shift for the voice, from the source and listener
+ * velocities along the source-to-listener vector.
+ */
+static ALfloat CalcDopplerShift(const struct ALvoiceProps *props, const ALlistener *Listener,
+                                ALfloat SourceVel, ALfloat ListenerVel)
+{
+    const ALfloat DopplerFactor = props->DopplerFactor * Listener->Params.DopplerFactor;
+    const ALfloat SpeedOfSound = Listener->Params.SpeedOfSound;
+    ALfloat vss, vls;
+
+    if(!(DopplerFactor > 0.0f))
+        return 1.0f;
+
+    vss = SourceVel * DopplerFactor;
+    vls = ListenerVel * DopplerFactor;
+
+    if(!(vls < SpeedOfSound))
+    {
+        /* Listener moving away from the source at the speed of sound. Sound
+         * waves can't catch it.
+         */
+        return 0.0f;
+    }
+    if(!(vss < SpeedOfSound))
+    {
+        /* Source moving toward the listener at the speed of sound. Sound
+         * waves bunch up to extreme frequencies.
+         */
+        return HUGE_VALF;
+    }
+    /* Source and listener movement is nominal. Calculate the proper doppler
+     * shift.
+     */
+    return (SpeedOfSound-vls) / (SpeedOfSound-vss);
+}
+
+static void CalcAttnSourceParams(ALvoice *voice, const struct ALvoiceProps *props, const ALbuffer *ALBuffer, const ALCcontext *ALContext, ALuint changes)
+{
+    const ALCdevice *Device = ALContext->Device;
+    const ALlistener *Listener = ALContext->Listener;
+    const ALsizei NumSends = Device->NumAuxSends;
+    aluVector SourceToListener;
+    ALfloat Distance, ClampedDist;
+    ALeffectslot *SendSlots[MAX_SENDS];
+    ALfloat RoomRolloff[MAX_SENDS];
+    ALfloat DecayDistance[MAX_SENDS];
+    ALfloat DecayLFDistance[MAX_SENDS];
+    ALfloat DecayHFDistance[MAX_SENDS];
+    ALfloat DryGain, DryGainHF, DryGainLF;
+    ALfloat WetGain[MAX_SENDS];
+    ALfloat WetGainHF[MAX_SENDS];
+    ALfloat WetGainLF[MAX_SENDS];
+    bool directional;
+    ALfloat dir[3];
+    ALfloat spread;
+    ALint i;
+
+    /* Set mixing buffers and get send parameters. */
     voice->Direct.Buffer = Device->Dry.Buffer;
     voice->Direct.Channels = Device->Dry.NumChannels;
     for(i = 0;i < NumSends;i++)
@@ -1263,33 +1706,11 @@ static void CalcAttnSourceParams(ALvoice *voice, const struct ALvoiceProps *prop
         }
     }
 
-    /* Transform source to listener space (convert to head relative) */
-    aluVectorSet(&Position, props->Position[0], props->Position[1], props->Position[2], 1.0f);
-    aluVectorSet(&Direction, props->Direction[0], props->Direction[1], props->Direction[2], 0.0f);
-    aluVectorSet(&Velocity, props->Velocity[0], props->Velocity[1], props->Velocity[2], 0.0f);
-    if(props->HeadRelative == AL_FALSE)
-    {
-        const aluMatrixf *Matrix = &Listener->Params.Matrix;
-        /* Transform source vectors */
-        Position = aluMatrixfVector(Matrix, &Position);
-        Velocity = aluMatrixfVector(Matrix, &Velocity);
-        Direction = aluMatrixfVector(Matrix, &Direction);
-    }
-    else
-    {
-        const aluVector *lvelocity = &Listener->Params.Velocity;
-        /* Offset the source velocity to be relative of the listener velocity */
-        Velocity.v[0] += lvelocity->v[0];
-        Velocity.v[1] += lvelocity->v[1];
-        Velocity.v[2] += lvelocity->v[2];
-    }
-
-    directional = aluNormalize(Direction.v) > FLT_EPSILON;
-    SourceToListener.v[0] = -Position.v[0];
-    SourceToListener.v[1] = -Position.v[1];
-    SourceToListener.v[2] = -Position.v[2];
-    SourceToListener.v[3] = 0.0f;
-    Distance = aluNormalize(SourceToListener.v);
+    /* Use the listener-relative geometry from the last spatial update. */
+    directional = voice->DirLength > FLT_EPSILON;
+    aluVectorSet(&SourceToListener, voice->ToListener[0], voice->ToListener[1],
+                 voice->ToListener[2], 0.0f);
+    Distance = voice->Distance;
 
     /* Initial source gain */
     DryGain = props->Gain;
@@ -1420,7 +1841,7 @@ static void CalcAttnSourceParams(ALvoice *voice, const struct ALvoiceProps *prop
         ALfloat ConeHF;
         ALfloat Angle;
 
-        Angle = acosf(aluDotproduct(&Direction, &SourceToListener));
+        Angle = acosf(voice->ConeCos);
         Angle = RAD2DEG(Angle * ConeScale * 2.0f);
         if(!(Angle > props->InnerAngle))
         {
@@ -1468,57 +1889,9 @@ static void CalcAttnSourceParams(ALvoice *voice, const struct ALvoiceProps *prop
         WetGainLF[i] *= props->Send[i].GainLF;
     }
 
-
-    /* Initial source pitch */
-    Pitch = props->Pitch;
-
-    /* Calculate velocity-based doppler effect */
-    DopplerFactor = props->DopplerFactor * Listener->Params.DopplerFactor;
-    if(DopplerFactor > 0.0f)
-    {
-        const aluVector *lvelocity = &Listener->Params.Velocity;
-        const ALfloat SpeedOfSound = Listener->Params.SpeedOfSound;
-        ALfloat vss, vls;
-
-        vss = aluDotproduct(&Velocity, &SourceToListener) * DopplerFactor;
-        vls = aluDotproduct(lvelocity, &SourceToListener) * DopplerFactor;
-
-        if(!(vls < SpeedOfSound))
-        {
-            /* Listener moving away from the source at the speed of sound.
-             * Sound waves can't catch it.
-             */
-            Pitch = 0.0f;
-        }
-        else if(!(vss < SpeedOfSound))
-        {
-            /* Source moving toward the listener at the speed of sound. Sound
-             * waves bunch up to extreme frequencies.
-             */
-            Pitch = HUGE_VALF;
-        }
-        else
-        {
-            /* Source and listener movement is nominal. Calculate the proper
-             * doppler shift.
-             */
-            Pitch *= (SpeedOfSound-vls) / (SpeedOfSound-vss);
-        }
-    }
-
-    /* Adjust pitch based on the buffer and output frequencies, and calculate
-     * fixed-point stepping value.
-     */
-    Pitch *= (ALfloat)ALBuffer->Frequency/(ALfloat)Device->Frequency;
-    if(Pitch > (ALfloat)MAX_PITCH)
-        voice->Step = MAX_PITCH<<FRACTIONBITS;
-    else
-        voice->Step = maxi(fastf2i(Pitch*FRACTIONONE + 0.5f), 1);
-    if(props->Resampler == BSinc24Resampler)
-        BsincPrepare(voice->Step, &voice->ResampleState.bsinc, &bsinc24);
-    else if(props->Resampler == BSinc12Resampler)
-        BsincPrepare(voice->Step, &voice->ResampleState.bsinc, &bsinc12);
-    voice->Resampler = SelectResampler(props->Resampler);
+    /* Calculate the stepping value, if the pitch or doppler shift changed. */
+    if((changes&(VOICE_CHANGED_PITCH|VOICE_CHANGED_SPATIAL)))
+        CalcVoiceStep(voice, props, ALBuffer, Device);
 
     if(Distance > FLT_EPSILON)
     {
@@ -1543,22 +1916,165 @@ static void CalcAttnSourceParams(ALvoice *voice, const struct ALvoiceProps *prop
         spread = 0.0f;
 
     CalcPanningAndFilters(voice, Distance, dir, spread, DryGain, DryGainHF, DryGainLF, WetGain,
-                          WetGainLF, WetGainHF, SendSlots, ALBuffer, props, Listener, Device);
+                          WetGainLF, WetGainHF, SendSlots, ALBuffer, props, Listener, Device,
+                          !(changes&VOICE_CHANGED_SPATIAL));
+}
+
+/* Gets the loudest of the voice's target gains. */
+static ALfloat CalcVoiceAudibility(const ALvoice *voice, ALsizei num_sends)
+{
+    ALfloat gain = 0.0f;
+    ALsizei c, i, j;
+
+    for(c = 0;c < voice->NumChannels;c++)
+    {
+        const DirectParams *parms = &voice->Direct.Params[c];
+        if((voice->Flags&VOICE_HAS_HRTF))
+            gain = maxf(gain, parms->Hrtf.Target.Gain);
+        else for(j = 0;j < voice->Direct.Channels;j++)
+            gain = maxf(gain, parms->Gains.Target[j]);
+
+        for(i = 0;i < num_sends;i++)
+        {
+            if(!voice->Send[i].Buffer)
+                continue;
+            for(j = 0;j < voice->Send[i].Channels;j++)
+                gain = maxf(gain, voice->Send[i].Params[c].Gains.Target[j]);
+        }
+    }
+    return gain;
+}
+
+/* Lets the mixer know when it can skip the voice. */
+static void UpdateVoiceAudibility(ALvoice *voice, ALsizei num_sends)
+{
+    voice->Audibility = CalcVoiceAudibility(voice, num_sends);
+    if(!(voice->Audibility > GAIN_SILENCE_THRESHOLD))
+        voice->Flags |= VOICE_IS_SILENT;
+    else
+        voice->Flags &= ~VOICE_IS_SILENT;
 }
 
-static void CalcSourceParams(ALvoice *voice, ALCcontext *context, bool force)
+/* Calculates the parameters of the spatialized voices gathered in the batch,
+ * and empties it.
+ */
+static void CalcVoiceBatchParams(VoiceBatch *batch, ALCcontext *context)
 {
+    const ALsizei num_sends = context->Device->NumAuxSends;
+    ALsizei i;
+
+    CalcVoiceBatchGeometry(batch, context->Listener);
+    for(i = 0;i < VOICE_BATCH_SIZE;i++)
+    {
+        ALvoice *voice;
+
+        if(i == batch->NumWorld)
+            i = VOICE_BATCH_SIZE - batch->NumRelative;
+        if(i == VOICE_BATCH_SIZE)
+            break;
+
+        voice = batch->Voice[i];
+        voice->ToListener[0] = batch->ToListenerX[i];
+        voice->ToListener[1] = batch->ToListenerY[i];
+        voice->ToListener[2] = batch->ToListenerZ[i];
+        voice->Distance = batch->Distance[i];
+        voice->ConeCos = batch->ConeCos[i];
+        voice->DirLength = batch->DirLength[i];
+        voice->DopplerShift = CalcDopplerShift(voice->Props, context->Listener,
+            batch->SourceVel[i], batch->ListenerVel[i]);
+
+        CalcAttnSourceParams(voice, voice->Props, batch->Buffer[i], context, VOICE_CHANGED_ALL);
+        UpdateVoiceAudibility(voice, num_sends);
+    }
+    batch->NumWorld = 0;
+    batch->NumRelative = 0;
+}
+
+/* Compares the voice's current properties with an update, to find what
+ * needs recalculating. This is done here rather than tracked as properties
+ * are set, since an update the mixer hasn't seen yet can be replaced by a
+ * newer one.
+ */
+static ALuint GetVoicePropChanges(const struct ALvoiceProps *old,
+                                  const struct ALvoiceProps *props, ALsizei num_sends)
+{
+    ALuint changes = 0;
+    ALsizei i;
+
+    if(old->Pitch != props->Pitch || old->Resampler != props->Resampler)
+        changes |= VOICE_CHANGED_PITCH;
+
+    if(memcmp(old->Position, props->Position, sizeof(props->Position)) != 0 ||
+       memcmp(old->Velocity, props->Velocity, sizeof(props->Velocity)) != 0 ||
+       memcmp(old->Direction, props->Direction, sizeof(props->Direction)) != 0 ||
+       memcmp(old->Orientation, props->Orientation, sizeof(props->Orientation)) != 0 ||
+       memcmp(old->StereoPan, props->StereoPan, sizeof(props->StereoPan)) != 0 ||
+       old->HeadRelative != props->HeadRelative ||
+       old->DirectChannels != props->DirectChannels ||
+       old->SpatializeMode != props->SpatializeMode ||
+       old->DopplerFactor != props->DopplerFactor ||
+       old->Radius != props->Radius ||
+       memcmp(old->Hrtf, props->Hrtf, sizeof(props->Hrtf)) != 0)
+        changes |= VOICE_CHANGED_SPATIAL;
+
+    /* Everything else, besides the priority, is applied with the gains and
+     * filters.
+     */
+    if(old->Gain != props->Gain || old->MinGain != props->MinGain ||
+       old->MaxGain != props->MaxGain || old->OuterGain != props->OuterGain ||
+       old->OuterGainHF != props->OuterGainHF || old->InnerAngle != props->InnerAngle ||
+       old->OuterAngle != props->OuterAngle || old->RefDistance != props->RefDistance ||
+       old->MaxDistance != props->MaxDistance || old->RolloffFactor != props->RolloffFactor ||
+       old->DistanceModel != props->DistanceModel ||
+       old->DryGainHFAuto != props->DryGainHFAuto || old->WetGainAuto != props->WetGainAuto ||
+       old->WetGainHFAuto != props->WetGainHFAuto ||
+       old->AirAbsorptionFactor != props->AirAbsorptionFactor ||
+       old->RoomRolloffFactor != props->RoomRolloffFactor ||
+       memcmp(&old->Direct, &props->Direct, sizeof(props->Direct)) != 0)
+        changes |= VOICE_CHANGED_GAIN;
+    for(i = 0;i < num_sends && !(changes&VOICE_CHANGED_GAIN);i++)
+    {
+        if(old->Send[i].Slot != props->Send[i].Slot ||
+           old->Send[i].Gain != props->Send[i].Gain ||
+           old->Send[i].GainHF != props->Send[i].GainHF ||
+           old->Send[i].HFReference != props->Send[i].HFReference ||
+           old->Send[i].GainLF != props->Send[i].GainLF ||
+           old->Send[i].LFReference != props->Send[i].LFReference)
+            changes |= VOICE_CHANGED_GAIN;
+    }
+
+    return changes;
+}
+
+/* Updates the voice's parameters for its property changes and the given
+ * listener changes. Only the parts affected by the changes get recalculated,
+ * except a spatial change on a spatialized voice, which adds it to the batch
+ * instead. The batch is calculated when it fills up or gets flushed by the
+ * caller with CalcVoiceBatchParams.
+ */
+static void CalcSourceParams(ALvoice *voice, ALCcontext *context, ALuint listener_changes,
+                             VoiceBatch *batch)
+{
+    const ALsizei num_sends = context->Device->NumAuxSends;
     ALbufferlistitem *BufferListItem;
     struct ALvoiceProps *props;
+    ALuint changes = 0;
 
     props = ATOMIC_EXCHANGE_PTR(&voice->Update, NULL, almemory_order_acq_rel);
-    if(!props && !force) return;
+    if(!props && !listener_changes && !(voice->Flags&VOICE_NEEDS_UPDATE))
+        return;
 
     if(props)
     {
-        memcpy(voice->Props, props,
-            FAM_SIZE(struct ALvoiceProps, Send, context->Device->NumAuxSends)
-        );
+        HrtfFilter *oldhrtf[MAX_INPUT_CHANNELS];
+
+        changes = GetVoicePropChanges(voice->Props, props, num_sends);
+        /* The voice takes over the update's filter references, and the
+         * container goes back with the old ones for the app to release.
+         */
+        memcpy(oldhrtf, voice->Props->Hrtf, sizeof(oldhrtf));
+        memcpy(voice->Props, props, FAM_SIZE(struct ALvoiceProps, Send, num_sends));
+        memcpy(props->Hrtf, oldhrtf, sizeof(oldhrtf));
 
         ATOMIC_REPLACE_HEAD(struct ALvoiceProps*, &context->FreeVoiceProps, props);
     }
@@ -1570,11 +2086,63 @@ static void CalcSourceParams(ALvoice *voice, ALCcontext *context, bool force)
         const ALbuffer *buffer;
         if(BufferListItem->num_buffers >= 1 && (buffer=BufferListItem->buffers[0]) != NULL)
         {
-            if(props->SpatializeMode == SpatializeOn ||
-               (props->SpatializeMode == SpatializeAuto && buffer->FmtChannels == FmtMono))
-                CalcAttnSourceParams(voice, props, buffer, context);
+            const bool spatialize = props->SpatializeMode == SpatializeOn ||
+                (props->SpatializeMode == SpatializeAuto && buffer->FmtChannels == FmtMono);
+            const bool bformat = buffer->FmtChannels == FmtBFormat2D ||
+                                 buffer->FmtChannels == FmtBFormat3D;
+
+            /* Listener orientation and position only affect voices that are
+             * positioned in the world, or local B-Format voices that get
+             * rotated with the listener. The listener velocity and context
+             * properties affect all spatialized voices, while the listener
+             * gain and effect slots affect everything.
+             */
+            if((voice->Flags&VOICE_NEEDS_UPDATE) || (listener_changes&LISTENER_CHANGED_SLOTS))
+                changes |= VOICE_CHANGED_ALL;
+            if((listener_changes&LISTENER_CHANGED_POSE) && !props->HeadRelative &&
+               (spatialize || bformat))
+                changes |= VOICE_CHANGED_SPATIAL;
+            if((listener_changes&(LISTENER_CHANGED_VELOCITY|LISTENER_CHANGED_CONTEXT)) &&
+               spatialize)
+                changes |= VOICE_CHANGED_SPATIAL;
+            if((listener_changes&LISTENER_CHANGED_GAIN))
+                changes |= VOICE_CHANGED_GAIN;
+            voice->Flags &= ~VOICE_NEEDS_UPDATE;
+
+            if(!changes)
+                break;
+            if(!(changes&~VOICE_CHANGED_PITCH))
+            {
+                /* Only the pitch changed, so the gains are unaffected. */
+                CalcVoiceStep(voice, props, buffer, context->Device);
+            }
+            else if(spatialize && (changes&VOICE_CHANGED_SPATIAL))
+            {
+                const ALsizei idx = (props->HeadRelative != AL_FALSE) ?
+                    (VOICE_BATCH_SIZE-1 - batch->NumRelative++) : batch->NumWorld++;
+
+                batch->Voice[idx] = voice;
+                batch->Buffer[idx] = buffer;
+                batch->PosX[idx] = props->Position[0];
+                batch->PosY[idx] = props->Position[1];
+                batch->PosZ[idx] = props->Position[2];
+                batch->VelX[idx] = props->Velocity[0];
+                batch->VelY[idx] = props->Velocity[1];
+                batch->VelZ[idx] = props->Velocity[2];
+                batch->DirX[idx] = props->Direction[0];
+                batch->DirY[idx] = props->Direction[1];
+                batch->DirZ[idx] = props->Direction[2];
+                if(batch->NumWorld+batch->NumRelative == VOICE_BATCH_SIZE)
+                    CalcVoiceBatchParams(batch, context);
+            }
             else
-                CalcNonAttnSourceParams(voice, props, buffer, context);
+            {
+                if(spatialize)
+                    CalcAttnSourceParams(voice, props, buffer, context, changes);
+                else
+                    CalcNonAttnSourceParams(voice, props, buffer, context, changes);
+                UpdateVoiceAudibility(voice, num_sends);
+            }
             break;
         }
         BufferListItem = ATOMIC_LOAD(&BufferListItem->next, almemory_order_acquire);
@@ -1582,38 +2150,234 @@ static void CalcSourceParams(ALvoice *voice, ALCcontext *context, bool force)
 }
 
 
+static inline bool RanksBefore(const VoiceRank *a, const VoiceRank *b)
+{
+    /* Ties go to the earlier voice, to keep the selection stable. */
+    return a->Score > b->Score || (a->Score == b->Score && a->Index < b->Index);
+}
+
+/* Partially sorts the ranks so the first 'keep' entries are the highest. */
+static void SelectTopRanks(VoiceRank *ranks, ALsizei count, ALsizei keep)
+{
+    ALsizei lo = 0, hi = count-1;
+
+    while(lo < hi)
+    {
+        const VoiceRank pivot = ranks[lo + (hi-lo)/2];
+        ALsizei i = lo, j = hi;
+
+        while(i <= j)
+        {
+            while(RanksBefore(&ranks[i], &pivot)) i++;
+            while(RanksBefore(&pivot, &ranks[j])) j--;
+            if(i <= j)
+            {
+                VoiceRank tmp = ranks[i];
+                ranks[i++] = ranks[j];
+                ranks[j--] = tmp;
+            }
+        }
+
+        if(keep-1 <= j)
+            hi = j;
+        else if(keep-1 >= i)
+            lo = i;
+        else
+            break;
+    }
+}
+
+/* Ranks the playing voices by their priority-scaled audibility, and keeps the
+ * target gains of all but the top MaxRealVoices silent. The mixer can then
+ * fade them out and leave them virtual until they rank high enough again.
+ */
+static void LimitRealVoices(ALCcontext *ctx)
+{
+    const ALsizei num_sends = ctx->Device->NumAuxSends;
+    VoiceRank *ranks = ctx->VoiceRanks;
+    VoiceBatch batch;
+    ALsizei count = 0;
+    ALsizei i, c, s;
+
+    for(i = 0;i < ctx->VoiceCount;i++)
+    {
+        ALvoice *voice = ctx->Voices[i];
+        if(!ATOMIC_LOAD(&voice->Source, almemory_order_relaxed) ||
+           !ATOMIC_LOAD(&voice->Playing, almemory_order_relaxed) || voice->Step < 1)
+            continue;
+
+        ranks[count].Score = voice->Props->Priority * voice->Audibility;
+        ranks[count].Index = i;
+        count++;
+    }
+
+    if(count > ctx->MaxRealVoices)
+        SelectTopRanks(ranks, count, ctx->MaxRealVoices);
+
+    batch.NumWorld = 0;
+    batch.NumRelative = 0;
+    for(i = 0;i < count;i++)
+    {
+        ALvoice *voice = ctx->Voices[ranks[i].Index];
+
+        if(i < ctx->MaxRealVoices)
+        {
+            if((voice->Flags&VOICE_IS_DEMOTED))
+            {
+                voice->Flags &= ~VOICE_IS_DEMOTED;
+                voice->Flags |= VOICE_NEEDS_UPDATE;
+                CalcSourceParams(voice, ctx, 0, &batch);
+            }
+            continue;
+        }
+
+        /* Only need to silence the targets if they were recalculated since
+         * the voice was demoted.
+         */
+        if((voice->Flags&VOICE_IS_DEMOTED) && (voice->Flags&VOICE_IS_SILENT))
+            continue;
+        voice->Flags |= VOICE_IS_DEMOTED | VOICE_IS_SILENT;
+
+        for(c = 0;c < voice->NumChannels;c++)
+        {
+            DirectParams *parms = &voice->Direct.Params[c];
+
+            memset(parms->Gains.Target, 0, sizeof(parms->Gains.Target));
+            parms->Gains.TargetMask = 0;
+            parms->Hrtf.Target.Gain = 0.0f;
+            for(s = 0;s < num_sends;s++)
+            {
+                memset(voice->Send[s].Params[c].Gains.Target, 0,
+                       sizeof(voice->Send[s].Params[c].Gains.Target));
+                voice->Send[s].Params[c].Gains.TargetMask = 0;
+            }
+        }
+    }
+    CalcVoiceBatchParams(&batch, ctx);
+}
+
+/* Voices with their own HRTF filters keep them unless another voice outranks
+ * them by this much, so similar voices don't keep trading places.
+ */
+#define HRTF_HYBRID_HOLD_SCALE 1.5f
+
+/* Ranks the playing voices by their priority-scaled direct gain for hybrid
+ * HRTF rendering, with the top HrtfDirectVoices getting their own HRTF
+ * filters and the rest mixed to the ambisonic buffer. Voices that are already
+ * playing fade out for one update before switching, then fade back in.
+ */
+static void RankHrtfVoices(ALCcontext *ctx)
+{
+    const ALsizei num_sends = ctx->Device->NumAuxSends;
+    const ALsizei limit = ctx->Device->HrtfDirectVoices;
+    VoiceRank *ranks = ctx->VoiceRanks;
+    VoiceBatch batch;
+    ALsizei count = 0;
+    ALsizei i, c, s;
+
+    for(i = 0;i < ctx->VoiceCount;i++)
+    {
+        ALvoice *voice = ctx->Voices[i];
+        if(!ATOMIC_LOAD(&voice->Source, almemory_order_relaxed) ||
+           !ATOMIC_LOAD(&voice->Playing, almemory_order_relaxed) || voice->Step < 1 ||
+           (voice->Flags&VOICE_IS_DEMOTED))
+            continue;
+
+        ranks[count].Score = voice->Props->Priority * voice->DirectGain;
+        if((voice->Flags&VOICE_HRTF_DIRECT))
+            ranks[count].Score *= HRTF_HYBRID_HOLD_SCALE;
+        ranks[count].Index = i;
+        count++;
+    }
+
+    if(count > limit)
+        SelectTopRanks(ranks, count, limit);
+
+    batch.NumWorld = 0;
+    batch.NumRelative = 0;
+    for(i = 0;i < count;i++)
+    {
+        ALvoice *voice = ctx->Voices[ranks[i].Index];
+        const bool direct = i < limit && ranks[i].Score > GAIN_SILENCE_THRESHOLD;
+
+        if(!(voice->Flags&VOICE_HRTF_SWITCHING))
+        {
+            if(direct == !!(voice->Flags&VOICE_HRTF_DIRECT))
+                continue;
+
+            /* A voice that's audible needs to fade out first. */
+            if((voice->Flags&VOICE_IS_FADING) && !(voice->Flags&VOICE_IS_VIRTUAL))
+            {
+                voice->Flags |= VOICE_HRTF_SWITCHING | VOICE_IS_SILENT;
+                for(c = 0;c < voice->NumChannels;c++)
+                {
+                    DirectParams *parms = &voice->Direct.Params[c];
+
+                    memset(parms->Gains.Target, 0, sizeof(parms->Gains.Target));
+                    parms->Gains.TargetMask = 0;
+                    parms->Hrtf.Target.Gain = 0.0f;
+                    for(s = 0;s < num_sends;s++)
+                    {
+                        memset(voice->Send[s].Params[c].Gains.Target, 0,
+                               sizeof(voice->Send[s].Params[c].Gains.Target));
+                        voice->Send[s].Params[c].Gains.TargetMask = 0;
+                    }
+                }
+                continue;
+            }
+        }
+
+        /* Switch once faded out. If the rank changed back in the meantime, the
+         * targets still need restoring.
+         */
+        voice->Flags &= ~(VOICE_HRTF_SWITCHING | VOICE_HRTF_DIRECT);
+        if(direct) voice->Flags |= VOICE_HRTF_DIRECT;
+        voice->Flags |= VOICE_NEEDS_UPDATE;
+        CalcSourceParams(voice, ctx, 0, &batch);
+    }
+    CalcVoiceBatchParams(&batch, ctx);
+}
+
 static void ProcessParamUpdates(ALCcontext *ctx, const struct ALeffectslotArray *slots)
 {
     ALvoice **voice, **voice_end;
     ALsource *source;
+    VoiceBatch batch;
     ALsizei i;
 
     IncrementRef(&ctx->UpdateCount);
     if(!ATOMIC_LOAD(&ctx->HoldUpdates, almemory_order_acquire))
     {
-        bool cforce = CalcContextParams(ctx);
-        bool force = CalcListenerParams(ctx) | cforce;
+        ALuint changes = CalcContextParams(ctx);
+        bool cforce = changes != 0;
+        changes |= CalcListenerParams(ctx);
         for(i = 0;i < slots->count;i++)
-            force |= CalcEffectSlotParams(slots->slot[i], ctx, cforce);
+        {
+            if(CalcEffectSlotParams(slots->slot[i], ctx, cforce))
+                changes |= LISTENER_CHANGED_SLOTS;
+        }
 
+        batch.NumWorld = 0;
+        batch.NumRelative = 0;
         voice = ctx->Voices;
         voice_end = voice + ctx->VoiceCount;
         for(;voice != voice_end;++voice)
         {
             source = ATOMIC_LOAD(&(*voice)->Source, almemory_order_acquire);
-            if(source) CalcSourceParams(*voice, ctx, force);
+            if(source) CalcSourceParams(*voice, ctx, changes, &batch);
         }
+        CalcVoiceBatchParams(&batch, ctx);
     }
     IncrementRef(&ctx->UpdateCount);
 }
 
 
-static void ApplyStablizer(FrontStablizer *Stablizer, ALfloat (*restrict Buffer)[BUFFERSIZE],
+static void ApplyStablizer(FrontStablizer *Stablizer, ALfloat *const *restrict Buffer,
                            int lidx, int ridx, int cidx, ALsizei SamplesToDo,
                            ALsizei NumChannels)
 {
-    ALfloat (*restrict lsplit)[BUFFERSIZE] = ASSUME_ALIGNED(Stablizer->LSplit, 16);
-    ALfloat (*restrict rsplit)[BUFFERSIZE] = ASSUME_ALIGNED(Stablizer->RSplit, 16);
+    ALfloat *const *restrict lsplit = Stablizer->LSplit;
+    ALfloat *const *restrict rsplit = Stablizer->RSplit;
     ALsizei i;
 
     /* Apply an all-pass to all channels, except the front-left and front-
@@ -1656,7 +2420,7 @@ static void ApplyStablizer(FrontStablizer *Stablizer, ALfloat (*restrict Buffer)
     }
 }
 
-static void ApplyDistanceComp(ALfloat (*restrict Samples)[BUFFERSIZE], DistanceComp *distcomp,
+static void ApplyDistanceComp(ALfloat *const *restrict Samples, DistanceComp *distcomp,
                               ALfloat *restrict Values, ALsizei SamplesToDo, ALsizei numchans)
 {
     ALsizei i, c;
@@ -1699,7 +2463,7 @@ static void ApplyDistanceComp(ALfloat (*restrict Samples)[BUFFERSIZE], DistanceC
     }
 }
 
-static void ApplyDither(ALfloat (*restrict Samples)[BUFFERSIZE], ALuint *dither_seed,
+static void ApplyDither(ALfloat *const *restrict Samples, ALuint *dither_seed,
                         const ALfloat quant_scale, const ALsizei SamplesToDo,
                         const ALsizei numchans)
 {
@@ -1753,7 +2517,7 @@ DECL_TEMPLATE(ALuint, Conv_ALint, 2147483648u)
 #undef DECL_TEMPLATE
 
 #define DECL_TEMPLATE(T, A)                                                   \
-static void Write##A(const ALfloat (*restrict InBuffer)[BUFFERSIZE],          \
+static void Write##A(ALfloat *const *restrict InBuffer,                      \
                      ALvoid *OutBuffer, ALsizei Offset, ALsizei SamplesToDo,  \
                      ALsizei numchans)                                        \
 {                                                                             \
@@ -1779,8 +2543,489 @@ DECL_TEMPLATE(ALbyte, I8)
 #undef DECL_TEMPLATE
 
 
+/* A thread for mixing a share of a context's voices, and processing a share of
+ * its effect slots. Each worker gets its own scratch space and output buffers,
+ * so they can mix without synchronizing with one another.
+ */
+typedef struct MixWorker {
+    struct MixThreadPool *Pool;
+    ALsizei Index;
+
+    althrd_t Thread;
+    alsem_t Start;
+
+    /* Private copies of the device's mix buffers and the active effect slots'
+     * wet buffers, added into the originals once all voices are mixed or all
+     * effect slots are processed. There are wet buffers for the pool's
+     * MaxSlots, so they never need to grow while mixing.
+     */
+    ALfloat **MixBuffer;
+    ALfloat **WetBuffers;
+
+    ALfloat **TempBuffer;
+} MixWorker;
+
+struct MixThreadPool {
+    ALCdevice *Device;
+
+    /* Number of channels in the device's mix buffer storage. */
+    ALsizei NumMixChannels;
+
+    /* Minimum number of playing voices before the workers are used. */
+    ALsizei MinVoices;
+
+    /* Most effect slots a context can have active, including its default
+     * slot.
+     */
+    ALsizei MaxSlots;
+
+    ATOMIC(int) killNow;
+    alsem_t Done;
+
+    /* Parameters for the current mix, and the task the workers run for it. */
+    ALCcontext *Context;
+    const struct ALeffectslotArray *Slots;
+    ALsizei SamplesToDo;
+    void (*Task)(struct MixThreadPool *pool, MixWorker *worker);
+
+    /* The effect slots to process for the current mix, with room for
+     * MaxSlots.
+     */
+    ALeffectslot **ProcSlots;
+    ALsizei NumProcSlots;
+
+    ALsizei NumWorkers;
+    MixWorker Workers[];
+};
+
+/* Mixes every step'th voice of the context, starting with the given one. The
+ * results are left in the voices for SendVoiceEvents.
+ */
+static void MixContextVoices(ALCcontext *ctx, ALsizei first, ALsizei step, ALsizei SamplesToDo,
+                             const VoiceMixBuffers *buffers)
+{
+    ALsizei i;
+
+    for(i = first;i < ctx->VoiceCount;i += step)
+    {
+        ALvoice *voice = ctx->Voices[i];
+        ALsource *source = ATOMIC_LOAD(&voice->Source, almemory_order_acquire);
+        if(source && ATOMIC_LOAD(&voice->Playing, almemory_order_relaxed) &&
+           voice->Step > 0)
+        {
+            voice->Stopped = !MixSource(voice, ctx, SamplesToDo, buffers);
+            voice->Mixed = true;
+        }
+    }
+}
+
+/* Marks the effect slots fed by the voices that were just mixed. Only the fed
+ * slots have input to process, and need their wet buffers cleared before the
+ * next mix.
+ */
+static void UpdateSlotInputs(ALCcontext *ctx, const struct ALeffectslotArray *auxslots,
+                             ALsizei SamplesToDo)
+{
+    const ALsizei NumSends = ctx->Device->NumAuxSends;
+    ALsizei i, s, j;
+
+    for(i = 0;i < ctx->VoiceCount;i++)
+    {
+        ALvoice *voice = ctx->Voices[i];
+        if(!voice->Mixed) continue;
+        voice->Mixed = false;
+
+        for(s = 0;s < NumSends;s++)
+        {
+            ALfloat **buffer = voice->Send[s].Buffer;
+            if(!buffer) continue;
+
+            for(j = 0;j < auxslots->count;j++)
+            {
+                ALeffectslot *slot = auxslots->slot[j];
+                if(slot->WetBuffer == buffer)
+                {
+                    slot->InputActive = AL_TRUE;
+                    slot->WetSamples = SamplesToDo;
+                    break;
+                }
+            }
+        }
+    }
+}
+
+static void SendVoiceEvents(ALCcontext *ctx)
+{
+    ALsizei i;
+
+    for(i = 0;i < ctx->VoiceCount;i++)
+    {
+        ALvoice *voice = ctx->Voices[i];
+        ALsource *source = ATOMIC_LOAD(&voice->Source, almemory_order_relaxed);
+        if(!source) continue;
+
+        if(voice->BuffersDone > 0)
+        {
+            SendBufferCompletedEvent(ctx, source->id, voice->BuffersDone);
+            voice->BuffersDone = 0;
+        }
+        if(voice->Stopped)
+        {
+            ATOMIC_STORE(&voice->Source, NULL, almemory_order_relaxed);
+            ATOMIC_STORE(&voice->Playing, false, almemory_order_release);
+            SendSourceStoppedEvent(ctx, source->id);
+            voice->Stopped = false;
+        }
+    }
+}
+
+static ALsizei CountPlayingVoices(const ALCcontext *ctx, ALsizei limit)
+{
+    ALsizei count = 0;
+    ALsizei i;
+
+    for(i = 0;i < ctx->VoiceCount && count < limit;i++)
+    {
+        ALvoice *voice = ctx->Voices[i];
+        if(ATOMIC_LOAD(&voice->Source, almemory_order_relaxed) &&
+           ATOMIC_LOAD(&voice->Playing, almemory_order_relaxed))
+            count++;
+    }
+    return count;
+}
+
+static void MixWorkerVoices(struct MixThreadPool *pool, MixWorker *worker)
+{
+    const struct ALeffectslotArray *auxslots = pool->Slots;
+    const ALsizei SamplesToDo = pool->SamplesToDo;
+    VoiceMixBuffers buffers;
+    ALsizei i, c;
+
+    for(c = 0;c < pool->NumMixChannels;c++)
+        memset(worker->MixBuffer[c], 0, SamplesToDo*sizeof(ALfloat));
+    for(i = 0;i < auxslots->count;i++)
+    {
+        ALfloat **wetbuffer = worker->WetBuffers + i*MAX_EFFECT_CHANNELS;
+        for(c = 0;c < auxslots->slot[i]->NumChannels;c++)
+            memset(wetbuffer[c], 0, SamplesToDo*sizeof(ALfloat));
+    }
+
+    buffers.TempBuffer = worker->TempBuffer;
+    buffers.MixBuffer = worker->MixBuffer;
+    buffers.Slots = auxslots;
+    buffers.WetBuffers = worker->WetBuffers;
+    MixContextVoices(pool->Context, worker->Index, pool->NumWorkers+1, SamplesToDo, &buffers);
+}
+
+static int MixWorkerProc(void *arg)
+{
+    MixWorker *worker = arg;
+    struct MixThreadPool *pool = worker->Pool;
+    FPUCtl oldMode;
+
+    SetRTPriority();
+    althrd_setname(althrd_current(), MIXER_WORKER_THREAD_NAME);
+
+    SetMixerFPUMode(&oldMode);
+    while(1)
+    {
+        if(alsem_wait(&worker->Start) != althrd_success)
+            continue;
+        if(ATOMIC_LOAD(&pool->killNow, almemory_order_acquire))
+            break;
+
+        pool->Task(pool, worker);
+        alsem_post(&pool->Done);
+    }
+    RestoreFPUMode(&oldMode);
+
+    return 0;
+}
+
+/* Splits the context's voices between the mixer thread and the workers.
+ * Voices are handed out in a fixed order, and the workers' output is added in
+ * a fixed order, so the result only depends on the number of threads.
+ */
+static ALboolean MixVoicesThreaded(struct MixThreadPool *pool, ALCcontext *ctx,
+                                   const struct ALeffectslotArray *auxslots,
+                                   ALsizei SamplesToDo)
+{
+    ALCdevice *device = pool->Device;
+    VoiceMixBuffers buffers;
+    ALsizei i, c, w, j;
+
+    if(auxslots->count > pool->MaxSlots)
+        return AL_FALSE;
+
+    pool->Context = ctx;
+    pool->Slots = auxslots;
+    pool->SamplesToDo = SamplesToDo;
+    pool->Task = MixWorkerVoices;
+    for(w = 0;w < pool->NumWorkers;w++)
+        alsem_post(&pool->Workers[w].Start);
+
+    buffers.TempBuffer = device->TempBuffer;
+    buffers.MixBuffer = NULL;
+    buffers.Slots = NULL;
+    buffers.WetBuffers = NULL;
+    MixContextVoices(ctx, 0, pool->NumWorkers+1, SamplesToDo, &buffers);
+
+    for(w = 0;w < pool->NumWorkers;)
+    {
+        if(alsem_wait(&pool->Done) == althrd_success)
+            w++;
+    }
+    UpdateSlotInputs(ctx, auxslots, SamplesToDo);
+
+    for(w = 0;w < pool->NumWorkers;w++)
+    {
+        const MixWorker *worker = &pool->Workers[w];
+
+        for(c = 0;c < pool->NumMixChannels;c++)
+        {
+            ALfloat *restrict dst = device->Dry.Buffer[c];
+            const ALfloat *restrict src = worker->MixBuffer[c];
+            for(j = 0;j < SamplesToDo;j++)
+                dst[j] += src[j];
+        }
+        for(i = 0;i < auxslots->count;i++)
+        {
+            ALeffectslot *slot = auxslots->slot[i];
+            if(!slot->InputActive) continue;
+            for(c = 0;c < slot->NumChannels;c++)
+            {
+                ALfloat *restrict dst = slot->WetBuffer[c];
+                const ALfloat *restrict src = worker->WetBuffers[i*MAX_EFFECT_CHANNELS + c];
+                for(j = 0;j < SamplesToDo;j++)
+                    dst[j] += src[j];
+            }
+        }
+    }
+
+    return AL_TRUE;
+}
+
+/* Updates the slot's input tracking for the current mix, returning whether its
+ * effect needs processing. Slots without input keep processing silence until
+ * the effect's tail plays out, then go dormant until fed again.
+ */
+static ALboolean UpdateSlotTail(ALeffectslot *slot, ALsizei SamplesToDo)
+{
+    if(slot->InputActive)
+        slot->TailRemaining = slot->Params.EffectState->TailLength;
+    else if(slot->TailRemaining > 0)
+        slot->TailRemaining = maxi(slot->TailRemaining-SamplesToDo, 0);
+    else
+        return AL_FALSE;
+    return AL_TRUE;
+}
+
+static void ProcessWorkerSlots(struct MixThreadPool *pool, MixWorker *worker)
+{
+    const ALCdevice *device = pool->Device;
+    const ALsizei SamplesToDo = pool->SamplesToDo;
+    ALsizei i, c;
+
+    for(c = 0;c < pool->NumMixChannels;c++)
+        memset(worker->MixBuffer[c], 0, SamplesToDo*sizeof(ALfloat));
+
+    for(i = worker->Index;i < pool->NumProcSlots;i += pool->NumWorkers+1)
+    {
+        const ALeffectslot *slot = pool->ProcSlots[i];
+        ALeffectState *state = slot->Params.EffectState;
+        ALfloat **OutBuffer = NULL;
+
+        if(state->OutBuffer)
+            OutBuffer = worker->MixBuffer + (state->OutBuffer - device->Dry.Buffer);
+        V(state,process)(SamplesToDo, slot->WetBuffer, OutBuffer, state->OutChannels);
+    }
+}
+
+/* Splits the effect slots that need processing between the mixer thread and
+ * the workers. As with the voices, slots are handed out in a fixed order and
+ * the workers' output is added in a fixed order, so the result only depends on
+ * the number of threads.
+ */
+static ALboolean ProcessSlotsThreaded(struct MixThreadPool *pool,
+                                      const struct ALeffectslotArray *auxslots,
+                                      ALsizei SamplesToDo)
+{
+    ALCdevice *device = pool->Device;
+    ALsizei i, c, w, j;
+    ALsizei count;
+
+    if(auxslots->count > pool->MaxSlots)
+        return AL_FALSE;
+
+    count = 0;
+    for(i = 0;i < auxslots->count;i++)
+    {
+        ALeffectslot *slot = auxslots->slot[i];
+        if(UpdateSlotTail(slot, SamplesToDo))
+            pool->ProcSlots[count++] = slot;
+    }
+    pool->NumProcSlots = count;
+    pool->SamplesToDo = SamplesToDo;
+
+    /* Only wake the workers that have a slot to process. */
+    pool->Task = ProcessWorkerSlots;
+    count = mini(pool->NumWorkers, count-1);
+    for(w = 0;w < count;w++)
+        alsem_post(&pool->Workers[w].Start);
+
+    for(i = 0;i < pool->NumProcSlots;i += pool->NumWorkers+1)
+    {
+        const ALeffectslot *slot = pool->ProcSlots[i];
+        ALeffectState *state = slot->Params.EffectState;
+        V(state,process)(SamplesToDo, slot->WetBuffer, state->OutBuffer, state->OutChannels);
+    }
+
+    for(w = 0;w < count;)
+    {
+        if(alsem_wait(&pool->Done) == althrd_success)
+            w++;
+    }
+
+    for(w = 0;w < count;w++)
+    {
+        const MixWorker *worker = &pool->Workers[w];
+        for(c = 0;c < pool->NumMixChannels;c++)
+        {
+            ALfloat *restrict dst = device->Dry.Buffer[c];
+            const ALfloat *restrict src = worker->MixBuffer[c];
+            for(j = 0;j < SamplesToDo;j++)
+                dst[j] += src[j];
+        }
+    }
+
+    return AL_TRUE;
+}
+
+void aluInitMixThreads(ALCdevice *device, ALsizei num_threads, ALsizei min_voices)
+{
+    struct MixThreadPool *pool;
+    ALsizei num_chans;
+    ALsizei i;
+
+    aluDeinitMixThreads(device);
+    if(num_threads < 2)
+        return;
+
+    /* FOAOut and RealOut are allocated after Dry, but may alias it. */
+    num_chans = device->Dry.NumChannels;
+    num_chans = maxi(num_chans, (ALsizei)(device->FOAOut.Buffer - device->Dry.Buffer) +
+                                device->FOAOut.NumChannels);
+    num_chans = maxi(num_chans, (ALsizei)(device->RealOut.Buffer - device->Dry.Buffer) +
+                                device->RealOut.NumChannels);
+
+    pool = al_calloc(16, FAM_SIZE(struct MixThreadPool, Workers, num_threads-1));
+    if(!pool)
+    {
+        ERR("Failed to allocate mixing thread pool\n");
+        return;
+    }
+    pool->Device = device;
+    pool->NumMixChannels = num_chans;
+    pool->MinVoices = min_voices;
+    pool->MaxSlots = (ALsizei)minu(device->AuxiliaryEffectSlotMax,
+                                   INT_MAX/MAX_EFFECT_CHANNELS - 1) + 1;
+    ATOMIC_INIT(&pool->killNow, AL_FALSE);
+    pool->ProcSlots = al_calloc(DEF_ALIGN, pool->MaxSlots*sizeof(pool->ProcSlots[0]));
+    if(!pool->ProcSlots)
+    {
+        ERR("Failed to allocate mixing thread slot list\n");
+        al_free(pool);
+        return;
+    }
+    if(alsem_init(&pool->Done, 0) != althrd_success)
+    {
+        ERR("Failed to create mixing thread semaphore\n");
+        al_free(pool->ProcSlots);
+        al_free(pool);
+        return;
+    }
+
+    for(i = 0;i < num_threads-1;i++)
+    {
+        MixWorker *worker = &pool->Workers[i];
+
+        worker->Pool = pool;
+        worker->Index = i+1;
+        worker->MixBuffer = aluAllocBufferLines(num_chans, device->MixQuantum);
+        worker->WetBuffers = aluAllocBufferLines(pool->MaxSlots*MAX_EFFECT_CHANNELS,
+                                                 device->MixQuantum);
+        worker->TempBuffer = aluAllocBufferLines(NUM_TEMP_BUFFERS,
+                                                 maxi(device->MixQuantum, BUFFERSIZE));
+        if(!worker->MixBuffer || !worker->WetBuffers || !worker->TempBuffer)
+        {
+            al_free(worker->MixBuffer);
+            al_free(worker->WetBuffers);
+            al_free(worker->TempBuffer);
+            break;
+        }
+        if(alsem_init(&worker->Start, 0) != althrd_success)
+        {
+            al_free(worker->MixBuffer);
+            al_free(worker->WetBuffers);
+            al_free(worker->TempBuffer);
+            break;
+        }
+        if(althrd_create(&worker->Thread, MixWorkerProc, worker) != althrd_success)
+        {
+            alsem_destroy(&worker->Start);
+            al_free(worker->MixBuffer);
+            al_free(worker->WetBuffers);
+            al_free(worker->TempBuffer);
+            break;
+        }
+        pool->NumWorkers++;
+    }
+
+    if(pool->NumWorkers == 0)
+    {
+        ERR("Failed to start mixing threads\n");
+        alsem_destroy(&pool->Done);
+        al_free(pool->ProcSlots);
+        al_free(pool);
+        return;
+    }
+
+    TRACE("Mixing with %d threads for %d or more voices\n", pool->NumWorkers+1,
+          pool->MinVoices);
+    device->MixThreads = pool;
+}
+
+void aluDeinitMixThreads(ALCdevice *device)
+{
+    struct MixThreadPool *pool = device->MixThreads;
+    ALsizei i;
+
+    if(!pool) return;
+    device->MixThreads = NULL;
+
+    ATOMIC_STORE(&pool->killNow, AL_TRUE, almemory_order_release);
+    for(i = 0;i < pool->NumWorkers;i++)
+        alsem_post(&pool->Workers[i].Start);
+    for(i = 0;i < pool->NumWorkers;i++)
+    {
+        MixWorker *worker = &pool->Workers[i];
+        int res;
+
+        althrd_join(worker->Thread, &res);
+        alsem_destroy(&worker->Start);
+        al_free(worker->MixBuffer);
+        al_free(worker->WetBuffers);
+        al_free(worker->TempBuffer);
+    }
+    alsem_destroy(&pool->Done);
+    al_free(pool->ProcSlots);
+    al_free(pool);
+}
+
+
 void aluMixData(ALCdevice *device, ALvoid *OutBuffer, ALsizei NumSamples)
 {
+    struct MixThreadPool *pool = device->MixThreads;
     ALsizei SamplesToDo;
     ALsizei SamplesDone;
     ALCcontext *ctx;
@@ -1789,7 +3034,7 @@ void aluMixData(ALCdevice *device, ALvoid *OutBuffer, ALsizei NumSamples)
     START_MIXER_MODE();
     for(SamplesDone = 0;SamplesDone < NumSamples;)
     {
-        SamplesToDo = mini(NumSamples-SamplesDone, BUFFERSIZE);
+        SamplesToDo = mini(NumSamples-SamplesDone, device->MixQuantum);
         for(c = 0;c < device->Dry.NumChannels;c++)
             memset(device->Dry.Buffer[c], 0, SamplesToDo*sizeof(ALfloat));
         if(device->Dry.Buffer != device->FOAOut.Buffer)
@@ -1808,38 +3053,53 @@ void aluMixData(ALCdevice *device, ALvoid *OutBuffer, ALsizei NumSamples)
 
             auxslots = ATOMIC_LOAD(&ctx->ActiveAuxSlots, almemory_order_acquire);
             ProcessParamUpdates(ctx, auxslots);
+            if(ctx->MaxRealVoices > 0)
+                LimitRealVoices(ctx);
+            if(device->HrtfDirectVoices > 0)
+                RankHrtfVoices(ctx);
 
+            /* Only clear the parts of the wet buffers voices wrote to. Slots
+             * without input keep silent buffers, and don't need clearing.
+             */
             for(i = 0;i < auxslots->count;i++)
             {
                 ALeffectslot *slot = auxslots->slot[i];
-                for(c = 0;c < slot->NumChannels;c++)
-                    memset(slot->WetBuffer[c], 0, SamplesToDo*sizeof(ALfloat));
+                if(slot->WetSamples > 0)
+                {
+                    for(c = 0;c < slot->NumChannels;c++)
+                        memset(slot->WetBuffer[c], 0, slot->WetSamples*sizeof(ALfloat));
+                    slot->WetSamples = 0;
+                }
+                slot->InputActive = AL_FALSE;
             }
 
             /* source processing */
-            for(i = 0;i < ctx->VoiceCount;i++)
+            if(!pool || CountPlayingVoices(ctx, pool->MinVoices) < pool->MinVoices ||
+               !MixVoicesThreaded(pool, ctx, auxslots, SamplesToDo))
             {
-                ALvoice *voice = ctx->Voices[i];
-                ALsource *source = ATOMIC_LOAD(&voice->Source, almemory_order_acquire);
-                if(source && ATOMIC_LOAD(&voice->Playing, almemory_order_relaxed) &&
-                   voice->Step > 0)
-                {
-                    if(!MixSource(voice, source->id, ctx, SamplesToDo))
-                    {
-                        ATOMIC_STORE(&voice->Source, NULL, almemory_order_relaxed);
-                        ATOMIC_STORE(&voice->Playing, false, almemory_order_release);
-                        SendSourceStoppedEvent(ctx, source->id);
-                    }
-                }
+                VoiceMixBuffers buffers;
+                buffers.TempBuffer = device->TempBuffer;
+                buffers.MixBuffer = NULL;
+                buffers.Slots = NULL;
+                buffers.WetBuffers = NULL;
+                MixContextVoices(ctx, 0, 1, SamplesToDo, &buffers);
+                UpdateSlotInputs(ctx, auxslots, SamplesToDo);
             }
+            SendVoiceEvents(ctx);
 
             /* effect slot processing */
-            for(i = 0;i < auxslots->count;i++)
+            if(!pool || auxslots->count < 2 ||
+               !ProcessSlotsThreaded(pool, auxslots, SamplesToDo))
             {
-                const ALeffectslot *slot = auxslots->slot[i];
-                ALeffectState *state = slot->Params.EffectState;
-                V(state,process)(SamplesToDo, slot->WetBuffer, state->OutBuffer,
-                                 state->OutChannels);
+                for(i = 0;i < auxslots->count;i++)
+                {
+                    ALeffectslot *slot = auxslots->slot[i];
+                    ALeffectState *state = slot->Params.EffectState;
+                    if(!UpdateSlotTail(slot, SamplesToDo))
+                        continue;
+                    V(state,process)(SamplesToDo, slot->WetBuffer, state->OutBuffer,
+                                     state->OutChannels);
+                }
             }
 
             ctx = ATOMIC_LOAD(&ctx->next, almemory_order_relaxed);
@@ -1884,7 +3144,7 @@ void aluMixData(ALCdevice *device, ALvoid *OutBuffer, ALsizei NumSamples)
 
         if(OutBuffer)
         {
-            ALfloat (*Buffer)[BUFFERSIZE] = device->RealOut.Buffer;
+            ALfloat **Buffer = device->RealOut.Buffer;
             ALsizei Channels = device->RealOut.NumChannels;
 
             switch(device->FmtType)
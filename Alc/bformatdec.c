@@ -201,12 +201,11 @@ typedef struct BFormatDec {
 
     BandSplitter XOver[MAX_AMBI_COEFFS];
 
-    ALfloat (*Samples)[BUFFERSIZE];
-    /* These two alias into Samples */
-    ALfloat (*SamplesHF)[BUFFERSIZE];
-    ALfloat (*SamplesLF)[BUFFERSIZE];
-
-    alignas(16) ALfloat ChannelMix[BUFFERSIZE];
+    ALfloat **Samples;
+    /* These three alias into Samples */
+    ALfloat **SamplesHF;
+    ALfloat **SamplesLF;
+    ALfloat *ChannelMix;
 
     struct {
         BandSplitter XOver;
@@ -230,13 +229,14 @@ void bformatdec_free(BFormatDec **dec)
         (*dec)->Samples = NULL;
         (*dec)->SamplesHF = NULL;
         (*dec)->SamplesLF = NULL;
+        (*dec)->ChannelMix = NULL;
 
         al_free(*dec);
         *dec = NULL;
     }
 }
 
-void bformatdec_reset(BFormatDec *dec, const AmbDecConf *conf, ALsizei chancount, ALuint srate, const ALsizei chanmap[MAX_OUTPUT_CHANNELS])
+void bformatdec_reset(BFormatDec *dec, const AmbDecConf *conf, ALsizei chancount, ALuint srate, ALsizei buflen, const ALsizei chanmap[MAX_OUTPUT_CHANNELS])
 {
     static const ALsizei map2DTo3D[MAX_AMBI2D_COEFFS] = {
         0,  1, 3,  4, 8,  9, 15
@@ -250,11 +250,13 @@ void bformatdec_reset(BFormatDec *dec, const AmbDecConf *conf, ALsizei chancount
     dec->Samples = NULL;
     dec->SamplesHF = NULL;
     dec->SamplesLF = NULL;
+    dec->ChannelMix = NULL;
 
     dec->NumChannels = chancount;
-    dec->Samples = al_calloc(16, dec->NumChannels*2 * sizeof(dec->Samples[0]));
+    dec->Samples = aluAllocBufferLines(dec->NumChannels*2 + 1, buflen);
     dec->SamplesHF = dec->Samples;
     dec->SamplesLF = dec->SamplesHF + dec->NumChannels;
+    dec->ChannelMix = dec->Samples[dec->NumChannels*2];
 
     dec->Enabled = 0;
     for(i = 0;i < conf->NumSpeakers;i++)
@@ -407,7 +409,7 @@ void bformatdec_reset(BFormatDec *dec, const AmbDecConf *conf, ALsizei chancount
 }
 
 
-void bformatdec_process(struct BFormatDec *dec, ALfloat (*restrict OutBuffer)[BUFFERSIZE], ALsizei OutChannels, const ALfloat (*restrict InSamples)[BUFFERSIZE], ALsizei SamplesToDo)
+void bformatdec_process(struct BFormatDec *dec, ALfloat *const *restrict OutBuffer, ALsizei OutChannels, ALfloat *const *restrict InSamples, ALsizei SamplesToDo)
 {
     ALsizei chan, i;
 
@@ -453,7 +455,7 @@ void bformatdec_process(struct BFormatDec *dec, ALfloat (*restrict OutBuffer)[BU
 }
 
 
-void bformatdec_upSample(struct BFormatDec *dec, ALfloat (*restrict OutBuffer)[BUFFERSIZE], const ALfloat (*restrict InSamples)[BUFFERSIZE], ALsizei InChannels, ALsizei SamplesToDo)
+void bformatdec_upSample(struct BFormatDec *dec, ALfloat *const *restrict OutBuffer, ALfloat *const *restrict InSamples, ALsizei InChannels, ALsizei SamplesToDo)
 {
     ALsizei i;
 
@@ -500,7 +502,10 @@ static ALsizei GetACNIndex(const BFChannelConfig *chans, ALsizei numchans, ALsiz
 #define GetChannelForACN(b, a) GetACNIndex((b).Ambi.Map, (b).NumChannels, (a))
 
 typedef struct AmbiUpsampler {
-    alignas(16) ALfloat Samples[NUM_BANDS][BUFFERSIZE];
+    /* The sample storage is a single block starting at Samples[0], sized for
+     * the device's mix quantum when reset.
+     */
+    ALfloat *Samples[NUM_BANDS];
 
     BandSplitter XOver[4];
 
@@ -514,8 +519,9 @@ AmbiUpsampler *ambiup_alloc()
 
 void ambiup_free(struct AmbiUpsampler **ambiup)
 {
-    if(ambiup)
+    if(ambiup && *ambiup)
     {
+        al_free((*ambiup)->Samples[0]);
         al_free(*ambiup);
         *ambiup = NULL;
     }
@@ -523,9 +529,15 @@ void ambiup_free(struct AmbiUpsampler **ambiup)
 
 void ambiup_reset(struct AmbiUpsampler *ambiup, const ALCdevice *device, ALfloat w_scale, ALfloat xyz_scale)
 {
+    const ALsizei stride = RoundUp(device->MixQuantum, 4);
     ALfloat ratio;
     ALsizei i;
 
+    al_free(ambiup->Samples[0]);
+    ambiup->Samples[0] = al_calloc(16, NUM_BANDS*stride*sizeof(ALfloat));
+    for(i = 1;i < NUM_BANDS;i++)
+        ambiup->Samples[i] = ambiup->Samples[0] + i*stride;
+
     ratio = 400.0f / (ALfloat)device->Frequency;
     for(i = 0;i < 4;i++)
         bandsplit_init(&ambiup->XOver[i], ratio);
@@ -576,7 +588,7 @@ void ambiup_reset(struct AmbiUpsampler *ambiup, const ALCdevice *device, ALfloat
     }
 }
 
-void ambiup_process(struct AmbiUpsampler *ambiup, ALfloat (*restrict OutBuffer)[BUFFERSIZE], ALsizei OutChannels, const ALfloat (*restrict InSamples)[BUFFERSIZE], ALsizei SamplesToDo)
+void ambiup_process(struct AmbiUpsampler *ambiup, ALfloat *const *restrict OutBuffer, ALsizei OutChannels, ALfloat *const *restrict InSamples, ALsizei SamplesToDo)
 {
     ALsizei i, j;
 
@@ -36,13 +36,13 @@ struct AmbiUpsampler;
 
 struct BFormatDec *bformatdec_alloc();
 void bformatdec_free(struct BFormatDec **dec);
-void bformatdec_reset(struct BFormatDec *dec, const struct AmbDecConf *conf, ALsizei chancount, ALuint srate, const ALsizei chanmap[MAX_OUTPUT_CHANNELS]);
+void bformatdec_reset(struct BFormatDec *dec, const struct AmbDecConf *conf, ALsizei chancount, ALuint srate, ALsizei buflen, const ALsizei chanmap[MAX_OUTPUT_CHANNELS]);
 
 /* Decodes the ambisonic input to the given output channels. */
-void bformatdec_process(struct BFormatDec *dec, ALfloat (*restrict OutBuffer)[BUFFERSIZE], ALsizei OutChannels, const ALfloat (*restrict InSamples)[BUFFERSIZE], ALsizei SamplesToDo);
+void bformatdec_process(struct BFormatDec *dec, ALfloat *const *restrict OutBuffer, ALsizei OutChannels, ALfloat *const *restrict InSamples, ALsizei SamplesToDo);
 
 /* Up-samples a first-order input to the decoder's configuration. */
-void bformatdec_upSample(struct BFormatDec *dec, ALfloat (*restrict OutBuffer)[BUFFERSIZE], const ALfloat (*restrict InSamples)[BUFFERSIZE], ALsizei InChannels, ALsizei SamplesToDo);
+void bformatdec_upSample(struct BFormatDec *dec, ALfloat *const *restrict OutBuffer, ALfloat *const *restrict InSamples, ALsizei InChannels, ALsizei SamplesToDo);
 
 
 /* Stand-alone first-order upsampler. Kept here because it shares some stuff
@@ -52,7 +52,7 @@ struct AmbiUpsampler *ambiup_alloc();
 void ambiup_free(struct AmbiUpsampler **ambiup);
 void ambiup_reset(struct AmbiUpsampler *ambiup, const ALCdevice *device, ALfloat w_scale, ALfloat xyz_scale);
 
-void ambiup_process(struct AmbiUpsampler *ambiup, ALfloat (*restrict OutBuffer)[BUFFERSIZE], ALsizei OutChannels, const ALfloat (*restrict InSamples)[BUFFERSIZE], ALsizei SamplesToDo);
+void ambiup_process(struct AmbiUpsampler *ambiup, ALfloat *const *restrict OutBuffer, ALsizei OutChannels, ALfloat *const *restrict InSamples, ALsizei SamplesToDo);
 
 
 /* Band splitter. Splits a signal into two phase-matching frequency bands. */
@@ -84,8 +84,9 @@ void splitterap_process(SplitterAllpass *splitter, ALfloat *restrict samples, AL
 typedef struct FrontStablizer {
     SplitterAllpass APFilter[MAX_OUTPUT_CHANNELS];
     BandSplitter LFilter, RFilter;
-    alignas(16) ALfloat LSplit[2][BUFFERSIZE];
-    alignas(16) ALfloat RSplit[2][BUFFERSIZE];
+    /* These point into storage allocated after the struct. */
+    ALfloat *LSplit[2];
+    ALfloat *RSplit[2];
 } FrontStablizer;
 
 #endif /* BFORMATDEC_H */
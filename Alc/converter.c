@@ -118,6 +118,28 @@ static void LoadSamples(ALfloat *dst, const ALvoid *src, ALint srcstep, enum Dev
 }
 
 
+void PrimeSampleConverter(SampleConverter *converter, const ALvoid **src, ALsizei *srcframes)
+{
+    const ALsizei toread = mini(*srcframes, MAX_RESAMPLE_PADDING);
+    ALsizei chan;
+
+    for(chan = 0;chan < converter->mNumChannels;chan++)
+    {
+        memset(converter->Chan[chan].mPrevSamples, 0,
+               sizeof(converter->Chan[chan].mPrevSamples));
+        LoadSamples(&converter->Chan[chan].mPrevSamples[MAX_RESAMPLE_PADDING],
+            (const ALbyte*)*src + converter->mSrcTypeSize*chan,
+            converter->mNumChannels, converter->mSrcType, toread
+        );
+    }
+    converter->mSrcPrepCount = MAX_RESAMPLE_PADDING*2;
+    converter->mFracOffset = 0;
+
+    *src = (const ALbyte*)*src + converter->mNumChannels*converter->mSrcTypeSize*toread;
+    *srcframes -= toread;
+}
+
+
 static inline ALbyte ALbyte_Sample(ALfloat val)
 { return fastf2i(clampf(val*128.0f, -128.0f, 127.0f)); }
 static inline ALubyte ALubyte_Sample(ALfloat val)
@@ -33,6 +33,13 @@ typedef struct SampleConverter {
 SampleConverter *CreateSampleConverter(enum DevFmtType srcType, enum DevFmtType dstType, ALsizei numchans, ALsizei srcRate, ALsizei dstRate);
 void DestroySampleConverter(SampleConverter **converter);
 
+/* Resets the converter's history to silence followed by the first input
+ * frames, so the first output sample lines up with the first input sample.
+ * Takes up to MAX_RESAMPLE_PADDING frames from src, with any shortfall being
+ * silence.
+ */
+void PrimeSampleConverter(SampleConverter *converter, const ALvoid **src, ALsizei *srcframes);
+
 ALsizei SampleConverterInput(SampleConverter *converter, const ALvoid **src, ALsizei *srcframes, ALvoid *dst, ALsizei dstframes);
 ALsizei SampleConverterAvailableOut(SampleConverter *converter, ALsizei srcframes);
 
@@ -65,8 +65,11 @@ typedef struct ALchorusState {
 
 static ALvoid ALchorusState_Destruct(ALchorusState *state);
 static ALboolean ALchorusState_deviceUpdate(ALchorusState *state, ALCdevice *Device);
+static DECLARE_FORWARD2(ALchorusState, ALeffectState, ALboolean, prepare, const ALCdevice*, const ALeffectProps*)
+static DECLARE_FORWARD2(ALchorusState, ALeffectState, ALboolean, setBuffer, const ALCdevice*, const struct ALbuffer*)
 static ALvoid ALchorusState_update(ALchorusState *state, const ALCcontext *Context, const ALeffectslot *Slot, const ALeffectProps *props);
-static ALvoid ALchorusState_process(ALchorusState *state, ALsizei SamplesToDo, const ALfloat (*restrict SamplesIn)[BUFFERSIZE], ALfloat (*restrict SamplesOut)[BUFFERSIZE], ALsizei NumChannels);
+static ALvoid ALchorusState_process(ALchorusState *state, ALsizei SamplesToDo, ALfloat *const *restrict SamplesIn, ALfloat *const *restrict SamplesOut, ALsizei NumChannels);
+static size_t ALchorusState_getMemorySize(ALchorusState *state);
 DECLARE_DEFAULT_ALLOCATORS(ALchorusState)
 
 DEFINE_ALEFFECTSTATE_VTABLE(ALchorusState);
@@ -146,6 +149,9 @@ static ALvoid ALchorusState_update(ALchorusState *state, const ALCcontext *Conte
                         (ALfloat)(state->delay - mindelay));
 
     state->feedback = props->Chorus.Feedback;
+    STATIC_CAST(ALeffectState,state)->TailLength = CalcFeedbackTailLength(
+        (state->delay+state->depth) / FRACTIONONE, state->feedback
+    );
 
     /* Gains for left and right sides */
     CalcAngleCoeffs(-F_PI_2, 0.0f, 0.0f, coeffs);
@@ -213,7 +219,7 @@ static void GetSinusoidDelays(ALint *restrict delays, ALsizei offset, const ALsi
 }
 
 
-static ALvoid ALchorusState_process(ALchorusState *state, ALsizei SamplesToDo, const ALfloat (*restrict SamplesIn)[BUFFERSIZE], ALfloat (*restrict SamplesOut)[BUFFERSIZE], ALsizei NumChannels)
+static ALvoid ALchorusState_process(ALchorusState *state, ALsizei SamplesToDo, ALfloat *const *restrict SamplesIn, ALfloat *const *restrict SamplesOut, ALsizei NumChannels)
 {
     const ALsizei bufmask = state->BufferLength-1;
     const ALfloat feedback = state->feedback;
@@ -284,6 +290,11 @@ static ALvoid ALchorusState_process(ALchorusState *state, ALsizei SamplesToDo, c
     state->offset = offset;
 }
 
+static size_t ALchorusState_getMemorySize(ALchorusState *state)
+{
+    return sizeof(*state) + state->BufferLength*sizeof(ALfloat);
+}
+
 
 typedef struct ChorusStateFactory {
     DERIVE_FROM_TYPE(EffectStateFactory);
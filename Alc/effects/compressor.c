@@ -42,8 +42,11 @@ typedef struct ALcompressorState {
 
 static ALvoid ALcompressorState_Destruct(ALcompressorState *state);
 static ALboolean ALcompressorState_deviceUpdate(ALcompressorState *state, ALCdevice *device);
+static DECLARE_FORWARD2(ALcompressorState, ALeffectState, ALboolean, prepare, const ALCdevice*, const ALeffectProps*)
+static DECLARE_FORWARD2(ALcompressorState, ALeffectState, ALboolean, setBuffer, const ALCdevice*, const struct ALbuffer*)
 static ALvoid ALcompressorState_update(ALcompressorState *state, const ALCcontext *context, const ALeffectslot *slot, const ALeffectProps *props);
-static ALvoid ALcompressorState_process(ALcompressorState *state, ALsizei SamplesToDo, const ALfloat (*restrict SamplesIn)[BUFFERSIZE], ALfloat (*restrict SamplesOut)[BUFFERSIZE], ALsizei NumChannels);
+static ALvoid ALcompressorState_process(ALcompressorState *state, ALsizei SamplesToDo, ALfloat *const *restrict SamplesIn, ALfloat *const *restrict SamplesOut, ALsizei NumChannels);
+static size_t ALcompressorState_getMemorySize(ALcompressorState *state);
 DECLARE_DEFAULT_ALLOCATORS(ALcompressorState)
 
 DEFINE_ALEFFECTSTATE_VTABLE(ALcompressorState);
@@ -90,7 +93,7 @@ static ALvoid ALcompressorState_update(ALcompressorState *state, const ALCcontex
                                slot->Params.Gain, state->Gain[i]);
 }
 
-static ALvoid ALcompressorState_process(ALcompressorState *state, ALsizei SamplesToDo, const ALfloat (*restrict SamplesIn)[BUFFERSIZE], ALfloat (*restrict SamplesOut)[BUFFERSIZE], ALsizei NumChannels)
+static ALvoid ALcompressorState_process(ALcompressorState *state, ALsizei SamplesToDo, ALfloat *const *restrict SamplesIn, ALfloat *const *restrict SamplesOut, ALsizei NumChannels)
 {
     ALsizei i, j, k;
     ALsizei base;
@@ -178,6 +181,11 @@ static ALvoid ALcompressorState_process(ALcompressorState *state, ALsizei Sample
     }
 }
 
+static size_t ALcompressorState_getMemorySize(ALcompressorState *state)
+{
+    return sizeof(*state);
+}
+
 
 typedef struct CompressorStateFactory {
     DERIVE_FROM_TYPE(EffectStateFactory);
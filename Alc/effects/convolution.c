@@ -0,0 +1,1093 @@
+/**
+ * OpenAL cross platform audio library
+ * Copyright (C) 2018 by Chris Robinson.
+ * This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Library General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ *  License along with this library; if not, write to the
+ *  Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ * Or go to http://www.gnu.org/copyleft/lgpl.html
+ */
+
+#include "config.h"
+
+#include <math.h>
+#include <stdlib.h>
+
+#include "alMain.h"
+#include "alAuxEffectSlot.h"
+#include "alBuffer.h"
+#include "alError.h"
+#include "alu.h"
+#include "converter.h"
+#include "fpu_modes.h"
+#include "threads.h"
+
+
+/* The impulse response is convolved in pieces of increasing size. The first
+ * HEAD_LENGTH taps are applied directly, so there's no added latency. The
+ * rest is split into segments, each using uniformly partitioned FFT
+ * convolution with its own block size. A segment can start no earlier than
+ * its block size, since a block's result is ready once the block's input is
+ * complete, so each segment starts where the previous one's block size
+ * allows.
+ *
+ * The first segment is processed on the mixer thread as its blocks complete.
+ * The larger segments each get their own helper thread, so a long block
+ * doesn't hold up a shorter segment's blocks, and start two blocks in, giving
+ * the helper a block's worth of time to finish each one. The mixer waits for
+ * the result if it's still needed by then, so the output doesn't depend on
+ * thread timing.
+ */
+#define HEAD_LENGTH   128
+#define NUM_SEGMENTS  3
+#define FIRST_ASYNC_SEGMENT 1
+
+static const ALsizei SegmentBlockSizes[NUM_SEGMENTS] = { HEAD_LENGTH, 1024, 8192 };
+
+/* Mono impulse responses play from the front, and stereo ones are split
+ * between the front-left and front-right. Other channel configurations only
+ * use their first channel.
+ */
+#define MAX_IR_CHANNELS  2
+
+/* Impulse responses are truncated to this many sample frames, after being
+ * resampled to the device rate.
+ */
+#define MAX_IR_LENGTH  (1<<24)
+
+
+typedef struct ConvSegment {
+    ALsizei BlockSize;
+    ALsizei NumParts;
+    ALsizei NumChannels;
+
+    /* The number of floats used for each half of a spectrum. The spectra of
+     * the 2*BlockSize real FFTs have BlockSize+1 bins, with the real and
+     * imaginary parts stored separately.
+     */
+    ALsizei BinStride;
+
+    /* Tables for the BlockSize-point complex FFT used for the real FFT, and
+     * for splitting its result.
+     */
+    ALsizei *BitReverse;
+    ALfloat *FFTCos, *FFTSin;
+    ALfloat *SplitCos, *SplitSin;
+
+    /* Spectra of the impulse response partitions for each channel, and of
+     * the most recent input frames (a frequency-domain delay line, where
+     * Newest is the spectrum of the latest frame).
+     */
+    ALfloat *Filter;
+    ALfloat *Spectra;
+    ALsizei Newest;
+
+    /* The time-domain input frame, holding the previous and current blocks,
+     * and working space.
+     */
+    ALfloat *Frame;
+    ALfloat *WorkRe, *WorkIm;
+    ALfloat *AccumRe, *AccumIm;
+
+    /* The block being filled by the mixer, the output for the next block
+     * written by the processing, and the output being read by the mixer.
+     */
+    ALfloat *Input;
+    ALfloat *Result;
+    ALfloat *Output;
+    ALsizei Pos;
+} ConvSegment;
+
+/* A single allocation holds an impulse response's processed filter, along
+ * with the history and buffers needed to convolve it. Filters are created off
+ * the mixer thread and passed to it, and replaced filters wait in a list
+ * until they're freed.
+ */
+typedef struct ConvFilter {
+    ALsizei NumChannels;
+    ALsizei Length;
+    ALsizei TailLength;
+    size_t Size;
+
+    /* The head taps, reversed, and the input history for them. */
+    alignas(16) ALfloat Head[MAX_IR_CHANNELS][HEAD_LENGTH];
+    alignas(16) ALfloat History[HEAD_LENGTH*2];
+
+    ConvSegment Segment[NUM_SEGMENTS];
+
+    ATOMIC(struct ConvFilter*) next;
+} ConvFilter;
+
+/* A helper thread processing one of the larger segments. The mixer queues the
+ * segment's block by setting it in Queued and waking the thread, which
+ * signals Done when the block's processed. Busy is the filter of a queued
+ * block the mixer hasn't waited on yet, if any.
+ */
+typedef struct ConvThread {
+    althrd_t Thread;
+    ALboolean Running;
+    ATOMIC(int) KillNow;
+    alsem_t Wake;
+    alsem_t Done;
+    ATOMIC(ConvSegment*) Queued;
+    const ConvFilter *Busy;
+} ConvThread;
+
+typedef struct ALconvolutionState {
+    DERIVE_FROM_TYPE(ALeffectState);
+
+    /* The current filter belongs to the mixer. A new one may be pending, and
+     * replaced ones wait in a list until they're freed off the mixer thread.
+     * Replaced filters stay with the mixer as retired until the helper threads
+     * finish any blocks of theirs.
+     */
+    ConvFilter *Filter;
+    ConvFilter *Retired;
+    ATOMIC(ConvFilter*) PendingFilter;
+    ATOMIC(ConvFilter*) FreeFilters;
+
+    /* The buffer the newest filter was made from, and the filter's size. Only
+     * accessed off the mixer thread.
+     */
+    const ALbuffer *Buffer;
+    size_t FilterSize;
+
+    /* The helper threads for the larger segments, indexed by segment. */
+    ConvThread Threads[NUM_SEGMENTS];
+
+    /* The panning gains for each impulse response channel. */
+    struct {
+        ALfloat Current[MAX_OUTPUT_CHANNELS];
+        ALfloat Target[MAX_OUTPUT_CHANNELS];
+    } Gains[MAX_IR_CHANNELS];
+} ALconvolutionState;
+
+static ALvoid ALconvolutionState_Destruct(ALconvolutionState *state);
+static ALboolean ALconvolutionState_deviceUpdate(ALconvolutionState *state, ALCdevice *device);
+static DECLARE_FORWARD2(ALconvolutionState, ALeffectState, ALboolean, prepare, const ALCdevice*, const ALeffectProps*)
+static ALboolean ALconvolutionState_setBuffer(ALconvolutionState *state, const ALCdevice *device, const struct ALbuffer *buffer);
+static ALvoid ALconvolutionState_update(ALconvolutionState *state, const ALCcontext *context, const ALeffectslot *slot, const ALeffectProps *props);
+static ALvoid ALconvolutionState_process(ALconvolutionState *state, ALsizei SamplesToDo, ALfloat *const *restrict SamplesIn, ALfloat *const *restrict SamplesOut, ALsizei NumChannels);
+static size_t ALconvolutionState_getMemorySize(ALconvolutionState *state);
+DECLARE_DEFAULT_ALLOCATORS(ALconvolutionState)
+
+DEFINE_ALEFFECTSTATE_VTABLE(ALconvolutionState);
+
+
+static void StopConvolutionThreads(ALconvolutionState *state);
+
+static void ALconvolutionState_Construct(ALconvolutionState *state)
+{
+    ALsizei i;
+
+    ALeffectState_Construct(STATIC_CAST(ALeffectState, state));
+    SET_VTABLE2(ALconvolutionState, ALeffectState, state);
+
+    state->Filter = NULL;
+    state->Retired = NULL;
+    ATOMIC_INIT(&state->PendingFilter, NULL);
+    ATOMIC_INIT(&state->FreeFilters, NULL);
+
+    state->Buffer = NULL;
+    state->FilterSize = 0;
+
+    for(i = 0;i < NUM_SEGMENTS;i++)
+    {
+        state->Threads[i].Running = AL_FALSE;
+        ATOMIC_INIT(&state->Threads[i].KillNow, AL_FALSE);
+        ATOMIC_INIT(&state->Threads[i].Queued, NULL);
+        state->Threads[i].Busy = NULL;
+    }
+
+    memset(state->Gains, 0, sizeof(state->Gains));
+}
+
+static void FreeConvFilterList(ConvFilter *filter)
+{
+    while(filter)
+    {
+        ConvFilter *next = ATOMIC_LOAD(&filter->next, almemory_order_relaxed);
+        al_free(filter);
+        filter = next;
+    }
+}
+
+static ALvoid ALconvolutionState_Destruct(ALconvolutionState *state)
+{
+    StopConvolutionThreads(state);
+
+    FreeConvFilterList(state->Retired);
+    state->Retired = NULL;
+    FreeConvFilterList(ATOMIC_EXCHANGE_PTR_SEQ(&state->PendingFilter, NULL));
+    FreeConvFilterList(ATOMIC_EXCHANGE_PTR_SEQ(&state->FreeFilters, NULL));
+    al_free(state->Filter);
+    state->Filter = NULL;
+
+    ALeffectState_Destruct(STATIC_CAST(ALeffectState,state));
+}
+
+
+/**************************************
+ *  FFT                               *
+ **************************************/
+
+/* Performs an in-place radix-2 FFT of the segment's block size, on input in
+ * bit-reversed order. A negative sign gives the inverse transform, which
+ * isn't scaled.
+ */
+static void ComplexFFT(const ConvSegment *seg, ALfloat *restrict re, ALfloat *restrict im,
+                       const ALfloat sign)
+{
+    const ALsizei size = seg->BlockSize;
+    ALsizei len, i, j;
+
+    for(len = 2;len <= size;len <<= 1)
+    {
+        const ALsizei half = len >> 1;
+        const ALsizei step = size / len;
+        for(i = 0;i < size;i += len)
+        {
+            for(j = 0;j < half;j++)
+            {
+                const ALfloat wr = seg->FFTCos[j*step];
+                const ALfloat wi = seg->FFTSin[j*step] * sign;
+                const ALsizei a = i + j;
+                const ALsizei b = a + half;
+                const ALfloat vr = re[b]*wr - im[b]*wi;
+                const ALfloat vi = re[b]*wi + im[b]*wr;
+
+                re[b] = re[a] - vr;
+                im[b] = im[a] - vi;
+                re[a] += vr;
+                im[a] += vi;
+            }
+        }
+    }
+}
+
+/* Calculates the BlockSize+1 bins of the spectrum of 2*BlockSize real
+ * samples. The even and odd samples are transformed together as one complex
+ * signal, and the result is split into the two halves of the spectrum.
+ */
+static void RealForwardFFT(const ConvSegment *seg, const ALfloat *restrict in,
+                           ALfloat *restrict outRe, ALfloat *restrict outIm)
+{
+    const ALsizei size = seg->BlockSize;
+    const ALsizei mask = size - 1;
+    ALfloat *restrict re = seg->WorkRe;
+    ALfloat *restrict im = seg->WorkIm;
+    ALsizei i;
+
+    for(i = 0;i < size;i++)
+    {
+        re[seg->BitReverse[i]] = in[i*2    ];
+        im[seg->BitReverse[i]] = in[i*2 + 1];
+    }
+    ComplexFFT(seg, re, im, 1.0f);
+
+    for(i = 0;i <= size;i++)
+    {
+        const ALsizei k1 = i & mask;
+        const ALsizei k2 = (size-i) & mask;
+        const ALfloat evenr = (re[k1] + re[k2]) * 0.5f;
+        const ALfloat eveni = (im[k1] - im[k2]) * 0.5f;
+        const ALfloat oddr  = (im[k1] + im[k2]) * 0.5f;
+        const ALfloat oddi  = (re[k2] - re[k1]) * 0.5f;
+
+        outRe[i] = evenr + seg->SplitCos[i]*oddr - seg->SplitSin[i]*oddi;
+        outIm[i] = eveni + seg->SplitCos[i]*oddi + seg->SplitSin[i]*oddr;
+    }
+}
+
+/* Inverts a spectrum from RealForwardFFT, leaving the 2*BlockSize samples
+ * interleaved in the segment's work buffers (even samples in WorkRe, odd in
+ * WorkIm), scaled by 2*BlockSize.
+ */
+static void RealInverseFFT(const ConvSegment *seg, const ALfloat *restrict inRe,
+                           const ALfloat *restrict inIm)
+{
+    const ALsizei size = seg->BlockSize;
+    ALfloat *restrict re = seg->WorkRe;
+    ALfloat *restrict im = seg->WorkIm;
+    ALsizei i;
+
+    for(i = 0;i < size;i++)
+    {
+        const ALsizei k2 = size - i;
+        const ALfloat evenr = inRe[i] + inRe[k2];
+        const ALfloat eveni = inIm[i] - inIm[k2];
+        const ALfloat diffr = inRe[i] - inRe[k2];
+        const ALfloat diffi = inIm[i] + inIm[k2];
+        const ALfloat oddr = diffr*seg->SplitCos[i] + diffi*seg->SplitSin[i];
+        const ALfloat oddi = diffi*seg->SplitCos[i] - diffr*seg->SplitSin[i];
+
+        re[seg->BitReverse[i]] = evenr - oddi;
+        im[seg->BitReverse[i]] = eveni + oddr;
+    }
+    ComplexFFT(seg, re, im, -1.0f);
+}
+
+static void ComplexMulAccum(ALfloat *restrict accRe, ALfloat *restrict accIm,
+                            const ALfloat *restrict aRe, const ALfloat *restrict aIm,
+                            const ALfloat *restrict bRe, const ALfloat *restrict bIm,
+                            const ALsizei count)
+{
+    ALsizei i;
+    for(i = 0;i < count;i++)
+    {
+        accRe[i] += aRe[i]*bRe[i] - aIm[i]*bIm[i];
+        accIm[i] += aRe[i]*bIm[i] + aIm[i]*bRe[i];
+    }
+}
+
+
+/**************************************
+ *  Segment Processing                *
+ **************************************/
+
+/* Convolves the segment's current input frame with its partitions, writing
+ * the last block of the result to the segment's Result buffer.
+ */
+static void ProcessSegment(ConvSegment *seg)
+{
+    const ALsizei size = seg->BlockSize;
+    const ALsizei stride = seg->BinStride;
+    ALfloat *spectrum;
+    ALsizei c, p, i;
+
+    seg->Newest = (seg->Newest ? seg->Newest : seg->NumParts) - 1;
+    spectrum = seg->Spectra + seg->Newest*stride*2;
+    RealForwardFFT(seg, seg->Frame, spectrum, spectrum+stride);
+
+    for(c = 0;c < seg->NumChannels;c++)
+    {
+        const ALfloat *filter = seg->Filter + c*seg->NumParts*stride*2;
+        ALfloat *restrict result = seg->Result + c*size;
+        ALsizei idx = seg->Newest;
+
+        /* Each partition applies to the input frame that many blocks old. */
+        memset(seg->AccumRe, 0, (size+1)*sizeof(ALfloat));
+        memset(seg->AccumIm, 0, (size+1)*sizeof(ALfloat));
+        for(p = 0;p < seg->NumParts;p++)
+        {
+            spectrum = seg->Spectra + idx*stride*2;
+            ComplexMulAccum(seg->AccumRe, seg->AccumIm, spectrum, spectrum+stride,
+                            filter, filter+stride, size+1);
+            filter += stride*2;
+            if(++idx == seg->NumParts) idx = 0;
+        }
+
+        /* The first block of the result wraps around, so only the last block
+         * is kept.
+         */
+        RealInverseFFT(seg, seg->AccumRe, seg->AccumIm);
+        for(i = size>>1;i < size;i++)
+        {
+            result[i*2 - size    ] = seg->WorkRe[i];
+            result[i*2 - size + 1] = seg->WorkIm[i];
+        }
+    }
+}
+
+static int ConvolutionThread(void *arg)
+{
+    ConvThread *thread = arg;
+    FPUCtl oldMode;
+
+    SetRTPriority();
+    althrd_setname(althrd_current(), CONVOLUTION_THREAD_NAME);
+
+    SetMixerFPUMode(&oldMode);
+    while(1)
+    {
+        ConvSegment *seg;
+
+        if(alsem_wait(&thread->Wake) != althrd_success)
+            continue;
+        if(ATOMIC_LOAD(&thread->KillNow, almemory_order_acquire))
+            break;
+
+        seg = ATOMIC_EXCHANGE_PTR(&thread->Queued, NULL, almemory_order_acquire);
+        if(!seg) continue;
+
+        ProcessSegment(seg);
+        alsem_post(&thread->Done);
+    }
+    RestoreFPUMode(&oldMode);
+
+    return 0;
+}
+
+/* Starts the helper threads needed by the filter layout's segments, leaving
+ * any already running.
+ */
+static ALboolean StartConvolutionThreads(ALconvolutionState *state, const ConvFilter *layout)
+{
+    ALsizei s;
+
+    for(s = FIRST_ASYNC_SEGMENT;s < NUM_SEGMENTS;s++)
+    {
+        ConvThread *thread = &state->Threads[s];
+
+        if(thread->Running || layout->Segment[s].NumParts == 0)
+            continue;
+
+        if(alsem_init(&thread->Wake, 0) != althrd_success)
+            goto error;
+        if(alsem_init(&thread->Done, 0) != althrd_success)
+        {
+            alsem_destroy(&thread->Wake);
+            goto error;
+        }
+
+        ATOMIC_STORE(&thread->KillNow, AL_FALSE, almemory_order_relaxed);
+        if(althrd_create(&thread->Thread, ConvolutionThread, thread) != althrd_success)
+        {
+            alsem_destroy(&thread->Done);
+            alsem_destroy(&thread->Wake);
+            goto error;
+        }
+        thread->Running = AL_TRUE;
+    }
+
+    return AL_TRUE;
+
+error:
+    ERR("Failed to start convolution thread\n");
+    return AL_FALSE;
+}
+
+static void StopConvolutionThreads(ALconvolutionState *state)
+{
+    ALsizei s;
+    int res;
+
+    for(s = FIRST_ASYNC_SEGMENT;s < NUM_SEGMENTS;s++)
+    {
+        ConvThread *thread = &state->Threads[s];
+
+        if(!thread->Running)
+            continue;
+        thread->Running = AL_FALSE;
+
+        ATOMIC_STORE(&thread->KillNow, AL_TRUE, almemory_order_release);
+        alsem_post(&thread->Wake);
+        althrd_join(thread->Thread, &res);
+
+        alsem_destroy(&thread->Done);
+        alsem_destroy(&thread->Wake);
+    }
+}
+
+/* Waits for a helper thread to finish the block queued by the mixer, if any. */
+static void WaitForThread(ConvThread *thread)
+{
+    if(thread->Busy)
+    {
+        while(alsem_wait(&thread->Done) != althrd_success)
+        {
+        }
+        thread->Busy = NULL;
+    }
+}
+
+/* Waits for the helper threads to finish any blocks queued by the mixer. */
+static void WaitForSegments(ALconvolutionState *state)
+{
+    ALsizei s;
+
+    for(s = FIRST_ASYNC_SEGMENT;s < NUM_SEGMENTS;s++)
+        WaitForThread(&state->Threads[s]);
+}
+
+/* Moves retired filters to the free list once the helper threads are done
+ * with them, checking on the threads without waiting.
+ */
+static void RetireFilters(ALconvolutionState *state)
+{
+    ConvFilter *filter, *next;
+    ALsizei s;
+
+    for(s = FIRST_ASYNC_SEGMENT;s < NUM_SEGMENTS;s++)
+    {
+        ConvThread *thread = &state->Threads[s];
+        if(thread->Busy && thread->Busy != state->Filter &&
+           alsem_trywait(&thread->Done) == althrd_success)
+            thread->Busy = NULL;
+    }
+
+    filter = state->Retired;
+    state->Retired = NULL;
+    while(filter)
+    {
+        next = ATOMIC_LOAD(&filter->next, almemory_order_relaxed);
+
+        for(s = FIRST_ASYNC_SEGMENT;s < NUM_SEGMENTS;s++)
+        {
+            if(state->Threads[s].Busy == filter)
+                break;
+        }
+        if(s < NUM_SEGMENTS)
+        {
+            ATOMIC_STORE(&filter->next, state->Retired, almemory_order_relaxed);
+            state->Retired = filter;
+        }
+        else
+            ATOMIC_REPLACE_HEAD(ConvFilter*, &state->FreeFilters, filter);
+        filter = next;
+    }
+}
+
+/* Handles a segment's completed input block on the mixer thread. */
+static void FinishSegmentBlock(ALconvolutionState *state, ConvSegment *seg, ALsizei s)
+{
+    const ALsizei size = seg->BlockSize;
+    ALfloat *output;
+
+    if(s >= FIRST_ASYNC_SEGMENT)
+    {
+        /* The helper thread's previous block becomes the output for the next
+         * one.
+         */
+        WaitForThread(&state->Threads[s]);
+        output = seg->Output;
+        seg->Output = seg->Result;
+        seg->Result = output;
+    }
+
+    memmove(seg->Frame, seg->Frame+size, size*sizeof(ALfloat));
+    memcpy(seg->Frame+size, seg->Input, size*sizeof(ALfloat));
+
+    if(s >= FIRST_ASYNC_SEGMENT)
+    {
+        ConvThread *thread = &state->Threads[s];
+
+        ATOMIC_STORE(&thread->Queued, seg, almemory_order_release);
+        thread->Busy = state->Filter;
+        alsem_post(&thread->Wake);
+    }
+    else
+    {
+        ProcessSegment(seg);
+        output = seg->Output;
+        seg->Output = seg->Result;
+        seg->Result = output;
+    }
+}
+
+
+/**************************************
+ *  Filter Creation                   *
+ **************************************/
+
+static void *CarveBuffer(char *base, size_t *offset, size_t size)
+{
+    void *ret = base ? base + *offset : NULL;
+    *offset += (size+15) & ~(size_t)15;
+    return ret;
+}
+
+/* Sets the segments' buffer pointers into the given base, or just calculates
+ * the size needed if it's NULL.
+ */
+static size_t LayoutFilter(ConvFilter *filter, char *base)
+{
+    const ALsizei numchans = filter->NumChannels;
+    size_t offset = (sizeof(*filter)+15) & ~(size_t)15;
+    ALsizei s;
+
+    for(s = 0;s < NUM_SEGMENTS;s++)
+    {
+        ConvSegment *seg = &filter->Segment[s];
+        const size_t size = seg->BlockSize;
+        const size_t stride = seg->BinStride;
+
+        if(seg->NumParts == 0)
+            continue;
+
+        seg->BitReverse = CarveBuffer(base, &offset, size*sizeof(ALsizei));
+        seg->FFTCos = CarveBuffer(base, &offset, size/2*sizeof(ALfloat));
+        seg->FFTSin = CarveBuffer(base, &offset, size/2*sizeof(ALfloat));
+        seg->SplitCos = CarveBuffer(base, &offset, (size+1)*sizeof(ALfloat));
+        seg->SplitSin = CarveBuffer(base, &offset, (size+1)*sizeof(ALfloat));
+
+        seg->Filter = CarveBuffer(base, &offset, numchans*seg->NumParts*stride*2*sizeof(ALfloat));
+        seg->Spectra = CarveBuffer(base, &offset, seg->NumParts*stride*2*sizeof(ALfloat));
+
+        seg->Frame = CarveBuffer(base, &offset, size*2*sizeof(ALfloat));
+        seg->WorkRe = CarveBuffer(base, &offset, size*sizeof(ALfloat));
+        seg->WorkIm = CarveBuffer(base, &offset, size*sizeof(ALfloat));
+        seg->AccumRe = CarveBuffer(base, &offset, stride*sizeof(ALfloat));
+        seg->AccumIm = CarveBuffer(base, &offset, stride*sizeof(ALfloat));
+
+        seg->Input = CarveBuffer(base, &offset, size*sizeof(ALfloat));
+        seg->Result = CarveBuffer(base, &offset, numchans*size*sizeof(ALfloat));
+        seg->Output = CarveBuffer(base, &offset, numchans*size*sizeof(ALfloat));
+    }
+
+    return offset;
+}
+
+static void InitSegmentTables(ConvSegment *seg)
+{
+    const ALsizei size = seg->BlockSize;
+    ALsizei bits = 0;
+    ALsizei i, j;
+
+    while((1<<bits) < size)
+        bits++;
+    for(i = 0;i < size;i++)
+    {
+        ALsizei rev = 0;
+        for(j = 0;j < bits;j++)
+            rev |= ((i>>j)&1) << (bits-1-j);
+        seg->BitReverse[i] = rev;
+    }
+
+    for(i = 0;i < size/2;i++)
+    {
+        const ALdouble w = (ALdouble)F_TAU * i / size;
+        seg->FFTCos[i] = (ALfloat)cos(w);
+        seg->FFTSin[i] = (ALfloat)-sin(w);
+    }
+    for(i = 0;i <= size;i++)
+    {
+        const ALdouble w = (ALdouble)F_PI * i / size;
+        seg->SplitCos[i] = (ALfloat)cos(w);
+        seg->SplitSin[i] = (ALfloat)-sin(w);
+    }
+}
+
+/* Loads the buffer's samples, resampled to the device rate, into an array of
+ * length samples for each used channel.
+ */
+static ALfloat *LoadImpulseResponse(const ALCdevice *device, const ALbuffer *buffer,
+                                    ALsizei *numchans, ALsizei *length)
+{
+    const ALsizei bufchans = ChannelsFromFmt(buffer->FmtChannels);
+    const ALsizei samplesize = BytesFromFmt(buffer->FmtType);
+    const ALbyte *data = buffer->data;
+    ALfloat *samples, *temp;
+    ALuint64 dstlen;
+    ALsizei c;
+
+    if(buffer->FmtChannels == FmtMono || buffer->FmtChannels == FmtStereo)
+        *numchans = bufchans;
+    else
+    {
+        WARN("Unsupported impulse response channel configuration, using the first channel\n");
+        *numchans = 1;
+    }
+
+    dstlen = (ALuint64)buffer->SampleLen * device->Frequency;
+    dstlen = (dstlen + buffer->Frequency-1) / buffer->Frequency;
+    if(dstlen > MAX_IR_LENGTH)
+    {
+        WARN("Truncating impulse response from "SZFMT" to %d samples\n", (size_t)dstlen,
+             MAX_IR_LENGTH);
+        dstlen = MAX_IR_LENGTH;
+    }
+    *length = (ALsizei)dstlen;
+
+    samples = al_calloc(16, (size_t)*numchans * *length * sizeof(ALfloat));
+    temp = al_calloc(16, buffer->SampleLen * sizeof(ALfloat));
+    if(!samples || !temp)
+        goto error;
+
+    for(c = 0;c < *numchans;c++)
+    {
+        ALfloat *dst = samples + (size_t)c * *length;
+
+        memset(temp, 0, buffer->SampleLen * sizeof(ALfloat));
+        if(buffer->Planar)
+            LoadFmtSamples(temp, &data[(size_t)c*buffer->SampleLen*samplesize], 1,
+                           buffer->FmtType, buffer->SampleLen);
+        else
+            LoadFmtSamples(temp, &data[c*samplesize], bufchans, buffer->FmtType,
+                           buffer->SampleLen);
+
+        if(buffer->Frequency == (ALsizei)device->Frequency)
+            memcpy(dst, temp, *length * sizeof(ALfloat));
+        else
+        {
+            static const ALfloat silence[MAX_RESAMPLE_PADDING] = { 0.0f };
+            SampleConverter *converter;
+            const ALvoid *src = temp;
+            ALsizei srcframes = buffer->SampleLen;
+            ALsizei done = 0;
+
+            converter = CreateSampleConverter(DevFmtFloat, DevFmtFloat, 1,
+                                              buffer->Frequency, device->Frequency);
+            if(!converter) goto error;
+
+            /* Start with a history of silence followed by the first input
+             * samples, so the first output sample lines up with the first
+             * input sample, and finish with enough silence to flush out the
+             * rest.
+             */
+            PrimeSampleConverter(converter, &src, &srcframes);
+            done = SampleConverterInput(converter, &src, &srcframes, dst, *length);
+            while(done < *length)
+            {
+                ALsizei got;
+
+                src = silence;
+                srcframes = MAX_RESAMPLE_PADDING;
+                got = SampleConverterInput(converter, &src, &srcframes, dst+done,
+                                           *length-done);
+                if(got <= 0) break;
+                done += got;
+            }
+            DestroySampleConverter(&converter);
+        }
+    }
+    al_free(temp);
+
+    return samples;
+
+error:
+    al_free(samples);
+    al_free(temp);
+    return NULL;
+}
+
+/* Creates a filter for the given buffer, or an empty one if there is none.
+ * The helper thread is started if the filter needs it.
+ */
+static ConvFilter *CreateConvFilter(ALconvolutionState *state, const ALCdevice *device,
+                                    const ALbuffer *buffer)
+{
+    ConvFilter layout, *filter;
+    ALfloat *samples = NULL;
+    ALsizei numchans = 0;
+    ALsizei length = 0;
+    ALsizei start, c, s, p;
+    size_t total;
+
+    if(buffer && buffer->SampleLen > 0)
+    {
+        samples = LoadImpulseResponse(device, buffer, &numchans, &length);
+        if(!samples) return NULL;
+    }
+
+    memset(&layout, 0, sizeof(layout));
+    layout.NumChannels = numchans;
+    layout.Length = length;
+    layout.TailLength = length ? HEAD_LENGTH : 0;
+
+    start = HEAD_LENGTH;
+    for(s = 0;s < NUM_SEGMENTS;s++)
+    {
+        ConvSegment *seg = &layout.Segment[s];
+        const ALsizei size = SegmentBlockSizes[s];
+        ALsizei end = length;
+
+        if(s+1 < NUM_SEGMENTS)
+            end = mini(end, SegmentBlockSizes[s+1]*2);
+
+        seg->BlockSize = size;
+        seg->NumParts = (end > start) ? (end-start + size-1) / size : 0;
+        seg->NumChannels = numchans;
+        seg->BinStride = (size+1 + 3) & ~3;
+        if(seg->NumParts > 0)
+        {
+            /* Input stops affecting the segment once it passes through the
+             * delay and partitions, and any blocks still in flight.
+             */
+            layout.TailLength = maxi(layout.TailLength, (seg->NumParts+4)*size);
+        }
+        start = end;
+    }
+    total = LayoutFilter(&layout, NULL);
+
+    if(!StartConvolutionThreads(state, &layout))
+    {
+        al_free(samples);
+        return NULL;
+    }
+
+    filter = al_calloc(16, total);
+    if(!filter)
+    {
+        al_free(samples);
+        return NULL;
+    }
+    *filter = layout;
+    filter->Size = total;
+    ATOMIC_INIT(&filter->next, NULL);
+    LayoutFilter(filter, (char*)filter);
+
+    for(c = 0;c < numchans;c++)
+    {
+        const ALfloat *ir = samples + (size_t)c*length;
+        ALsizei i;
+
+        for(i = 0;i < mini(length, HEAD_LENGTH);i++)
+            filter->Head[c][HEAD_LENGTH-1 - i] = ir[i];
+    }
+
+    start = HEAD_LENGTH;
+    for(s = 0;s < NUM_SEGMENTS;s++)
+    {
+        ConvSegment *seg = &filter->Segment[s];
+        const ALsizei size = seg->BlockSize;
+        const ALsizei stride = seg->BinStride;
+        /* Scale for the unnormalized inverse FFT. */
+        const ALfloat scale = 1.0f / (ALfloat)(size*2);
+
+        if(seg->NumParts == 0)
+            break;
+        InitSegmentTables(seg);
+
+        for(c = 0;c < numchans;c++)
+        {
+            const ALfloat *ir = samples + (size_t)c*length;
+            ALfloat *spectrum = seg->Filter + c*seg->NumParts*stride*2;
+
+            for(p = 0;p < seg->NumParts;p++)
+            {
+                const ALsizei pos = start + p*size;
+                const ALsizei todo = mini(size, length-pos);
+                ALsizei i;
+
+                memset(seg->Frame, 0, size*2*sizeof(ALfloat));
+                memcpy(seg->Frame, ir+pos, todo*sizeof(ALfloat));
+                RealForwardFFT(seg, seg->Frame, spectrum, spectrum+stride);
+                for(i = 0;i <= size;i++)
+                {
+                    spectrum[i] *= scale;
+                    spectrum[stride+i] *= scale;
+                }
+                spectrum += stride*2;
+            }
+        }
+        memset(seg->Frame, 0, size*2*sizeof(ALfloat));
+
+        start += seg->NumParts*size;
+    }
+    al_free(samples);
+
+    TRACE("New convolution filter: %d channel%s, %d samples, "SZFMT" bytes\n", numchans,
+          (numchans==1)?"":"s", length, total);
+    return filter;
+}
+
+
+/**************************************
+ *  Effect State                      *
+ **************************************/
+
+static ALboolean ALconvolutionState_deviceUpdate(ALconvolutionState *state, ALCdevice *device)
+{
+    ConvFilter *filter = NULL;
+
+    /* The mixer isn't running, so the filter can be replaced directly. */
+    WaitForSegments(state);
+    FreeConvFilterList(state->Retired);
+    state->Retired = NULL;
+    FreeConvFilterList(ATOMIC_EXCHANGE_PTR_SEQ(&state->PendingFilter, NULL));
+    FreeConvFilterList(ATOMIC_EXCHANGE_PTR_SEQ(&state->FreeFilters, NULL));
+
+    if(state->Buffer)
+    {
+        /* Reprocess the impulse response for the device's sample rate. */
+        filter = CreateConvFilter(state, device, state->Buffer);
+        if(!filter) return AL_FALSE;
+    }
+
+    al_free(state->Filter);
+    state->Filter = filter;
+    state->FilterSize = filter ? filter->Size : 0;
+    memset(state->Gains, 0, sizeof(state->Gains));
+
+    return AL_TRUE;
+}
+
+static ALboolean ALconvolutionState_setBuffer(ALconvolutionState *state, const ALCdevice *device, const struct ALbuffer *buffer)
+{
+    ConvFilter *filter;
+
+    /* Free any filters the mixer is done with. */
+    FreeConvFilterList(ATOMIC_EXCHANGE_PTR(&state->FreeFilters, NULL, almemory_order_acquire));
+
+    filter = CreateConvFilter(state, device, buffer);
+    if(!filter) return AL_FALSE;
+
+    state->Buffer = buffer;
+    state->FilterSize = filter->Size;
+
+    /* Replace any pending filter the mixer hasn't picked up yet. */
+    FreeConvFilterList(ATOMIC_EXCHANGE_PTR(&state->PendingFilter, filter,
+                                           almemory_order_acq_rel));
+
+    return AL_TRUE;
+}
+
+static ALvoid ALconvolutionState_update(ALconvolutionState *state, const ALCcontext *context, const ALeffectslot *slot, const ALeffectProps *UNUSED(props))
+{
+    const ALCdevice *device = context->Device;
+    ALfloat coeffs[MAX_AMBI_COEFFS];
+    ConvFilter *filter;
+
+    filter = ATOMIC_EXCHANGE_PTR(&state->PendingFilter, NULL, almemory_order_acq_rel);
+    if(filter)
+    {
+        /* Switch without waiting on the helper threads. A block they're still
+         * processing finishes into the old filter, which is retired until
+         * they're done with it, and each of the new filter's segments gets
+         * its thread at its first block boundary.
+         */
+        if(state->Filter)
+        {
+            ATOMIC_STORE(&state->Filter->next, state->Retired, almemory_order_relaxed);
+            state->Retired = state->Filter;
+        }
+        state->Filter = filter;
+        RetireFilters(state);
+    }
+    filter = state->Filter;
+
+    STATIC_CAST(ALeffectState,state)->TailLength = filter ? filter->TailLength : 0;
+
+    if(filter && filter->NumChannels == 2)
+    {
+        CalcAngleCoeffs(-F_PI/6.0f, 0.0f, 0.0f, coeffs);
+        ComputeDryPanGains(&device->Dry, coeffs, slot->Params.Gain, state->Gains[0].Target);
+
+        CalcAngleCoeffs( F_PI/6.0f, 0.0f, 0.0f, coeffs);
+        ComputeDryPanGains(&device->Dry, coeffs, slot->Params.Gain, state->Gains[1].Target);
+    }
+    else
+    {
+        CalcAngleCoeffs(0.0f, 0.0f, 0.0f, coeffs);
+        ComputeDryPanGains(&device->Dry, coeffs, slot->Params.Gain, state->Gains[0].Target);
+    }
+}
+
+static ALvoid ALconvolutionState_process(ALconvolutionState *state, ALsizei SamplesToDo, ALfloat *const *restrict SamplesIn, ALfloat *const *restrict SamplesOut, ALsizei NumChannels)
+{
+    ConvFilter *filter = state->Filter;
+    ALfloat *restrict history;
+    ALsizei base, c, s, i, j;
+
+    if(state->Retired)
+        RetireFilters(state);
+    if(!filter || filter->NumChannels == 0)
+        return;
+    history = filter->History;
+
+    for(base = 0;base < SamplesToDo;)
+    {
+        alignas(16) ALfloat temps[MAX_IR_CHANNELS][HEAD_LENGTH];
+        /* Stop at the end of the smallest segment's block, which is also the
+         * end of a block for the larger segments.
+         */
+        const ALsizei todo = mini(HEAD_LENGTH - filter->Segment[0].Pos, SamplesToDo-base);
+
+        /* Apply the head taps directly. */
+        memcpy(&history[HEAD_LENGTH-1], &SamplesIn[0][base], todo*sizeof(ALfloat));
+        for(c = 0;c < filter->NumChannels;c++)
+        {
+            const ALfloat *restrict head = filter->Head[c];
+            for(i = 0;i < todo;i++)
+            {
+                ALfloat sample = 0.0f;
+                for(j = 0;j < HEAD_LENGTH;j++)
+                    sample += head[j] * history[i+j];
+                temps[c][i] = sample;
+            }
+        }
+        memmove(history, &history[todo], (HEAD_LENGTH-1)*sizeof(ALfloat));
+
+        /* Add the segments' output, and feed them the input. */
+        for(s = 0;s < NUM_SEGMENTS;s++)
+        {
+            ConvSegment *seg = &filter->Segment[s];
+
+            if(seg->NumParts > 0)
+            {
+                for(c = 0;c < filter->NumChannels;c++)
+                {
+                    const ALfloat *restrict output = seg->Output + c*seg->BlockSize + seg->Pos;
+                    for(i = 0;i < todo;i++)
+                        temps[c][i] += output[i];
+                }
+                memcpy(seg->Input + seg->Pos, &SamplesIn[0][base], todo*sizeof(ALfloat));
+            }
+
+            seg->Pos += todo;
+            if(seg->Pos == seg->BlockSize)
+            {
+                seg->Pos = 0;
+                if(seg->NumParts > 0)
+                    FinishSegmentBlock(state, seg, s);
+            }
+        }
+
+        for(c = 0;c < filter->NumChannels;c++)
+            MixSamples(temps[c], NumChannels, SamplesOut, state->Gains[c].Current,
+                       state->Gains[c].Target, SamplesToDo-base, base, todo);
+
+        base += todo;
+    }
+}
+
+static size_t ALconvolutionState_getMemorySize(ALconvolutionState *state)
+{
+    return sizeof(*state) + state->FilterSize;
+}
+
+
+typedef struct ConvolutionStateFactory {
+    DERIVE_FROM_TYPE(EffectStateFactory);
+} ConvolutionStateFactory;
+
+ALeffectState *ConvolutionStateFactory_create(ConvolutionStateFactory *UNUSED(factory))
+{
+    ALconvolutionState *state;
+
+    NEW_OBJ0(state, ALconvolutionState)();
+    if(!state) return NULL;
+
+    return STATIC_CAST(ALeffectState, state);
+}
+
+DEFINE_EFFECTSTATEFACTORY_VTABLE(ConvolutionStateFactory);
+
+EffectStateFactory *ConvolutionStateFactory_getFactory(void)
+{
+    static ConvolutionStateFactory ConvolutionFactory = { { GET_VTABLE2(ConvolutionStateFactory, EffectStateFactory) } };
+
+    return STATIC_CAST(EffectStateFactory, &ConvolutionFactory);
+}
+
+
+void ALconvolution_setParami(ALeffect *UNUSED(effect), ALCcontext *context, ALenum param, ALint UNUSED(val))
+{ alSetError(context, AL_INVALID_ENUM, "Invalid convolution reverb integer property 0x%04x", param); }
+void ALconvolution_setParamiv(ALeffect *UNUSED(effect), ALCcontext *context, ALenum param, const ALint *UNUSED(vals))
+{ alSetError(context, AL_INVALID_ENUM, "Invalid convolution reverb integer-vector property 0x%04x", param); }
+void ALconvolution_setParamf(ALeffect *UNUSED(effect), ALCcontext *context, ALenum param, ALfloat UNUSED(val))
+{ alSetError(context, AL_INVALID_ENUM, "Invalid convolution reverb float property 0x%04x", param); }
+void ALconvolution_setParamfv(ALeffect *UNUSED(effect), ALCcontext *context, ALenum param, const ALfloat *UNUSED(vals))
+{ alSetError(context, AL_INVALID_ENUM, "Invalid convolution reverb float-vector property 0x%04x", param); }
+
+void ALconvolution_getParami(const ALeffect *UNUSED(effect), ALCcontext *context, ALenum param, ALint *UNUSED(val))
+{ alSetError(context, AL_INVALID_ENUM, "Invalid convolution reverb integer property 0x%04x", param); }
+void ALconvolution_getParamiv(const ALeffect *UNUSED(effect), ALCcontext *context, ALenum param, ALint *UNUSED(vals))
+{ alSetError(context, AL_INVALID_ENUM, "Invalid convolution reverb integer-vector property 0x%04x", param); }
+void ALconvolution_getParamf(const ALeffect *UNUSED(effect), ALCcontext *context, ALenum param, ALfloat *UNUSED(val))
+{ alSetError(context, AL_INVALID_ENUM, "Invalid convolution reverb float property 0x%04x", param); }
+void ALconvolution_getParamfv(const ALeffect *UNUSED(effect), ALCcontext *context, ALenum param, ALfloat *UNUSED(vals))
+{ alSetError(context, AL_INVALID_ENUM, "Invalid convolution reverb float-vector property 0x%04x", param); }
+
+DEFINE_ALEFFECT_VTABLE(ALconvolution);
@@ -38,8 +38,11 @@ typedef struct ALdedicatedState {
 
 static ALvoid ALdedicatedState_Destruct(ALdedicatedState *state);
 static ALboolean ALdedicatedState_deviceUpdate(ALdedicatedState *state, ALCdevice *device);
+static DECLARE_FORWARD2(ALdedicatedState, ALeffectState, ALboolean, prepare, const ALCdevice*, const ALeffectProps*)
+static DECLARE_FORWARD2(ALdedicatedState, ALeffectState, ALboolean, setBuffer, const ALCdevice*, const struct ALbuffer*)
 static ALvoid ALdedicatedState_update(ALdedicatedState *state, const ALCcontext *context, const ALeffectslot *slot, const ALeffectProps *props);
-static ALvoid ALdedicatedState_process(ALdedicatedState *state, ALsizei SamplesToDo, const ALfloat (*restrict SamplesIn)[BUFFERSIZE], ALfloat (*restrict SamplesOut)[BUFFERSIZE], ALsizei NumChannels);
+static ALvoid ALdedicatedState_process(ALdedicatedState *state, ALsizei SamplesToDo, ALfloat *const *restrict SamplesIn, ALfloat *const *restrict SamplesOut, ALsizei NumChannels);
+static size_t ALdedicatedState_getMemorySize(ALdedicatedState *state);
 DECLARE_DEFAULT_ALLOCATORS(ALdedicatedState)
 
 DEFINE_ALEFFECTSTATE_VTABLE(ALdedicatedState);
@@ -107,12 +110,17 @@ static ALvoid ALdedicatedState_update(ALdedicatedState *state, const ALCcontext
     }
 }
 
-static ALvoid ALdedicatedState_process(ALdedicatedState *state, ALsizei SamplesToDo, const ALfloat (*restrict SamplesIn)[BUFFERSIZE], ALfloat (*restrict SamplesOut)[BUFFERSIZE], ALsizei NumChannels)
+static ALvoid ALdedicatedState_process(ALdedicatedState *state, ALsizei SamplesToDo, ALfloat *const *restrict SamplesIn, ALfloat *const *restrict SamplesOut, ALsizei NumChannels)
 {
     MixSamples(SamplesIn[0], NumChannels, SamplesOut, state->CurrentGains,
                state->TargetGains, SamplesToDo, 0, SamplesToDo);
 }
 
+static size_t ALdedicatedState_getMemorySize(ALdedicatedState *state)
+{
+    return sizeof(*state);
+}
+
 
 typedef struct DedicatedStateFactory {
     DERIVE_FROM_TYPE(EffectStateFactory);
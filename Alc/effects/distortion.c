@@ -47,8 +47,11 @@ typedef struct ALdistortionState {
 
 static ALvoid ALdistortionState_Destruct(ALdistortionState *state);
 static ALboolean ALdistortionState_deviceUpdate(ALdistortionState *state, ALCdevice *device);
+static DECLARE_FORWARD2(ALdistortionState, ALeffectState, ALboolean, prepare, const ALCdevice*, const ALeffectProps*)
+static DECLARE_FORWARD2(ALdistortionState, ALeffectState, ALboolean, setBuffer, const ALCdevice*, const struct ALbuffer*)
 static ALvoid ALdistortionState_update(ALdistortionState *state, const ALCcontext *context, const ALeffectslot *slot, const ALeffectProps *props);
-static ALvoid ALdistortionState_process(ALdistortionState *state, ALsizei SamplesToDo, const ALfloat (*restrict SamplesIn)[BUFFERSIZE], ALfloat (*restrict SamplesOut)[BUFFERSIZE], ALsizei NumChannels);
+static ALvoid ALdistortionState_process(ALdistortionState *state, ALsizei SamplesToDo, ALfloat *const *restrict SamplesIn, ALfloat *const *restrict SamplesOut, ALsizei NumChannels);
+static size_t ALdistortionState_getMemorySize(ALdistortionState *state);
 DECLARE_DEFAULT_ALLOCATORS(ALdistortionState)
 
 DEFINE_ALEFFECTSTATE_VTABLE(ALdistortionState);
@@ -104,12 +107,17 @@ static ALvoid ALdistortionState_update(ALdistortionState *state, const ALCcontex
         cutoff / (frequency*4.0f), calc_rcpQ_from_bandwidth(cutoff / (frequency*4.0f), bandwidth)
     );
 
+    /* The filters run at the oversampled rate. */
+    STATIC_CAST(ALeffectState,state)->TailLength = maxi(
+        CalcFilterTailLength(&state->lowpass), CalcFilterTailLength(&state->bandpass)
+    )/4 + 1;
+
     CalcAngleCoeffs(0.0f, 0.0f, 0.0f, coeffs);
     ComputeDryPanGains(&device->Dry, coeffs, slot->Params.Gain * props->Distortion.Gain,
                        state->Gain);
 }
 
-static ALvoid ALdistortionState_process(ALdistortionState *state, ALsizei SamplesToDo, const ALfloat (*restrict SamplesIn)[BUFFERSIZE], ALfloat (*restrict SamplesOut)[BUFFERSIZE], ALsizei NumChannels)
+static ALvoid ALdistortionState_process(ALdistortionState *state, ALsizei SamplesToDo, ALfloat *const *restrict SamplesIn, ALfloat *const *restrict SamplesOut, ALsizei NumChannels)
 {
     ALfloat (*restrict buffer)[BUFFERSIZE] = state->Buffer;
     const ALfloat fc = state->edge_coeff;
@@ -175,6 +183,11 @@ static ALvoid ALdistortionState_process(ALdistortionState *state, ALsizei Sample
     }
 }
 
+static size_t ALdistortionState_getMemorySize(ALdistortionState *state)
+{
+    return sizeof(*state);
+}
+
 
 typedef struct DistortionStateFactory {
     DERIVE_FROM_TYPE(EffectStateFactory);
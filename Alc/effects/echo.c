@@ -56,8 +56,11 @@ typedef struct ALechoState {
 
 static ALvoid ALechoState_Destruct(ALechoState *state);
 static ALboolean ALechoState_deviceUpdate(ALechoState *state, ALCdevice *Device);
+static DECLARE_FORWARD2(ALechoState, ALeffectState, ALboolean, prepare, const ALCdevice*, const ALeffectProps*)
+static DECLARE_FORWARD2(ALechoState, ALeffectState, ALboolean, setBuffer, const ALCdevice*, const struct ALbuffer*)
 static ALvoid ALechoState_update(ALechoState *state, const ALCcontext *context, const ALeffectslot *slot, const ALeffectProps *props);
-static ALvoid ALechoState_process(ALechoState *state, ALsizei SamplesToDo, const ALfloat (*restrict SamplesIn)[BUFFERSIZE], ALfloat (*restrict SamplesOut)[BUFFERSIZE], ALsizei NumChannels);
+static ALvoid ALechoState_process(ALechoState *state, ALsizei SamplesToDo, ALfloat *const *restrict SamplesIn, ALfloat *const *restrict SamplesOut, ALsizei NumChannels);
+static size_t ALechoState_getMemorySize(ALechoState *state);
 DECLARE_DEFAULT_ALLOCATORS(ALechoState)
 
 DEFINE_ALEFFECTSTATE_VTABLE(ALechoState);
@@ -132,6 +135,9 @@ static ALvoid ALechoState_update(ALechoState *state, const ALCcontext *context,
     spread = asinf(1.0f - fabsf(spread))*4.0f;
 
     state->FeedGain = props->Echo.Feedback;
+    STATIC_CAST(ALeffectState,state)->TailLength = CalcFeedbackTailLength(
+        (ALfloat)state->Tap[1].delay, state->FeedGain
+    );
 
     gainhf = maxf(1.0f - props->Echo.Damping, 0.0625f); /* Limit -24dB */
     ALfilterState_setParams(&state->Filter, ALfilterType_HighShelf,
@@ -147,7 +153,7 @@ static ALvoid ALechoState_update(ALechoState *state, const ALCcontext *context,
     ComputeDryPanGains(&device->Dry, coeffs, slot->Params.Gain, state->Gains[1].Target);
 }
 
-static ALvoid ALechoState_process(ALechoState *state, ALsizei SamplesToDo, const ALfloat (*restrict SamplesIn)[BUFFERSIZE], ALfloat (*restrict SamplesOut)[BUFFERSIZE], ALsizei NumChannels)
+static ALvoid ALechoState_process(ALechoState *state, ALsizei SamplesToDo, ALfloat *const *restrict SamplesIn, ALfloat *const *restrict SamplesOut, ALsizei NumChannels)
 {
     const ALsizei mask = state->BufferLength-1;
     const ALsizei tap1 = state->Tap[0].delay;
@@ -205,6 +211,11 @@ static ALvoid ALechoState_process(ALechoState *state, ALsizei SamplesToDo, const
     state->Offset = offset;
 }
 
+static size_t ALechoState_getMemorySize(ALechoState *state)
+{
+    return sizeof(*state) + state->BufferLength*sizeof(ALfloat);
+}
+
 
 typedef struct EchoStateFactory {
     DERIVE_FROM_TYPE(EffectStateFactory);
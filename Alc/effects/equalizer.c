@@ -89,8 +89,11 @@ typedef struct ALequalizerState {
 
 static ALvoid ALequalizerState_Destruct(ALequalizerState *state);
 static ALboolean ALequalizerState_deviceUpdate(ALequalizerState *state, ALCdevice *device);
+static DECLARE_FORWARD2(ALequalizerState, ALeffectState, ALboolean, prepare, const ALCdevice*, const ALeffectProps*)
+static DECLARE_FORWARD2(ALequalizerState, ALeffectState, ALboolean, setBuffer, const ALCdevice*, const struct ALbuffer*)
 static ALvoid ALequalizerState_update(ALequalizerState *state, const ALCcontext *context, const ALeffectslot *slot, const ALeffectProps *props);
-static ALvoid ALequalizerState_process(ALequalizerState *state, ALsizei SamplesToDo, const ALfloat (*restrict SamplesIn)[BUFFERSIZE], ALfloat (*restrict SamplesOut)[BUFFERSIZE], ALsizei NumChannels);
+static ALvoid ALequalizerState_process(ALequalizerState *state, ALsizei SamplesToDo, ALfloat *const *restrict SamplesIn, ALfloat *const *restrict SamplesOut, ALsizei NumChannels);
+static size_t ALequalizerState_getMemorySize(ALequalizerState *state);
 DECLARE_DEFAULT_ALLOCATORS(ALequalizerState)
 
 DEFINE_ALEFFECTSTATE_VTABLE(ALequalizerState);
@@ -174,27 +177,61 @@ static ALvoid ALequalizerState_update(ALequalizerState *state, const ALCcontext
         ALfilterState_copyParams(&state->Chans[i].filter[2], &state->Chans[0].filter[2]);
         ALfilterState_copyParams(&state->Chans[i].filter[3], &state->Chans[0].filter[3]);
     }
+
+    STATIC_CAST(ALeffectState,state)->TailLength = 0;
+    for(i = 0;i < 4;i++)
+        STATIC_CAST(ALeffectState,state)->TailLength = maxi(
+            STATIC_CAST(ALeffectState,state)->TailLength,
+            CalcFilterTailLength(&state->Chans[0].filter[i])
+        );
 }
 
-static ALvoid ALequalizerState_process(ALequalizerState *state, ALsizei SamplesToDo, const ALfloat (*restrict SamplesIn)[BUFFERSIZE], ALfloat (*restrict SamplesOut)[BUFFERSIZE], ALsizei NumChannels)
+static ALvoid ALequalizerState_process(ALequalizerState *state, ALsizei SamplesToDo, ALfloat *const *restrict SamplesIn, ALfloat *const *restrict SamplesOut, ALsizei NumChannels)
 {
     ALfloat (*restrict temps)[BUFFERSIZE] = state->SampleBuffer;
-    ALsizei c;
+    ALfilterState *filters[MAX_EFFECT_CHANNELS];
+    const ALfloat *src[MAX_EFFECT_CHANNELS];
+    ALfloat *dst[MAX_EFFECT_CHANNELS];
+    ALsizei base, c, f;
 
-    for(c = 0;c < MAX_EFFECT_CHANNELS;c++)
+    for(base = 0;base < SamplesToDo;)
     {
-        ALfilterState_process(&state->Chans[c].filter[0], temps[0], SamplesIn[c], SamplesToDo);
-        ALfilterState_process(&state->Chans[c].filter[1], temps[1], temps[0], SamplesToDo);
-        ALfilterState_process(&state->Chans[c].filter[2], temps[2], temps[1], SamplesToDo);
-        ALfilterState_process(&state->Chans[c].filter[3], temps[3], temps[2], SamplesToDo);
-
-        MixSamples(temps[3], NumChannels, SamplesOut,
-            state->Chans[c].CurrentGains, state->Chans[c].TargetGains,
-            SamplesToDo, 0, SamplesToDo
-        );
+        ALsizei todo = mini(BUFFERSIZE, SamplesToDo-base);
+
+        /* Run each filter stage for all channels together, with the later
+         * stages in place.
+         */
+        for(c = 0;c < MAX_EFFECT_CHANNELS;c++)
+        {
+            src[c] = SamplesIn[c] + base;
+            dst[c] = temps[c];
+        }
+        for(f = 0;f < 4;f++)
+        {
+            for(c = 0;c < MAX_EFFECT_CHANNELS;c++)
+                filters[c] = &state->Chans[c].filter[f];
+            MultiFilterSamples(filters, dst, src, MAX_EFFECT_CHANNELS, todo);
+            for(c = 0;c < MAX_EFFECT_CHANNELS;c++)
+                src[c] = temps[c];
+        }
+
+        for(c = 0;c < MAX_EFFECT_CHANNELS;c++)
+        {
+            MixSamples(temps[c], NumChannels, SamplesOut,
+                state->Chans[c].CurrentGains, state->Chans[c].TargetGains,
+                SamplesToDo-base, base, todo
+            );
+        }
+
+        base += todo;
     }
 }
 
+static size_t ALequalizerState_getMemorySize(ALequalizerState *state)
+{
+    return sizeof(*state);
+}
+
 
 typedef struct EqualizerStateFactory {
     DERIVE_FROM_TYPE(EffectStateFactory);
@@ -52,8 +52,11 @@ typedef struct ALmodulatorState {
 
 static ALvoid ALmodulatorState_Destruct(ALmodulatorState *state);
 static ALboolean ALmodulatorState_deviceUpdate(ALmodulatorState *state, ALCdevice *device);
+static DECLARE_FORWARD2(ALmodulatorState, ALeffectState, ALboolean, prepare, const ALCdevice*, const ALeffectProps*)
+static DECLARE_FORWARD2(ALmodulatorState, ALeffectState, ALboolean, setBuffer, const ALCdevice*, const struct ALbuffer*)
 static ALvoid ALmodulatorState_update(ALmodulatorState *state, const ALCcontext *context, const ALeffectslot *slot, const ALeffectProps *props);
-static ALvoid ALmodulatorState_process(ALmodulatorState *state, ALsizei SamplesToDo, const ALfloat (*restrict SamplesIn)[BUFFERSIZE], ALfloat (*restrict SamplesOut)[BUFFERSIZE], ALsizei NumChannels);
+static ALvoid ALmodulatorState_process(ALmodulatorState *state, ALsizei SamplesToDo, ALfloat *const *restrict SamplesIn, ALfloat *const *restrict SamplesOut, ALsizei NumChannels);
+static size_t ALmodulatorState_getMemorySize(ALmodulatorState *state);
 DECLARE_DEFAULT_ALLOCATORS(ALmodulatorState)
 
 DEFINE_ALEFFECTSTATE_VTABLE(ALmodulatorState);
@@ -152,6 +155,7 @@ static ALvoid ALmodulatorState_update(ALmodulatorState *state, const ALCcontext
     state->Chans[0].Filter.a2 = 0.0f;
     for(i = 1;i < MAX_EFFECT_CHANNELS;i++)
         ALfilterState_copyParams(&state->Chans[i].Filter, &state->Chans[0].Filter);
+    STATIC_CAST(ALeffectState,state)->TailLength = CalcFilterTailLength(&state->Chans[0].Filter);
 
     STATIC_CAST(ALeffectState,state)->OutBuffer = device->FOAOut.Buffer;
     STATIC_CAST(ALeffectState,state)->OutChannels = device->FOAOut.NumChannels;
@@ -160,7 +164,7 @@ static ALvoid ALmodulatorState_update(ALmodulatorState *state, const ALCcontext
                                slot->Params.Gain, state->Chans[i].TargetGains);
 }
 
-static ALvoid ALmodulatorState_process(ALmodulatorState *state, ALsizei SamplesToDo, const ALfloat (*restrict SamplesIn)[BUFFERSIZE], ALfloat (*restrict SamplesOut)[BUFFERSIZE], ALsizei NumChannels)
+static ALvoid ALmodulatorState_process(ALmodulatorState *state, ALsizei SamplesToDo, ALfloat *const *restrict SamplesIn, ALfloat *const *restrict SamplesOut, ALsizei NumChannels)
 {
     ALfloat *restrict modsamples = ASSUME_ALIGNED(state->ModSamples, 16);
     const ALsizei step = state->step;
@@ -168,7 +172,10 @@ static ALvoid ALmodulatorState_process(ALmodulatorState *state, ALsizei SamplesT
 
     for(base = 0;base < SamplesToDo;)
     {
-        alignas(16) ALfloat temps[2][MAX_UPDATE_SAMPLES];
+        alignas(16) ALfloat temps[MAX_EFFECT_CHANNELS][MAX_UPDATE_SAMPLES];
+        ALfilterState *filters[MAX_EFFECT_CHANNELS];
+        const ALfloat *src[MAX_EFFECT_CHANNELS];
+        ALfloat *dst[MAX_EFFECT_CHANNELS];
         ALsizei td = mini(MAX_UPDATE_SAMPLES, SamplesToDo-base);
         ALsizei c, i;
 
@@ -178,11 +185,18 @@ static ALvoid ALmodulatorState_process(ALmodulatorState *state, ALsizei SamplesT
 
         for(c = 0;c < MAX_EFFECT_CHANNELS;c++)
         {
-            ALfilterState_process(&state->Chans[c].Filter, temps[0], &SamplesIn[c][base], td);
+            filters[c] = &state->Chans[c].Filter;
+            src[c] = &SamplesIn[c][base];
+            dst[c] = temps[c];
+        }
+        MultiFilterSamples(filters, dst, src, MAX_EFFECT_CHANNELS, td);
+
+        for(c = 0;c < MAX_EFFECT_CHANNELS;c++)
+        {
             for(i = 0;i < td;i++)
-                temps[1][i] = temps[0][i] * modsamples[i];
+                temps[c][i] *= modsamples[i];
 
-            MixSamples(temps[1], NumChannels, SamplesOut, state->Chans[c].CurrentGains,
+            MixSamples(temps[c], NumChannels, SamplesOut, state->Chans[c].CurrentGains,
                        state->Chans[c].TargetGains, SamplesToDo-base, base, td);
         }
 
@@ -190,6 +204,11 @@ static ALvoid ALmodulatorState_process(ALmodulatorState *state, ALsizei SamplesT
     }
 }
 
+static size_t ALmodulatorState_getMemorySize(ALmodulatorState *state)
+{
+    return sizeof(*state);
+}
+
 
 typedef struct ModulatorStateFactory {
     DERIVE_FROM_TYPE(EffectStateFactory);
@@ -16,8 +16,11 @@ typedef struct ALnullState {
 /* Forward-declare "virtual" functions to define the vtable with. */
 static ALvoid ALnullState_Destruct(ALnullState *state);
 static ALboolean ALnullState_deviceUpdate(ALnullState *state, ALCdevice *device);
+static ALboolean ALnullState_prepare(ALnullState *state, const ALCdevice *device, const ALeffectProps *props);
+static ALboolean ALnullState_setBuffer(ALnullState *state, const ALCdevice *device, const struct ALbuffer *buffer);
 static ALvoid ALnullState_update(ALnullState *state, const ALCcontext *context, const ALeffectslot *slot, const ALeffectProps *props);
-static ALvoid ALnullState_process(ALnullState *state, ALsizei samplesToDo, const ALfloat (*restrict samplesIn)[BUFFERSIZE], ALfloat (*restrict samplesOut)[BUFFERSIZE], ALsizei mumChannels);
+static ALvoid ALnullState_process(ALnullState *state, ALsizei samplesToDo, ALfloat *const *restrict samplesIn, ALfloat *const *restrict samplesOut, ALsizei mumChannels);
+static size_t ALnullState_getMemorySize(ALnullState *state);
 static void *ALnullState_New(size_t size);
 static void ALnullState_Delete(void *ptr);
 
@@ -53,6 +56,30 @@ static ALboolean ALnullState_deviceUpdate(ALnullState* UNUSED(state), ALCdevice*
     return AL_TRUE;
 }
 
+/* This prepares the effect state for new properties. It's called from the
+ * application's thread before the properties are passed to the mixer, so any
+ * memory the new properties need can be allocated here instead of in update.
+ * The state may be in use by the mixer at the same time, so anything passed
+ * to it must go through atomics. DECLARE_FORWARD2 can be used to use the
+ * parent's method, which does nothing.
+ */
+static ALboolean ALnullState_prepare(ALnullState* UNUSED(state), const ALCdevice* UNUSED(device), const ALeffectProps* UNUSED(props))
+{
+    return AL_TRUE;
+}
+
+/* This gives the effect state the buffer set on its effect slot, or NULL if
+ * there is none. It's called from the application's thread when the slot's
+ * buffer changes or the state is loaded into a slot with a buffer, and has
+ * the same restrictions as prepare. The buffer stays valid until the next
+ * call. DECLARE_FORWARD2 can be used to use the parent's method, which
+ * ignores the buffer.
+ */
+static ALboolean ALnullState_setBuffer(ALnullState* UNUSED(state), const ALCdevice* UNUSED(device), const struct ALbuffer* UNUSED(buffer))
+{
+    return AL_TRUE;
+}
+
 /* This updates the effect state. This is called any time the effect is
  * (re)loaded into a slot.
  */
@@ -64,8 +91,16 @@ static ALvoid ALnullState_update(ALnullState* UNUSED(state), const ALCcontext* U
  * input to the output buffer. The result should be added to the output buffer,
  * not replace it.
  */
-static ALvoid ALnullState_process(ALnullState* UNUSED(state), ALsizei UNUSED(samplesToDo), const ALfloatBUFFERSIZE*restrict UNUSED(samplesIn), ALfloatBUFFERSIZE*restrict UNUSED(samplesOut), ALsizei UNUSED(numChannels))
+static ALvoid ALnullState_process(ALnullState* UNUSED(state), ALsizei UNUSED(samplesToDo), ALfloat*const*restrict UNUSED(samplesIn), ALfloat*const*restrict UNUSED(samplesOut), ALsizei UNUSED(numChannels))
+{
+}
+
+/* This returns the number of bytes of memory used by the effect state,
+ * including any buffers it allocated.
+ */
+static size_t ALnullState_getMemorySize(ALnullState *state)
 {
+    return sizeof(*state);
 }
 
 /* This allocates memory to store the object, before it gets constructed.
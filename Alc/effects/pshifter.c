@@ -83,8 +83,11 @@ typedef struct ALpshifterState {
 
 static ALvoid ALpshifterState_Destruct(ALpshifterState *state);
 static ALboolean ALpshifterState_deviceUpdate(ALpshifterState *state, ALCdevice *device);
+static DECLARE_FORWARD2(ALpshifterState, ALeffectState, ALboolean, prepare, const ALCdevice*, const ALeffectProps*)
+static DECLARE_FORWARD2(ALpshifterState, ALeffectState, ALboolean, setBuffer, const ALCdevice*, const struct ALbuffer*)
 static ALvoid ALpshifterState_update(ALpshifterState *state, const ALCcontext *context, const ALeffectslot *slot, const ALeffectProps *props);
-static ALvoid ALpshifterState_process(ALpshifterState *state, ALsizei SamplesToDo, const ALfloat (*restrict SamplesIn)[BUFFERSIZE], ALfloat (*restrict SamplesOut)[BUFFERSIZE], ALsizei NumChannels);
+static ALvoid ALpshifterState_process(ALpshifterState *state, ALsizei SamplesToDo, ALfloat *const *restrict SamplesIn, ALfloat *const *restrict SamplesOut, ALsizei NumChannels);
+static size_t ALpshifterState_getMemorySize(ALpshifterState *state);
 DECLARE_DEFAULT_ALLOCATORS(ALpshifterState)
 
 DEFINE_ALEFFECTSTATE_VTABLE(ALpshifterState);
@@ -246,6 +249,11 @@ static ALvoid ALpshifterState_update(ALpshifterState *state, const ALCcontext *c
     ALfloat coeffs[MAX_AMBI_COEFFS];
 
     state->Frequency  = (ALfloat)device->Frequency;
+    /* Input stays in the analysis window for a frame's length, and the last
+     * frame it's in takes another frame's length plus the FIFO latency to
+     * come out.
+     */
+    STATIC_CAST(ALeffectState,state)->TailLength = STFT_SIZE*2 + FIFO_LATENCY;
     state->PitchShift = powf(2.0f,
         (ALfloat)(props->Pshifter.CoarseTune*100 + props->Pshifter.FineTune) / 1200.0f
     );
@@ -254,7 +262,7 @@ static ALvoid ALpshifterState_update(ALpshifterState *state, const ALCcontext *c
     ComputeDryPanGains(&device->Dry, coeffs, slot->Params.Gain, state->Gain);
 }
 
-static ALvoid ALpshifterState_process(ALpshifterState *state, ALsizei SamplesToDo, const ALfloat (*restrict SamplesIn)[BUFFERSIZE], ALfloat (*restrict SamplesOut)[BUFFERSIZE], ALsizei NumChannels)
+static ALvoid ALpshifterState_process(ALpshifterState *state, ALsizei SamplesToDo, ALfloat *const *restrict SamplesIn, ALfloat *const *restrict SamplesOut, ALsizei NumChannels)
 {
     /* Pitch shifter engine based on the work of Stephan Bernsee.
      * http://blogs.zynaptiq.com/bernsee/pitch-shifting-using-the-ft/
@@ -263,133 +271,145 @@ static ALvoid ALpshifterState_process(ALpshifterState *state, ALsizei SamplesToD
     static const ALfloat expected = F_TAU / (ALfloat)OVERSAMP;
     const ALfloat freq_bin = state->Frequency / (ALfloat)STFT_SIZE;
     ALfloat *restrict bufferOut = state->BufferOut;
-    ALsizei i, j, k;
+    ALsizei base, i, j, k;
 
-    for (i = 0; i < SamplesToDo; i++)
+    for(base = 0;base < SamplesToDo;)
     {
-        /* Fill FIFO buffer with samples data */
-        state->InFIFO[state->count] = SamplesIn[0][i];
-        bufferOut[i]  = state->OutFIFO[state->count - FIFO_LATENCY];
-
-        state->count++;
+        ALsizei todo = mini(BUFFERSIZE, SamplesToDo-base);
 
-        /* Check whether FIFO buffer is filled */
-        if ( state->count >= STFT_SIZE )
+        for (i = 0; i < todo; i++)
         {
-            state->count = FIFO_LATENCY;
+            /* Fill FIFO buffer with samples data */
+            state->InFIFO[state->count] = SamplesIn[0][base+i];
+            bufferOut[i]  = state->OutFIFO[state->count - FIFO_LATENCY];
 
-            /* Real signal windowing and store in FFTbuffer */
-            for ( k = 0; k < STFT_SIZE; k++ )
+            state->count++;
+
+            /* Check whether FIFO buffer is filled */
+            if ( state->count >= STFT_SIZE )
             {
-                state->FFTbuffer[k].Real = state->InFIFO[k] * state->window[k];
-                state->FFTbuffer[k].Imag = 0.0f;
-            }
+                state->count = FIFO_LATENCY;
 
-            /* ANALYSIS */
-            /* Apply FFT to FFTbuffer data */
-            FFT( state->FFTbuffer, STFT_SIZE, -1 );
+                /* Real signal windowing and store in FFTbuffer */
+                for ( k = 0; k < STFT_SIZE; k++ )
+                {
+                    state->FFTbuffer[k].Real = state->InFIFO[k] * state->window[k];
+                    state->FFTbuffer[k].Imag = 0.0f;
+                }
 
-            /* Analyze the obtained data. Since the real FFT is symmetric, only
-             * STFT_half_size+1 samples are needed.
-             */
-            for ( k = 0; k <= STFT_HALF_SIZE; k++ )
-            {
-                ALphasor component;
-                ALfloat tmp;
+                /* ANALYSIS */
+                /* Apply FFT to FFTbuffer data */
+                FFT( state->FFTbuffer, STFT_SIZE, -1 );
 
-                /* Compute amplitude and phase */
-                component = rect2polar( state->FFTbuffer[k] );
+                /* Analyze the obtained data. Since the real FFT is symmetric, only
+                 * STFT_half_size+1 samples are needed.
+                 */
+                for ( k = 0; k <= STFT_HALF_SIZE; k++ )
+                {
+                    ALphasor component;
+                    ALfloat tmp;
 
-                /* Compute phase difference and subtract expected phase difference */
-                tmp = ( component.Phase - state->LastPhase[k] ) - (ALfloat)k*expected;
+                    /* Compute amplitude and phase */
+                    component = rect2polar( state->FFTbuffer[k] );
 
-                /* Map delta phase into +/- Pi interval */
-                tmp -= F_PI*(ALfloat)( fastf2i(tmp/F_PI) + fastf2i(tmp/F_PI) % 2 );
+                    /* Compute phase difference and subtract expected phase difference */
+                    tmp = ( component.Phase - state->LastPhase[k] ) - (ALfloat)k*expected;
 
-                /* Get deviation from bin frequency from the +/- Pi interval */
-                tmp /= expected;
+                    /* Map delta phase into +/- Pi interval */
+                    tmp -= F_PI*(ALfloat)( fastf2i(tmp/F_PI) + fastf2i(tmp/F_PI) % 2 );
 
-                /* Compute the k-th partials' true frequency, twice the
-                 * amplitude for maintain the gain (because half of bins are
-                 * used) and store amplitude and true frequency in analysis
-                 * buffer.
-                 */
-                state->Analysis_buffer[k].Amplitude = 2.0f * component.Amplitude;
-                state->Analysis_buffer[k].Frequency = ((ALfloat)k + tmp) * freq_bin;
+                    /* Get deviation from bin frequency from the +/- Pi interval */
+                    tmp /= expected;
 
-                /* Store actual phase[k] for the calculations in the next frame*/
-                state->LastPhase[k] = component.Phase;
-            }
+                    /* Compute the k-th partials' true frequency, twice the
+                     * amplitude for maintain the gain (because half of bins are
+                     * used) and store amplitude and true frequency in analysis
+                     * buffer.
+                     */
+                    state->Analysis_buffer[k].Amplitude = 2.0f * component.Amplitude;
+                    state->Analysis_buffer[k].Frequency = ((ALfloat)k + tmp) * freq_bin;
 
-            /* PROCESSING */
-            /* pitch shifting */
-            memset(state->Syntesis_buffer, 0, STFT_SIZE*sizeof(ALfrequencyDomain));
+                    /* Store actual phase[k] for the calculations in the next frame*/
+                    state->LastPhase[k] = component.Phase;
+                }
 
-            for (k = 0; k <= STFT_HALF_SIZE; k++)
-            {
-                j = fastf2i( (ALfloat)k*state->PitchShift );
+                /* PROCESSING */
+                /* pitch shifting */
+                memset(state->Syntesis_buffer, 0, STFT_SIZE*sizeof(ALfrequencyDomain));
 
-                if ( j <= STFT_HALF_SIZE )
+                for (k = 0; k <= STFT_HALF_SIZE; k++)
                 {
-                    state->Syntesis_buffer[j].Amplitude += state->Analysis_buffer[k].Amplitude; 
-                    state->Syntesis_buffer[j].Frequency  = state->Analysis_buffer[k].Frequency *
-                                                           state->PitchShift;
+                    j = fastf2i( (ALfloat)k*state->PitchShift );
+
+                    if ( j <= STFT_HALF_SIZE )
+                    {
+                        state->Syntesis_buffer[j].Amplitude += state->Analysis_buffer[k].Amplitude; 
+                        state->Syntesis_buffer[j].Frequency  = state->Analysis_buffer[k].Frequency *
+                                                               state->PitchShift;
+                    }
                 }
-            }
 
-            /* SYNTHESIS */
-            /* Synthesis the processing data */
-            for ( k = 0; k <= STFT_HALF_SIZE; k++ )
-            {
-                ALphasor component;
-                ALfloat tmp;
+                /* SYNTHESIS */
+                /* Synthesis the processing data */
+                for ( k = 0; k <= STFT_HALF_SIZE; k++ )
+                {
+                    ALphasor component;
+                    ALfloat tmp;
 
-                /* Compute bin deviation from scaled freq */
-                tmp = state->Syntesis_buffer[k].Frequency/freq_bin - (ALfloat)k;
+                    /* Compute bin deviation from scaled freq */
+                    tmp = state->Syntesis_buffer[k].Frequency/freq_bin - (ALfloat)k;
 
-                /* Calculate actual delta phase and accumulate it to get bin phase */
-                state->SumPhase[k] += ((ALfloat)k + tmp) * expected;
+                    /* Calculate actual delta phase and accumulate it to get bin phase */
+                    state->SumPhase[k] += ((ALfloat)k + tmp) * expected;
 
-                component.Amplitude = state->Syntesis_buffer[k].Amplitude;
-                component.Phase     = state->SumPhase[k];
+                    component.Amplitude = state->Syntesis_buffer[k].Amplitude;
+                    component.Phase     = state->SumPhase[k];
 
-                /* Compute phasor component to cartesian complex number and storage it into FFTbuffer*/
-                state->FFTbuffer[k] = polar2rect( component );
-            }
+                    /* Compute phasor component to cartesian complex number and storage it into FFTbuffer*/
+                    state->FFTbuffer[k] = polar2rect( component );
+                }
 
-            /* zero negative frequencies for recontruct a real signal */
-            memset( &state->FFTbuffer[STFT_HALF_SIZE+1], 0, (STFT_HALF_SIZE-1)*sizeof(ALcomplex));
+                /* zero negative frequencies for recontruct a real signal */
+                memset( &state->FFTbuffer[STFT_HALF_SIZE+1], 0, (STFT_HALF_SIZE-1)*sizeof(ALcomplex));
 
-            /* Apply iFFT to buffer data */
-            FFT( state->FFTbuffer, STFT_SIZE, 1 );
+                /* Apply iFFT to buffer data */
+                FFT( state->FFTbuffer, STFT_SIZE, 1 );
 
-            /* Windowing and add to output */
-            for( k=0; k < STFT_SIZE; k++ )
-            {
-                state->OutputAccum[k] += 2.0f * state->window[k]*state->FFTbuffer[k].Real /
-                                         (STFT_HALF_SIZE * OVERSAMP);
-            }
+                /* Windowing and add to output */
+                for( k=0; k < STFT_SIZE; k++ )
+                {
+                    state->OutputAccum[k] += 2.0f * state->window[k]*state->FFTbuffer[k].Real /
+                                             (STFT_HALF_SIZE * OVERSAMP);
+                }
 
-            /* Shift accumulator, input & output FIFO */
-            memmove(state->OutFIFO    , state->OutputAccum          , STFT_STEP   *sizeof(ALfloat));
-            memmove(state->OutputAccum, state->OutputAccum+STFT_STEP, STFT_SIZE   *sizeof(ALfloat));
-            memmove(state->InFIFO     , state->InFIFO     +STFT_STEP, FIFO_LATENCY*sizeof(ALfloat));
+                /* Shift accumulator, input & output FIFO */
+                memmove(state->OutFIFO    , state->OutputAccum          , STFT_STEP   *sizeof(ALfloat));
+                memmove(state->OutputAccum, state->OutputAccum+STFT_STEP, STFT_SIZE   *sizeof(ALfloat));
+                memmove(state->InFIFO     , state->InFIFO     +STFT_STEP, FIFO_LATENCY*sizeof(ALfloat));
+            }
         }
-    }
 
-    /* Now, mix the processed sound data to the output*/
-    for (j = 0; j < NumChannels; j++ )
-    {
-        ALfloat gain = state->Gain[j];
+        /* Now, mix the processed sound data to the output*/
+        for (j = 0; j < NumChannels; j++ )
+        {
+            ALfloat gain = state->Gain[j];
 
-        if(!(fabsf(gain) > GAIN_SILENCE_THRESHOLD))
-             continue;
+            if(!(fabsf(gain) > GAIN_SILENCE_THRESHOLD))
+                 continue;
+
+            for(i = 0;i < todo;i++)
+                SamplesOut[j][base+i] += gain * bufferOut[i];
+        }
 
-        for(i = 0;i < SamplesToDo;i++)
-            SamplesOut[j][i] += gain * bufferOut[i];
+        base += todo;
     }
 }
 
+static size_t ALpshifterState_getMemorySize(ALpshifterState *state)
+{
+    return sizeof(*state);
+}
+
 typedef struct PshifterStateFactory {
     DERIVE_FROM_TYPE(EffectStateFactory);
 } PshifterStateFactory;
@@ -31,32 +31,19 @@
 #include "alFilter.h"
 #include "alListener.h"
 #include "alError.h"
+#include "alconfig.h"
 #include "mixer_defs.h"
+#include "cpu_caps.h"
+
+#include "backends/base.h"
+
+#include "reverb.h"
 
 /* This is a user config option for modifying the overall output of the reverb
  * effect.
  */
 ALfloat ReverbBoost = 1.0f;
 
-/* This is the maximum number of samples processed for each inner loop
- * iteration. */
-#define MAX_UPDATE_SAMPLES  256
-
-/* The number of samples used for cross-faded delay lines.  This can be used
- * to balance the compensation for abrupt line changes and attenuation due to
- * minimally lengthed recursive lines.  Try to keep this below the device
- * update size.
- */
-#define FADE_SAMPLES  128
-
-/* The number of spatialized lines or channels to process. Four channels allows
- * for a 3D A-Format response. NOTE: This can't be changed without taking care
- * of the conversion matrices, and a few places where the length arrays are
- * assumed to have 4 elements.
- */
-#define NUM_LINES 4
-
-
 /* The B-Format to A-Format conversion matrix. The arrangement of rows is
  * deliberately chosen to align the resulting lines to their spatial opposites
  * (0:above front left <-> 3:above back right, 1:below front right <-> 2:below
@@ -79,8 +66,6 @@ static const aluMatrixf A2B = {{
     { 0.866025403785f,  0.866025403785f, -0.866025403785f, -0.866025403785f }
 }};
 
-static const ALfloat FadeStep = 1.0f / FADE_SAMPLES;
-
 /* The all-pass and delay lines have a variable length dependent on the
  * effect's density parameter, which helps alter the perceived environment
  * size. The size-to-density conversion is a cubed scale:
@@ -214,131 +199,140 @@ static const ALfloat LATE_LINE_LENGTHS[NUM_LINES] =
     1.9419362e-3f, 2.4466860e-3f, 3.3791220e-3f, 3.8838720e-3f
 };
 
+/* The other quality tiers spread the same range of lengths over fewer or
+ * more late lines (N), with each of the longest paths mirroring its opposite
+ * shortest path:
+ *
+ *     L_i = 2^(i / (N - 1)) r_d               for i < N / 2
+ *     L_i = 2 r_a - L_(N-i-1)                 for i >= N / 2
+ *
+ * With the all-pass lengths following the same relation as above.
+ */
+static const ALfloat LATE_LINE_LENGTHS_2[2] =
+{
+    1.9419361e-3f, 3.8838722e-3f
+};
+static const ALfloat LATE_ALLPASS_LENGTHS_2[2] =
+{
+    1.6182801e-4f, 3.2365602e-4f
+};
 
-typedef struct DelayLineI {
-    /* The delay lines use interleaved samples, with the lengths being powers
-     * of 2 to allow the use of bit-masking instead of a modulus for wrapping.
-     */
-    ALsizei  Mask;
-    ALfloat (*Line)[NUM_LINES];
-} DelayLineI;
-
-typedef struct VecAllpass {
-    DelayLineI Delay;
-    ALsizei Offset[NUM_LINES][2];
-} VecAllpass;
-
-typedef struct T60Filter {
-    /* Two filters are used to adjust the signal. One to control the low
-     * frequencies, and one to control the high frequencies. The HF filter also
-     * adjusts the overall output gain, affecting the remaining mid-band.
-     */
-    ALfloat HFCoeffs[3];
-    ALfloat LFCoeffs[3];
-
-    /* The HF and LF filters each keep a state of the last input and last
-     * output sample.
-     */
-    ALfloat HFState[2];
-    ALfloat LFState[2];
-} T60Filter;
-
-typedef struct EarlyReflections {
-    /* A Gerzon vector all-pass filter is used to simulate initial diffusion.
-     * The spread from this filter also helps smooth out the reverb tail.
-     */
-    VecAllpass VecAp;
-
-    /* An echo line is used to complete the second half of the early
-     * reflections.
-     */
-    DelayLineI Delay;
-    ALsizei    Offset[NUM_LINES][2];
-    ALfloat    Coeff[NUM_LINES];
-
-    /* The gain for each output channel based on 3D panning. */
-    ALfloat CurrentGain[NUM_LINES][MAX_OUTPUT_CHANNELS];
-    ALfloat PanGain[NUM_LINES][MAX_OUTPUT_CHANNELS];
-} EarlyReflections;
-
-typedef struct LateReverb {
-    /* Attenuation to compensate for the modal density and decay rate of the
-     * late lines.
-     */
-    ALfloat DensityGain;
-
-    /* A recursive delay line is used fill in the reverb tail. */
-    DelayLineI Delay;
-    ALsizei    Offset[NUM_LINES][2];
-
-    /* T60 decay filters are used to simulate absorption. */
-    T60Filter T60[NUM_LINES];
-
-    /* A Gerzon vector all-pass filter is used to simulate diffusion. */
-    VecAllpass VecAp;
-
-    /* The gain for each output channel based on 3D panning. */
-    ALfloat CurrentGain[NUM_LINES][MAX_OUTPUT_CHANNELS];
-    ALfloat PanGain[NUM_LINES][MAX_OUTPUT_CHANNELS];
-} LateReverb;
-
-typedef struct ALreverbState {
-    DERIVE_FROM_TYPE(ALeffectState);
-
-    /* All delay lines are allocated as a single buffer to reduce memory
-     * fragmentation and management code.
-     */
-    ALfloat *SampleBuffer;
-    ALuint   TotalSamples;
-
-    /* Master effect filters */
-    struct {
-        ALfilterState Lp;
-        ALfilterState Hp;
-    } Filter[NUM_LINES];
-
-    /* Core delay line (early reflections and late reverb tap from this). */
-    DelayLineI Delay;
-
-    /* Tap points for early reflection delay. */
-    ALsizei EarlyDelayTap[NUM_LINES][2];
-    ALfloat EarlyDelayCoeff[NUM_LINES];
-
-    /* Tap points for late reverb feed and delay. */
-    ALsizei LateFeedTap;
-    ALsizei LateDelayTap[NUM_LINES][2];
-
-    /* The feed-back and feed-forward all-pass coefficient. */
-    ALfloat ApFeedCoeff;
-
-    /* Coefficients for the all-pass and line scattering matrices. */
-    ALfloat MixX;
-    ALfloat MixY;
-
-    EarlyReflections Early;
-
-    LateReverb Late;
-
-    /* Indicates the cross-fade point for delay line reads [0,FADE_SAMPLES]. */
-    ALsizei FadeCount;
+static const ALfloat LATE_LINE_LENGTHS_8[8] =
+{
+    1.9419361e-3f, 2.1440713e-3f, 2.3672466e-3f, 2.6136522e-3f,
+    3.2121561e-3f, 3.4585617e-3f, 3.6817370e-3f, 3.8838722e-3f
+};
+static const ALfloat LATE_ALLPASS_LENGTHS_8[8] =
+{
+    1.6182801e-4f, 1.7867261e-4f, 1.9727055e-4f, 2.1780435e-4f,
+    2.6767968e-4f, 2.8821347e-4f, 3.0681142e-4f, 3.2365602e-4f
+};
 
-    /* The current write offset for all delay lines. */
-    ALsizei Offset;
+static const ALfloat LATE_LINE_LENGTHS_16[16] =
+{
+    1.9419361e-3f, 2.0337783e-3f, 2.1299640e-3f, 2.2306988e-3f,
+    2.3361978e-3f, 2.4466862e-3f, 2.5624001e-3f, 2.6835865e-3f,
+    3.1422218e-3f, 3.2634083e-3f, 3.3791221e-3f, 3.4896106e-3f,
+    3.5951095e-3f, 3.6958443e-3f, 3.7920301e-3f, 3.8838722e-3f
+};
+static const ALfloat LATE_ALLPASS_LENGTHS_16[16] =
+{
+    1.6182801e-4f, 1.6948152e-4f, 1.7749700e-4f, 1.8589157e-4f,
+    1.9468315e-4f, 2.0389052e-4f, 2.1353334e-4f, 2.2363221e-4f,
+    2.6185182e-4f, 2.7195069e-4f, 2.8159351e-4f, 2.9080088e-4f,
+    2.9959246e-4f, 3.0798702e-4f, 3.1600250e-4f, 3.2365602e-4f
+};
 
-    /* Temporary storage used when processing. */
-    alignas(16) ALfloat AFormatSamples[NUM_LINES][MAX_UPDATE_SAMPLES];
-    alignas(16) ALfloat ReverbSamples[NUM_LINES][MAX_UPDATE_SAMPLES];
-    alignas(16) ALfloat EarlySamples[NUM_LINES][MAX_UPDATE_SAMPLES];
-} ALreverbState;
 
 static ALvoid ALreverbState_Destruct(ALreverbState *State);
 static ALboolean ALreverbState_deviceUpdate(ALreverbState *State, ALCdevice *Device);
+static ALboolean ALreverbState_prepare(ALreverbState *State, const ALCdevice *Device, const ALeffectProps *props);
+static DECLARE_FORWARD2(ALreverbState, ALeffectState, ALboolean, setBuffer, const ALCdevice*, const struct ALbuffer*)
 static ALvoid ALreverbState_update(ALreverbState *State, const ALCcontext *Context, const ALeffectslot *Slot, const ALeffectProps *props);
-static ALvoid ALreverbState_process(ALreverbState *State, ALsizei SamplesToDo, const ALfloat (*restrict SamplesIn)[BUFFERSIZE], ALfloat (*restrict SamplesOut)[BUFFERSIZE], ALsizei NumChannels);
+static ALvoid ALreverbState_process(ALreverbState *State, ALsizei SamplesToDo, ALfloat *const *restrict SamplesIn, ALfloat *const *restrict SamplesOut, ALsizei NumChannels);
+static size_t ALreverbState_getMemorySize(ALreverbState *State);
 DECLARE_DEFAULT_ALLOCATORS(ALreverbState)
 
 DEFINE_ALEFFECTSTATE_VTABLE(ALreverbState);
 
+
+static void EarlyReflection_Unfaded_C(ALreverbState *State, const ALsizei todo, ALfloat fade,
+                                      ALfloat (*restrict out)[MAX_UPDATE_SAMPLES]);
+static void EarlyReflection_Faded_C(ALreverbState *State, const ALsizei todo, ALfloat fade,
+                                    ALfloat (*restrict out)[MAX_UPDATE_SAMPLES]);
+static void LateReverb_Unfaded_C(ALreverbState *State, const ALsizei todo, ALfloat fade,
+                                 ALfloat (*restrict out)[MAX_UPDATE_SAMPLES]);
+static void LateReverb_Faded_C(ALreverbState *State, const ALsizei todo, ALfloat fade,
+                               ALfloat (*restrict out)[MAX_UPDATE_SAMPLES]);
+static void LateReverbPair_Unfaded_C(ALreverbState *State, const ALsizei todo, ALfloat fade,
+                                     ALfloat (*restrict out)[MAX_UPDATE_SAMPLES]);
+static void LateReverbPair_Faded_C(ALreverbState *State, const ALsizei todo, ALfloat fade,
+                                   ALfloat (*restrict out)[MAX_UPDATE_SAMPLES]);
+static void LateReverbLines_Unfaded_C(ALreverbState *State, const ALsizei todo, ALfloat fade,
+                                      ALfloat (*restrict out)[MAX_UPDATE_SAMPLES]);
+static void LateReverbLines_Faded_C(ALreverbState *State, const ALsizei todo, ALfloat fade,
+                                    ALfloat (*restrict out)[MAX_UPDATE_SAMPLES]);
+
+static void SelectReverbProcs(ALreverbState *state)
+{
+    const ALsizei numLines = state->Late.NumLines;
+
+    state->EarlyUnfaded = EarlyReflection_Unfaded_C;
+    state->EarlyFaded = EarlyReflection_Faded_C;
+    if(numLines == NUM_LINES)
+    {
+        state->LateUnfaded = LateReverb_Unfaded_C;
+        state->LateFaded = LateReverb_Faded_C;
+    }
+    else if(numLines < NUM_LINES)
+    {
+        state->LateUnfaded = LateReverbPair_Unfaded_C;
+        state->LateFaded = LateReverbPair_Faded_C;
+    }
+    else
+    {
+        state->LateUnfaded = LateReverbLines_Unfaded_C;
+        state->LateFaded = LateReverbLines_Faded_C;
+    }
+
+#ifdef HAVE_NEON
+    if((CPUCapFlags&CPU_CAP_NEON))
+    {
+        state->EarlyUnfaded = EarlyReflection_Unfaded_Neon;
+        state->EarlyFaded = EarlyReflection_Faded_Neon;
+        if(numLines == NUM_LINES)
+        {
+            state->LateUnfaded = LateReverb_Unfaded_Neon;
+            state->LateFaded = LateReverb_Faded_Neon;
+        }
+        else if(numLines > NUM_LINES)
+        {
+            state->LateUnfaded = LateReverbGroups_Unfaded_Neon;
+            state->LateFaded = LateReverbGroups_Faded_Neon;
+        }
+        return;
+    }
+#endif
+#ifdef HAVE_SSE
+    if((CPUCapFlags&CPU_CAP_SSE))
+    {
+        state->EarlyUnfaded = EarlyReflection_Unfaded_SSE;
+        state->EarlyFaded = EarlyReflection_Faded_SSE;
+        if(numLines == NUM_LINES)
+        {
+            state->LateUnfaded = LateReverb_Unfaded_SSE;
+            state->LateFaded = LateReverb_Faded_SSE;
+        }
+        else if(numLines > NUM_LINES)
+        {
+            state->LateUnfaded = LateReverbGroups_Unfaded_SSE;
+            state->LateFaded = LateReverbGroups_Faded_SSE;
+        }
+        return;
+    }
+#endif
+}
+
 static void ALreverbState_Construct(ALreverbState *state)
 {
     ALsizei i, j;
@@ -346,8 +340,7 @@ static void ALreverbState_Construct(ALreverbState *state)
     ALeffectState_Construct(STATIC_CAST(ALeffectState, state));
     SET_VTABLE2(ALreverbState, ALeffectState, state);
 
-    state->TotalSamples = 0;
-    state->SampleBuffer = NULL;
+    state->Buffer = NULL;
 
     for(i = 0;i < NUM_LINES;i++)
     {
@@ -367,7 +360,7 @@ static void ALreverbState_Construct(ALreverbState *state)
 
     state->LateFeedTap = 0;
 
-    for(i = 0;i < NUM_LINES;i++)
+    for(i = 0;i < MAX_LATE_LINES;i++)
     {
         state->LateDelayTap[i][0] = 0;
         state->LateDelayTap[i][1] = 0;
@@ -390,20 +383,33 @@ static void ALreverbState_Construct(ALreverbState *state)
         state->Early.Coeff[i] = 0.0f;
     }
 
+    state->Late.NumLines = NUM_LINES;
+    state->Late.NumGroups = 1;
+    state->Late.LineLengths = LATE_LINE_LENGTHS;
+    state->Late.AllpassLengths = LATE_ALLPASS_LENGTHS;
     state->Late.DensityGain = 0.0f;
+    state->Late.MixX = 0.0f;
+    state->Late.MixY = 0.0f;
+    state->Late.GroupMixX = 0.0f;
+    state->Late.GroupMixY = 0.0f;
 
-    state->Late.Delay.Mask = 0;
-    state->Late.Delay.Line = NULL;
-    state->Late.VecAp.Delay.Mask = 0;
-    state->Late.VecAp.Delay.Line = NULL;
-    for(i = 0;i < NUM_LINES;i++)
+    for(i = 0;i < MAX_LATE_GROUPS;i++)
+    {
+        state->Late.Delay[i].Mask = 0;
+        state->Late.Delay[i].Line = NULL;
+        state->Late.VecAp[i].Delay.Mask = 0;
+        state->Late.VecAp[i].Delay.Line = NULL;
+        for(j = 0;j < NUM_LINES;j++)
+        {
+            state->Late.VecAp[i].Offset[j][0] = 0;
+            state->Late.VecAp[i].Offset[j][1] = 0;
+        }
+    }
+    for(i = 0;i < MAX_LATE_LINES;i++)
     {
         state->Late.Offset[i][0] = 0;
         state->Late.Offset[i][1] = 0;
 
-        state->Late.VecAp.Offset[i][0] = 0;
-        state->Late.VecAp.Offset[i][1] = 0;
-
         for(j = 0;j < 3;j++)
         {
             state->Late.T60[i].HFCoeffs[j] = 0.0f;
@@ -428,12 +434,14 @@ static void ALreverbState_Construct(ALreverbState *state)
 
     state->FadeCount = 0;
     state->Offset = 0;
+
+    SelectReverbProcs(state);
 }
 
 static ALvoid ALreverbState_Destruct(ALreverbState *State)
 {
-    al_free(State->SampleBuffer);
-    State->SampleBuffer = NULL;
+    al_free(State->Buffer);
+    State->Buffer = NULL;
 
     ALeffectState_Destruct(STATIC_CAST(ALeffectState,State));
 }
@@ -447,133 +455,275 @@ static inline ALfloat CalcDelayLengthMult(ALfloat density)
     return maxf(5.0f, cbrtf(density*DENSITY_SCALE));
 }
 
-/* Given the allocated sample buffer, this function updates each delay line
- * offset.
+/* Calculates the lengths the delay lines need to hold for the given
+ * properties. These follow the tap and offset calculations in
+ * UpdateDelayLine, UpdateEarlyLines, and UpdateLateLines, for the longest
+ * line of each set.
  */
-static inline ALvoid RealizeLineOffset(ALfloat *sampleBuffer, DelayLineI *Delay)
-{
-    union {
-        ALfloat *f;
-        ALfloat (*f4)[NUM_LINES];
-    } u;
-    u.f = &sampleBuffer[(ptrdiff_t)Delay->Line * NUM_LINES];
-    Delay->Line = u.f4;
-}
-
-/* Calculate the length of a delay line and store its mask and offset. */
-static ALuint CalcLineLength(const ALfloat length, const ptrdiff_t offset, const ALuint frequency,
-                             const ALuint extra, DelayLineI *Delay)
+static ALvoid CalcLineSizes(const ALfloat density, const ALfloat earlyDelay, const ALfloat lateDelay, const ALfloat echoTime, const ALfloat echoDepth, const ALuint frequency, const LateReverb *Late, ReverbLineSizes *sizes)
 {
-    ALuint samples;
+    const ALfloat *lineLengths = Late->LineLengths;
+    const ALsizei last = Late->NumLines - 1;
+    ALfloat multiplier, length;
+
+    multiplier = CalcDelayLengthMult(density);
 
-    /* All line lengths are powers of 2, calculated from their lengths in
-     * seconds, rounded up.
+    /* The main delay line needs the latest early reflection tap, which is
+     * also where the late reverb is fed, and the latest late reverb tap
+     * after it.
      */
-    samples = fastf2i(ceilf(length*frequency));
-    samples = NextPowerOf2(samples + extra);
+    length = earlyDelay + EARLY_TAP_LENGTHS[NUM_LINES-1]*multiplier;
+    sizes->EarlyTaps = fastf2i(length * frequency);
+    length = lateDelay + (lineLengths[last] - lineLengths[0])*0.25f*multiplier;
+    sizes->LateTaps = fastf2i(length * frequency);
+
+    length = EARLY_ALLPASS_LENGTHS[NUM_LINES-1] * multiplier;
+    sizes->EarlyAllpass = fastf2i(length * frequency);
+    length = EARLY_LINE_LENGTHS[NUM_LINES-1] * multiplier;
+    sizes->Early = fastf2i(length * frequency);
 
-    /* All lines share a single sample buffer. */
-    Delay->Mask = samples - 1;
-    Delay->Line = (ALfloat(*)[NUM_LINES])offset;
+    length = Late->AllpassLengths[last] * multiplier;
+    sizes->LateAllpass = fastf2i(length * frequency);
+    /* The late lines approach the echo time with the echo depth. */
+    length = lerp(lineLengths[last] * multiplier, echoTime, echoDepth);
+    sizes->Late = fastf2i(length*frequency + 0.5f);
+}
 
-    /* Return the sample count for accumulation. */
-    return samples;
+/* Gets the number of sample frames a delay line needs to hold the given
+ * length. Lines are written before they're read, so a delay of the full
+ * length needs one more sample, and the result is rounded up to a power of 2
+ * to allow the use of bit-masking instead of a modulus for wrapping.
+ */
+static inline ALsizei CalcLineLength(const ALsizei length)
+{
+    return NextPowerOf2(length + 1);
 }
 
-/* Calculates the delay line metrics and allocates the shared sample buffer
- * for all lines given the sample rate (frequency).  If an allocation failure
- * occurs, it returns AL_FALSE.
+/* Gets the number of sample frames needed for all lines of the given sizes.
+ * The main delay line must also be extended by the update size
+ * (MAX_UPDATE_SAMPLES) for block processing.
  */
-static ALboolean AllocLines(const ALuint frequency, ALreverbState *State)
+static ALsizei CalcBufferLength(const ReverbLineSizes *sizes, const ALsizei numGroups)
 {
-    ALuint totalSamples, i;
-    ALfloat multiplier, length;
+    return CalcLineLength(sizes->EarlyTaps + sizes->LateTaps + MAX_UPDATE_SAMPLES) +
+           CalcLineLength(sizes->EarlyAllpass) + CalcLineLength(sizes->Early) +
+           (CalcLineLength(sizes->LateAllpass) + CalcLineLength(sizes->Late))*numGroups;
+}
 
-    /* All delay line lengths are calculated to accomodate the full range of
-     * lengths given their respective paramters.
-     */
-    totalSamples = 0;
+/* Sets up a delay line at the given offset of the sample buffer, returning
+ * the offset of the next line.
+ */
+static ALsizei SetDelayLine(DelayLineI *Delay, ReverbBuffer *buffer, const ALsizei offset,
+                            const ALsizei length)
+{
+    Delay->Mask = CalcLineLength(length) - 1;
+    Delay->Line = &buffer->Samples[offset];
+    return offset + Delay->Mask + 1;
+}
 
-    /* Multiplier for the maximum density value, i.e. density=1, which is
-     * actually the least density...
-     */
-    multiplier = CalcDelayLengthMult(AL_EAXREVERB_MAX_DENSITY);
+/* Points each delay line into the given sample buffer, in the same order
+ * CalcBufferLength counts them.
+ */
+static ALvoid RealizeLines(ALreverbState *State, ReverbBuffer *buffer)
+{
+    const ReverbLineSizes *sizes = &buffer->Sizes;
+    ALsizei offset, i;
 
-    /* The main delay length includes the maximum early reflection delay, the
-     * largest early tap width, the maximum late reverb delay, and the
-     * largest late tap width.  Finally, it must also be extended by the
-     * update size (MAX_UPDATE_SAMPLES) for block processing.
+    offset = SetDelayLine(&State->Delay, buffer, 0,
+                          sizes->EarlyTaps + sizes->LateTaps + MAX_UPDATE_SAMPLES);
+    offset = SetDelayLine(&State->Early.VecAp.Delay, buffer, offset, sizes->EarlyAllpass);
+    offset = SetDelayLine(&State->Early.Delay, buffer, offset, sizes->Early);
+
+    /* The late vector all-pass and delay lines, for each group of late
+     * lines.
      */
-    length = AL_EAXREVERB_MAX_REFLECTIONS_DELAY + EARLY_TAP_LENGTHS[NUM_LINES-1]*multiplier +
-             AL_EAXREVERB_MAX_LATE_REVERB_DELAY +
-             (LATE_LINE_LENGTHS[NUM_LINES-1] - LATE_LINE_LENGTHS[0])*0.25f*multiplier;
-    totalSamples += CalcLineLength(length, totalSamples, frequency, MAX_UPDATE_SAMPLES,
-                                   &State->Delay);
+    for(i = 0;i < State->Late.NumGroups;i++)
+    {
+        offset = SetDelayLine(&State->Late.VecAp[i].Delay, buffer, offset,
+                              sizes->LateAllpass);
+        offset = SetDelayLine(&State->Late.Delay[i], buffer, offset, sizes->Late);
+    }
 
-    /* The early vector all-pass line. */
-    length = EARLY_ALLPASS_LENGTHS[NUM_LINES-1] * multiplier;
-    totalSamples += CalcLineLength(length, totalSamples, frequency, 0,
-                                   &State->Early.VecAp.Delay);
+    /* The late reverb is fed past the latest early reflection tap. */
+    State->LateFeedTap = sizes->EarlyTaps;
+}
 
-    /* The early reflection line. */
-    length = EARLY_LINE_LENGTHS[NUM_LINES-1] * multiplier;
-    totalSamples += CalcLineLength(length, totalSamples, frequency, 0,
-                                   &State->Early.Delay);
+/* Allocates a zeroed sample buffer for the given line sizes. */
+static ReverbBuffer *CreateReverbBuffer(const ReverbLineSizes *sizes, const ALsizei numGroups)
+{
+    const ALsizei total = CalcBufferLength(sizes, numGroups);
+    ReverbBuffer *buffer;
 
-    /* The late vector all-pass line. */
-    length = LATE_ALLPASS_LENGTHS[NUM_LINES-1] * multiplier;
-    totalSamples += CalcLineLength(length, totalSamples, frequency, 0,
-                                   &State->Late.VecAp.Delay);
+    buffer = al_calloc(16, FAM_SIZE(ReverbBuffer, Samples, total));
+    if(!buffer) return NULL;
 
-    /* The late delay lines are calculated from the larger of the maximum
-     * density line length or the maximum echo time.
-     */
-    length = maxf(AL_EAXREVERB_MAX_ECHO_TIME, LATE_LINE_LENGTHS[NUM_LINES-1]*multiplier);
-    totalSamples += CalcLineLength(length, totalSamples, frequency, 0,
-                                   &State->Late.Delay);
+    TRACE("New reverb buffer length: %dx4 samples\n", total);
+    buffer->Sizes = *sizes;
+
+    return buffer;
+}
+
+/* Copies the history of a delay line into another, keeping each sample at the
+ * same offset from the current write position.
+ */
+static void CopyDelayLine(const DelayLineI *dst, const DelayLineI *src, const ALsizei offset)
+{
+    const ALsizei count = mini(dst->Mask, src->Mask) + 1;
+    ALsizei i;
+
+    for(i = 1;i <= count;i++)
+        memcpy(dst->Line[(offset-i)&dst->Mask], src->Line[(offset-i)&src->Mask],
+               sizeof(dst->Line[0]));
+}
 
-    if(totalSamples != State->TotalSamples)
+/* Switches to the given sample buffer, returning the old one. The delay
+ * lines' contents are carried over so the reverb continues uninterrupted. The
+ * late feed may move further back, which only shifts the late reverb input
+ * that straddles the switch. The mixer must not be using the state.
+ */
+static ReverbBuffer *SwapReverbBuffer(ALreverbState *State, ReverbBuffer *buffer)
+{
+    const ALsizei numGroups = State->Late.NumGroups;
+    DelayLineI delay, earlyAp, early;
+    DelayLineI lateAp[MAX_LATE_GROUPS], late[MAX_LATE_GROUPS];
+    ReverbBuffer *oldbuffer;
+    ALsizei i;
+
+    delay = State->Delay;
+    earlyAp = State->Early.VecAp.Delay;
+    early = State->Early.Delay;
+    for(i = 0;i < numGroups;i++)
     {
-        ALfloat *newBuffer;
+        lateAp[i] = State->Late.VecAp[i].Delay;
+        late[i] = State->Late.Delay[i];
+    }
 
-        TRACE("New reverb buffer length: %ux4 samples\n", totalSamples);
-        newBuffer = al_calloc(16, sizeof(ALfloat[NUM_LINES]) * totalSamples);
-        if(!newBuffer) return AL_FALSE;
+    RealizeLines(State, buffer);
 
-        al_free(State->SampleBuffer);
-        State->SampleBuffer = newBuffer;
-        State->TotalSamples = totalSamples;
+    CopyDelayLine(&State->Delay, &delay, State->Offset);
+    CopyDelayLine(&State->Early.VecAp.Delay, &earlyAp, State->Offset);
+    CopyDelayLine(&State->Early.Delay, &early, State->Offset);
+    for(i = 0;i < numGroups;i++)
+    {
+        CopyDelayLine(&State->Late.VecAp[i].Delay, &lateAp[i], State->Offset);
+        CopyDelayLine(&State->Late.Delay[i], &late[i], State->Offset);
     }
 
-    /* Update all delays to reflect the new sample buffer. */
-    RealizeLineOffset(State->SampleBuffer, &State->Delay);
-    RealizeLineOffset(State->SampleBuffer, &State->Early.VecAp.Delay);
-    RealizeLineOffset(State->SampleBuffer, &State->Early.Delay);
-    RealizeLineOffset(State->SampleBuffer, &State->Late.VecAp.Delay);
-    RealizeLineOffset(State->SampleBuffer, &State->Late.Delay);
+    oldbuffer = State->Buffer;
+    State->Buffer = buffer;
+    return oldbuffer;
+}
 
-    /* Clear the sample buffer. */
-    for(i = 0;i < State->TotalSamples;i++)
-        State->SampleBuffer[i] = 0.0f;
+/* Sets the size of the late reverb network from the device's reverb quality
+ * setting.
+ */
+static void SetLateNetworkSize(ALreverbState *State, const ALCdevice *Device)
+{
+    LateReverb *Late = &State->Late;
+    const char *str;
 
-    return AL_TRUE;
+    Late->NumLines = NUM_LINES;
+    if(ConfigValueStr(alstr_get_cstr(Device->DeviceName), "reverb", "quality", &str))
+    {
+        if(strcasecmp(str, "low") == 0)
+            Late->NumLines = 2;
+        else if(strcasecmp(str, "high") == 0)
+            Late->NumLines = 8;
+        else if(strcasecmp(str, "ultra") == 0)
+            Late->NumLines = 16;
+        else if(strcasecmp(str, "medium") != 0)
+            ERR("Unexpected reverb quality: %s\n", str);
+    }
+
+    switch(Late->NumLines)
+    {
+        case 2:
+            Late->LineLengths = LATE_LINE_LENGTHS_2;
+            Late->AllpassLengths = LATE_ALLPASS_LENGTHS_2;
+            break;
+        case 8:
+            Late->LineLengths = LATE_LINE_LENGTHS_8;
+            Late->AllpassLengths = LATE_ALLPASS_LENGTHS_8;
+            break;
+        case 16:
+            Late->LineLengths = LATE_LINE_LENGTHS_16;
+            Late->AllpassLengths = LATE_ALLPASS_LENGTHS_16;
+            break;
+        default:
+            Late->LineLengths = LATE_LINE_LENGTHS;
+            Late->AllpassLengths = LATE_ALLPASS_LENGTHS;
+            break;
+    }
+    Late->NumGroups = maxi(Late->NumLines / NUM_LINES, 1);
+    TRACE("Using %d late reverb lines\n", Late->NumLines);
 }
 
 static ALboolean ALreverbState_deviceUpdate(ALreverbState *State, ALCdevice *Device)
 {
-    ALuint frequency = Device->Frequency;
-    ALfloat multiplier;
+    ReverbLineSizes sizes;
+    ReverbBuffer *buffer;
 
-    /* Allocate the delay lines. */
-    if(!AllocLines(frequency, State))
-        return AL_FALSE;
+    SetLateNetworkSize(State, Device);
+    SelectReverbProcs(State);
+
+    /* Start with minimal delay lines. The slot's properties are always
+     * prepared before the mixer gets this state, which will grow the lines to
+     * what they need.
+     */
+    memset(&sizes, 0, sizeof(sizes));
+    buffer = CreateReverbBuffer(&sizes, State->Late.NumGroups);
+    if(!buffer) return AL_FALSE;
+
+    al_free(State->Buffer);
+
+    State->Buffer = buffer;
+    RealizeLines(State, buffer);
 
-    multiplier = CalcDelayLengthMult(AL_EAXREVERB_MAX_DENSITY);
+    return AL_TRUE;
+}
 
-    /* The late feed taps are set a fixed position past the latest delay tap. */
-    State->LateFeedTap = fastf2i((AL_EAXREVERB_MAX_REFLECTIONS_DELAY +
-                                  EARLY_TAP_LENGTHS[NUM_LINES-1]*multiplier) *
-                                 frequency);
+/* Grows the delay lines if the new properties need them to be longer. The
+ * lines are only shrunk again by a device update, so properties that change
+ * back and forth won't keep reallocating them, and the mixer never has to
+ * read past the end of a line while cross-fading from older taps. The new
+ * buffer is allocated and filled here, off the mixer thread, with the device
+ * only locked for the switch.
+ */
+static ALboolean ALreverbState_prepare(ALreverbState *State, const ALCdevice *Device, const ALeffectProps *props)
+{
+    const ReverbLineSizes *cursizes;
+    ReverbLineSizes sizes;
+    ReverbBuffer *buffer;
+
+    if(!State->Buffer)
+        return AL_FALSE;
+    cursizes = &State->Buffer->Sizes;
+
+    CalcLineSizes(props->Reverb.Density, props->Reverb.ReflectionsDelay,
+                  props->Reverb.LateReverbDelay, props->Reverb.EchoTime,
+                  props->Reverb.EchoDepth, Device->Frequency, &State->Late, &sizes);
+    if(sizes.EarlyTaps <= cursizes->EarlyTaps &&
+       sizes.LateTaps <= cursizes->LateTaps &&
+       sizes.EarlyAllpass <= cursizes->EarlyAllpass &&
+       sizes.Early <= cursizes->Early &&
+       sizes.LateAllpass <= cursizes->LateAllpass &&
+       sizes.Late <= cursizes->Late)
+        return AL_TRUE;
+
+    sizes.EarlyTaps = maxi(sizes.EarlyTaps, cursizes->EarlyTaps);
+    sizes.LateTaps = maxi(sizes.LateTaps, cursizes->LateTaps);
+    sizes.EarlyAllpass = maxi(sizes.EarlyAllpass, cursizes->EarlyAllpass);
+    sizes.Early = maxi(sizes.Early, cursizes->Early);
+    sizes.LateAllpass = maxi(sizes.LateAllpass, cursizes->LateAllpass);
+    sizes.Late = maxi(sizes.Late, cursizes->Late);
+
+    buffer = CreateReverbBuffer(&sizes, State->Late.NumGroups);
+    if(!buffer) return AL_FALSE;
+
+    V0(Device->Backend,lock)();
+    buffer = SwapReverbBuffer(State, buffer);
+    V0(Device->Backend,unlock)();
+    al_free(buffer);
 
     return AL_TRUE;
 }
@@ -619,13 +769,24 @@ static inline ALfloat CalcDensityGain(const ALfloat a)
     return sqrtf(1.0f - a*a);
 }
 
-/* Calculate the scattering matrix coefficients given a diffusion factor. */
-static inline ALvoid CalcMatrixCoeffs(const ALfloat diffusion, ALfloat *x, ALfloat *y)
+/* Calculate the scattering matrix coefficients given the matrix order and a
+ * diffusion factor.
+ */
+static inline ALvoid CalcMatrixCoeffs(const ALsizei order, const ALfloat diffusion,
+                                      ALfloat *x, ALfloat *y)
 {
     ALfloat n, t;
 
-    /* The matrix is of order 4, so n is sqrt(4 - 1). */
-    n = sqrtf(3.0f);
+    /* The matrix is of order 1, 2, or 4, so n is sqrt(order - 1). An order 1
+     * matrix is just the identity.
+     */
+    n = sqrtf((ALfloat)(order - 1));
+    if(!(n > 0.0f))
+    {
+        *x = 1.0f;
+        *y = 0.0f;
+        return;
+    }
     t = diffusion * atanf(n);
 
     /* Calculate the first mixing matrix coefficient. */
@@ -959,8 +1120,11 @@ static ALvoid UpdateDelayLine(const ALfloat earlyDelay, const ALfloat lateDelay,
 
         length = EARLY_TAP_LENGTHS[i]*multiplier;
         State->EarlyDelayCoeff[i] = CalcDecayCoeff(length, decayTime);
-
-        length = lateDelay + (LATE_LINE_LENGTHS[i] - LATE_LINE_LENGTHS[0])*0.25f*multiplier;
+    }
+    for(i = 0;i < (ALuint)State->Late.NumLines;i++)
+    {
+        const ALfloat *lineLengths = State->Late.LineLengths;
+        length = lateDelay + (lineLengths[i] - lineLengths[0])*0.25f*multiplier;
         State->LateDelayTap[i][1] = State->LateFeedTap + fastf2i(length * frequency);
     }
 }
@@ -992,11 +1156,28 @@ static ALvoid UpdateEarlyLines(const ALfloat density, const ALfloat decayTime, c
     }
 }
 
-/* Update the late reverb line lengths and T60 coefficients. */
+/* Update the late reverb line lengths, T60 coefficients, and scattering
+ * matrices.
+ */
 static ALvoid UpdateLateLines(const ALfloat density, const ALfloat diffusion, const ALfloat lfDecayTime, const ALfloat mfDecayTime, const ALfloat hfDecayTime, const ALfloat lfW, const ALfloat hfW, const ALfloat echoTime, const ALfloat echoDepth, const ALuint frequency, LateReverb *Late)
 {
+    const ALfloat *lineLengths = Late->LineLengths;
+    const ALfloat *apLengths = Late->AllpassLengths;
+    const ALsizei numLines = Late->NumLines;
     ALfloat multiplier, length, bandWeights[3];
-    ALsizei i;
+    ALfloat lineAvg, apAvg;
+    ALsizei i, g;
+
+    /* Get the average lengths of the delay lines and all-pass lines. */
+    lineAvg = 0.0f;
+    apAvg = 0.0f;
+    for(i = 0;i < numLines;i++)
+    {
+        lineAvg += lineLengths[i];
+        apAvg += apLengths[i];
+    }
+    lineAvg /= (ALfloat)numLines;
+    apAvg /= (ALfloat)numLines;
 
     /* To compensate for changes in modal density and decay time of the late
      * reverb signal, the input is attenuated based on the maximal energy of
@@ -1007,12 +1188,10 @@ static ALvoid UpdateLateLines(const ALfloat density, const ALfloat diffusion, co
      * attenuation coefficient.
      */
     multiplier = CalcDelayLengthMult(density);
-    length = (LATE_LINE_LENGTHS[0] + LATE_LINE_LENGTHS[1] +
-              LATE_LINE_LENGTHS[2] + LATE_LINE_LENGTHS[3]) / 4.0f * multiplier;
+    length = lineAvg * multiplier;
     /* Include the echo transformation (see below). */
     length = lerp(length, echoTime, echoDepth);
-    length += (LATE_ALLPASS_LENGTHS[0] + LATE_ALLPASS_LENGTHS[1] +
-               LATE_ALLPASS_LENGTHS[2] + LATE_ALLPASS_LENGTHS[3]) / 4.0f * multiplier;
+    length += apAvg * multiplier;
     /* The density gain calculation uses an average decay time weighted by
      * approximate bandwidth.  This attempts to compensate for losses of
      * energy that reduce decay time due to scattering into highly attenuated
@@ -1025,33 +1204,49 @@ static ALvoid UpdateLateLines(const ALfloat density, const ALfloat diffusion, co
         CalcDecayCoeff(length, (bandWeights[0]*lfDecayTime + bandWeights[1]*mfDecayTime +
                                 bandWeights[2]*hfDecayTime) / F_TAU)
     );
+    /* When there are more lines than A-Format channels, each channel feeds
+     * multiple lines, and when there are fewer, each line takes multiple
+     * channels. Scale the input so the network gets the same energy as the
+     * 4-line network would, with the outputs being summed or shared as-is.
+     */
+    if(numLines != NUM_LINES)
+        Late->DensityGain *= sqrtf((ALfloat)mini(numLines, NUM_LINES) /
+                                   (ALfloat)maxi(numLines, NUM_LINES));
 
-    for(i = 0;i < NUM_LINES;i++)
+    /* Get the mixing matrix coefficients for the lines in each group, and
+     * between the groups.
+     */
+    if(numLines < NUM_LINES)
+        CalcMatrixCoeffs(2, diffusion, &Late->MixX, &Late->MixY);
+    else
+        CalcMatrixCoeffs(NUM_LINES, diffusion, &Late->MixX, &Late->MixY);
+    CalcMatrixCoeffs(Late->NumGroups, diffusion, &Late->GroupMixX, &Late->GroupMixY);
+
+    for(i = 0;i < numLines;i++)
     {
+        g = i / NUM_LINES;
+
         /* Calculate the length (in seconds) of each all-pass line. */
-        length = LATE_ALLPASS_LENGTHS[i] * multiplier;
+        length = apLengths[i] * multiplier;
 
         /* Calculate the delay offset for each all-pass line. */
-        Late->VecAp.Offset[i][1] = fastf2i(length * frequency);
+        Late->VecAp[g].Offset[i%NUM_LINES][1] = fastf2i(length * frequency);
 
         /* Calculate the length (in seconds) of each delay line.  This also
          * applies the echo transformation.  As the EAX echo depth approaches
          * 1, the line lengths approach a length equal to the echoTime.  This
          * helps to produce distinct echoes along the tail.
          */
-        length = lerp(LATE_LINE_LENGTHS[i] * multiplier, echoTime, echoDepth);
+        length = lerp(lineLengths[i] * multiplier, echoTime, echoDepth);
 
         /* Calculate the delay offset for each delay line. */
         Late->Offset[i][1] = fastf2i(length*frequency + 0.5f);
 
         /* Approximate the absorption that the vector all-pass would exhibit
          * given the current diffusion so we don't have to process a full T60
-         * filter for each of its four lines.
+         * filter for each of its lines.
          */
-        length += lerp(LATE_ALLPASS_LENGTHS[i],
-                       (LATE_ALLPASS_LENGTHS[0] + LATE_ALLPASS_LENGTHS[1] +
-                        LATE_ALLPASS_LENGTHS[2] + LATE_ALLPASS_LENGTHS[3]) / 4.0f,
-                       diffusion) * multiplier;
+        length += lerp(apLengths[i], apAvg, diffusion) * multiplier;
 
         /* Calculate the T60 damping coefficients for each line. */
         CalcT60DampingCoeffs(length, lfDecayTime, mfDecayTime, hfDecayTime,
@@ -1152,7 +1347,7 @@ static ALvoid ALreverbState_update(ALreverbState *State, const ALCcontext *Conte
     const ALlistener *Listener = Context->Listener;
     ALuint frequency = Device->Frequency;
     ALfloat lf0norm, hf0norm, hfRatio;
-    ALfloat lfDecayTime, hfDecayTime;
+    ALfloat lfDecayTime, hfDecayTime, decayTime;
     ALfloat gain, gainlf, gainhf;
     ALsizei i;
 
@@ -1187,7 +1382,7 @@ static ALvoid ALreverbState_update(ALreverbState *State, const ALCcontext *Conte
                      frequency, &State->Early);
 
     /* Get the mixing matrix coefficients. */
-    CalcMatrixCoeffs(props->Reverb.Diffusion, &State->MixX, &State->MixY);
+    CalcMatrixCoeffs(NUM_LINES, props->Reverb.Diffusion, &State->MixX, &State->MixY);
 
     /* If the HF limit parameter is flagged, calculate an appropriate limit
      * based on the air absorption parameter.
@@ -1211,6 +1406,17 @@ static ALvoid ALreverbState_update(ALreverbState *State, const ALCcontext *Conte
                     props->Reverb.EchoTime, props->Reverb.EchoDepth,
                     frequency, &State->Late);
 
+    /* The tail lasts through the reflections and late reverb delays and the
+     * longest late line, until the slowest decaying band falls below the
+     * tail gain.
+     */
+    decayTime = maxf(props->Reverb.DecayTime, maxf(lfDecayTime, hfDecayTime));
+    STATIC_CAST(ALeffectState,State)->TailLength = ClampTailLength(
+        (props->Reverb.ReflectionsDelay + props->Reverb.LateReverbDelay +
+         decayTime*(logf(EFFECT_TAIL_GAIN)/logf(REVERB_DECAY_GAIN))) * frequency +
+        State->Late.Offset[State->Late.NumLines-1][1]
+    );
+
     /* Update early and late 3D panning. */
     gain = props->Reverb.Gain * Slot->Params.Gain * ReverbBoost;
     Update3DPanning(Device, props->Reverb.ReflectionsPan,
@@ -1223,13 +1429,21 @@ static ALvoid ALreverbState_update(ALreverbState *State, const ALCcontext *Conte
     {
         if(State->EarlyDelayTap[i][1] != State->EarlyDelayTap[i][0] ||
            State->Early.VecAp.Offset[i][1] != State->Early.VecAp.Offset[i][0] ||
-           State->Early.Offset[i][1] != State->Early.Offset[i][0] ||
-           State->LateDelayTap[i][1] != State->LateDelayTap[i][0] ||
-           State->Late.VecAp.Offset[i][1] != State->Late.VecAp.Offset[i][0] ||
+           State->Early.Offset[i][1] != State->Early.Offset[i][0])
+        {
+            State->FadeCount = 0;
+            return;
+        }
+    }
+    for(i = 0;i < State->Late.NumLines;i++)
+    {
+        const VecAllpass *vap = &State->Late.VecAp[i/NUM_LINES];
+        if(State->LateDelayTap[i][1] != State->LateDelayTap[i][0] ||
+           vap->Offset[i%NUM_LINES][1] != vap->Offset[i%NUM_LINES][0] ||
            State->Late.Offset[i][1] != State->Late.Offset[i][0])
         {
             State->FadeCount = 0;
-            break;
+            return;
         }
     }
 }
@@ -1396,9 +1610,9 @@ DECL_TEMPLATE(Faded)
  * line processing and non-transitional processing.
  */
 #define DECL_TEMPLATE(T)                                                      \
-static void EarlyReflection_##T(ALreverbState *State, const ALsizei todo,     \
-                                ALfloat fade,                                 \
-                                ALfloat (*restrict out)[MAX_UPDATE_SAMPLES])  \
+static void EarlyReflection_##T##_C(ALreverbState *State, const ALsizei todo, \
+                                   ALfloat fade,                              \
+                                   ALfloat (*restrict out)[MAX_UPDATE_SAMPLES]) \
 {                                                                             \
     ALsizei offset = State->Offset;                                           \
     const ALfloat apFeedCoeff = State->ApFeedCoeff;                           \
@@ -1478,13 +1692,13 @@ static inline void LateT60Filter(ALfloat *restrict out, const ALfloat *restrict
  * processing and one for non-transitional processing.
  */
 #define DECL_TEMPLATE(T)                                                      \
-static void LateReverb_##T(ALreverbState *State, const ALsizei todo,          \
-                           ALfloat fade,                                      \
-                           ALfloat (*restrict out)[MAX_UPDATE_SAMPLES])       \
+static void LateReverb_##T##_C(ALreverbState *State, const ALsizei todo,      \
+                              ALfloat fade,                                   \
+                              ALfloat (*restrict out)[MAX_UPDATE_SAMPLES])    \
 {                                                                             \
     const ALfloat apFeedCoeff = State->ApFeedCoeff;                           \
-    const ALfloat mixX = State->MixX;                                         \
-    const ALfloat mixY = State->MixY;                                         \
+    const ALfloat mixX = State->Late.MixX;                                    \
+    const ALfloat mixY = State->Late.MixY;                                    \
     ALsizei offset;                                                           \
     ALsizei i, j;                                                             \
                                                                               \
@@ -1500,21 +1714,21 @@ static void LateReverb_##T(ALreverbState *State, const ALsizei todo,          \
             ) * State->Late.DensityGain;                                      \
                                                                               \
         for(j = 0;j < NUM_LINES;j++)                                          \
-            f[j] += T##DelayLineOut(&State->Late.Delay,                       \
+            f[j] += T##DelayLineOut(&State->Late.Delay[0],                    \
                 offset - State->Late.Offset[j][0],                            \
                 offset - State->Late.Offset[j][1], j, fade                    \
             );                                                                \
                                                                               \
         LateT60Filter(fr, f, State->Late.T60);                                \
         VectorAllpass_##T(f, fr, offset, apFeedCoeff, mixX, mixY, fade,       \
-                          &State->Late.VecAp);                                \
+                          &State->Late.VecAp[0]);                             \
                                                                               \
         for(j = 0;j < NUM_LINES;j++)                                          \
             out[j][i] = f[j];                                                 \
                                                                               \
         VectorPartialScatterRev(fr, f, mixX, mixY);                           \
                                                                               \
-        DelayLineIn4(&State->Late.Delay, offset, fr);                         \
+        DelayLineIn4(&State->Late.Delay[0], offset, fr);                      \
                                                                               \
         offset++;                                                             \
         fade += FadeStep;                                                     \
@@ -1524,7 +1738,223 @@ DECL_TEMPLATE(Unfaded)
 DECL_TEMPLATE(Faded)
 #undef DECL_TEMPLATE
 
-static ALvoid ALreverbState_process(ALreverbState *State, ALsizei SamplesToDo, const ALfloat (*restrict SamplesIn)[BUFFERSIZE], ALfloat (*restrict SamplesOut)[BUFFERSIZE], ALsizei NumChannels)
+/* Scatters the matching lines of each group of a larger late reverb network
+ * between the groups, using a matrix of the same form as above for the number
+ * of groups. Combined with scattering the lines within each group, this forms
+ * an orthogonal matrix over all the lines.
+ */
+static void GroupScatter(ALfloat *restrict out, const ALfloat *restrict in,
+                         const ALsizei numGroups, const ALfloat xCoeff,
+                         const ALfloat yCoeff)
+{
+    ALsizei i;
+
+    if(numGroups == 2)
+    {
+        for(i = 0;i < NUM_LINES;i++)
+        {
+            out[i]           = xCoeff*in[i]           + yCoeff*in[NUM_LINES+i];
+            out[NUM_LINES+i] = xCoeff*in[NUM_LINES+i] - yCoeff*in[i];
+        }
+    }
+    else
+    {
+        for(i = 0;i < NUM_LINES;i++)
+        {
+            ALfloat g[4] = { in[i], in[NUM_LINES+i], in[NUM_LINES*2+i], in[NUM_LINES*3+i] };
+            ALfloat gs[4];
+
+            VectorPartialScatter(gs, g, xCoeff, yCoeff);
+            out[i]             = gs[0];
+            out[NUM_LINES+i]   = gs[1];
+            out[NUM_LINES*2+i] = gs[2];
+            out[NUM_LINES*3+i] = gs[3];
+        }
+    }
+}
+
+/* Applies the scattering matrix to all lines of an 8- or 16-line late reverb
+ * network.
+ */
+static inline void LateScatter(ALfloat *restrict out, const ALfloat *restrict in,
+                               const LateReverb *Late)
+{
+    ALfloat f[MAX_LATE_LINES];
+    ALsizei g;
+
+    for(g = 0;g < Late->NumGroups;g++)
+        VectorPartialScatter(&f[g*NUM_LINES], &in[g*NUM_LINES], Late->MixX, Late->MixY);
+    GroupScatter(out, f, Late->NumGroups, Late->GroupMixX, Late->GroupMixY);
+}
+
+/* Same as above, but reverses the input. */
+static inline void LateScatterRev(ALfloat *restrict out, const ALfloat *restrict in,
+                                  const LateReverb *Late)
+{
+    ALfloat f[MAX_LATE_LINES];
+    ALsizei g;
+
+    for(g = 0;g < Late->NumGroups;g++)
+        VectorPartialScatterRev(&f[g*NUM_LINES], &in[(Late->NumGroups-1-g)*NUM_LINES],
+                                Late->MixX, Late->MixY);
+    GroupScatter(out, f, Late->NumGroups, Late->GroupMixX, Late->GroupMixY);
+}
+
+/* These are the same as the vector all-pass and late reverb above, but for
+ * 8- or 16-line late reverb networks. Each A-Format channel feeds and is fed
+ * by the lines in its position of every group.
+ */
+#define DECL_TEMPLATE(T)                                                      \
+static void LateAllpass_##T(ALfloat *restrict out, const ALfloat *restrict in,\
+                            const ALsizei offset, const ALfloat feedCoeff,    \
+                            const ALfloat mu, LateReverb *Late)               \
+{                                                                             \
+    ALfloat f[MAX_LATE_LINES], fs[MAX_LATE_LINES];                            \
+    ALsizei i;                                                                \
+                                                                              \
+    (void)mu; /* Ignore for Unfaded. */                                       \
+                                                                              \
+    for(i = 0;i < Late->NumLines;i++)                                         \
+    {                                                                         \
+        const VecAllpass *Vap = &Late->VecAp[i/NUM_LINES];                    \
+        const ALsizei c = i%NUM_LINES;                                        \
+                                                                              \
+        out[i] = T##DelayLineOut(&Vap->Delay, offset-Vap->Offset[c][0],       \
+                                 offset-Vap->Offset[c][1], c, mu) -           \
+                 feedCoeff*in[i];                                             \
+        f[i] = in[i] + feedCoeff*out[i];                                      \
+    }                                                                         \
+    LateScatter(fs, f, Late);                                                 \
+                                                                              \
+    for(i = 0;i < Late->NumLines;i++)                                         \
+        DelayLineIn(&Late->VecAp[i/NUM_LINES].Delay, offset, i%NUM_LINES,     \
+                    &fs[i], 1);                                               \
+}                                                                             \
+                                                                              \
+static void LateReverbLines_##T##_C(ALreverbState *State, const ALsizei todo, \
+                                    ALfloat fade,                             \
+                                    ALfloat (*restrict out)[MAX_UPDATE_SAMPLES])\
+{                                                                             \
+    LateReverb *Late = &State->Late;                                          \
+    const ALsizei numLines = Late->NumLines;                                  \
+    const ALfloat apFeedCoeff = State->ApFeedCoeff;                           \
+    ALsizei offset;                                                           \
+    ALsizei i, j, c;                                                          \
+                                                                              \
+    offset = State->Offset;                                                   \
+    for(i = 0;i < todo;i++)                                                   \
+    {                                                                         \
+        ALfloat f[MAX_LATE_LINES], fr[MAX_LATE_LINES];                        \
+                                                                              \
+        for(j = 0;j < numLines;j++)                                           \
+            f[j] = T##DelayLineOut(&State->Delay,                             \
+                offset - State->LateDelayTap[j][0],                           \
+                offset - State->LateDelayTap[j][1], j%NUM_LINES, fade         \
+            ) * Late->DensityGain;                                            \
+                                                                              \
+        for(j = 0;j < numLines;j++)                                           \
+            f[j] += T##DelayLineOut(&Late->Delay[j/NUM_LINES],                \
+                offset - Late->Offset[j][0],                                  \
+                offset - Late->Offset[j][1], j%NUM_LINES, fade                \
+            );                                                                \
+                                                                              \
+        for(j = 0;j < numLines;j++)                                           \
+            fr[j] = FirstOrderFilter(                                         \
+                FirstOrderFilter(f[j], Late->T60[j].HFCoeffs,                 \
+                                 Late->T60[j].HFState),                       \
+                Late->T60[j].LFCoeffs, Late->T60[j].LFState                   \
+            );                                                                \
+        LateAllpass_##T(f, fr, offset, apFeedCoeff, fade, Late);              \
+                                                                              \
+        for(c = 0;c < NUM_LINES;c++)                                          \
+        {                                                                     \
+            ALfloat sum = f[c];                                               \
+            for(j = NUM_LINES+c;j < numLines;j += NUM_LINES)                  \
+                sum += f[j];                                                  \
+            out[c][i] = sum;                                                  \
+        }                                                                     \
+                                                                              \
+        LateScatterRev(fr, f, Late);                                          \
+                                                                              \
+        for(j = 0;j < numLines;j++)                                           \
+            DelayLineIn(&Late->Delay[j/NUM_LINES], offset, j%NUM_LINES,       \
+                        &fr[j], 1);                                           \
+                                                                              \
+        offset++;                                                             \
+        fade += FadeStep;                                                     \
+    }                                                                         \
+}
+DECL_TEMPLATE(Unfaded)
+DECL_TEMPLATE(Faded)
+#undef DECL_TEMPLATE
+
+/* This is the late reverb for the 2-line network, which uses a 2D rotation
+ * for scattering. Each line is fed by, and feeds, the two A-Format channels
+ * on its side (0 and 2 on the left, 1 and 3 on the right).
+ */
+#define DECL_TEMPLATE(T)                                                      \
+static void LateReverbPair_##T##_C(ALreverbState *State, const ALsizei todo,  \
+                                   ALfloat fade,                              \
+                                   ALfloat (*restrict out)[MAX_UPDATE_SAMPLES])\
+{                                                                             \
+    LateReverb *Late = &State->Late;                                          \
+    VecAllpass *Vap = &Late->VecAp[0];                                        \
+    const ALfloat apFeedCoeff = State->ApFeedCoeff;                           \
+    const ALfloat densityGain = Late->DensityGain;                            \
+    const ALfloat mixX = Late->MixX;                                          \
+    const ALfloat mixY = Late->MixY;                                          \
+    ALsizei offset;                                                           \
+    ALsizei i, j;                                                             \
+                                                                              \
+    offset = State->Offset;                                                   \
+    for(i = 0;i < todo;i++)                                                   \
+    {                                                                         \
+        ALfloat f[2], fr[2], ap[2];                                           \
+                                                                              \
+        for(j = 0;j < 2;j++)                                                  \
+        {                                                                     \
+            f[j] = (T##DelayLineOut(&State->Delay,                            \
+                        offset - State->LateDelayTap[j][0],                   \
+                        offset - State->LateDelayTap[j][1], j, fade) +        \
+                    T##DelayLineOut(&State->Delay,                            \
+                        offset - State->LateDelayTap[j][0],                   \
+                        offset - State->LateDelayTap[j][1], j+2, fade)        \
+                   ) * densityGain;                                           \
+            f[j] += T##DelayLineOut(&Late->Delay[0],                          \
+                offset - Late->Offset[j][0],                                  \
+                offset - Late->Offset[j][1], j, fade                          \
+            );                                                                \
+            fr[j] = FirstOrderFilter(                                         \
+                FirstOrderFilter(f[j], Late->T60[j].HFCoeffs,                 \
+                                 Late->T60[j].HFState),                       \
+                Late->T60[j].LFCoeffs, Late->T60[j].LFState                   \
+            );                                                                \
+                                                                              \
+            f[j] = T##DelayLineOut(&Vap->Delay, offset-Vap->Offset[j][0],     \
+                                   offset-Vap->Offset[j][1], j, fade) -       \
+                   apFeedCoeff*fr[j];                                         \
+            ap[j] = fr[j] + apFeedCoeff*f[j];                                 \
+        }                                                                     \
+        Vap->Delay.Line[offset&Vap->Delay.Mask][0] = mixX*ap[0] + mixY*ap[1]; \
+        Vap->Delay.Line[offset&Vap->Delay.Mask][1] = mixX*ap[1] - mixY*ap[0]; \
+                                                                              \
+        out[0][i] = out[2][i] = f[0];                                         \
+        out[1][i] = out[3][i] = f[1];                                         \
+                                                                              \
+        Late->Delay[0].Line[offset&Late->Delay[0].Mask][0] =                  \
+            mixX*f[1] + mixY*f[0];                                            \
+        Late->Delay[0].Line[offset&Late->Delay[0].Mask][1] =                  \
+            mixX*f[0] - mixY*f[1];                                            \
+                                                                              \
+        offset++;                                                             \
+        fade += FadeStep;                                                     \
+    }                                                                         \
+}
+DECL_TEMPLATE(Unfaded)
+DECL_TEMPLATE(Faded)
+#undef DECL_TEMPLATE
+
+static ALvoid ALreverbState_process(ALreverbState *State, ALsizei SamplesToDo, ALfloat *const *restrict SamplesIn, ALfloat *const *restrict SamplesOut, ALsizei NumChannels)
 {
     ALfloat (*restrict afmt)[MAX_UPDATE_SAMPLES] = State->AFormatSamples;
     ALfloat (*restrict early)[MAX_UPDATE_SAMPLES] = State->EarlySamples;
@@ -1548,35 +1978,49 @@ static ALvoid ALreverbState_process(ALreverbState *State, ALsizei SamplesToDo, c
                 SamplesIn, MAX_EFFECT_CHANNELS, base, todo
             );
 
-        /* Process the samples for reverb. */
-        for(c = 0;c < NUM_LINES;c++)
+        /* Band-pass the incoming samples, all lines together. Use the early
+         * output lines for temp storage.
+         */
         {
-            /* Band-pass the incoming samples. Use the early output lines for
-             * temp storage.
-             */
-            ALfilterState_process(&State->Filter[c].Lp, early[0], afmt[c], todo);
-            ALfilterState_process(&State->Filter[c].Hp, early[1], early[0], todo);
-
-            /* Feed the initial delay line. */
-            DelayLineIn(&State->Delay, State->Offset, c, early[1], todo);
+            ALfilterState *filters[NUM_LINES];
+            const ALfloat *src[NUM_LINES];
+            ALfloat *dst[NUM_LINES];
+
+            for(c = 0;c < NUM_LINES;c++)
+            {
+                filters[c] = &State->Filter[c].Lp;
+                src[c] = afmt[c];
+                dst[c] = early[c];
+            }
+            MultiFilterSamples(filters, dst, src, NUM_LINES, todo);
+            for(c = 0;c < NUM_LINES;c++)
+            {
+                filters[c] = &State->Filter[c].Hp;
+                src[c] = early[c];
+            }
+            MultiFilterSamples(filters, dst, src, NUM_LINES, todo);
         }
 
+        /* Feed the initial delay line. */
+        for(c = 0;c < NUM_LINES;c++)
+            DelayLineIn(&State->Delay, State->Offset, c, early[c], todo);
+
         if(UNLIKELY(fadeCount < FADE_SAMPLES))
         {
             /* Generate early reflections. */
-            EarlyReflection_Faded(State, todo, fade, early);
+            State->EarlyFaded(State, todo, fade, early);
 
             /* Generate late reverb. */
-            LateReverb_Faded(State, todo, fade, late);
+            State->LateFaded(State, todo, fade, late);
             fade = minf(1.0f, fade + todo*FadeStep);
         }
         else
         {
             /* Generate early reflections. */
-            EarlyReflection_Unfaded(State, todo, fade, early);
+            State->EarlyUnfaded(State, todo, fade, early);
 
             /* Generate late reverb. */
-            LateReverb_Unfaded(State, todo, fade, late);
+            State->LateUnfaded(State, todo, fade, late);
         }
 
         /* Step all delays forward. */
@@ -1592,8 +2036,12 @@ static ALvoid ALreverbState_process(ALreverbState *State, ALsizei SamplesToDo, c
                 State->EarlyDelayTap[c][0] = State->EarlyDelayTap[c][1];
                 State->Early.VecAp.Offset[c][0] = State->Early.VecAp.Offset[c][1];
                 State->Early.Offset[c][0] = State->Early.Offset[c][1];
+            }
+            for(c = 0;c < State->Late.NumLines;c++)
+            {
+                VecAllpass *vap = &State->Late.VecAp[c/NUM_LINES];
                 State->LateDelayTap[c][0] = State->LateDelayTap[c][1];
-                State->Late.VecAp.Offset[c][0] = State->Late.VecAp.Offset[c][1];
+                vap->Offset[c%NUM_LINES][0] = vap->Offset[c%NUM_LINES][1];
                 State->Late.Offset[c][0] = State->Late.Offset[c][1];
             }
         }
@@ -1617,6 +2065,14 @@ static ALvoid ALreverbState_process(ALreverbState *State, ALsizei SamplesToDo, c
     State->FadeCount = fadeCount;
 }
 
+static size_t ALreverbState_getMemorySize(ALreverbState *State)
+{
+    if(!State->Buffer)
+        return sizeof(*State);
+    return sizeof(*State) + FAM_SIZE(ReverbBuffer, Samples,
+        CalcBufferLength(&State->Buffer->Sizes, State->Late.NumGroups));
+}
+
 
 typedef struct ReverbStateFactory {
     DERIVE_FROM_TYPE(EffectStateFactory);
@@ -0,0 +1,233 @@
+#ifndef EFFECTS_REVERB_H
+#define EFFECTS_REVERB_H
+
+#include "alMain.h"
+#include "alAuxEffectSlot.h"
+#include "alFilter.h"
+
+
+/* This is the maximum number of samples processed for each inner loop
+ * iteration. */
+#define MAX_UPDATE_SAMPLES  256
+
+/* The number of samples used for cross-faded delay lines.  This can be used
+ * to balance the compensation for abrupt line changes and attenuation due to
+ * minimally lengthed recursive lines.  Try to keep this below the device
+ * update size.
+ */
+#define FADE_SAMPLES  128
+
+/* The number of spatialized lines or channels to process. Four channels allows
+ * for a 3D A-Format response. NOTE: This can't be changed without taking care
+ * of the conversion matrices, and a few places where the length arrays are
+ * assumed to have 4 elements.
+ */
+#define NUM_LINES 4
+
+/* The maximum number of lines in the late reverb's feedback delay network.
+ * The network size depends on the quality tier, and its lines are stored and
+ * processed in groups of NUM_LINES, one line for each A-Format channel.
+ */
+#define MAX_LATE_LINES  16
+#define MAX_LATE_GROUPS (MAX_LATE_LINES/NUM_LINES)
+
+static const ALfloat FadeStep = 1.0f / FADE_SAMPLES;
+
+
+struct ALreverbState;
+
+typedef void (*ReverbProcFunc)(struct ALreverbState *State, const ALsizei todo, ALfloat fade,
+                               ALfloat (*restrict out)[MAX_UPDATE_SAMPLES]);
+
+typedef struct DelayLineI {
+    /* The delay lines use interleaved samples, with the lengths being powers
+     * of 2 to allow the use of bit-masking instead of a modulus for wrapping.
+     */
+    ALsizei  Mask;
+    ALfloat (*Line)[NUM_LINES];
+} DelayLineI;
+
+/* The lengths, in sample frames, the delay lines need to hold. The main delay
+ * line holds the early taps, followed by the late taps after the late feed,
+ * plus an update's worth of samples.
+ */
+typedef struct ReverbLineSizes {
+    ALsizei EarlyTaps;
+    ALsizei LateTaps;
+    ALsizei EarlyAllpass;
+    ALsizei Early;
+    ALsizei LateAllpass;
+    ALsizei Late;
+} ReverbLineSizes;
+
+/* A single buffer holds the samples for all delay lines. It's allocated off
+ * the mixer thread whenever the properties need longer lines.
+ */
+typedef struct ReverbBuffer {
+    ReverbLineSizes Sizes;
+
+    alignas(16) ALfloat Samples[][NUM_LINES];
+} ReverbBuffer;
+
+typedef struct VecAllpass {
+    DelayLineI Delay;
+    ALsizei Offset[NUM_LINES][2];
+} VecAllpass;
+
+typedef struct T60Filter {
+    /* Two filters are used to adjust the signal. One to control the low
+     * frequencies, and one to control the high frequencies. The HF filter also
+     * adjusts the overall output gain, affecting the remaining mid-band.
+     */
+    ALfloat HFCoeffs[3];
+    ALfloat LFCoeffs[3];
+
+    /* The HF and LF filters each keep a state of the last input and last
+     * output sample.
+     */
+    ALfloat HFState[2];
+    ALfloat LFState[2];
+} T60Filter;
+
+typedef struct EarlyReflections {
+    /* A Gerzon vector all-pass filter is used to simulate initial diffusion.
+     * The spread from this filter also helps smooth out the reverb tail.
+     */
+    VecAllpass VecAp;
+
+    /* An echo line is used to complete the second half of the early
+     * reflections.
+     */
+    DelayLineI Delay;
+    ALsizei    Offset[NUM_LINES][2];
+    ALfloat    Coeff[NUM_LINES];
+
+    /* The gain for each output channel based on 3D panning. */
+    ALfloat CurrentGain[NUM_LINES][MAX_OUTPUT_CHANNELS];
+    ALfloat PanGain[NUM_LINES][MAX_OUTPUT_CHANNELS];
+} EarlyReflections;
+
+typedef struct LateReverb {
+    /* The number of lines in the feedback delay network (2, 4, 8, or 16), and
+     * the number of delay line groups holding them. A 2-line network uses the
+     * first two lines of a single group.
+     */
+    ALsizei NumLines;
+    ALsizei NumGroups;
+
+    /* The line lengths, in seconds, for the network size. */
+    const ALfloat *LineLengths;
+    const ALfloat *AllpassLengths;
+
+    /* Attenuation to compensate for the modal density and decay rate of the
+     * late lines.
+     */
+    ALfloat DensityGain;
+
+    /* Coefficients for the scattering matrices, between the lines of each
+     * group and between the groups.
+     */
+    ALfloat MixX, MixY;
+    ALfloat GroupMixX, GroupMixY;
+
+    /* Recursive delay lines are used fill in the reverb tail. */
+    DelayLineI Delay[MAX_LATE_GROUPS];
+    ALsizei    Offset[MAX_LATE_LINES][2];
+
+    /* T60 decay filters are used to simulate absorption. */
+    T60Filter T60[MAX_LATE_LINES];
+
+    /* A Gerzon vector all-pass filter is used to simulate diffusion. */
+    VecAllpass VecAp[MAX_LATE_GROUPS];
+
+    /* The gain for each output channel based on 3D panning. */
+    ALfloat CurrentGain[NUM_LINES][MAX_OUTPUT_CHANNELS];
+    ALfloat PanGain[NUM_LINES][MAX_OUTPUT_CHANNELS];
+} LateReverb;
+
+typedef struct ALreverbState {
+    DERIVE_FROM_TYPE(ALeffectState);
+
+    /* All delay lines are allocated as a single buffer to reduce memory
+     * fragmentation and management code. It's only replaced with the device
+     * locked, so the mixer never sees it change.
+     */
+    ReverbBuffer *Buffer;
+
+    /* Master effect filters */
+    struct {
+        ALfilterState Lp;
+        ALfilterState Hp;
+    } Filter[NUM_LINES];
+
+    /* Core delay line (early reflections and late reverb tap from this). */
+    DelayLineI Delay;
+
+    /* Tap points for early reflection delay. */
+    ALsizei EarlyDelayTap[NUM_LINES][2];
+    ALfloat EarlyDelayCoeff[NUM_LINES];
+
+    /* Tap points for late reverb feed and delay. */
+    ALsizei LateFeedTap;
+    ALsizei LateDelayTap[MAX_LATE_LINES][2];
+
+    /* The feed-back and feed-forward all-pass coefficient. */
+    ALfloat ApFeedCoeff;
+
+    /* Coefficients for the all-pass and line scattering matrices. */
+    ALfloat MixX;
+    ALfloat MixY;
+
+    EarlyReflections Early;
+
+    LateReverb Late;
+
+    /* Indicates the cross-fade point for delay line reads [0,FADE_SAMPLES]. */
+    ALsizei FadeCount;
+
+    /* The current write offset for all delay lines. */
+    ALsizei Offset;
+
+    /* Processing functions for the early reflections and late reverb, with
+     * and without cross-fading delay line taps, for the running CPU and late
+     * network size.
+     */
+    ReverbProcFunc EarlyUnfaded, EarlyFaded;
+    ReverbProcFunc LateUnfaded, LateFaded;
+
+    /* Temporary storage used when processing. */
+    alignas(16) ALfloat AFormatSamples[NUM_LINES][MAX_UPDATE_SAMPLES];
+    alignas(16) ALfloat ReverbSamples[NUM_LINES][MAX_UPDATE_SAMPLES];
+    alignas(16) ALfloat EarlySamples[NUM_LINES][MAX_UPDATE_SAMPLES];
+} ALreverbState;
+
+
+/* SSE reverb processing */
+void EarlyReflection_Unfaded_SSE(ALreverbState *State, const ALsizei todo, ALfloat fade,
+                                 ALfloat (*restrict out)[MAX_UPDATE_SAMPLES]);
+void EarlyReflection_Faded_SSE(ALreverbState *State, const ALsizei todo, ALfloat fade,
+                               ALfloat (*restrict out)[MAX_UPDATE_SAMPLES]);
+void LateReverb_Unfaded_SSE(ALreverbState *State, const ALsizei todo, ALfloat fade,
+                            ALfloat (*restrict out)[MAX_UPDATE_SAMPLES]);
+void LateReverb_Faded_SSE(ALreverbState *State, const ALsizei todo, ALfloat fade,
+                          ALfloat (*restrict out)[MAX_UPDATE_SAMPLES]);
+void LateReverbGroups_Unfaded_SSE(ALreverbState *State, const ALsizei todo, ALfloat fade,
+                                  ALfloat (*restrict out)[MAX_UPDATE_SAMPLES]);
+void LateReverbGroups_Faded_SSE(ALreverbState *State, const ALsizei todo, ALfloat fade,
+                                ALfloat (*restrict out)[MAX_UPDATE_SAMPLES]);
+
+/* Neon reverb processing */
+void EarlyReflection_Unfaded_Neon(ALreverbState *State, const ALsizei todo, ALfloat fade,
+                                  ALfloat (*restrict out)[MAX_UPDATE_SAMPLES]);
+void EarlyReflection_Faded_Neon(ALreverbState *State, const ALsizei todo, ALfloat fade,
+                                ALfloat (*restrict out)[MAX_UPDATE_SAMPLES]);
+void LateReverb_Unfaded_Neon(ALreverbState *State, const ALsizei todo, ALfloat fade,
+                             ALfloat (*restrict out)[MAX_UPDATE_SAMPLES]);
+void LateReverb_Faded_Neon(ALreverbState *State, const ALsizei todo, ALfloat fade,
+                           ALfloat (*restrict out)[MAX_UPDATE_SAMPLES]);
+void LateReverbGroups_Unfaded_Neon(ALreverbState *State, const ALsizei todo, ALfloat fade,
+                                   ALfloat (*restrict out)[MAX_UPDATE_SAMPLES]);
+void LateReverbGroups_Faded_Neon(ALreverbState *State, const ALsizei todo, ALfloat fade,
+                                 ALfloat (*restrict out)[MAX_UPDATE_SAMPLES]);
+
+#endif /* EFFECTS_REVERB_H */
@@ -0,0 +1,398 @@
+#include "config.h"
+
+#include <arm_neon.h>
+
+#include "alMain.h"
+#include "alu.h"
+
+#include "reverb.h"
+
+
+/* These process all four lines of the feedback network with one vector, in
+ * line order. Each operation is done in the same order as the C versions in
+ * reverb.c, and separate multiplies and adds are used rather than
+ * multiply-accumulates, to keep the results the same.
+ */
+
+static inline float32x4_t DelayLineOut4(const DelayLineI *Delay, const ALsizei offset,
+                                        const ALsizei (*restrict taps)[2])
+{
+    const ALsizei mask = Delay->Mask;
+    return (float32x4_t){ Delay->Line[(offset-taps[0][0])&mask][0],
+                          Delay->Line[(offset-taps[1][0])&mask][1],
+                          Delay->Line[(offset-taps[2][0])&mask][2],
+                          Delay->Line[(offset-taps[3][0])&mask][3] };
+}
+
+static inline float32x4_t FadedDelayLineOut4(const DelayLineI *Delay, const ALsizei offset,
+                                             const ALsizei (*restrict taps)[2], const ALfloat mu)
+{
+    const ALsizei mask = Delay->Mask;
+    const float32x4_t out0 = (float32x4_t){ Delay->Line[(offset-taps[0][0])&mask][0],
+                                            Delay->Line[(offset-taps[1][0])&mask][1],
+                                            Delay->Line[(offset-taps[2][0])&mask][2],
+                                            Delay->Line[(offset-taps[3][0])&mask][3] };
+    const float32x4_t out1 = (float32x4_t){ Delay->Line[(offset-taps[0][1])&mask][0],
+                                            Delay->Line[(offset-taps[1][1])&mask][1],
+                                            Delay->Line[(offset-taps[2][1])&mask][2],
+                                            Delay->Line[(offset-taps[3][1])&mask][3] };
+    return vaddq_f32(vmulq_f32(out0, vdupq_n_f32(1.0f-mu)),
+                     vmulq_f32(out1, vdupq_n_f32(mu)));
+}
+#define UnfadedDelayLineOut4(d, o, t, mu) DelayLineOut4(d, o, t)
+
+static inline void DelayLineIn4(DelayLineI *Delay, const ALsizei offset, const float32x4_t in)
+{
+    vst1q_f32(Delay->Line[offset&Delay->Mask], in);
+}
+
+static inline float32x4_t ReverseLines(const float32x4_t in)
+{
+    const float32x4_t swapped = vrev64q_f32(in);
+    return vcombine_f32(vget_high_f32(swapped), vget_low_f32(swapped));
+}
+
+static inline float32x4_t FlipSigns(const float32x4_t in, const uint32x4_t signs)
+{
+    return vreinterpretq_f32_u32(veorq_u32(vreinterpretq_u32_f32(in), signs));
+}
+
+/* Applies the scattering matrix. The sign masks negate the matrix elements
+ * that are -y, and each row is summed left to right like the C version.
+ */
+static inline float32x4_t VectorPartialScatter4(const float32x4_t in, const float32x4_t xCoeff,
+                                                const float32x4_t yCoeff)
+{
+    const uint32x4_t sign0 = (uint32x4_t){ 0, 0x80000000u, 0, 0x80000000u };
+    const uint32x4_t sign1 = (uint32x4_t){ 0x80000000u, 0, 0x80000000u, 0x80000000u };
+    const uint32x4_t sign2 = (uint32x4_t){ 0, 0, 0, 0x80000000u };
+    const float32x2_t lo = vget_low_f32(in);
+    const float32x2_t hi = vget_high_f32(in);
+    float32x4_t p0, p1, p2, sum;
+
+    /* [in1, -in0, in0, -in0] + [-in2, in2, -in1, -in1] + [in3, in3, in3, -in2] */
+    p0 = vsetq_lane_f32(vget_lane_f32(lo, 1), vdupq_lane_f32(lo, 0), 0);
+    p1 = vcombine_f32(vdup_lane_f32(hi, 0), vdup_lane_f32(lo, 1));
+    p2 = vsetq_lane_f32(vget_lane_f32(hi, 0), vdupq_lane_f32(hi, 1), 3);
+
+    sum = vaddq_f32(FlipSigns(p0, sign0), FlipSigns(p1, sign1));
+    sum = vaddq_f32(sum, FlipSigns(p2, sign2));
+    return vaddq_f32(vmulq_f32(xCoeff, in), vmulq_f32(yCoeff, sum));
+}
+
+/* Same as above, but reverses the input. */
+static inline float32x4_t VectorPartialScatterRev4(const float32x4_t in,
+                                                   const float32x4_t xCoeff,
+                                                   const float32x4_t yCoeff)
+{
+    const uint32x4_t sign0 = (uint32x4_t){ 0, 0, 0, 0x80000000u };
+    const uint32x4_t sign1 = (uint32x4_t){ 0x80000000u, 0, 0x80000000u, 0x80000000u };
+    const uint32x4_t sign2 = (uint32x4_t){ 0, 0x80000000u, 0, 0x80000000u };
+    const float32x2_t lo = vget_low_f32(in);
+    const float32x2_t hi = vget_high_f32(in);
+    float32x4_t p0, p1, p2, sum;
+
+    /* [in0, in0, in0, -in1] + [-in1, in1, -in2, -in2] + [in2, -in3, in3, -in3] */
+    p0 = vsetq_lane_f32(vget_lane_f32(lo, 1), vdupq_lane_f32(lo, 0), 3);
+    p1 = vcombine_f32(vdup_lane_f32(lo, 1), vdup_lane_f32(hi, 0));
+    p2 = vsetq_lane_f32(vget_lane_f32(hi, 0), vdupq_lane_f32(hi, 1), 0);
+
+    sum = vaddq_f32(FlipSigns(p0, sign0), FlipSigns(p1, sign1));
+    sum = vaddq_f32(sum, FlipSigns(p2, sign2));
+    return vaddq_f32(vmulq_f32(xCoeff, ReverseLines(in)), vmulq_f32(yCoeff, sum));
+}
+
+#define DECL_TEMPLATE(T)                                                      \
+static inline float32x4_t VectorAllpass4_##T(const float32x4_t in,            \
+                                             const ALsizei offset,            \
+                                             const float32x4_t feedCoeff,     \
+                                             const float32x4_t xCoeff,        \
+                                             const float32x4_t yCoeff,        \
+                                             const ALfloat mu, VecAllpass *Vap)\
+{                                                                             \
+    float32x4_t out, f;                                                       \
+                                                                              \
+    (void)mu; /* Ignore for Unfaded. */                                       \
+                                                                              \
+    out = vsubq_f32(T##DelayLineOut4(&Vap->Delay, offset, Vap->Offset, mu),   \
+                    vmulq_f32(feedCoeff, in));                                \
+    f = vaddq_f32(in, vmulq_f32(feedCoeff, out));                             \
+                                                                              \
+    DelayLineIn4(&Vap->Delay, offset, VectorPartialScatter4(f, xCoeff, yCoeff));\
+    return out;                                                               \
+}
+DECL_TEMPLATE(Unfaded)
+DECL_TEMPLATE(Faded)
+#undef DECL_TEMPLATE
+
+/* Writes one sample of line output to the separate line buffers. */
+static inline void StoreLineSample(ALfloat (*restrict out)[MAX_UPDATE_SAMPLES],
+                                   const ALsizei pos, const float32x4_t sample)
+{
+    vst1q_lane_f32(&out[0][pos], sample, 0);
+    vst1q_lane_f32(&out[1][pos], sample, 1);
+    vst1q_lane_f32(&out[2][pos], sample, 2);
+    vst1q_lane_f32(&out[3][pos], sample, 3);
+}
+
+#define DECL_TEMPLATE(T)                                                      \
+void EarlyReflection_##T##_Neon(ALreverbState *State, const ALsizei todo,     \
+                                ALfloat fade,                                 \
+                                ALfloat (*restrict out)[MAX_UPDATE_SAMPLES])  \
+{                                                                             \
+    const float32x4_t apFeedCoeff = vdupq_n_f32(State->ApFeedCoeff);          \
+    const float32x4_t mixX = vdupq_n_f32(State->MixX);                        \
+    const float32x4_t mixY = vdupq_n_f32(State->MixY);                        \
+    const float32x4_t delayCoeff = vld1q_f32(State->EarlyDelayCoeff);         \
+    const float32x4_t earlyCoeff = vld1q_f32(State->Early.Coeff);             \
+    ALsizei offset = State->Offset;                                           \
+    ALsizei i;                                                                \
+                                                                              \
+    for(i = 0;i < todo;i++)                                                   \
+    {                                                                         \
+        float32x4_t f, fr;                                                    \
+                                                                              \
+        fr = vmulq_f32(T##DelayLineOut4(&State->Delay, offset,                \
+                                        State->EarlyDelayTap, fade),          \
+                       delayCoeff);                                           \
+                                                                              \
+        f = VectorAllpass4_##T(fr, offset, apFeedCoeff, mixX, mixY, fade,     \
+                               &State->Early.VecAp);                          \
+                                                                              \
+        DelayLineIn4(&State->Early.Delay, offset, ReverseLines(f));           \
+                                                                              \
+        f = vaddq_f32(f, vmulq_f32(T##DelayLineOut4(&State->Early.Delay,      \
+            offset, State->Early.Offset, fade), earlyCoeff));                 \
+                                                                              \
+        StoreLineSample(out, i, f);                                           \
+                                                                              \
+        fr = VectorPartialScatterRev4(f, mixX, mixY);                         \
+                                                                              \
+        DelayLineIn4(&State->Delay, offset-State->LateFeedTap, fr);           \
+                                                                              \
+        offset++;                                                             \
+        fade += FadeStep;                                                     \
+    }                                                                         \
+}
+DECL_TEMPLATE(Unfaded)
+DECL_TEMPLATE(Faded)
+#undef DECL_TEMPLATE
+
+/* Applies a first order filter section to each line, keeping the filter
+ * states in vectors.
+ */
+static inline float32x4_t FirstOrderFilter4(const float32x4_t in,
+                                            const float32x4_t *restrict coeffs,
+                                            float32x4_t *restrict state)
+{
+    float32x4_t out = vaddq_f32(vaddq_f32(vmulq_f32(coeffs[0], in),
+                                          vmulq_f32(coeffs[1], state[0])),
+                                vmulq_f32(coeffs[2], state[1]));
+    state[0] = in;
+    state[1] = out;
+    return out;
+}
+
+#define DECL_TEMPLATE(T)                                                      \
+void LateReverb_##T##_Neon(ALreverbState *State, const ALsizei todo,          \
+                           ALfloat fade,                                      \
+                           ALfloat (*restrict out)[MAX_UPDATE_SAMPLES])       \
+{                                                                             \
+    const float32x4_t apFeedCoeff = vdupq_n_f32(State->ApFeedCoeff);          \
+    const float32x4_t mixX = vdupq_n_f32(State->Late.MixX);                   \
+    const float32x4_t mixY = vdupq_n_f32(State->Late.MixY);                   \
+    const float32x4_t densityGain = vdupq_n_f32(State->Late.DensityGain);     \
+    T60Filter *restrict t60 = State->Late.T60;                                \
+    float32x4_t hfCoeffs[3], lfCoeffs[3];                                     \
+    float32x4_t hfState[2], lfState[2];                                       \
+    ALsizei offset = State->Offset;                                           \
+    ALsizei i;                                                                \
+                                                                              \
+    for(i = 0;i < 3;i++)                                                      \
+    {                                                                         \
+        hfCoeffs[i] = (float32x4_t){ t60[0].HFCoeffs[i], t60[1].HFCoeffs[i],  \
+                                     t60[2].HFCoeffs[i], t60[3].HFCoeffs[i] };\
+        lfCoeffs[i] = (float32x4_t){ t60[0].LFCoeffs[i], t60[1].LFCoeffs[i],  \
+                                     t60[2].LFCoeffs[i], t60[3].LFCoeffs[i] };\
+    }                                                                         \
+    for(i = 0;i < 2;i++)                                                      \
+    {                                                                         \
+        hfState[i] = (float32x4_t){ t60[0].HFState[i], t60[1].HFState[i],     \
+                                    t60[2].HFState[i], t60[3].HFState[i] };   \
+        lfState[i] = (float32x4_t){ t60[0].LFState[i], t60[1].LFState[i],     \
+                                    t60[2].LFState[i], t60[3].LFState[i] };   \
+    }                                                                         \
+                                                                              \
+    for(i = 0;i < todo;i++)                                                   \
+    {                                                                         \
+        float32x4_t f, fr;                                                    \
+                                                                              \
+        f = vmulq_f32(T##DelayLineOut4(&State->Delay, offset,                 \
+                                       State->LateDelayTap, fade),            \
+                      densityGain);                                           \
+        f = vaddq_f32(f, T##DelayLineOut4(&State->Late.Delay[0], offset,      \
+                                          State->Late.Offset, fade));         \
+                                                                              \
+        fr = FirstOrderFilter4(FirstOrderFilter4(f, hfCoeffs, hfState),       \
+                               lfCoeffs, lfState);                            \
+        f = VectorAllpass4_##T(fr, offset, apFeedCoeff, mixX, mixY, fade,     \
+                               &State->Late.VecAp[0]);                        \
+                                                                              \
+        StoreLineSample(out, i, f);                                           \
+                                                                              \
+        fr = VectorPartialScatterRev4(f, mixX, mixY);                         \
+                                                                              \
+        DelayLineIn4(&State->Late.Delay[0], offset, fr);                      \
+                                                                              \
+        offset++;                                                             \
+        fade += FadeStep;                                                     \
+    }                                                                         \
+                                                                              \
+    for(i = 0;i < 2;i++)                                                      \
+    {                                                                         \
+        t60[0].HFState[i] = vgetq_lane_f32(hfState[i], 0);                    \
+        t60[1].HFState[i] = vgetq_lane_f32(hfState[i], 1);                    \
+        t60[2].HFState[i] = vgetq_lane_f32(hfState[i], 2);                    \
+        t60[3].HFState[i] = vgetq_lane_f32(hfState[i], 3);                    \
+        t60[0].LFState[i] = vgetq_lane_f32(lfState[i], 0);                    \
+        t60[1].LFState[i] = vgetq_lane_f32(lfState[i], 1);                    \
+        t60[2].LFState[i] = vgetq_lane_f32(lfState[i], 2);                    \
+        t60[3].LFState[i] = vgetq_lane_f32(lfState[i], 3);                    \
+    }                                                                         \
+}
+DECL_TEMPLATE(Unfaded)
+DECL_TEMPLATE(Faded)
+#undef DECL_TEMPLATE
+
+/* Scatters the matching lines of each group of a larger late reverb network
+ * between the groups, like GroupScatter in reverb.c.
+ */
+static inline void GroupScatter4(float32x4_t *restrict out,
+                                 const float32x4_t *restrict in,
+                                 const ALsizei numGroups,
+                                 const float32x4_t xCoeff,
+                                 const float32x4_t yCoeff)
+{
+    if(numGroups == 2)
+    {
+        out[0] = vaddq_f32(vmulq_f32(xCoeff, in[0]), vmulq_f32(yCoeff, in[1]));
+        out[1] = vsubq_f32(vmulq_f32(xCoeff, in[1]), vmulq_f32(yCoeff, in[0]));
+    }
+    else
+    {
+        out[0] = vaddq_f32(vmulq_f32(xCoeff, in[0]),
+            vmulq_f32(yCoeff, vaddq_f32(vsubq_f32(in[1], in[2]), in[3])));
+        out[1] = vaddq_f32(vmulq_f32(xCoeff, in[1]),
+            vmulq_f32(yCoeff, vaddq_f32(vsubq_f32(in[2], in[0]), in[3])));
+        out[2] = vaddq_f32(vmulq_f32(xCoeff, in[2]),
+            vmulq_f32(yCoeff, vaddq_f32(vsubq_f32(in[0], in[1]), in[3])));
+        out[3] = vsubq_f32(vmulq_f32(xCoeff, in[3]),
+            vmulq_f32(yCoeff, vaddq_f32(vaddq_f32(in[0], in[1]), in[2])));
+    }
+}
+
+/* Processes a late reverb network of 8 or 16 lines, one group of four lines
+ * at a time.
+ */
+#define DECL_TEMPLATE(T)                                                      \
+void LateReverbGroups_##T##_Neon(ALreverbState *State, const ALsizei todo,    \
+                                 ALfloat fade,                                \
+                                 ALfloat (*restrict out)[MAX_UPDATE_SAMPLES]) \
+{                                                                             \
+    LateReverb *Late = &State->Late;                                          \
+    const ALsizei numGroups = Late->NumGroups;                                \
+    const float32x4_t apFeedCoeff = vdupq_n_f32(State->ApFeedCoeff);          \
+    const float32x4_t mixX = vdupq_n_f32(Late->MixX);                         \
+    const float32x4_t mixY = vdupq_n_f32(Late->MixY);                         \
+    const float32x4_t groupMixX = vdupq_n_f32(Late->GroupMixX);               \
+    const float32x4_t groupMixY = vdupq_n_f32(Late->GroupMixY);               \
+    const float32x4_t densityGain = vdupq_n_f32(Late->DensityGain);           \
+    float32x4_t hfCoeffs[MAX_LATE_GROUPS][3], lfCoeffs[MAX_LATE_GROUPS][3];   \
+    float32x4_t hfState[MAX_LATE_GROUPS][2], lfState[MAX_LATE_GROUPS][2];     \
+    ALsizei offset = State->Offset;                                           \
+    ALsizei i, g;                                                             \
+                                                                              \
+    for(g = 0;g < numGroups;g++)                                              \
+    {                                                                         \
+        const T60Filter *t60 = &Late->T60[g*NUM_LINES];                       \
+        for(i = 0;i < 3;i++)                                                  \
+        {                                                                     \
+            hfCoeffs[g][i] = (float32x4_t){ t60[0].HFCoeffs[i],               \
+                t60[1].HFCoeffs[i], t60[2].HFCoeffs[i], t60[3].HFCoeffs[i] }; \
+            lfCoeffs[g][i] = (float32x4_t){ t60[0].LFCoeffs[i],               \
+                t60[1].LFCoeffs[i], t60[2].LFCoeffs[i], t60[3].LFCoeffs[i] }; \
+        }                                                                     \
+        for(i = 0;i < 2;i++)                                                  \
+        {                                                                     \
+            hfState[g][i] = (float32x4_t){ t60[0].HFState[i],                 \
+                t60[1].HFState[i], t60[2].HFState[i], t60[3].HFState[i] };    \
+            lfState[g][i] = (float32x4_t){ t60[0].LFState[i],                 \
+                t60[1].LFState[i], t60[2].LFState[i], t60[3].LFState[i] };    \
+        }                                                                     \
+    }                                                                         \
+                                                                              \
+    for(i = 0;i < todo;i++)                                                   \
+    {                                                                         \
+        float32x4_t f[MAX_LATE_GROUPS], fr[MAX_LATE_GROUPS];                  \
+        float32x4_t fs[MAX_LATE_GROUPS];                                      \
+        float32x4_t sum;                                                      \
+                                                                              \
+        for(g = 0;g < numGroups;g++)                                          \
+        {                                                                     \
+            VecAllpass *Vap = &Late->VecAp[g];                                \
+            float32x4_t in;                                                   \
+                                                                              \
+            in = vmulq_f32(T##DelayLineOut4(&State->Delay, offset,            \
+                    &State->LateDelayTap[g*NUM_LINES], fade),                 \
+                densityGain);                                                 \
+            in = vaddq_f32(in, T##DelayLineOut4(&Late->Delay[g], offset,      \
+                    &Late->Offset[g*NUM_LINES], fade));                       \
+            in = FirstOrderFilter4(FirstOrderFilter4(in, hfCoeffs[g],         \
+                                                     hfState[g]),             \
+                                   lfCoeffs[g], lfState[g]);                  \
+                                                                              \
+            f[g] = vsubq_f32(T##DelayLineOut4(&Vap->Delay, offset,            \
+                                              Vap->Offset, fade),             \
+                             vmulq_f32(apFeedCoeff, in));                     \
+            fr[g] = VectorPartialScatter4(                                    \
+                vaddq_f32(in, vmulq_f32(apFeedCoeff, f[g])), mixX, mixY       \
+            );                                                                \
+        }                                                                     \
+        GroupScatter4(fs, fr, numGroups, groupMixX, groupMixY);               \
+        for(g = 0;g < numGroups;g++)                                          \
+            DelayLineIn4(&Late->VecAp[g].Delay, offset, fs[g]);               \
+                                                                              \
+        sum = f[0];                                                           \
+        for(g = 1;g < numGroups;g++)                                          \
+            sum = vaddq_f32(sum, f[g]);                                       \
+        StoreLineSample(out, i, sum);                                         \
+                                                                              \
+        for(g = 0;g < numGroups;g++)                                          \
+            fr[g] = VectorPartialScatterRev4(f[numGroups-1-g], mixX, mixY);   \
+        GroupScatter4(fs, fr, numGroups, groupMixX, groupMixY);               \
+        for(g = 0;g < numGroups;g++)                                          \
+            DelayLineIn4(&Late->Delay[g], offset, fs[g]);                     \
+                                                                              \
+        offset++;                                                             \
+        fade += FadeStep;                                                     \
+    }                                                                         \
+                                                                              \
+    for(g = 0;g < numGroups;g++)                                              \
+    {                                                                         \
+        T60Filter *t60 = &Late->T60[g*NUM_LINES];                             \
+        for(i = 0;i < 2;i++)                                                  \
+        {                                                                     \
+            t60[0].HFState[i] = vgetq_lane_f32(hfState[g][i], 0);             \
+            t60[1].HFState[i] = vgetq_lane_f32(hfState[g][i], 1);             \
+            t60[2].HFState[i] = vgetq_lane_f32(hfState[g][i], 2);             \
+            t60[3].HFState[i] = vgetq_lane_f32(hfState[g][i], 3);             \
+            t60[0].LFState[i] = vgetq_lane_f32(lfState[g][i], 0);             \
+            t60[1].LFState[i] = vgetq_lane_f32(lfState[g][i], 1);             \
+            t60[2].LFState[i] = vgetq_lane_f32(lfState[g][i], 2);             \
+            t60[3].LFState[i] = vgetq_lane_f32(lfState[g][i], 3);             \
+        }                                                                     \
+    }                                                                         \
+}
+DECL_TEMPLATE(Unfaded)
+DECL_TEMPLATE(Faded)
+#undef DECL_TEMPLATE
@@ -0,0 +1,422 @@
+#include "config.h"
+
+#include <xmmintrin.h>
+
+#include "alMain.h"
+#include "alu.h"
+
+#include "reverb.h"
+
+
+/* These process all four lines of the feedback network with one vector, in
+ * line order. Each operation is done in the same order as the C versions in
+ * reverb.c, so the results are identical.
+ */
+
+/* Gathers the output of each line from its own tap offset. */
+static inline __m128 DelayLineOut4(const DelayLineI *Delay, const ALsizei offset,
+                                   const ALsizei (*restrict taps)[2])
+{
+    const ALsizei mask = Delay->Mask;
+    return _mm_setr_ps(Delay->Line[(offset-taps[0][0])&mask][0],
+                       Delay->Line[(offset-taps[1][0])&mask][1],
+                       Delay->Line[(offset-taps[2][0])&mask][2],
+                       Delay->Line[(offset-taps[3][0])&mask][3]);
+}
+
+/* Cross-fades the outputs of each line between its old and new tap offsets. */
+static inline __m128 FadedDelayLineOut4(const DelayLineI *Delay, const ALsizei offset,
+                                        const ALsizei (*restrict taps)[2], const ALfloat mu)
+{
+    const ALsizei mask = Delay->Mask;
+    const __m128 out0 = _mm_setr_ps(Delay->Line[(offset-taps[0][0])&mask][0],
+                                    Delay->Line[(offset-taps[1][0])&mask][1],
+                                    Delay->Line[(offset-taps[2][0])&mask][2],
+                                    Delay->Line[(offset-taps[3][0])&mask][3]);
+    const __m128 out1 = _mm_setr_ps(Delay->Line[(offset-taps[0][1])&mask][0],
+                                    Delay->Line[(offset-taps[1][1])&mask][1],
+                                    Delay->Line[(offset-taps[2][1])&mask][2],
+                                    Delay->Line[(offset-taps[3][1])&mask][3]);
+    return _mm_add_ps(_mm_mul_ps(out0, _mm_set1_ps(1.0f-mu)),
+                      _mm_mul_ps(out1, _mm_set1_ps(mu)));
+}
+#define UnfadedDelayLineOut4(d, o, t, mu) DelayLineOut4(d, o, t)
+
+static inline void DelayLineIn4(DelayLineI *Delay, const ALsizei offset, const __m128 in)
+{
+    _mm_store_ps(Delay->Line[offset&Delay->Mask], in);
+}
+
+/* Applies the scattering matrix. The sign masks negate the matrix elements
+ * that are -y, and each row is summed left to right like the C version.
+ */
+static inline __m128 VectorPartialScatter4(const __m128 in, const __m128 xCoeff,
+                                           const __m128 yCoeff)
+{
+    const __m128 sign0 = _mm_setr_ps(0.0f, -0.0f,  0.0f, -0.0f);
+    const __m128 sign1 = _mm_setr_ps(-0.0f, 0.0f, -0.0f, -0.0f);
+    const __m128 sign2 = _mm_setr_ps(0.0f,  0.0f,  0.0f, -0.0f);
+    __m128 sum;
+
+    /* [in1, -in0, in0, -in0] + [-in2, in2, -in1, -in1] + [in3, in3, in3, -in2] */
+    sum = _mm_add_ps(
+        _mm_xor_ps(_mm_shuffle_ps(in, in, _MM_SHUFFLE(0, 0, 0, 1)), sign0),
+        _mm_xor_ps(_mm_shuffle_ps(in, in, _MM_SHUFFLE(1, 1, 2, 2)), sign1)
+    );
+    sum = _mm_add_ps(sum,
+        _mm_xor_ps(_mm_shuffle_ps(in, in, _MM_SHUFFLE(2, 3, 3, 3)), sign2)
+    );
+    return _mm_add_ps(_mm_mul_ps(xCoeff, in), _mm_mul_ps(yCoeff, sum));
+}
+
+/* Same as above, but reverses the input. */
+static inline __m128 VectorPartialScatterRev4(const __m128 in, const __m128 xCoeff,
+                                              const __m128 yCoeff)
+{
+    const __m128 sign0 = _mm_setr_ps( 0.0f, 0.0f,  0.0f, -0.0f);
+    const __m128 sign1 = _mm_setr_ps(-0.0f, 0.0f, -0.0f, -0.0f);
+    const __m128 sign2 = _mm_setr_ps( 0.0f, -0.0f, 0.0f, -0.0f);
+    __m128 sum;
+
+    /* [in0, in0, in0, -in1] + [-in1, in1, -in2, -in2] + [in2, -in3, in3, -in3] */
+    sum = _mm_add_ps(
+        _mm_xor_ps(_mm_shuffle_ps(in, in, _MM_SHUFFLE(1, 0, 0, 0)), sign0),
+        _mm_xor_ps(_mm_shuffle_ps(in, in, _MM_SHUFFLE(2, 2, 1, 1)), sign1)
+    );
+    sum = _mm_add_ps(sum,
+        _mm_xor_ps(_mm_shuffle_ps(in, in, _MM_SHUFFLE(3, 3, 3, 2)), sign2)
+    );
+    return _mm_add_ps(_mm_mul_ps(xCoeff, _mm_shuffle_ps(in, in, _MM_SHUFFLE(0, 1, 2, 3))),
+                      _mm_mul_ps(yCoeff, sum));
+}
+
+#define DECL_TEMPLATE(T)                                                      \
+static inline __m128 VectorAllpass4_##T(const __m128 in, const ALsizei offset,\
+                                        const __m128 feedCoeff,               \
+                                        const __m128 xCoeff,                  \
+                                        const __m128 yCoeff, const ALfloat mu,\
+                                        VecAllpass *Vap)                      \
+{                                                                             \
+    __m128 out, f;                                                            \
+                                                                              \
+    (void)mu; /* Ignore for Unfaded. */                                       \
+                                                                              \
+    out = _mm_sub_ps(T##DelayLineOut4(&Vap->Delay, offset, Vap->Offset, mu),  \
+                     _mm_mul_ps(feedCoeff, in));                              \
+    f = _mm_add_ps(in, _mm_mul_ps(feedCoeff, out));                           \
+                                                                              \
+    DelayLineIn4(&Vap->Delay, offset, VectorPartialScatter4(f, xCoeff, yCoeff));\
+    return out;                                                               \
+}
+DECL_TEMPLATE(Unfaded)
+DECL_TEMPLATE(Faded)
+#undef DECL_TEMPLATE
+
+/* Writes up to four samples of line output, given as one vector per sample,
+ * to the separate line buffers.
+ */
+static inline void StoreLineSamples(ALfloat (*restrict out)[MAX_UPDATE_SAMPLES],
+                                    const ALsizei pos, __m128 *restrict samples,
+                                    const ALsizei count)
+{
+    ALsizei i;
+
+    if(LIKELY(count == 4))
+    {
+        _MM_TRANSPOSE4_PS(samples[0], samples[1], samples[2], samples[3]);
+        _mm_store_ps(&out[0][pos], samples[0]);
+        _mm_store_ps(&out[1][pos], samples[1]);
+        _mm_store_ps(&out[2][pos], samples[2]);
+        _mm_store_ps(&out[3][pos], samples[3]);
+        return;
+    }
+
+    for(i = 0;i < count;i++)
+    {
+        alignas(16) ALfloat s[NUM_LINES];
+        _mm_store_ps(s, samples[i]);
+        out[0][pos+i] = s[0];
+        out[1][pos+i] = s[1];
+        out[2][pos+i] = s[2];
+        out[3][pos+i] = s[3];
+    }
+}
+
+#define DECL_TEMPLATE(T)                                                      \
+void EarlyReflection_##T##_SSE(ALreverbState *State, const ALsizei todo,      \
+                               ALfloat fade,                                  \
+                               ALfloat (*restrict out)[MAX_UPDATE_SAMPLES])   \
+{                                                                             \
+    const __m128 apFeedCoeff = _mm_set1_ps(State->ApFeedCoeff);               \
+    const __m128 mixX = _mm_set1_ps(State->MixX);                             \
+    const __m128 mixY = _mm_set1_ps(State->MixY);                             \
+    const __m128 delayCoeff = _mm_loadu_ps(State->EarlyDelayCoeff);           \
+    const __m128 earlyCoeff = _mm_loadu_ps(State->Early.Coeff);               \
+    ALsizei offset = State->Offset;                                           \
+    ALsizei base, i;                                                          \
+                                                                              \
+    for(base = 0;base < todo;base += 4)                                       \
+    {                                                                         \
+        const ALsizei count = mini(todo-base, 4);                             \
+        __m128 samples[4];                                                    \
+                                                                              \
+        for(i = 0;i < count;i++)                                              \
+        {                                                                     \
+            __m128 f, fr;                                                     \
+                                                                              \
+            fr = _mm_mul_ps(T##DelayLineOut4(&State->Delay, offset,           \
+                                             State->EarlyDelayTap, fade),     \
+                            delayCoeff);                                      \
+                                                                              \
+            f = VectorAllpass4_##T(fr, offset, apFeedCoeff, mixX, mixY, fade, \
+                                   &State->Early.VecAp);                      \
+                                                                              \
+            DelayLineIn4(&State->Early.Delay, offset,                         \
+                         _mm_shuffle_ps(f, f, _MM_SHUFFLE(0, 1, 2, 3)));      \
+                                                                              \
+            f = _mm_add_ps(f, _mm_mul_ps(T##DelayLineOut4(&State->Early.Delay,\
+                offset, State->Early.Offset, fade), earlyCoeff));             \
+                                                                              \
+            samples[i] = f;                                                   \
+                                                                              \
+            fr = VectorPartialScatterRev4(f, mixX, mixY);                     \
+                                                                              \
+            DelayLineIn4(&State->Delay, offset-State->LateFeedTap, fr);       \
+                                                                              \
+            offset++;                                                         \
+            fade += FadeStep;                                                 \
+        }                                                                     \
+        StoreLineSamples(out, base, samples, count);                          \
+    }                                                                         \
+}
+DECL_TEMPLATE(Unfaded)
+DECL_TEMPLATE(Faded)
+#undef DECL_TEMPLATE
+
+/* Applies a first order filter section to each line, keeping the filter
+ * states in vectors.
+ */
+static inline __m128 FirstOrderFilter4(const __m128 in, const __m128 *restrict coeffs,
+                                       __m128 *restrict state)
+{
+    __m128 out = _mm_add_ps(_mm_add_ps(_mm_mul_ps(coeffs[0], in),
+                                       _mm_mul_ps(coeffs[1], state[0])),
+                            _mm_mul_ps(coeffs[2], state[1]));
+    state[0] = in;
+    state[1] = out;
+    return out;
+}
+
+#define DECL_TEMPLATE(T)                                                      \
+void LateReverb_##T##_SSE(ALreverbState *State, const ALsizei todo,           \
+                          ALfloat fade,                                       \
+                          ALfloat (*restrict out)[MAX_UPDATE_SAMPLES])        \
+{                                                                             \
+    const __m128 apFeedCoeff = _mm_set1_ps(State->ApFeedCoeff);               \
+    const __m128 mixX = _mm_set1_ps(State->Late.MixX);                        \
+    const __m128 mixY = _mm_set1_ps(State->Late.MixY);                        \
+    const __m128 densityGain = _mm_set1_ps(State->Late.DensityGain);          \
+    T60Filter *restrict t60 = State->Late.T60;                                \
+    __m128 hfCoeffs[3], lfCoeffs[3];                                          \
+    __m128 hfState[2], lfState[2];                                            \
+    ALsizei offset = State->Offset;                                           \
+    ALsizei base, i;                                                          \
+                                                                              \
+    for(i = 0;i < 3;i++)                                                      \
+    {                                                                         \
+        hfCoeffs[i] = _mm_setr_ps(t60[0].HFCoeffs[i], t60[1].HFCoeffs[i],     \
+                                  t60[2].HFCoeffs[i], t60[3].HFCoeffs[i]);    \
+        lfCoeffs[i] = _mm_setr_ps(t60[0].LFCoeffs[i], t60[1].LFCoeffs[i],     \
+                                  t60[2].LFCoeffs[i], t60[3].LFCoeffs[i]);    \
+    }                                                                         \
+    for(i = 0;i < 2;i++)                                                      \
+    {                                                                         \
+        hfState[i] = _mm_setr_ps(t60[0].HFState[i], t60[1].HFState[i],        \
+                                 t60[2].HFState[i], t60[3].HFState[i]);       \
+        lfState[i] = _mm_setr_ps(t60[0].LFState[i], t60[1].LFState[i],        \
+                                 t60[2].LFState[i], t60[3].LFState[i]);       \
+    }                                                                         \
+                                                                              \
+    for(base = 0;base < todo;base += 4)                                       \
+    {                                                                         \
+        const ALsizei count = mini(todo-base, 4);                             \
+        __m128 samples[4];                                                    \
+                                                                              \
+        for(i = 0;i < count;i++)                                              \
+        {                                                                     \
+            __m128 f, fr;                                                     \
+                                                                              \
+            f = _mm_mul_ps(T##DelayLineOut4(&State->Delay, offset,            \
+                                            State->LateDelayTap, fade),       \
+                           densityGain);                                      \
+            f = _mm_add_ps(f, T##DelayLineOut4(&State->Late.Delay[0], offset, \
+                                               State->Late.Offset, fade));    \
+                                                                              \
+            fr = FirstOrderFilter4(FirstOrderFilter4(f, hfCoeffs, hfState),   \
+                                   lfCoeffs, lfState);                        \
+            f = VectorAllpass4_##T(fr, offset, apFeedCoeff, mixX, mixY, fade, \
+                                   &State->Late.VecAp[0]);                    \
+                                                                              \
+            samples[i] = f;                                                   \
+                                                                              \
+            fr = VectorPartialScatterRev4(f, mixX, mixY);                     \
+                                                                              \
+            DelayLineIn4(&State->Late.Delay[0], offset, fr);                  \
+                                                                              \
+            offset++;                                                         \
+            fade += FadeStep;                                                 \
+        }                                                                     \
+        StoreLineSamples(out, base, samples, count);                          \
+    }                                                                         \
+                                                                              \
+    for(i = 0;i < 2;i++)                                                      \
+    {                                                                         \
+        alignas(16) ALfloat hf[NUM_LINES], lf[NUM_LINES];                     \
+        _mm_store_ps(hf, hfState[i]);                                         \
+        _mm_store_ps(lf, lfState[i]);                                         \
+        t60[0].HFState[i] = hf[0]; t60[1].HFState[i] = hf[1];                 \
+        t60[2].HFState[i] = hf[2]; t60[3].HFState[i] = hf[3];                 \
+        t60[0].LFState[i] = lf[0]; t60[1].LFState[i] = lf[1];                 \
+        t60[2].LFState[i] = lf[2]; t60[3].LFState[i] = lf[3];                 \
+    }                                                                         \
+}
+DECL_TEMPLATE(Unfaded)
+DECL_TEMPLATE(Faded)
+#undef DECL_TEMPLATE
+
+/* Scatters the matching lines of each group of a larger late reverb network
+ * between the groups, like GroupScatter in reverb.c.
+ */
+static inline void GroupScatter4(__m128 *restrict out, const __m128 *restrict in,
+                                 const ALsizei numGroups, const __m128 xCoeff,
+                                 const __m128 yCoeff)
+{
+    if(numGroups == 2)
+    {
+        out[0] = _mm_add_ps(_mm_mul_ps(xCoeff, in[0]), _mm_mul_ps(yCoeff, in[1]));
+        out[1] = _mm_sub_ps(_mm_mul_ps(xCoeff, in[1]), _mm_mul_ps(yCoeff, in[0]));
+    }
+    else
+    {
+        out[0] = _mm_add_ps(_mm_mul_ps(xCoeff, in[0]),
+            _mm_mul_ps(yCoeff, _mm_add_ps(_mm_sub_ps(in[1], in[2]), in[3])));
+        out[1] = _mm_add_ps(_mm_mul_ps(xCoeff, in[1]),
+            _mm_mul_ps(yCoeff, _mm_add_ps(_mm_sub_ps(in[2], in[0]), in[3])));
+        out[2] = _mm_add_ps(_mm_mul_ps(xCoeff, in[2]),
+            _mm_mul_ps(yCoeff, _mm_add_ps(_mm_sub_ps(in[0], in[1]), in[3])));
+        out[3] = _mm_sub_ps(_mm_mul_ps(xCoeff, in[3]),
+            _mm_mul_ps(yCoeff, _mm_add_ps(_mm_add_ps(in[0], in[1]), in[2])));
+    }
+}
+
+/* Processes a late reverb network of 8 or 16 lines, one group of four lines
+ * at a time.
+ */
+#define DECL_TEMPLATE(T)                                                      \
+void LateReverbGroups_##T##_SSE(ALreverbState *State, const ALsizei todo,     \
+                                ALfloat fade,                                 \
+                                ALfloat (*restrict out)[MAX_UPDATE_SAMPLES])  \
+{                                                                             \
+    LateReverb *Late = &State->Late;                                          \
+    const ALsizei numGroups = Late->NumGroups;                                \
+    const __m128 apFeedCoeff = _mm_set1_ps(State->ApFeedCoeff);               \
+    const __m128 mixX = _mm_set1_ps(Late->MixX);                              \
+    const __m128 mixY = _mm_set1_ps(Late->MixY);                              \
+    const __m128 groupMixX = _mm_set1_ps(Late->GroupMixX);                    \
+    const __m128 groupMixY = _mm_set1_ps(Late->GroupMixY);                    \
+    const __m128 densityGain = _mm_set1_ps(Late->DensityGain);                \
+    __m128 hfCoeffs[MAX_LATE_GROUPS][3], lfCoeffs[MAX_LATE_GROUPS][3];        \
+    __m128 hfState[MAX_LATE_GROUPS][2], lfState[MAX_LATE_GROUPS][2];          \
+    ALsizei offset = State->Offset;                                           \
+    ALsizei base, i, g;                                                       \
+                                                                              \
+    for(g = 0;g < numGroups;g++)                                              \
+    {                                                                         \
+        const T60Filter *t60 = &Late->T60[g*NUM_LINES];                       \
+        for(i = 0;i < 3;i++)                                                  \
+        {                                                                     \
+            hfCoeffs[g][i] = _mm_setr_ps(t60[0].HFCoeffs[i], t60[1].HFCoeffs[i],\
+                                         t60[2].HFCoeffs[i], t60[3].HFCoeffs[i]);\
+            lfCoeffs[g][i] = _mm_setr_ps(t60[0].LFCoeffs[i], t60[1].LFCoeffs[i],\
+                                         t60[2].LFCoeffs[i], t60[3].LFCoeffs[i]);\
+        }                                                                     \
+        for(i = 0;i < 2;i++)                                                  \
+        {                                                                     \
+            hfState[g][i] = _mm_setr_ps(t60[0].HFState[i], t60[1].HFState[i], \
+                                        t60[2].HFState[i], t60[3].HFState[i]);\
+            lfState[g][i] = _mm_setr_ps(t60[0].LFState[i], t60[1].LFState[i], \
+                                        t60[2].LFState[i], t60[3].LFState[i]);\
+        }                                                                     \
+    }                                                                         \
+                                                                              \
+    for(base = 0;base < todo;base += 4)                                       \
+    {                                                                         \
+        const ALsizei count = mini(todo-base, 4);                             \
+        __m128 samples[4];                                                    \
+                                                                              \
+        for(i = 0;i < count;i++)                                              \
+        {                                                                     \
+            __m128 f[MAX_LATE_GROUPS], fr[MAX_LATE_GROUPS];                   \
+            __m128 fs[MAX_LATE_GROUPS];                                       \
+            __m128 sum;                                                       \
+                                                                              \
+            for(g = 0;g < numGroups;g++)                                      \
+            {                                                                 \
+                VecAllpass *Vap = &Late->VecAp[g];                            \
+                __m128 in;                                                    \
+                                                                              \
+                in = _mm_mul_ps(T##DelayLineOut4(&State->Delay, offset,       \
+                        &State->LateDelayTap[g*NUM_LINES], fade),             \
+                    densityGain);                                             \
+                in = _mm_add_ps(in, T##DelayLineOut4(&Late->Delay[g], offset, \
+                        &Late->Offset[g*NUM_LINES], fade));                   \
+                in = FirstOrderFilter4(FirstOrderFilter4(in, hfCoeffs[g],     \
+                                                         hfState[g]),         \
+                                       lfCoeffs[g], lfState[g]);              \
+                                                                              \
+                f[g] = _mm_sub_ps(T##DelayLineOut4(&Vap->Delay, offset,       \
+                                                   Vap->Offset, fade),        \
+                                  _mm_mul_ps(apFeedCoeff, in));               \
+                fr[g] = VectorPartialScatter4(                                \
+                    _mm_add_ps(in, _mm_mul_ps(apFeedCoeff, f[g])), mixX, mixY \
+                );                                                            \
+            }                                                                 \
+            GroupScatter4(fs, fr, numGroups, groupMixX, groupMixY);           \
+            for(g = 0;g < numGroups;g++)                                      \
+                DelayLineIn4(&Late->VecAp[g].Delay, offset, fs[g]);           \
+                                                                              \
+            sum = f[0];                                                       \
+            for(g = 1;g < numGroups;g++)                                      \
+                sum = _mm_add_ps(sum, f[g]);                                  \
+            samples[i] = sum;                                                 \
+                                                                              \
+            for(g = 0;g < numGroups;g++)                                      \
+                fr[g] = VectorPartialScatterRev4(f[numGroups-1-g], mixX, mixY);\
+            GroupScatter4(fs, fr, numGroups, groupMixX, groupMixY);           \
+            for(g = 0;g < numGroups;g++)                                      \
+                DelayLineIn4(&Late->Delay[g], offset, fs[g]);                 \
+                                                                              \
+            offset++;                                                         \
+            fade += FadeStep;                                                 \
+        }                                                                     \
+        StoreLineSamples(out, base, samples, count);                          \
+    }                                                                         \
+                                                                              \
+    for(g = 0;g < numGroups;g++)                                              \
+    {                                                                         \
+        T60Filter *t60 = &Late->T60[g*NUM_LINES];                             \
+        for(i = 0;i < 2;i++)                                                  \
+        {                                                                     \
+            alignas(16) ALfloat hf[NUM_LINES], lf[NUM_LINES];                 \
+            _mm_store_ps(hf, hfState[g][i]);                                  \
+            _mm_store_ps(lf, lfState[g][i]);                                  \
+            t60[0].HFState[i] = hf[0]; t60[1].HFState[i] = hf[1];             \
+            t60[2].HFState[i] = hf[2]; t60[3].HFState[i] = hf[3];             \
+            t60[0].LFState[i] = lf[0]; t60[1].LFState[i] = lf[1];             \
+            t60[2].LFState[i] = lf[2]; t60[3].LFState[i] = lf[3];             \
+        }                                                                     \
+    }                                                                         \
+}
+DECL_TEMPLATE(Unfaded)
+DECL_TEMPLATE(Faded)
+#undef DECL_TEMPLATE
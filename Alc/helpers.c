@@ -135,6 +135,26 @@ extern inline int fallback_ctz64(ALuint64 value);
 
 int CPUCapFlags = 0;
 
+#if defined(HAVE_GCC_GET_CPUID) && (defined(__i386__) || defined(__x86_64__) || \
+                                    defined(_M_IX86) || defined(_M_X64))
+/* Reads the XCR0 register, which says whether the OS preserves the XMM (bit 1)
+ * and YMM (bit 2) register states across context switches. Only call this
+ * when CPUID reports OSXSAVE.
+ */
+static unsigned int GetXCR0(void)
+{
+    unsigned int eax, edx;
+    __asm__ __volatile__(".byte 0x0f, 0x01, 0xd0" : "=a"(eax), "=d"(edx) : "c"(0));
+    return eax;
+}
+#elif defined(HAVE_CPUID_INTRINSIC) && (defined(__i386__) || defined(__x86_64__) || \
+                                        defined(_M_IX86) || defined(_M_X64))
+static unsigned int GetXCR0(void)
+{
+    return (unsigned int)_xgetbv(0);
+}
+#endif
+
 void FillCPUCaps(int capfilter)
 {
     int caps = 0;
@@ -183,6 +203,22 @@ void FillCPUCaps(int capfilter)
                     }
                 }
             }
+
+            /* AVX2 and FMA need the AVX bit and OS support for saving the YMM
+             * registers (OSXSAVE, and XCR0 reporting XMM and YMM state).
+             */
+            if((cpuinf[0].regs[2]&(1<<27)) && (cpuinf[0].regs[2]&(1<<28)) &&
+               (GetXCR0()&0x6) == 0x6)
+            {
+                if((cpuinf[0].regs[2]&(1<<12)))
+                    caps |= CPU_CAP_FMA;
+                if(maxfunc >= 7)
+                {
+                    __cpuid_count(7, 0, cpuinf[0].regs[0], cpuinf[0].regs[1], cpuinf[0].regs[2], cpuinf[0].regs[3]);
+                    if((cpuinf[0].regs[1]&(1<<5)))
+                        caps |= CPU_CAP_AVX2;
+                }
+            }
         }
     }
 #elif defined(HAVE_CPUID_INTRINSIC) && (defined(__i386__) || defined(__x86_64__) || \
@@ -231,6 +267,19 @@ void FillCPUCaps(int capfilter)
                     }
                 }
             }
+
+            if((cpuinf[0].regs[2]&(1<<27)) && (cpuinf[0].regs[2]&(1<<28)) &&
+               (GetXCR0()&0x6) == 0x6)
+            {
+                if((cpuinf[0].regs[2]&(1<<12)))
+                    caps |= CPU_CAP_FMA;
+                if(maxfunc >= 7)
+                {
+                    (__cpuidex)(cpuinf[0].regs, 7, 0);
+                    if((cpuinf[0].regs[1]&(1<<5)))
+                        caps |= CPU_CAP_AVX2;
+                }
+            }
         }
     }
 #else
@@ -288,11 +337,13 @@ void FillCPUCaps(int capfilter)
     }
 #endif
 
-    TRACE("Extensions:%s%s%s%s%s%s\n",
+    TRACE("Extensions:%s%s%s%s%s%s%s%s\n",
         ((capfilter&CPU_CAP_SSE)    ? ((caps&CPU_CAP_SSE)    ? " +SSE"    : " -SSE")    : ""),
         ((capfilter&CPU_CAP_SSE2)   ? ((caps&CPU_CAP_SSE2)   ? " +SSE2"   : " -SSE2")   : ""),
         ((capfilter&CPU_CAP_SSE3)   ? ((caps&CPU_CAP_SSE3)   ? " +SSE3"   : " -SSE3")   : ""),
         ((capfilter&CPU_CAP_SSE4_1) ? ((caps&CPU_CAP_SSE4_1) ? " +SSE4.1" : " -SSE4.1") : ""),
+        ((capfilter&CPU_CAP_AVX2)   ? ((caps&CPU_CAP_AVX2)   ? " +AVX2"   : " -AVX2")   : ""),
+        ((capfilter&CPU_CAP_FMA)    ? ((caps&CPU_CAP_FMA)    ? " +FMA"    : " -FMA")    : ""),
         ((capfilter&CPU_CAP_NEON)   ? ((caps&CPU_CAP_NEON)   ? " +NEON"   : " -NEON")   : ""),
         ((!capfilter) ? " -none-" : "")
     );
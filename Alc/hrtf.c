@@ -22,6 +22,10 @@
 
 #include <stdlib.h>
 #include <ctype.h>
+#include <float.h>
+#ifndef _WIN32
+#include <unistd.h>
+#endif
 
 #include "AL/al.h"
 #include "AL/alc.h"
@@ -33,6 +37,7 @@
 #include "alconfig.h"
 
 #include "compat.h"
+#include "cpu_caps.h"
 #include "almalloc.h"
 
 
@@ -58,12 +63,38 @@
 struct HrtfEntry {
     struct HrtfEntry *next;
     struct Hrtf *handle;
+    /* File mapping the handle's data points into, for native data sets. */
+    struct FileMapping mapping;
     char filename[];
 };
 
 static const ALchar magicMarker00[8] = "MinPHR00";
 static const ALchar magicMarker01[8] = "MinPHR01";
 static const ALchar magicMarker02[8] = "MinPHR02";
+static const ALchar magicMarkerN0[8] = "MinPHRN0";
+static const ALchar magicMarkerBF0[8] = "HrtfBF00";
+
+/* Native data sets store the values in the machine's byte order and float
+ * layout, laid out so the HRTF can reference them in place. After the marker:
+ *
+ * ALuint  byte order mark (NATIVE_BYTE_ORDER_MARK as written)
+ * ALuint  sample rate
+ * ALuint  IR size
+ * ALuint  IR count
+ * ALuint  elevation count
+ * ALfloat field distance, in meters
+ * ALubyte azimuth counts[elevation count]
+ * ALushort elevation offsets[elevation count], aligned to 2 bytes
+ * ALfloat coefficients[IR count][IR size][2], aligned to 16 bytes
+ * ALubyte delays[IR count][2]
+ */
+#define NATIVE_BYTE_ORDER_MARK 0x01020304u
+#define NATIVE_HEADER_SIZE     (sizeof(magicMarkerN0) + sizeof(ALuint)*6)
+
+/* Version of the processed data stored in the HRTF cache, to be increased
+ * whenever it would be processed differently.
+ */
+#define HRTF_CACHE_VERSION 1
 
 /* First value for pass-through coefficients (remaining are 0), used for omni-
  * directional sounds. */
@@ -72,6 +103,17 @@ static const ALfloat PassthruCoeff = 0.707106781187f/*sqrt(0.5)*/;
 static ATOMIC_FLAG LoadedHrtfLock = ATOMIC_FLAG_INIT;
 static struct HrtfEntry *LoadedHrtfs = NULL;
 
+/* The HRTFs last found for each device name, so opening another device doesn't
+ * have to search for them again.
+ */
+struct HrtfListEntry {
+    struct HrtfListEntry *next;
+    vector_EnumeratedHrtf list;
+    char devname[];
+};
+static ATOMIC_FLAG HrtfListLock = ATOMIC_FLAG_INIT;
+static struct HrtfListEntry *HrtfLists = NULL;
+
 
 /* Calculate the elevation index given the polar elevation in radians. This
  * will return an index between 0 and (evcount - 1). Assumes the FPU is in
@@ -194,6 +236,661 @@ void GetHrtfCoeffs(const struct Hrtf *Hrtf, ALfloat elevation, ALfloat azimuth,
 }
 
 
+/* A filter with no response, for channels that don't play through the HRTF. */
+static HrtfFilter SilentHrtfFilter;
+
+/* Filters whose last reference was released, waiting to go back in their
+ * HRTFs' caches.
+ */
+static ATOMIC(HrtfFilter*) ReleasedFilters = ATOMIC_INIT_STATIC(NULL);
+
+HrtfFilter *GetSilentHrtfFilter(void)
+{
+    return &SilentHrtfFilter;
+}
+
+static inline ALuint FloatBits(ALfloat value)
+{
+    union { ALfloat f; ALuint u; } conv = { value };
+    return conv.u;
+}
+
+static void RemoveUnusedFilter(struct Hrtf *Hrtf, HrtfFilter *filter)
+{
+    if(filter->LruPrev) filter->LruPrev->LruNext = filter->LruNext;
+    else Hrtf->LruHead = filter->LruNext;
+    if(filter->LruNext) filter->LruNext->LruPrev = filter->LruPrev;
+    else Hrtf->LruTail = filter->LruPrev;
+    filter->LruPrev = filter->LruNext = NULL;
+    filter->Unused = AL_FALSE;
+    Hrtf->NumUnused--;
+}
+
+static void RemoveHashedFilter(struct Hrtf *Hrtf, HrtfFilter *filter, ALuint hash)
+{
+    HrtfFilter **iter = &Hrtf->FilterHash[hash];
+    while(*iter != filter)
+        iter = &(*iter)->HashNext;
+    *iter = filter->HashNext;
+    filter->HashNext = NULL;
+}
+
+static inline ALuint HashFilterKey(const ALuint key[3], ALfloat scale)
+{
+    ALuint hash = key[0]*73856093u ^ key[1]*19349663u ^ key[2]*83492791u ^ FloatBits(scale);
+    return (hash ^ (hash>>16)) & (HRTF_FILTER_HASH_SIZE-1);
+}
+
+/* Pops the least recently released filter off the cache for reuse. Must be
+ * called with the filter lock held.
+ */
+static HrtfFilter *TakeOldestFilter(struct Hrtf *Hrtf)
+{
+    HrtfFilter *filter = Hrtf->LruTail;
+    RemoveUnusedFilter(Hrtf, filter);
+    RemoveHashedFilter(Hrtf, filter, HashFilterKey(filter->Key, filter->Scale));
+    return filter;
+}
+
+/* Bit-reversed indices for the full-size FFT. The indices for the half-size
+ * FFT are the first half shifted down.
+ */
+static ALubyte FFTRev[HRTF_FFT_SIZE];
+/* Factors to split the half-size FFT of real input into the full spectrum. */
+static ALfloat FFTUnpack[2][HRTF_FFT_BLOCK+1];
+alignas(16) ALfloat HrtfFFTTwiddles[2][HRTF_FFT_SIZE];
+
+void InitHrtfFFT(void)
+{
+    ALsizei i, b, h;
+
+    for(i = 0;i < HRTF_FFT_SIZE;i++)
+    {
+        ALsizei r = 0;
+        for(b = 1;b < HRTF_FFT_SIZE;b <<= 1)
+            r = (r<<1) | ((i&b) ? 1 : 0);
+        FFTRev[i] = (ALubyte)r;
+    }
+    HrtfFFTTwiddles[0][0] = 1.0f;
+    HrtfFFTTwiddles[1][0] = 0.0f;
+    for(h = 1;h < HRTF_FFT_SIZE;h <<= 1)
+    {
+        for(i = 0;i < h;i++)
+        {
+            HrtfFFTTwiddles[0][h+i] = cosf(-F_PI * (ALfloat)i / (ALfloat)h);
+            HrtfFFTTwiddles[1][h+i] = sinf(-F_PI * (ALfloat)i / (ALfloat)h);
+        }
+    }
+    for(i = 0;i <= HRTF_FFT_BLOCK;i++)
+    {
+        FFTUnpack[0][i] = cosf(-F_TAU * (ALfloat)i / (ALfloat)HRTF_FFT_SIZE);
+        FFTUnpack[1][i] = sinf(-F_TAU * (ALfloat)i / (ALfloat)HRTF_FFT_SIZE);
+    }
+}
+
+void HrtfFFTLoadReal(const ALfloat *restrict input, ALfloat weight, ALfloat step,
+                     ALfloat *restrict re, ALfloat *restrict im)
+{
+    ALsizei i;
+
+    /* Even samples go in the real part and odd samples in the imaginary. */
+    for(i = 0;i < HRTF_FFT_BLOCK/2;i++)
+    {
+        const ALsizei r = FFTRev[i] >> 1;
+        re[r] = input[i*2 + 0] * weight;
+        weight += step;
+        im[r] = input[i*2 + 1] * weight;
+        weight += step;
+    }
+    for(;i < HRTF_FFT_BLOCK;i++)
+    {
+        const ALsizei r = FFTRev[i] >> 1;
+        re[r] = 0.0f;
+        im[r] = 0.0f;
+    }
+}
+
+void HrtfFFTRadix4(ALfloat *restrict re, ALfloat *restrict im, ALsizei n)
+{
+    ALsizei k;
+
+    for(k = 0;k < n;k += 4)
+    {
+        const ALfloat r0 = re[k+0] + re[k+1], i0 = im[k+0] + im[k+1];
+        const ALfloat r1 = re[k+0] - re[k+1], i1 = im[k+0] - im[k+1];
+        const ALfloat r2 = re[k+2] + re[k+3], i2 = im[k+2] + im[k+3];
+        const ALfloat r3 = re[k+2] - re[k+3], i3 = im[k+2] - im[k+3];
+
+        re[k+0] = r0 + r2; im[k+0] = i0 + i2;
+        re[k+2] = r0 - r2; im[k+2] = i0 - i2;
+        /* The odd half's twiddle factor is -i. */
+        re[k+1] = r1 + i3; im[k+1] = i1 - r3;
+        re[k+3] = r1 - i3; im[k+3] = i1 + r3;
+    }
+}
+
+void HrtfFFTStages(ALfloat *restrict re, ALfloat *restrict im, ALsizei n)
+{
+    ALsizei h, k, j;
+
+    HrtfFFTRadix4(re, im, n);
+    for(h = 4;h < n;h <<= 1)
+    {
+        const ALfloat *restrict twr = &HrtfFFTTwiddles[0][h];
+        const ALfloat *restrict twi = &HrtfFFTTwiddles[1][h];
+        for(k = 0;k < n;k += h*2)
+        {
+            ALfloat *restrict ar = &re[k], *restrict ai = &im[k];
+            ALfloat *restrict br = &re[k+h], *restrict bi = &im[k+h];
+            for(j = 0;j < h;j++)
+            {
+                const ALfloat tr = br[j]*twr[j] - bi[j]*twi[j];
+                const ALfloat ti = br[j]*twi[j] + bi[j]*twr[j];
+                br[j] = ar[j] - tr; bi[j] = ai[j] - ti;
+                ar[j] = ar[j] + tr; ai[j] = ai[j] + ti;
+            }
+        }
+    }
+}
+
+void HrtfFFTUnpackReal(const ALfloat *restrict re, const ALfloat *restrict im,
+                       HrtfSpectrum *restrict spectrum)
+{
+    ALsizei k;
+
+    /* With Z as the transform of the packed input, the even samples' spectrum
+     * is E = (Z[k] + conj(Z[N-k]))/2 and the odd samples' is
+     * O = (Z[k] - conj(Z[N-k]))/2i, giving X[k] = E + W^k*O. The upper half
+     * is the conjugate of the lower half mirrored.
+     */
+    for(k = 0;k <= HRTF_FFT_BLOCK;k++)
+    {
+        const ALsizei a = k & (HRTF_FFT_BLOCK-1);
+        const ALsizei b = (HRTF_FFT_BLOCK-k) & (HRTF_FFT_BLOCK-1);
+        const ALfloat er = 0.5f*(re[a] + re[b]), ei = 0.5f*(im[a] - im[b]);
+        const ALfloat odr = 0.5f*(im[a] + im[b]), odi = -0.5f*(re[a] - re[b]);
+        const ALfloat wr = FFTUnpack[0][k], wi = FFTUnpack[1][k];
+        const ALfloat xr = er + wr*odr - wi*odi;
+        const ALfloat xi = ei + wr*odi + wi*odr;
+
+        spectrum->Real[FFTRev[k]] = xr;
+        spectrum->Imag[FFTRev[k]] = xi;
+        if(k > 0 && k < HRTF_FFT_BLOCK)
+        {
+            spectrum->Real[FFTRev[HRTF_FFT_SIZE-k]] =  xr;
+            spectrum->Imag[FFTRev[HRTF_FFT_SIZE-k]] = -xi;
+        }
+    }
+}
+
+/* Calculates the partitioned spectra of the filter's responses, offset by
+ * their delays.
+ */
+static void CalcFilterSpectrum(HrtfFilter *filter, ALsizei irSize)
+{
+    const ALfloat scale = 1.0f / (ALfloat)HRTF_FFT_SIZE;
+    alignas(16) ALfloat re[HRTF_FFT_SIZE];
+    alignas(16) ALfloat im[HRTF_FFT_SIZE];
+    ALsizei length;
+    ALsizei p, i;
+
+    length = irSize + maxi(filter->Delay[0], filter->Delay[1]);
+    filter->NumParts = (length + HRTF_FFT_BLOCK-1) / HRTF_FFT_BLOCK;
+    for(p = 0;p < filter->NumParts;p++)
+    {
+        for(i = 0;i < HRTF_FFT_BLOCK;i++)
+        {
+            ALsizei l = p*HRTF_FFT_BLOCK + i - filter->Delay[0];
+            ALsizei r = p*HRTF_FFT_BLOCK + i - filter->Delay[1];
+            re[FFTRev[i]] = (l >= 0 && l < irSize) ? filter->Coeffs[l][0] : 0.0f;
+            im[FFTRev[i]] = (r >= 0 && r < irSize) ? filter->Coeffs[r][1] : 0.0f;
+        }
+        for(;i < HRTF_FFT_SIZE;i++)
+        {
+            re[FFTRev[i]] = 0.0f;
+            im[FFTRev[i]] = 0.0f;
+        }
+        HrtfFFTStages(re, im, HRTF_FFT_SIZE);
+        for(i = 0;i < HRTF_FFT_SIZE;i++)
+        {
+            filter->Spectrum[p].Real[FFTRev[i]] = re[i] * scale;
+            filter->Spectrum[p].Imag[FFTRev[i]] = im[i] * scale;
+        }
+    }
+}
+
+HrtfFilter *GetHrtfFilter(struct Hrtf *Hrtf, ALfloat elevation, ALfloat azimuth, ALfloat spread,
+                          ALfloat scale, ALboolean spectrum)
+{
+    HrtfFilter *filter;
+    ALuint key[3];
+    ALuint hash;
+
+    if(scale > 0.0f)
+    {
+        key[0] = (ALuint)fastf2i(elevation * scale);
+        key[1] = (ALuint)fastf2i(azimuth * scale);
+        key[2] = (ALuint)fastf2i(spread * scale);
+    }
+    else
+    {
+        scale = 0.0f;
+        key[0] = FloatBits(elevation);
+        key[1] = FloatBits(azimuth);
+        key[2] = FloatBits(spread);
+    }
+    hash = HashFilterKey(key, scale);
+
+    /* Put released filters back first, so they can be found or reused. */
+    ReclaimHrtfFilters();
+
+    while(ATOMIC_FLAG_TEST_AND_SET(&Hrtf->FilterLock, almemory_order_acquire))
+        althrd_yield();
+
+    filter = Hrtf->FilterHash[hash];
+    while(filter)
+    {
+        if(filter->Scale == scale && filter->Key[0] == key[0] &&
+           filter->Key[1] == key[1] && filter->Key[2] == key[2])
+            break;
+        filter = filter->HashNext;
+    }
+
+    if(filter)
+    {
+        Hrtf->Hits++;
+        if(filter->Unused)
+            RemoveUnusedFilter(Hrtf, filter);
+    }
+    else
+    {
+        Hrtf->Misses++;
+        /* Reuse the oldest released filter once enough are kept around, else
+         * make a new one.
+         */
+        if(Hrtf->NumUnused >= HRTF_FILTER_CACHE_SIZE)
+            filter = TakeOldestFilter(Hrtf);
+        else if((filter=al_calloc(16, sizeof(*filter))) == NULL)
+        {
+            if(!Hrtf->LruTail)
+            {
+                ATOMIC_FLAG_CLEAR(&Hrtf->FilterLock, almemory_order_release);
+                ERR("Failed to allocate HRTF filter\n");
+                return &SilentHrtfFilter;
+            }
+            filter = TakeOldestFilter(Hrtf);
+        }
+
+        filter->Owner = Hrtf;
+        filter->NumParts = 0;
+        filter->Scale = scale;
+        filter->Key[0] = key[0];
+        filter->Key[1] = key[1];
+        filter->Key[2] = key[2];
+        filter->HashNext = Hrtf->FilterHash[hash];
+        Hrtf->FilterHash[hash] = filter;
+
+        /* Quantized filters are calculated from the quantized angles, so they
+         * don't depend on which direction created them.
+         */
+        if(scale > 0.0f)
+        {
+            elevation = (ALfloat)(ALint)key[0] / scale;
+            azimuth = (ALfloat)(ALint)key[1] / scale;
+            spread = (ALfloat)(ALint)key[2] / scale;
+        }
+        GetHrtfCoeffs(Hrtf, elevation, azimuth, spread, filter->Coeffs, filter->Delay);
+    }
+    if(spectrum && filter->NumParts == 0)
+        CalcFilterSpectrum(filter, Hrtf->irSize);
+    /* References are only added from 0 with the lock held. */
+    IncrementRef(&filter->ref);
+
+    ATOMIC_FLAG_CLEAR(&Hrtf->FilterLock, almemory_order_release);
+
+    Hrtf_IncRef(Hrtf);
+    return filter;
+}
+
+void HrtfFilter_IncRef(HrtfFilter *filter)
+{
+    /* The caller already holds a reference, so this can't race with the
+     * filter being reused.
+     */
+    if(!filter || !filter->Owner)
+        return;
+    IncrementRef(&filter->ref);
+    Hrtf_IncRef(filter->Owner);
+}
+
+void HrtfFilter_DecRef(HrtfFilter *filter)
+{
+    struct Hrtf *Hrtf;
+    uint ref;
+
+    if(!filter || !(Hrtf=filter->Owner))
+        return;
+
+    /* Other references can be dropped as-is. The last one is handed off to
+     * the released list along with its HRTF reference, since putting the
+     * filter back in the cache needs the lock and releasing the HRTF may
+     * unload it. A lookup may reacquire the filter while it's on the list,
+     * which is fine since the list's reference keeps this from seeing the
+     * last reference again until it's reclaimed.
+     */
+    ref = ReadRef(&filter->ref);
+    while(ref > 1 && ATOMIC_COMPARE_EXCHANGE_WEAK(&filter->ref, &ref, ref-1,
+                                                  almemory_order_acq_rel,
+                                                  almemory_order_relaxed) == 0)
+    {
+        /* ref is (re-)filled with the current value on failure. */
+    }
+    if(ref <= 1)
+    {
+        ATOMIC_REPLACE_HEAD(HrtfFilter*, &ReleasedFilters, filter);
+        return;
+    }
+
+    /* The filter's remaining references each hold the HRTF too, so this
+     * can't be the last HRTF reference.
+     */
+    Hrtf_DecRef(Hrtf);
+}
+
+void ReclaimHrtfFilters(void)
+{
+    HrtfFilter *filter;
+
+    filter = ATOMIC_EXCHANGE_PTR(&ReleasedFilters, NULL, almemory_order_acq_rel);
+    while(filter)
+    {
+        HrtfFilter *next = ATOMIC_LOAD(&filter->next, almemory_order_relaxed);
+        struct Hrtf *Hrtf = filter->Owner;
+
+        while(ATOMIC_FLAG_TEST_AND_SET(&Hrtf->FilterLock, almemory_order_acquire))
+            althrd_yield();
+        if(DecrementRef(&filter->ref) == 0)
+        {
+            /* Unused filters are kept until a lookup reuses them or the HRTF
+             * is destroyed.
+             */
+            filter->Unused = AL_TRUE;
+            filter->LruPrev = NULL;
+            filter->LruNext = Hrtf->LruHead;
+            if(Hrtf->LruHead) Hrtf->LruHead->LruPrev = filter;
+            else Hrtf->LruTail = filter;
+            Hrtf->LruHead = filter;
+            Hrtf->NumUnused++;
+        }
+        ATOMIC_FLAG_CLEAR(&Hrtf->FilterLock, almemory_order_release);
+
+        /* Releasing the HRTF may unload it, so it has to be last. */
+        Hrtf_DecRef(Hrtf);
+        filter = next;
+    }
+}
+
+void ResetHrtfFFTState(HrtfFFTState *state)
+{
+    ALsizei i;
+
+    for(i = 0;i < HRTF_FFT_PARTS;i++)
+    {
+        HrtfFilter_DecRef(state->Slots[i].Filter[0]);
+        HrtfFilter_DecRef(state->Slots[i].Filter[1]);
+    }
+    memset(state, 0, sizeof(*state));
+}
+
+
+#define HASH_BASIS U64(0xcbf29ce484222325)
+
+/* Continues a 64-bit FNV-1a hash with the given data. */
+static ALuint64 HashBytes(ALuint64 hash, const void *data, size_t len)
+{
+    const ALubyte *bytes = data;
+    size_t i;
+
+    for(i = 0;i < len;i++)
+        hash = (hash^bytes[i]) * U64(0x100000001b3);
+    return hash;
+}
+
+/* How much of a data set goes into its hash. Along with the data set's size,
+ * the headers and leading coefficients are enough to tell data sets apart
+ * without having to read through large ones on every load.
+ */
+#define HASH_PREFIX_SIZE 65536
+
+/* Hashes a data set for keying the HRTF cache. This is FNV-1a over 64-bit
+ * words of the data set's prefix, rather than bytes.
+ */
+static ALuint64 HashDataSet(const ALubyte *data, size_t len)
+{
+    const ALuint64 size = len;
+    ALuint64 hash, word;
+    size_t i;
+
+    hash = HashBytes(HASH_BASIS, &size, sizeof(size));
+    if(len > HASH_PREFIX_SIZE)
+        len = HASH_PREFIX_SIZE;
+    for(i = 0;i+sizeof(word) <= len;i += sizeof(word))
+    {
+        memcpy(&word, data+i, sizeof(word));
+        hash = (hash^word) * U64(0x100000001b3);
+    }
+    return HashBytes(hash, data+i, len-i);
+}
+
+/* Gets the path of the named file in the HRTF cache directory. Returns false
+ * if there's no cache directory set.
+ */
+static ALboolean GetHrtfCacheFile(al_string *fname, const char *name)
+{
+    const char *path;
+
+    if(!ConfigValueStr(NULL, NULL, "hrtf-cache", &path) || !path[0])
+        return AL_FALSE;
+    alstr_copy_cstr(fname, path);
+    if(alstr_get_cstr(*fname)[alstr_length(*fname)-1] != '/')
+        alstr_append_char(fname, '/');
+    alstr_append_cstr(fname, name);
+    return AL_TRUE;
+}
+
+/* Maps the given cache file, quietly failing if it doesn't exist. */
+static struct FileMapping MapCacheFile(const char *fname)
+{
+    struct FileMapping fmap;
+    FILE *f;
+
+    f = al_fopen(fname, "rb");
+    if(!f)
+    {
+        fmap.ptr = NULL;
+        fmap.len = 0;
+        return fmap;
+    }
+    fclose(f);
+
+    return MapFileToMem(fname);
+}
+
+/* Counts the temporary cache files made by this process. */
+static ATOMIC(ALuint) CacheFileCount = ATOMIC_INIT_STATIC(0);
+
+/* Writes the given data as a cache file. It's written to a temporary file
+ * that then replaces the cache file, so other processes never see it partly
+ * written. The temporary file is named with the process ID and a count, so
+ * it's unique to this call.
+ */
+static void StoreCacheFile(const char *fname, const void *data, size_t len)
+{
+    al_string tmpname = AL_STRING_INIT_STATIC();
+    unsigned long pid;
+    ALboolean ok;
+    char str[48];
+    FILE *f;
+
+#ifdef _WIN32
+    pid = GetCurrentProcessId();
+#else
+    pid = (unsigned long)getpid();
+#endif
+    snprintf(str, sizeof(str), ".%lx-%x.tmp", pid,
+             ATOMIC_ADD(&CacheFileCount, 1, almemory_order_relaxed));
+    alstr_copy_cstr(&tmpname, fname);
+    alstr_append_cstr(&tmpname, str);
+
+    f = al_fopen(alstr_get_cstr(tmpname), "wb");
+    if(!f)
+        WARN("Failed to create HRTF cache file %s\n", alstr_get_cstr(tmpname));
+    else
+    {
+        ok = (fwrite(data, 1, len, f) == len);
+        ok = (fclose(f) == 0) && ok;
+        if(ok && rename(alstr_get_cstr(tmpname), fname) == 0)
+            TRACE("Stored HRTF cache file %s\n", fname);
+        else
+        {
+            WARN("Failed to store HRTF cache file %s\n", fname);
+            remove(alstr_get_cstr(tmpname));
+        }
+    }
+    alstr_reset(&tmpname);
+}
+
+/* Loads the cached B-Format HRTF coefficients from the given file. */
+static ALboolean LoadBFormatCache(DirectHrtfState *state, ALsizei NumChannels, const char *fname)
+{
+    struct FileMapping fmap;
+    ALuint header[3];
+    const ALubyte *data;
+    size_t reqsize;
+    ALsizei i;
+
+    fmap = MapCacheFile(fname);
+    if(!fmap.ptr)
+        return AL_FALSE;
+
+    data = fmap.ptr;
+    if(fmap.len < sizeof(magicMarkerBF0)+sizeof(header) ||
+       memcmp(data, magicMarkerBF0, sizeof(magicMarkerBF0)) != 0)
+    {
+        WARN("Invalid HRTF cache file %s\n", fname);
+        UnmapFileMem(&fmap);
+        return AL_FALSE;
+    }
+    data += sizeof(magicMarkerBF0);
+    memcpy(header, data, sizeof(header));
+    data += sizeof(header);
+
+    reqsize = sizeof(magicMarkerBF0) + sizeof(header) +
+              sizeof(state->Chan[0].Coeffs[0])*header[1]*NumChannels;
+    if(header[0] != NATIVE_BYTE_ORDER_MARK || header[1] > HRIR_LENGTH ||
+       header[2] != (ALuint)NumChannels || fmap.len != reqsize)
+    {
+        WARN("Invalid HRTF cache file %s\n", fname);
+        UnmapFileMem(&fmap);
+        return AL_FALSE;
+    }
+    for(i = 0;i < (ALsizei)header[1]*NumChannels*2;i++)
+    {
+        ALfloat val;
+        memcpy(&val, data + sizeof(val)*i, sizeof(val));
+        if(!isfinite(val))
+        {
+            WARN("Invalid coefficient in HRTF cache file %s: %f\n", fname, val);
+            UnmapFileMem(&fmap);
+            return AL_FALSE;
+        }
+    }
+
+    state->IrSize = header[1];
+    for(i = 0;i < NumChannels;i++)
+    {
+        memcpy(state->Chan[i].Coeffs, data, sizeof(state->Chan[i].Coeffs[0])*state->IrSize);
+        data += sizeof(state->Chan[i].Coeffs[0])*state->IrSize;
+    }
+    UnmapFileMem(&fmap);
+
+    TRACE("Loaded B-Format HRTF coefficients from %s\n", fname);
+    return AL_TRUE;
+}
+
+/* Stores the B-Format HRTF coefficients to the given cache file. */
+static void StoreBFormatCache(const DirectHrtfState *state, ALsizei NumChannels, const char *fname)
+{
+    ALuint header[3] = { NATIVE_BYTE_ORDER_MARK, state->IrSize, NumChannels };
+    size_t len;
+    ALubyte *data, *ptr;
+    ALsizei i;
+
+    len = sizeof(magicMarkerBF0) + sizeof(header) +
+          sizeof(state->Chan[0].Coeffs[0])*state->IrSize*NumChannels;
+    data = ptr = al_malloc(DEF_ALIGN, len);
+    if(!data) return;
+
+    memcpy(ptr, magicMarkerBF0, sizeof(magicMarkerBF0));
+    ptr += sizeof(magicMarkerBF0);
+    memcpy(ptr, header, sizeof(header));
+    ptr += sizeof(header);
+    for(i = 0;i < NumChannels;i++)
+    {
+        memcpy(ptr, state->Chan[i].Coeffs, sizeof(state->Chan[i].Coeffs[0])*state->IrSize);
+        ptr += sizeof(state->Chan[i].Coeffs[0])*state->IrSize;
+    }
+
+    StoreCacheFile(fname, data, len);
+    al_free(data);
+}
+
+
+ALfloat GetHrtfFFTCost(struct Hrtf *Hrtf)
+{
+    al_string cachename = AL_STRING_INIT_STATIC();
+    ALfloat cost = 0.0f;
+    char name[64];
+    FILE *f;
+
+    while(ATOMIC_FLAG_TEST_AND_SET(&Hrtf->FilterLock, almemory_order_acquire))
+        althrd_yield();
+    cost = Hrtf->FFTCost;
+    ATOMIC_FLAG_CLEAR(&Hrtf->FilterLock, almemory_order_release);
+    if(cost > 0.0f)
+        return cost;
+
+    /* The cost depends on the CPU as well as the data set. */
+    snprintf(name, sizeof(name), "fftcost-%08x%08x-%x.cache", (ALuint)(Hrtf->Hash>>32),
+             (ALuint)Hrtf->Hash, CPUCapFlags);
+    if(Hrtf->Hash != 0 && GetHrtfCacheFile(&cachename, name))
+    {
+        if((f=al_fopen(alstr_get_cstr(cachename), "rb")) != NULL)
+        {
+            if(fread(&cost, sizeof(cost), 1, f) != 1 || !(cost > 0.0f))
+                cost = 0.0f;
+            fclose(f);
+        }
+    }
+
+    if(cost > 0.0f)
+        TRACE("Loaded FFT convolution cost from %s\n", alstr_get_cstr(cachename));
+    else
+    {
+        cost = maxf(aluBenchmarkHrtfFFT(Hrtf), FLT_EPSILON);
+        if(!alstr_empty(cachename))
+            StoreCacheFile(alstr_get_cstr(cachename), &cost, sizeof(cost));
+    }
+    alstr_reset(&cachename);
+
+    while(ATOMIC_FLAG_TEST_AND_SET(&Hrtf->FilterLock, almemory_order_acquire))
+        althrd_yield();
+    Hrtf->FFTCost = cost;
+    ATOMIC_FLAG_CLEAR(&Hrtf->FilterLock, almemory_order_release);
+
+    return cost;
+}
+
 void BuildBFormatHrtf(const struct Hrtf *Hrtf, DirectHrtfState *state, ALsizei NumChannels, const struct AngularPoint *AmbiPoints, const ALfloat (*restrict AmbiMatrix)[MAX_AMBI_COEFFS], ALsizei AmbiCount, const ALfloat *restrict AmbiOrderHFGain)
 {
 /* Set this to 2 for dual-band HRTF processing. May require a higher quality
@@ -206,9 +903,34 @@ void BuildBFormatHrtf(const struct Hrtf *Hrtf, DirectHrtfState *state, ALsizei N
     ALsizei min_delay = HRTF_HISTORY_LENGTH;
     ALsizei max_delay = 0;
     ALfloat temps[3][HRIR_LENGTH];
+    al_string cachename = AL_STRING_INIT_STATIC();
     ALsizei max_length = 0;
     ALsizei i, c, b;
 
+    /* Look for the coefficients in the cache. They're keyed by the data set,
+     * sample rate, and ambisonic order, along with a hash of everything else
+     * that goes into them.
+     */
+    if(Hrtf->Hash != 0)
+    {
+        const ALuint version = HRTF_CACHE_VERSION;
+        ALuint64 key = HashBytes(HASH_BASIS, &version, sizeof(version));
+        char name[96];
+
+        key = HashBytes(key, AmbiPoints, sizeof(AmbiPoints[0])*AmbiCount);
+        key = HashBytes(key, AmbiMatrix, sizeof(AmbiMatrix[0])*AmbiCount);
+        key = HashBytes(key, AmbiOrderHFGain, sizeof(AmbiOrderHFGain[0])*(MAX_AMBI_ORDER+1));
+        snprintf(name, sizeof(name), "bformat-%08x%08x-%u-%d-%08x%08x.cache",
+            (ALuint)(Hrtf->Hash>>32), (ALuint)Hrtf->Hash, Hrtf->sampleRate,
+            (ALsizei)sqrtf((ALfloat)NumChannels) - 1, (ALuint)(key>>32), (ALuint)key);
+        if(GetHrtfCacheFile(&cachename, name) &&
+           LoadBFormatCache(state, NumChannels, alstr_get_cstr(cachename)))
+        {
+            alstr_reset(&cachename);
+            return;
+        }
+    }
+
     for(c = 0;c < AmbiCount;c++)
     {
         ALuint evidx, azidx;
@@ -314,6 +1036,10 @@ void BuildBFormatHrtf(const struct Hrtf *Hrtf, DirectHrtfState *state, ALsizei N
     TRACE("Skipped delay min: %d, max: %d, new FIR length: %d\n", min_delay, max_delay,
           max_length);
     state->IrSize = max_length;
+
+    if(!alstr_empty(cachename))
+        StoreBFormatCache(state, NumChannels, alstr_get_cstr(cachename));
+    alstr_reset(&cachename);
 #undef NUM_BANDS
 }
 
@@ -348,6 +1074,7 @@ static struct Hrtf *CreateHrtfStore(ALuint rate, ALsizei irSize,
         ALsizei i;
 
         InitRef(&Hrtf->ref, 0);
+        ATOMIC_FLAG_CLEAR(&Hrtf->FilterLock, almemory_order_relaxed);
         Hrtf->sampleRate = rate;
         Hrtf->irSize = irSize;
         Hrtf->distance = distance;
@@ -394,6 +1121,42 @@ static struct Hrtf *CreateHrtfStore(ALuint rate, ALsizei irSize,
     return Hrtf;
 }
 
+/* Frees the HRTF along with its cached filters. Only called once all of its
+ * references are gone, which includes those held by the filters.
+ */
+static void DestroyHrtfStore(struct Hrtf *Hrtf)
+{
+    ALsizei i;
+
+    if(!Hrtf) return;
+
+    if(Hrtf->Hits > 0 || Hrtf->Misses > 0)
+        TRACE("HRTF filter cache: %u hits, %u misses\n", Hrtf->Hits, Hrtf->Misses);
+    for(i = 0;i < HRTF_FILTER_HASH_SIZE;i++)
+    {
+        HrtfFilter *filter = Hrtf->FilterHash[i];
+        while(filter)
+        {
+            HrtfFilter *next = filter->HashNext;
+            al_free(filter);
+            filter = next;
+        }
+    }
+    al_free(Hrtf);
+}
+
+/* Destroys the entry's loaded HRTF, and unmaps the data it used. */
+static void UnloadEntry(struct HrtfEntry *entry)
+{
+    DestroyHrtfStore(entry->handle);
+    entry->handle = NULL;
+    if(entry->mapping.ptr)
+    {
+        UnmapFileMem(&entry->mapping);
+        entry->mapping.ptr = NULL;
+    }
+}
+
 static ALubyte GetLE_ALubyte(const ALubyte **data, size_t *len)
 {
     ALubyte ret = (*data)[0];
@@ -995,6 +1758,223 @@ static struct Hrtf *LoadHrtf02(const ALubyte *data, size_t datalen, const char *
     return Hrtf;
 }
 
+/* Calculates the offsets of the elevation offsets, coefficients, and delays
+ * in a native data set, returning its total size.
+ */
+static size_t CalcNativeLayout(ALuint irSize, ALuint irCount, ALuint evCount, size_t offsets[3])
+{
+    size_t offset = NATIVE_HEADER_SIZE + sizeof(ALubyte)*evCount;
+
+    offsets[0] = RoundUp(offset, sizeof(ALushort));
+    offset = offsets[0] + sizeof(ALushort)*evCount;
+    offsets[1] = RoundUp(offset, 16);
+    offset = offsets[1] + sizeof(ALfloat[2])*irSize*irCount;
+    offsets[2] = offset;
+    return offset + sizeof(ALubyte[2])*irCount;
+}
+
+/* Loads a native data set, starting with its marker. The HRTF references the
+ * given data directly instead of copying it, so it needs to stay valid for the
+ * life of the HRTF.
+ */
+static struct Hrtf *LoadHrtfNative(const ALubyte *data, size_t datalen, const char *filename)
+{
+    struct Hrtf *Hrtf = NULL;
+    ALboolean failed = AL_FALSE;
+    ALuint header[5];
+    ALuint mark, rate;
+    ALuint irSize, irCount, evCount;
+    ALfloat distance;
+    const ALubyte *azCount;
+    const ALushort *evOffset;
+    const ALfloat (*coeffs)[2];
+    const ALubyte (*delays)[2];
+    size_t offsets[3], reqsize;
+    ALuint count, i;
+
+    /* The tables are aligned relative to the start of the data, which must
+     * itself be aligned for the coefficients to be usable by the mixers (as
+     * mapped files always are).
+     */
+    if(((uintptr_t)data&15) != 0)
+    {
+        ERR("Unaligned data for %s\n", filename);
+        return NULL;
+    }
+    if(datalen < NATIVE_HEADER_SIZE)
+    {
+        ERR("Unexpected end of %s data (req "SZFMT", rem "SZFMT")\n", filename,
+            NATIVE_HEADER_SIZE, datalen);
+        return NULL;
+    }
+    memcpy(header, data+sizeof(magicMarkerN0), sizeof(header));
+    memcpy(&distance, data+sizeof(magicMarkerN0)+sizeof(header), sizeof(distance));
+    mark = header[0];
+    rate = header[1];
+    irSize = header[2];
+    irCount = header[3];
+    evCount = header[4];
+
+    if(mark != NATIVE_BYTE_ORDER_MARK)
+    {
+        ERR("Mismatched byte order in %s: 0x%08x\n", filename, mark);
+        return NULL;
+    }
+    if(irSize < MIN_IR_SIZE || irSize > HRIR_LENGTH || (irSize%MOD_IR_SIZE))
+    {
+        ERR("Unsupported HRIR size: irSize=%u (%d to %d by %d)\n",
+            irSize, MIN_IR_SIZE, HRIR_LENGTH, MOD_IR_SIZE);
+        failed = AL_TRUE;
+    }
+    if(!(distance >= MIN_FD_DISTANCE/1000.0f && distance <= MAX_FD_DISTANCE/1000.0f))
+    {
+        ERR("Unsupported field distance: distance=%fm (%dmm to %dmm)\n",
+            distance, MIN_FD_DISTANCE, MAX_FD_DISTANCE);
+        failed = AL_TRUE;
+    }
+    if(evCount < MIN_EV_COUNT || evCount > MAX_EV_COUNT)
+    {
+        ERR("Unsupported elevation count: evCount=%u (%d to %d)\n",
+            evCount, MIN_EV_COUNT, MAX_EV_COUNT);
+        failed = AL_TRUE;
+    }
+    if(irCount < evCount || irCount > MAX_EV_COUNT*MAX_AZ_COUNT)
+    {
+        ERR("Unsupported IR count: irCount=%u\n", irCount);
+        failed = AL_TRUE;
+    }
+    if(failed)
+        return NULL;
+
+    reqsize = CalcNativeLayout(irSize, irCount, evCount, offsets);
+    if(datalen < reqsize)
+    {
+        ERR("Unexpected end of %s data (req "SZFMT", rem "SZFMT")\n", filename,
+            reqsize, datalen);
+        return NULL;
+    }
+
+    azCount = data + NATIVE_HEADER_SIZE;
+    evOffset = (const ALushort*)(data + offsets[0]);
+    coeffs = (const ALfloat(*)[2])(data + offsets[1]);
+    delays = (const ALubyte(*)[2])(data + offsets[2]);
+
+    count = 0;
+    for(i = 0;i < evCount;i++)
+    {
+        if(azCount[i] < MIN_AZ_COUNT || azCount[i] > MAX_AZ_COUNT)
+        {
+            ERR("Unsupported azimuth count: azCount[%u]=%d (%d to %d)\n",
+                i, azCount[i], MIN_AZ_COUNT, MAX_AZ_COUNT);
+            failed = AL_TRUE;
+        }
+        if(evOffset[i] != count)
+        {
+            ERR("Invalid evOffset: evOffset[%u]=%d (%u)\n", i, evOffset[i], count);
+            failed = AL_TRUE;
+        }
+        count += azCount[i];
+    }
+    if(count != irCount)
+    {
+        ERR("Mismatched IR count: %u (%u)\n", irCount, count);
+        failed = AL_TRUE;
+    }
+    for(i = 0;i < irCount && !failed;i++)
+    {
+        if(delays[i][0] > MAX_HRIR_DELAY || delays[i][1] > MAX_HRIR_DELAY)
+        {
+            ERR("Invalid delays[%u]: %d, %d (%d)\n", i, delays[i][0], delays[i][1],
+                MAX_HRIR_DELAY);
+            failed = AL_TRUE;
+        }
+    }
+    /* The coefficients are used as-is, so make sure they're sane. This also
+     * catches NaN and infinity, which fail the comparison.
+     */
+    for(i = 0;i < irCount*irSize && !failed;i++)
+    {
+        if(!(fabsf(coeffs[i][0]) <= 1.0f && fabsf(coeffs[i][1]) <= 1.0f))
+        {
+            ERR("Invalid coeffs[%u]: %f, %f\n", i, coeffs[i][0], coeffs[i][1]);
+            failed = AL_TRUE;
+        }
+    }
+    if(failed)
+        return NULL;
+
+    Hrtf = al_calloc(16, sizeof(struct Hrtf));
+    if(Hrtf == NULL)
+    {
+        ERR("Out of memory allocating storage for %s.\n", filename);
+        return NULL;
+    }
+    InitRef(&Hrtf->ref, 0);
+    ATOMIC_FLAG_CLEAR(&Hrtf->FilterLock, almemory_order_relaxed);
+    Hrtf->sampleRate = rate;
+    Hrtf->irSize = irSize;
+    Hrtf->distance = distance;
+    Hrtf->evCount = evCount;
+    Hrtf->azCount = azCount;
+    Hrtf->evOffset = evOffset;
+    Hrtf->coeffs = coeffs;
+    Hrtf->delays = delays;
+
+    return Hrtf;
+}
+
+/* Loads a data set converted to the native format in the given cache file,
+ * keeping it mapped for the entry.
+ */
+static struct Hrtf *LoadHrtfCache(struct HrtfEntry *entry, const char *fname)
+{
+    struct Hrtf *hrtf = NULL;
+    struct FileMapping fmap;
+
+    fmap = MapCacheFile(fname);
+    if(!fmap.ptr)
+        return NULL;
+
+    if(fmap.len >= sizeof(magicMarkerN0) &&
+       memcmp(fmap.ptr, magicMarkerN0, sizeof(magicMarkerN0)) == 0)
+        hrtf = LoadHrtfNative(fmap.ptr, fmap.len, fname);
+    if(!hrtf)
+    {
+        WARN("Invalid HRTF cache file %s\n", fname);
+        UnmapFileMem(&fmap);
+        return NULL;
+    }
+
+    TRACE("Loaded cached data set from %s\n", fname);
+    entry->mapping = fmap;
+    return hrtf;
+}
+
+/* Stores the HRTF as a native data set in the given cache file. */
+static void StoreHrtfCache(const struct Hrtf *Hrtf, const char *fname)
+{
+    ALuint irCount = Hrtf->evOffset[Hrtf->evCount-1] + Hrtf->azCount[Hrtf->evCount-1];
+    ALuint header[5] = { NATIVE_BYTE_ORDER_MARK, Hrtf->sampleRate, Hrtf->irSize,
+                         irCount, Hrtf->evCount };
+    size_t offsets[3], len;
+    ALubyte *data;
+
+    len = CalcNativeLayout(Hrtf->irSize, irCount, Hrtf->evCount, offsets);
+    data = al_calloc(16, len);
+    if(!data) return;
+
+    memcpy(data, magicMarkerN0, sizeof(magicMarkerN0));
+    memcpy(data+sizeof(magicMarkerN0), header, sizeof(header));
+    memcpy(data+sizeof(magicMarkerN0)+sizeof(header), &Hrtf->distance, sizeof(Hrtf->distance));
+    memcpy(data+NATIVE_HEADER_SIZE, Hrtf->azCount, sizeof(Hrtf->azCount[0])*Hrtf->evCount);
+    memcpy(data+offsets[0], Hrtf->evOffset, sizeof(Hrtf->evOffset[0])*Hrtf->evCount);
+    memcpy(data+offsets[1], Hrtf->coeffs, sizeof(Hrtf->coeffs[0])*Hrtf->irSize*irCount);
+    memcpy(data+offsets[2], Hrtf->delays, sizeof(Hrtf->delays[0])*irCount);
+
+    StoreCacheFile(fname, data, len);
+    al_free(data);
+}
+
 
 static void AddFileEntry(vector_EnumeratedHrtf *list, const_al_string filename)
 {
@@ -1188,7 +2168,70 @@ static const ALubyte *GetResource(int name, size_t *size)
 }
 #endif
 
-vector_EnumeratedHrtf EnumerateHrtf(const_al_string devname)
+static vector_EnumeratedHrtf CopyHrtfList(const vector_EnumeratedHrtf list)
+{
+    vector_EnumeratedHrtf ret = VECTOR_INIT_STATIC();
+    size_t i;
+
+    VECTOR_RESIZE(ret, 0, VECTOR_SIZE(list));
+    for(i = 0;i < VECTOR_SIZE(list);i++)
+    {
+        EnumeratedHrtf entry = { AL_STRING_INIT_STATIC(), VECTOR_ELEM(list, i).hrtf };
+        alstr_copy(&entry.name, VECTOR_ELEM(list, i).name);
+        VECTOR_PUSH_BACK(ret, entry);
+    }
+    return ret;
+}
+
+/* Drops the cached lists of HRTFs for all device names. */
+static void ClearHrtfLists(void)
+{
+    struct HrtfListEntry *entry;
+
+    while(ATOMIC_FLAG_TEST_AND_SET(&HrtfListLock, almemory_order_seq_cst))
+        althrd_yield();
+    entry = HrtfLists;
+    HrtfLists = NULL;
+    ATOMIC_FLAG_CLEAR(&HrtfListLock, almemory_order_seq_cst);
+
+    while(entry != NULL)
+    {
+        struct HrtfListEntry *next = entry->next;
+        FreeHrtfList(&entry->list);
+        al_free(entry);
+        entry = next;
+    }
+}
+
+/* Replaces the cached list of HRTFs for the device name with a copy of the
+ * given one.
+ */
+static void CacheHrtfList(const_al_string devname, const vector_EnumeratedHrtf list)
+{
+    vector_EnumeratedHrtf copy = CopyHrtfList(list);
+    struct HrtfListEntry *entry;
+
+    while(ATOMIC_FLAG_TEST_AND_SET(&HrtfListLock, almemory_order_seq_cst))
+        althrd_yield();
+    entry = HrtfLists;
+    while(entry && alstr_cmp_cstr(devname, entry->devname) != 0)
+        entry = entry->next;
+    if(!entry)
+    {
+        entry = al_calloc(DEF_ALIGN,
+            FAM_SIZE(struct HrtfListEntry, devname, alstr_length(devname)+1)
+        );
+        strcpy(entry->devname, alstr_get_cstr(devname));
+        entry->next = HrtfLists;
+        HrtfLists = entry;
+    }
+    else
+        FreeHrtfList(&entry->list);
+    entry->list = copy;
+    ATOMIC_FLAG_CLEAR(&HrtfListLock, almemory_order_seq_cst);
+}
+
+static vector_EnumeratedHrtf SearchHrtfs(const_al_string devname)
 {
     vector_EnumeratedHrtf list = VECTOR_INIT_STATIC();
     const char *defaulthrtf = "";
@@ -1290,6 +2333,42 @@ vector_EnumeratedHrtf EnumerateHrtf(const_al_string devname)
     return list;
 }
 
+vector_EnumeratedHrtf EnumerateHrtf(const_al_string devname)
+{
+    vector_EnumeratedHrtf list = SearchHrtfs(devname);
+
+    /* Data sets may have been added or removed since the other lists were
+     * cached, so have later devices search again.
+     */
+    ClearHrtfLists();
+    CacheHrtfList(devname, list);
+    return list;
+}
+
+vector_EnumeratedHrtf GetCachedHrtfList(const_al_string devname)
+{
+    vector_EnumeratedHrtf list = VECTOR_INIT_STATIC();
+    struct HrtfListEntry *entry;
+
+    while(ATOMIC_FLAG_TEST_AND_SET(&HrtfListLock, almemory_order_seq_cst))
+        althrd_yield();
+    entry = HrtfLists;
+    while(entry && alstr_cmp_cstr(devname, entry->devname) != 0)
+        entry = entry->next;
+    if(entry)
+        list = CopyHrtfList(entry->list);
+    ATOMIC_FLAG_CLEAR(&HrtfListLock, almemory_order_seq_cst);
+
+    if(!entry)
+    {
+        list = SearchHrtfs(devname);
+        CacheHrtfList(devname, list);
+        return list;
+    }
+    TRACE("Using %u cached HRTF entries\n", (ALuint)VECTOR_SIZE(list));
+    return list;
+}
+
 void FreeHrtfList(vector_EnumeratedHrtf *list)
 {
 #define CLEAR_ENTRY(i) alstr_reset(&(i)->name)
@@ -1300,8 +2379,10 @@ void FreeHrtfList(vector_EnumeratedHrtf *list)
 
 struct Hrtf *GetLoadedHrtf(struct HrtfEntry *entry)
 {
+    al_string cachename = AL_STRING_INIT_STATIC();
     struct Hrtf *hrtf = NULL;
     struct FileMapping fmap;
+    ALuint64 hash = 0;
     const ALubyte *rdata;
     const char *name;
     ALuint residx;
@@ -1348,8 +2429,42 @@ struct Hrtf *GetLoadedHrtf(struct HrtfEntry *entry)
         rsize = fmap.len;
     }
 
-    if(rsize < sizeof(magicMarker02))
+    /* With a cache directory set, data sets are hashed to find their cached
+     * data, and non-native ones get converted to native ones in the cache for
+     * later loads to use in place.
+     */
+    if(rsize >= sizeof(magicMarkerN0) && GetHrtfCacheFile(&cachename, "hrtf-"))
+    {
+        hash = HashDataSet(rdata, rsize);
+        if(memcmp(rdata, magicMarkerN0, sizeof(magicMarkerN0)) == 0)
+            alstr_clear(&cachename);
+        else
+        {
+            char str[32];
+            snprintf(str, sizeof(str), "%08x%08x.cache", (ALuint)(hash>>32), (ALuint)hash);
+            alstr_append_cstr(&cachename, str);
+            hrtf = LoadHrtfCache(entry, alstr_get_cstr(cachename));
+            if(hrtf) alstr_clear(&cachename);
+        }
+    }
+
+    if(hrtf)
+    {
+        /* Loaded from the cache. */
+    }
+    else if(rsize < sizeof(magicMarker02))
         ERR("%s data is too short ("SZFMT" bytes)\n", name, rsize);
+    else if(memcmp(rdata, magicMarkerN0, sizeof(magicMarkerN0)) == 0)
+    {
+        TRACE("Detected native data set format\n");
+        hrtf = LoadHrtfNative(rdata, rsize, name);
+        /* The HRTF uses the mapped data in place, so keep it mapped. */
+        if(hrtf && fmap.ptr)
+        {
+            entry->mapping = fmap;
+            fmap.ptr = NULL;
+        }
+    }
     else if(memcmp(rdata, magicMarker02, sizeof(magicMarker02)) == 0)
     {
         TRACE("Detected data set format v2\n");
@@ -1373,6 +2488,9 @@ struct Hrtf *GetLoadedHrtf(struct HrtfEntry *entry)
     }
     else
         ERR("Invalid header in %s: \"%.8s\"\n", name, (const char*)rdata);
+    if(hrtf && !alstr_empty(cachename))
+        StoreHrtfCache(hrtf, alstr_get_cstr(cachename));
+    alstr_reset(&cachename);
     if(fmap.ptr)
         UnmapFileMem(&fmap);
 
@@ -1381,6 +2499,7 @@ struct Hrtf *GetLoadedHrtf(struct HrtfEntry *entry)
         ERR("Failed to load %s\n", name);
         goto done;
     }
+    hrtf->Hash = hash;
     entry->handle = hrtf;
     Hrtf_IncRef(hrtf);
 
@@ -1418,8 +2537,7 @@ void Hrtf_DecRef(struct Hrtf *hrtf)
              */
             if(hrtf == Hrtf->handle && ReadRef(&hrtf->ref) == 0)
             {
-                al_free(Hrtf->handle);
-                Hrtf->handle = NULL;
+                UnloadEntry(Hrtf);
                 TRACE("Unloaded unused HRTF %s\n", Hrtf->filename);
             }
             Hrtf = Hrtf->next;
@@ -1432,13 +2550,18 @@ void Hrtf_DecRef(struct Hrtf *hrtf)
 
 void FreeHrtfs(void)
 {
-    struct HrtfEntry *Hrtf = LoadedHrtfs;
+    struct HrtfEntry *Hrtf;
+
+    ReclaimHrtfFilters();
+    ClearHrtfLists();
+
+    Hrtf = LoadedHrtfs;
     LoadedHrtfs = NULL;
 
     while(Hrtf != NULL)
     {
         struct HrtfEntry *next = Hrtf->next;
-        al_free(Hrtf->handle);
+        UnloadEntry(Hrtf);
         al_free(Hrtf);
         Hrtf = next;
     }
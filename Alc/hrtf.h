@@ -23,9 +23,62 @@
 #define HRIR_LENGTH      (1<<HRIR_BITS)
 #define HRIR_MASK        (HRIR_LENGTH-1)
 
+/* Number of hash buckets for the HRTF's filter cache, and the number of
+ * unreferenced filters it keeps around before lookups start reusing them.
+ */
+#define HRTF_FILTER_HASH_SIZE  256
+#define HRTF_FILTER_CACHE_SIZE 256
+
+/* Block size for partitioned FFT convolution, along with the FFT size and
+ * the most partitions needed for the longest HRIR with the longest delay.
+ */
+#define HRTF_FFT_BLOCK   64
+#define HRTF_FFT_SIZE    (HRTF_FFT_BLOCK*2)
+#define HRTF_FFT_PARTS   ((HRIR_LENGTH + HRTF_HISTORY_LENGTH-1 + HRTF_FFT_BLOCK-1) / \
+                          HRTF_FFT_BLOCK)
+
 
 struct HrtfEntry;
 
+/* A spectrum for FFT convolution, split into real and imaginary parts with
+ * the bins in bit-reversed order.
+ */
+typedef struct HrtfSpectrum {
+    alignas(16) ALfloat Real[HRTF_FFT_SIZE];
+    alignas(16) ALfloat Imag[HRTF_FFT_SIZE];
+} HrtfSpectrum;
+
+/* A set of blended HRIR coefficients and delays for a given direction. These
+ * are shared between voices through the owning HRTF's filter cache, and each
+ * reference also holds a reference on the owning HRTF.
+ */
+typedef struct HrtfFilter {
+    alignas(16) ALfloat Coeffs[HRIR_LENGTH][2];
+    ALsizei Delay[2];
+
+    /* Spectra of the left and right responses (packed as the real and
+     * imaginary parts of the signal) with the delays applied, split into
+     * block-sized partitions and prescaled for the inverse FFT. Only
+     * calculated for voices using FFT convolution, and NumParts is 0 until
+     * then.
+     */
+    ALsizei NumParts;
+    HrtfSpectrum Spectrum[HRTF_FFT_PARTS];
+
+    RefCount ref;
+    struct Hrtf *Owner;
+
+    /* Lookup key and cache links, protected by the owner's filter lock. */
+    ALfloat Scale;
+    ALuint Key[3];
+    ALboolean Unused;
+    struct HrtfFilter *HashNext;
+    struct HrtfFilter *LruPrev, *LruNext;
+
+    /* Link for the list of released filters waiting to be reclaimed. */
+    ATOMIC(struct HrtfFilter*) next;
+} HrtfFilter;
+
 struct Hrtf {
     RefCount ref;
 
@@ -39,6 +92,25 @@ struct Hrtf {
     const ALushort *evOffset;
     const ALfloat (*coeffs)[2];
     const ALubyte (*delays)[2];
+
+    /* Hash of the data set, keying its processed data in the HRTF cache. 0 if
+     * the cache isn't in use.
+     */
+    ALuint64 Hash;
+
+    /* Measured cost of FFT convolution relative to direct convolution, or 0
+     * if not measured yet.
+     */
+    ALfloat FFTCost;
+
+    /* Cache of the blended filters in use by voices, along with the most
+     * recently released ones (at the head of the LRU list).
+     */
+    ATOMIC_FLAG FilterLock;
+    HrtfFilter *FilterHash[HRTF_FILTER_HASH_SIZE];
+    HrtfFilter *LruHead, *LruTail;
+    ALsizei NumUnused;
+    ALuint Hits, Misses;
 };
 
 
@@ -47,9 +119,38 @@ typedef struct HrtfState {
     alignas(16) ALfloat Values[HRIR_LENGTH][2];
 } HrtfState;
 
+/* Partitioned FFT convolution state for a voice channel. The input is
+ * gathered in blocks, with each block's spectrum kept along with the filter
+ * it gets convolved with, so a filter change fades between the two filters
+ * over one block by summing their spectra. The output is delayed by one
+ * block.
+ */
+typedef struct HrtfFFTState {
+    /* Gain-scaled input of the block being gathered, and the output of the
+     * last processed block being played alongside it.
+     */
+    alignas(16) ALfloat Input[HRTF_FFT_BLOCK];
+    alignas(16) ALfloat Output[2][HRTF_FFT_BLOCK];
+    alignas(16) ALfloat Overlap[2][HRTF_FFT_BLOCK];
+    ALsizei Pos;
+
+    /* The filter the last block was convolved with, which a new filter fades
+     * from.
+     */
+    HrtfFilter *LastFilter;
+
+    /* Spectra of the last few input blocks, each with up to two referenced
+     * filters to convolve with. Cur is the most recent.
+     */
+    struct {
+        HrtfSpectrum Input[2];
+        HrtfFilter *Filter[2];
+    } Slots[HRTF_FFT_PARTS];
+    ALsizei Cur;
+} HrtfFFTState;
+
 typedef struct HrtfParams {
-    alignas(16) ALfloat Coeffs[HRIR_LENGTH][2];
-    ALsizei Delay[2];
+    HrtfFilter *Filter;
     ALfloat Gain;
 } HrtfParams;
 
@@ -71,7 +172,17 @@ struct AngularPoint {
 
 void FreeHrtfs(void);
 
+/**
+ * Searches for the available HRTFs for the given device, and remembers them
+ * for later calls to GetCachedHrtfList. Lists remembered for other devices are
+ * dropped, so they search again.
+ */
 vector_EnumeratedHrtf EnumerateHrtf(const_al_string devname);
+/**
+ * Returns the HRTFs found by the last search for the given device, only
+ * searching if there hasn't been one yet.
+ */
+vector_EnumeratedHrtf GetCachedHrtfList(const_al_string devname);
 void FreeHrtfList(vector_EnumeratedHrtf *list);
 struct Hrtf *GetLoadedHrtf(struct HrtfEntry *entry);
 void Hrtf_IncRef(struct Hrtf *hrtf);
@@ -79,6 +190,71 @@ void Hrtf_DecRef(struct Hrtf *hrtf);
 
 void GetHrtfCoeffs(const struct Hrtf *Hrtf, ALfloat elevation, ALfloat azimuth, ALfloat spread, ALfloat (*coeffs)[2], ALsizei *delays);
 
+/**
+ * Returns a referenced filter for the given elevation, azimuth, and spread,
+ * sharing a cached one when possible. A non-0 scale quantizes the angles to
+ * that many steps per radian, otherwise only exact matches are shared. The
+ * filter's spectrum is also calculated if requested. Returns the silent
+ * filter if a new one couldn't be allocated. This may allocate and calculate
+ * a new filter, so it's not to be called from the mixer.
+ */
+HrtfFilter *GetHrtfFilter(struct Hrtf *Hrtf, ALfloat elevation, ALfloat azimuth, ALfloat spread, ALfloat scale, ALboolean spectrum);
+/** Returns a static filter with no response, which holds no references. */
+HrtfFilter *GetSilentHrtfFilter(void);
+void HrtfFilter_IncRef(HrtfFilter *filter);
+/**
+ * Releases a filter reference without locking or freeing anything, so it's
+ * safe for the mixer. The last reference is handed off to a list of released
+ * filters, to be returned to the cache by ReclaimHrtfFilters.
+ */
+void HrtfFilter_DecRef(HrtfFilter *filter);
+/**
+ * Returns released filters to their HRTFs' caches, dropping the references
+ * they held on their HRTFs. Called from the app and device-handling code,
+ * never from the mixer.
+ */
+void ReclaimHrtfFilters(void);
+
+/**
+ * Returns the cost of FFT convolution relative to direct convolution with the
+ * HRTF, benchmarking it the first time unless it's in the HRTF cache.
+ */
+ALfloat GetHrtfFFTCost(struct Hrtf *Hrtf);
+
+/** Clears the FFT convolution state, releasing its filters. */
+void ResetHrtfFFTState(HrtfFFTState *state);
+
+/* Twiddle factors for the FFT convolution, as real and imaginary parts, with
+ * the factors for the stage combining pairs of h-point transforms at [h, 2h).
+ */
+extern alignas(16) ALfloat HrtfFFTTwiddles[2][HRTF_FFT_SIZE];
+
+void InitHrtfFFT(void);
+/**
+ * Loads a real block of HRTF_FFT_BLOCK samples, weighted by a linear ramp, as
+ * half as many complex samples in bit-reversed order, zero-padded for a
+ * transform of HRTF_FFT_BLOCK points.
+ */
+void HrtfFFTLoadReal(const ALfloat *restrict input, ALfloat weight, ALfloat step,
+                     ALfloat *restrict re, ALfloat *restrict im);
+/**
+ * Applies the first two stages of an n-point FFT to input in bit-reversed
+ * order. The remaining stages use HrtfFFTTwiddles.
+ */
+void HrtfFFTRadix4(ALfloat *restrict re, ALfloat *restrict im, ALsizei n);
+/**
+ * Applies all stages of an n-point FFT to input in bit-reversed order, giving
+ * output in natural order. Swapping the real and imaginary parts gives the
+ * (unscaled) inverse.
+ */
+void HrtfFFTStages(ALfloat *restrict re, ALfloat *restrict im, ALsizei n);
+/**
+ * Expands the transform of a block loaded with HrtfFFTLoadReal into the full
+ * spectrum of the zero-padded real input.
+ */
+void HrtfFFTUnpackReal(const ALfloat *restrict re, const ALfloat *restrict im,
+                       HrtfSpectrum *restrict spectrum);
+
 /**
  * Produces HRTF filter coefficients for decoding B-Format, given a set of
  * virtual speaker positions and HF/LF matrices for decoding to them. The
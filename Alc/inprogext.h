@@ -72,6 +72,36 @@ AL_API void AL_APIENTRY alGetPointervSOFT(ALenum pname, void **values);
 #endif
 #endif
 
+#ifndef AL_SOFT_source_priority
+#define AL_SOFT_source_priority 1
+#define AL_SOURCE_PRIORITY_SOFT                  0x19A0
+#define ALC_MAX_REAL_VOICES_SOFT                 0x19A1
+#endif
+
+#ifndef AL_SOFT_buffer_float_cache
+#define AL_SOFT_buffer_float_cache 1
+#define AL_FLOAT_CACHE_SOFT                      0x19A2
+#endif
+
+#ifndef ALC_SOFT_hrtf_mode
+#define ALC_SOFT_hrtf_mode 1
+#define ALC_HRTF_MODE_SOFT                       0x19A3
+#define ALC_HRTF_FULL_SOFT                       0x19A4
+#define ALC_HRTF_BASIC_SOFT                      0x19A5
+#define ALC_HRTF_HYBRID_SOFT                     0x19A6
+#define ALC_HRTF_DIRECT_VOICES_SOFT              0x19A7
+#endif
+
+#ifndef AL_SOFT_effect_slot_memory
+#define AL_SOFT_effect_slot_memory 1
+#define AL_EFFECTSLOT_MEMORY_SIZE_SOFT           0x19A8
+#endif
+
+#ifndef AL_SOFT_convolution_reverb
+#define AL_SOFT_convolution_reverb 1
+#define AL_EFFECT_CONVOLUTION_REVERB_SOFT        0xA000
+#endif
+
 #ifdef __cplusplus
 } /* extern "C" */
 #endif
@@ -8,6 +8,7 @@
 
 
 extern inline ALuint GetCompressorSampleRate(const Compressor *Comp);
+extern inline ALsizei GetCompressorBufferSize(const Compressor *Comp);
 
 #define RMS_WINDOW_SIZE (1<<7)
 #define RMS_WINDOW_MASK (RMS_WINDOW_SIZE-1)
@@ -22,7 +23,7 @@ static_assert(RMS_VALUE_MAX < (UINT_MAX / RMS_WINDOW_SIZE), "RMS_VALUE_MAX is to
  *   Maxed  - Absolute maximum of any channel.
  */
 static void SumChannels(Compressor *Comp, const ALsizei NumChans, const ALsizei SamplesToDo,
-                        ALfloat (*restrict OutBuffer)[BUFFERSIZE])
+                        ALfloat *const *restrict OutBuffer)
 {
     ALsizei c, i;
 
@@ -40,7 +41,7 @@ static void SumChannels(Compressor *Comp, const ALsizei NumChans, const ALsizei
 }
 
 static void MaxChannels(Compressor *Comp, const ALsizei NumChans, const ALsizei SamplesToDo,
-                        ALfloat (*restrict OutBuffer)[BUFFERSIZE])
+                        ALfloat *const *restrict OutBuffer)
 {
     ALsizei c, i;
 
@@ -154,13 +155,14 @@ Compressor *CompressorInit(const ALfloat PreGainDb, const ALfloat PostGainDb,
                            const ALfloat AttackTimeMin, const ALfloat AttackTimeMax,
                            const ALfloat ReleaseTimeMin, const ALfloat ReleaseTimeMax,
                            const ALfloat Ratio, const ALfloat ThresholdDb,
-                           const ALfloat KneeDb, const ALuint SampleRate)
+                           const ALfloat KneeDb, const ALuint SampleRate,
+                           const ALsizei BufferSize)
 {
+    const size_t envsize = RoundUp(BufferSize, 4);
     Compressor *Comp;
     size_t size;
-    ALsizei i;
 
-    size = sizeof(*Comp);
+    size = RoundUp(sizeof(*Comp), 16) + sizeof(Comp->Envelope[0]) * envsize;
     if(RmsSensing)
         size += sizeof(Comp->RmsWindow[0]) * RMS_WINDOW_SIZE;
     Comp = al_calloc(16, size);
@@ -176,23 +178,26 @@ Compressor *CompressorInit(const ALfloat PreGainDb, const ALfloat PostGainDb,
     Comp->Threshold = ThresholdDb / 20.0f;
     Comp->Knee = maxf(0.0f, KneeDb / 20.0f);
     Comp->SampleRate = SampleRate;
+    Comp->BufferSize = BufferSize;
 
+    /* The envelope and RMS window are stored after the struct, and are
+     * already cleared by the allocation.
+     */
+    Comp->Envelope = (ALfloat*)((char*)Comp + RoundUp(sizeof(*Comp), 16));
     Comp->RmsSum = 0;
     if(RmsSensing)
-        Comp->RmsWindow = (ALuint*)(Comp+1);
+        Comp->RmsWindow = (ALuint*)(Comp->Envelope + envsize);
     else
         Comp->RmsWindow = NULL;
     Comp->RmsIndex = 0;
 
-    for(i = 0;i < BUFFERSIZE;i++)
-        Comp->Envelope[i] = 0.0f;
     Comp->EnvLast = -6.0f;
 
     return Comp;
 }
 
 void ApplyCompression(Compressor *Comp, const ALsizei NumChans, const ALsizei SamplesToDo,
-                      ALfloat (*restrict OutBuffer)[BUFFERSIZE])
+                      ALfloat *const *restrict OutBuffer)
 {
     ALsizei c, i;
 
@@ -3,7 +3,6 @@
 
 #include "AL/al.h"
 
-/* For BUFFERSIZE. */
 #include "alMain.h"
 
 typedef struct Compressor {
@@ -18,11 +17,12 @@ typedef struct Compressor {
     ALfloat Threshold;
     ALfloat Knee;
     ALuint SampleRate;
+    ALsizei BufferSize;
 
     ALuint RmsSum;
     ALuint *RmsWindow;
     ALsizei RmsIndex;
-    ALfloat Envelope[BUFFERSIZE];
+    ALfloat *Envelope;
     ALfloat EnvLast;
 } Compressor;
 
@@ -41,17 +41,21 @@ typedef struct Compressor {
  *   ThresholdDb    - Triggering threshold (in dB).
  *   KneeDb         - Knee width (below threshold; in dB).
  *   SampleRate     - Sample rate to process.
+ *   BufferSize     - Maximum number of samples processed at once.
  */
 Compressor *CompressorInit(const ALfloat PreGainDb, const ALfloat PostGainDb,
     const ALboolean SummedLink, const ALboolean RmsSensing, const ALfloat AttackTimeMin,
     const ALfloat AttackTimeMax, const ALfloat ReleaseTimeMin, const ALfloat ReleaseTimeMax,
     const ALfloat Ratio, const ALfloat ThresholdDb, const ALfloat KneeDb,
-    const ALuint SampleRate);
+    const ALuint SampleRate, const ALsizei BufferSize);
 
 void ApplyCompression(struct Compressor *Comp, const ALsizei NumChans, const ALsizei SamplesToDo,
-                      ALfloat (*restrict OutBuffer)[BUFFERSIZE]);
+                      ALfloat *const *restrict OutBuffer);
 
 inline ALuint GetCompressorSampleRate(const Compressor *Comp)
 { return Comp->SampleRate; }
 
+inline ALsizei GetCompressorBufferSize(const Compressor *Comp)
+{ return Comp->BufferSize; }
+
 #endif /* MASTERING_H */
@@ -36,12 +36,14 @@
 #include "sample_cvt.h"
 #include "alu.h"
 #include "alconfig.h"
-#include "ringbuffer.h"
 
 #include "cpu_caps.h"
 #include "mixer_defs.h"
 
 
+/* Each step of a voice mix covers at most BUFFERSIZE output samples, even with
+ * a larger mixing quantum, so the fixed-point position math fits in an int.
+ */
 static_assert((INT_MAX>>FRACTIONBITS)/MAX_PITCH > BUFFERSIZE,
               "MAX_PITCH and/or BUFFERSIZE are too large for FRACTIONBITS!");
 
@@ -56,8 +58,10 @@ enum Resampler ResamplerDefault = LinearResampler;
 
 MixerFunc MixSamples = Mix_C;
 RowMixerFunc MixRowSamples = MixRow_C;
+MultiFilterFunc MultiFilterSamples = MultiFilter_C;
 static HrtfMixerFunc MixHrtfSamples = MixHrtf_C;
 static HrtfMixerBlendFunc MixHrtfBlendSamples = MixHrtfBlend_C;
+static HrtfMixerFFTFunc MixHrtfFFTSamples = MixHrtfFFT_C;
 
 static MixerFunc SelectMixer(void)
 {
@@ -65,6 +69,10 @@ static MixerFunc SelectMixer(void)
     if((CPUCapFlags&CPU_CAP_NEON))
         return Mix_Neon;
 #endif
+#ifdef HAVE_AVX2
+    if((CPUCapFlags&(CPU_CAP_AVX2|CPU_CAP_FMA)) == (CPU_CAP_AVX2|CPU_CAP_FMA))
+        return Mix_AVX2;
+#endif
 #ifdef HAVE_SSE
     if((CPUCapFlags&CPU_CAP_SSE))
         return Mix_SSE;
@@ -78,6 +86,10 @@ static RowMixerFunc SelectRowMixer(void)
     if((CPUCapFlags&CPU_CAP_NEON))
         return MixRow_Neon;
 #endif
+#ifdef HAVE_AVX2
+    if((CPUCapFlags&(CPU_CAP_AVX2|CPU_CAP_FMA)) == (CPU_CAP_AVX2|CPU_CAP_FMA))
+        return MixRow_AVX2;
+#endif
 #ifdef HAVE_SSE
     if((CPUCapFlags&CPU_CAP_SSE))
         return MixRow_SSE;
@@ -85,12 +97,29 @@ static RowMixerFunc SelectRowMixer(void)
     return MixRow_C;
 }
 
+static MultiFilterFunc SelectMultiFilter(void)
+{
+#ifdef HAVE_NEON
+    if((CPUCapFlags&CPU_CAP_NEON))
+        return MultiFilter_Neon;
+#endif
+#ifdef HAVE_SSE
+    if((CPUCapFlags&CPU_CAP_SSE))
+        return MultiFilter_SSE;
+#endif
+    return MultiFilter_C;
+}
+
 static inline HrtfMixerFunc SelectHrtfMixer(void)
 {
 #ifdef HAVE_NEON
     if((CPUCapFlags&CPU_CAP_NEON))
         return MixHrtf_Neon;
 #endif
+#ifdef HAVE_AVX2
+    if((CPUCapFlags&(CPU_CAP_AVX2|CPU_CAP_FMA)) == (CPU_CAP_AVX2|CPU_CAP_FMA))
+        return MixHrtf_AVX2;
+#endif
 #ifdef HAVE_SSE
     if((CPUCapFlags&CPU_CAP_SSE))
         return MixHrtf_SSE;
@@ -104,6 +133,10 @@ static inline HrtfMixerBlendFunc SelectHrtfBlendMixer(void)
     if((CPUCapFlags&CPU_CAP_NEON))
         return MixHrtfBlend_Neon;
 #endif
+#ifdef HAVE_AVX2
+    if((CPUCapFlags&(CPU_CAP_AVX2|CPU_CAP_FMA)) == (CPU_CAP_AVX2|CPU_CAP_FMA))
+        return MixHrtfBlend_AVX2;
+#endif
 #ifdef HAVE_SSE
     if((CPUCapFlags&CPU_CAP_SSE))
         return MixHrtfBlend_SSE;
@@ -111,6 +144,69 @@ static inline HrtfMixerBlendFunc SelectHrtfBlendMixer(void)
     return MixHrtfBlend_C;
 }
 
+static inline HrtfMixerFFTFunc SelectHrtfFFTMixer(void)
+{
+#ifdef HAVE_NEON
+    if((CPUCapFlags&CPU_CAP_NEON))
+        return MixHrtfFFT_Neon;
+#endif
+#ifdef HAVE_AVX2
+    if((CPUCapFlags&(CPU_CAP_AVX2|CPU_CAP_FMA)) == (CPU_CAP_AVX2|CPU_CAP_FMA))
+        return MixHrtfFFT_AVX2;
+#endif
+#ifdef HAVE_SSE
+    if((CPUCapFlags&CPU_CAP_SSE))
+        return MixHrtfFFT_SSE;
+#endif
+    return MixHrtfFFT_C;
+}
+
+/* Gets the fused resample, filter, and mix function for a mono voice's direct
+ * path, or NULL if there isn't one for the given resampler and filter.
+ */
+static FusedMixerFunc SelectFusedMixer(enum Resampler resampler, enum ActiveFilters filter)
+{
+    if(filter != AF_None && filter != AF_LowPass)
+        return NULL;
+#ifdef HAVE_SSE
+    if((CPUCapFlags&CPU_CAP_SSE))
+    {
+        switch(resampler)
+        {
+            case PointResampler:
+                return (filter == AF_LowPass) ? MixFused_point_lp_SSE : MixFused_point_SSE;
+            case LinearResampler:
+                return (filter == AF_LowPass) ? MixFused_lerp_lp_SSE : MixFused_lerp_SSE;
+            case BSinc12Resampler:
+                return (filter == AF_LowPass) ? MixFused_bsinc_lp_SSE : MixFused_bsinc_SSE;
+            case FIR4Resampler:
+            case BSinc24Resampler:
+                break;
+        }
+    }
+#endif
+    return NULL;
+}
+
+/* Mixes the samples to each run of consecutive output channels set in the
+ * mask, skipping the silent ones in between.
+ */
+static void MixChannelMask(const ALfloat *data, ALuint mask,
+                           ALfloat *const *restrict OutBuffer, ALfloat *CurrentGains,
+                           const ALfloat *TargetGains, ALsizei Counter, ALsizei OutPos,
+                           ALsizei BufferSize)
+{
+    while(mask)
+    {
+        const ALsizei first = CTZ64((ALuint64)mask);
+        const ALsizei count = CTZ64(~(ALuint64)(mask>>first));
+
+        MixSamples(data, count, OutBuffer+first, CurrentGains+first, TargetGains+first,
+                   Counter, OutPos, BufferSize);
+        mask &= ~(((1u<<count)-1u) << first);
+    }
+}
+
 ResamplerFunc SelectResampler(enum Resampler resampler)
 {
     switch(resampler)
@@ -122,6 +218,10 @@ ResamplerFunc SelectResampler(enum Resampler resampler)
             if((CPUCapFlags&CPU_CAP_NEON))
                 return Resample_lerp_Neon;
 #endif
+#ifdef HAVE_AVX2
+            if((CPUCapFlags&(CPU_CAP_AVX2|CPU_CAP_FMA)) == (CPU_CAP_AVX2|CPU_CAP_FMA))
+                return Resample_lerp_AVX2;
+#endif
 #ifdef HAVE_SSE4_1
             if((CPUCapFlags&CPU_CAP_SSE4_1))
                 return Resample_lerp_SSE41;
@@ -139,6 +239,10 @@ ResamplerFunc SelectResampler(enum Resampler resampler)
             if((CPUCapFlags&CPU_CAP_NEON))
                 return Resample_bsinc_Neon;
 #endif
+#ifdef HAVE_AVX2
+            if((CPUCapFlags&(CPU_CAP_AVX2|CPU_CAP_FMA)) == (CPU_CAP_AVX2|CPU_CAP_FMA))
+                return Resample_bsinc_AVX2;
+#endif
 #ifdef HAVE_SSE
             if((CPUCapFlags&CPU_CAP_SSE))
                 return Resample_bsinc_SSE;
@@ -187,24 +291,82 @@ void aluInitMixer(void)
         }
     }
 
+    InitHrtfFFT();
+
     MixHrtfBlendSamples = SelectHrtfBlendMixer();
     MixHrtfSamples = SelectHrtfMixer();
+    MixHrtfFFTSamples = SelectHrtfFFTMixer();
     MixSamples = SelectMixer();
     MixRowSamples = SelectRowMixer();
+    MultiFilterSamples = SelectMultiFilter();
 }
 
+/* Returns the elapsed time since start in nanoseconds. */
+static ALuint64 GetElapsedNanoseconds(const struct timespec *start)
+{
+    struct timespec now;
+    if(altimespec_get(&now, AL_TIME_UTC) != AL_TIME_UTC)
+        return 0;
+    return (ALuint64)(now.tv_sec-start->tv_sec)*1000000000 + now.tv_nsec - start->tv_nsec;
+}
 
-static void SendAsyncEvent(ALCcontext *context, ALuint enumtype, ALenum type,
-                           ALuint objid, ALuint param, const char *msg)
+ALfloat aluBenchmarkHrtfFFT(struct Hrtf *Hrtf)
 {
-    AsyncEvent evt;
-    evt.EnumType = enumtype;
-    evt.Type = type;
-    evt.ObjectId = objid;
-    evt.Param = param;
-    strcpy(evt.Message, msg);
-    if(ll_ringbuffer_write(context->AsyncEvents, (const char*)&evt, 1) == 1)
-        alsem_post(&context->EventSem);
+    struct {
+        HrtfState Direct;
+        HrtfFFTState FFT;
+        alignas(16) ALfloat Input[BUFFERSIZE];
+        alignas(16) ALfloat Output[2][BUFFERSIZE];
+    } *bench;
+    ALuint64 directTime = UINT64_MAX;
+    ALuint64 fftTime = UINT64_MAX;
+    HrtfFilter *filter;
+    MixHrtfParams hrtfparams;
+    struct timespec start;
+    ALsizei r, i;
+
+    bench = al_calloc(16, sizeof(*bench));
+    if(!bench) return 1.0f;
+    filter = GetHrtfFilter(Hrtf, 0.0f, 0.0f, 0.0f, 0.0f, AL_TRUE);
+
+    /* Take the best of a few runs, to lessen the effect of anything else
+     * using the CPU.
+     */
+    for(r = 0;r < 3;r++)
+    {
+        ALuint64 elapsed;
+
+        if(altimespec_get(&start, AL_TIME_UTC) != AL_TIME_UTC)
+            break;
+        for(i = 0;i < 8;i++)
+        {
+            hrtfparams.Coeffs = filter->Coeffs;
+            hrtfparams.Delay[0] = filter->Delay[0];
+            hrtfparams.Delay[1] = filter->Delay[1];
+            hrtfparams.Gain = 1.0f;
+            hrtfparams.GainStep = 0.0f;
+            MixHrtfSamples(bench->Output[0], bench->Output[1], bench->Input, i*BUFFERSIZE,
+                           0, Hrtf->irSize, &hrtfparams, &bench->Direct, BUFFERSIZE);
+        }
+        elapsed = GetElapsedNanoseconds(&start);
+        directTime = minu64(directTime, elapsed);
+
+        if(altimespec_get(&start, AL_TIME_UTC) != AL_TIME_UTC)
+            break;
+        for(i = 0;i < 8;i++)
+            MixHrtfFFTSamples(bench->Output[0], bench->Output[1], bench->Input, 0, filter,
+                              1.0f, 0.0f, &bench->FFT, BUFFERSIZE);
+        elapsed = GetElapsedNanoseconds(&start);
+        fftTime = minu64(fftTime, elapsed);
+    }
+
+    ResetHrtfFFTState(&bench->FFT);
+    HrtfFilter_DecRef(filter);
+    al_free(bench);
+
+    if(directTime == UINT64_MAX || fftTime == UINT64_MAX || directTime == 0)
+        return 1.0f;
+    return (ALfloat)((ALdouble)fftTime / (ALdouble)directTime);
 }
 
 
@@ -246,8 +408,8 @@ DECL_TEMPLATE(ALalaw)
 
 #undef DECL_TEMPLATE
 
-static void LoadSamples(ALfloat *restrict dst, const ALvoid *restrict src, ALint srcstep,
-                        enum FmtType srctype, ALsizei samples)
+void LoadFmtSamples(ALfloat *restrict dst, const ALvoid *restrict src, ALint srcstep,
+                    enum FmtType srctype, ALsizei samples)
 {
 #define HANDLE_FMT(ET, ST) case ET: Load_##ST(dst, src, srcstep, samples); break
     switch(srctype)
@@ -262,58 +424,177 @@ static void LoadSamples(ALfloat *restrict dst, const ALvoid *restrict src, ALint
 #undef HANDLE_FMT
 }
 
+/* Loads samples for the given channel of a buffer, starting at the given
+ * sample frame, from its float copy if it has one. Planar storage is read
+ * contiguously.
+ */
+static inline void LoadBufferSamples(ALfloat *restrict dst, const ALbuffer *buffer,
+                                     ALsizei pos, ALsizei chan, ALsizei numchans,
+                                     ALsizei samplesize, ALsizei samples)
+{
+    const ALfloat *fdata = ATOMIC_LOAD(&buffer->FloatData, almemory_order_acquire);
+    if(fdata)
+        Load_ALfloat(dst, fdata + chan*FloatDataStride(buffer) + pos, 1, samples);
+    else if(buffer->Planar)
+    {
+        const ALubyte *data = buffer->data;
+        LoadFmtSamples(dst, &data[((size_t)chan*buffer->SampleLen + pos)*samplesize], 1,
+                       buffer->FmtType, samples);
+    }
+    else
+    {
+        const ALubyte *data = buffer->data;
+        LoadFmtSamples(dst, &data[(pos*numchans + chan)*samplesize], numchans,
+                       buffer->FmtType, samples);
+    }
+}
 
-static const ALfloat *DoFilters(ALfilterState *lpfilter, ALfilterState *hpfilter,
-                                ALfloat *restrict dst, const ALfloat *restrict src,
-                                ALsizei numsamples, enum ActiveFilters type)
+/* Gets a buffer channel's samples if they can be resampled in place, which
+ * needs them to be contiguous floats. The number of zeroed samples that can
+ * be read after the end is stored in guard.
+ */
+static inline const ALfloat *GetBufferFloatChannel(const ALbuffer *buffer, ALsizei chan,
+                                                   ALsizei numchans, ALsizei *guard)
 {
-    ALsizei i;
-    switch(type)
+    const ALfloat *fdata = ATOMIC_LOAD(&buffer->FloatData, almemory_order_acquire);
+    if(fdata)
     {
-        case AF_None:
-            ALfilterState_processPassthru(lpfilter, src, numsamples);
-            ALfilterState_processPassthru(hpfilter, src, numsamples);
-            break;
+        *guard = MAX_RESAMPLE_PADDING;
+        return fdata + chan*FloatDataStride(buffer);
+    }
+    if(buffer->FmtType == FmtFloat && (numchans == 1 || buffer->Planar))
+    {
+        /* Planar channels follow each other, so only the last one has the
+         * storage's zeroed frames after it.
+         */
+        *guard = (chan == numchans-1) ? MAX_RESAMPLE_PADDING : 0;
+        return (const ALfloat*)buffer->data + (size_t)chan*buffer->SampleLen;
+    }
+    return NULL;
+}
 
-        case AF_LowPass:
-            ALfilterState_process(lpfilter, dst, src, numsamples);
-            ALfilterState_processPassthru(hpfilter, dst, numsamples);
-            return dst;
-        case AF_HighPass:
-            ALfilterState_processPassthru(lpfilter, src, numsamples);
-            ALfilterState_process(hpfilter, dst, src, numsamples);
-            return dst;
-
-        case AF_BandPass:
-            for(i = 0;i < numsamples;)
-            {
-                ALfloat temp[256];
-                ALsizei todo = mini(256, numsamples-i);
 
-                ALfilterState_process(lpfilter, temp, src+i, todo);
-                ALfilterState_process(hpfilter, dst+i, temp, todo);
-                i += todo;
+/* Filters the resampled samples for up to four of a voice channel's outputs
+ * at once, starting with the given output (0 is the direct path, and 1 and up
+ * are the sends). Filtered samples are written to the given temp buffers, and
+ * each output's resulting samples are stored in out. Sends without a target
+ * are skipped, leaving their filters untouched.
+ */
+static void DoFilters(ALvoice *voice, ALsizei chan, ALsizei first, ALsizei numouts,
+                      ALfloat *const *restrict dst, const ALfloat *src,
+                      ALsizei numsamples, const ALfloat **out)
+{
+    ALfilterState *lowpass[4], *highpass[4];
+    enum ActiveFilters types[4];
+    ALfilterState *filters[4];
+    const ALfloat *fsrc[4];
+    ALfloat *fdst[4];
+    ALsizei count, i;
+
+    numouts = mini(numouts-first, 4);
+    for(i = 0;i < numouts;i++)
+    {
+        if(first+i == 0)
+        {
+            DirectParams *parms = &voice->Direct.Params[chan];
+            lowpass[i] = &parms->LowPass;
+            highpass[i] = &parms->HighPass;
+            types[i] = voice->Direct.FilterType;
+        }
+        else
+        {
+            const ALsizei send = first+i - 1;
+            SendParams *parms = &voice->Send[send].Params[chan];
+            lowpass[i] = &parms->LowPass;
+            highpass[i] = &parms->HighPass;
+            types[i] = voice->Send[send].FilterType;
+            if(!voice->Send[send].Buffer)
+            {
+                out[i] = NULL;
+                lowpass[i] = highpass[i] = NULL;
             }
-            return dst;
+        }
     }
-    return src;
+
+    /* Apply the first filter of each output, which all take the resampled
+     * samples.
+     */
+    count = 0;
+    for(i = 0;i < numouts;i++)
+    {
+        if(!lowpass[i])
+            continue;
+        switch(types[i])
+        {
+            case AF_None:
+                ALfilterState_processPassthru(lowpass[i], src, numsamples);
+                ALfilterState_processPassthru(highpass[i], src, numsamples);
+                out[i] = src;
+                break;
+
+            case AF_LowPass:
+            case AF_BandPass:
+                filters[count] = lowpass[i];
+                fsrc[count] = src;
+                fdst[count++] = dst[i];
+                out[i] = dst[i];
+                break;
+            case AF_HighPass:
+                ALfilterState_processPassthru(lowpass[i], src, numsamples);
+                filters[count] = highpass[i];
+                fsrc[count] = src;
+                fdst[count++] = dst[i];
+                out[i] = dst[i];
+                break;
+        }
+    }
+    if(count > 0)
+        MultiFilterSamples(filters, fdst, fsrc, count, numsamples);
+
+    /* Then the high-pass filter after the low-pass, in place. */
+    count = 0;
+    for(i = 0;i < numouts;i++)
+    {
+        if(!lowpass[i])
+            continue;
+        if(types[i] == AF_LowPass)
+            ALfilterState_processPassthru(highpass[i], dst[i], numsamples);
+        else if(types[i] == AF_BandPass)
+        {
+            filters[count] = highpass[i];
+            fsrc[count] = dst[i];
+            fdst[count++] = dst[i];
+        }
+    }
+    if(count > 0)
+        MultiFilterSamples(filters, fdst, fsrc, count, numsamples);
 }
 
 
-/* This function uses these device temp buffers. */
+/* This function uses these temp buffers. */
 #define SOURCE_DATA_BUF 0
 #define RESAMPLED_BUF 1
-#define FILTERED_BUF 2
-#define NFC_DATA_BUF 3
-ALboolean MixSource(ALvoice *voice, ALuint SourceID, ALCcontext *Context, ALsizei SamplesToDo)
+#define NFC_DATA_BUF 2
+#define FILTERED_BUF 3 /* Up to four, for filtering outputs together. */
+ALboolean MixSource(ALvoice *voice, ALCcontext *Context, ALsizei SamplesToDo,
+                    const VoiceMixBuffers *buffers)
 {
     ALCdevice *Device = Context->Device;
+    ALfloat **TempBuffer = buffers->TempBuffer;
+    ALfloat **DirectBuffer;
+    ALfloat **SendBuffer[MAX_SENDS];
     ALbufferlistitem *BufferListItem;
     ALbufferlistitem *BufferLoopItem;
+    const ALbuffer *InPlaceBuffer;
+    ALsizei InPlaceEnd;
+    bool InPlaceGuard;
     ALsizei NumChannels, SampleSize;
-    ALbitfieldSOFT enabledevt;
+    ALsizei NumOutputs;
     ALsizei buffers_done = 0;
     ResamplerFunc Resample;
+    FusedMixerFunc FusedMixer;
+    ALsizei FilterBase;
+    bool HasSends;
     ALsizei DataPosInt;
     ALsizei DataPosFrac;
     ALint64 DataSize64;
@@ -324,6 +605,7 @@ ALboolean MixSource(ALvoice *voice, ALuint SourceID, ALCcontext *Context, ALsize
     bool isplaying;
     bool firstpass;
     bool isstatic;
+    bool isvirtual;
     ALsizei chan;
     ALsizei send;
 
@@ -339,10 +621,78 @@ ALboolean MixSource(ALvoice *voice, ALuint SourceID, ALCcontext *Context, ALsize
     increment      = voice->Step;
 
     IrSize = (Device->HrtfHandle ? Device->HrtfHandle->irSize : 0);
+    NumOutputs = 1 + Device->NumAuxSends;
+
+    /* Redirect the output to the given buffers, if any. */
+    DirectBuffer = voice->Direct.Buffer;
+    if(buffers->MixBuffer)
+        DirectBuffer = buffers->MixBuffer + (DirectBuffer - Device->Dry.Buffer);
+    for(send = 0;send < Device->NumAuxSends;send++)
+    {
+        SendBuffer[send] = voice->Send[send].Buffer;
+        if(buffers->WetBuffers && SendBuffer[send])
+        {
+            const struct ALeffectslotArray *slots = buffers->Slots;
+            ALsizei i;
+            for(i = 0;i < slots->count;i++)
+            {
+                if(slots->slot[i]->WetBuffer == SendBuffer[send])
+                {
+                    SendBuffer[send] = buffers->WetBuffers + i*MAX_EFFECT_CHANNELS;
+                    break;
+                }
+            }
+            assert(i < slots->count);
+        }
+    }
 
     Resample = ((increment == FRACTIONONE && DataPosFrac == 0) ?
                 Resample_copy_C : voice->Resampler);
 
+    /* A mono voice without HRTF or NFC can have its direct path resampled,
+     * filtered, and mixed in one pass, leaving the rest of the outputs to be
+     * filtered from the resampled samples.
+     */
+    HasSends = false;
+    for(send = 0;send < Device->NumAuxSends;send++)
+        HasSends |= (SendBuffer[send] != NULL);
+    FusedMixer = NULL;
+    if(NumChannels == 1 && !(voice->Flags&(VOICE_HAS_HRTF|VOICE_HAS_NFC)))
+        FusedMixer = SelectFusedMixer(
+            (Resample == Resample_copy_C) ? PointResampler : voice->ResamplerType,
+            voice->Direct.FilterType
+        );
+    FilterBase = FusedMixer ? 1 : 0;
+
+    /* A voice with silent target gains doesn't need to be mixed once it has
+     * faded out, or if it's just starting.
+     */
+    isvirtual = (voice->Flags&VOICE_IS_SILENT) &&
+                ((voice->Flags&VOICE_IS_VIRTUAL) || !(voice->Flags&VOICE_IS_FADING));
+    if(!isvirtual && (voice->Flags&VOICE_IS_VIRTUAL))
+    {
+        /* No samples were processed while virtual, so the stored history is
+         * stale. Clear it and let the gains fade in from silence.
+         */
+        for(chan = 0;chan < NumChannels;chan++)
+        {
+            DirectParams *parms = &voice->Direct.Params[chan];
+
+            memset(voice->PrevSamples[chan], 0, sizeof(voice->PrevSamples[chan]));
+            ALfilterState_clear(&parms->LowPass);
+            ALfilterState_clear(&parms->HighPass);
+            NfcFilterClear(&parms->NFCtrlFilter);
+            memset(&parms->Hrtf.State, 0, sizeof(parms->Hrtf.State));
+            if((voice->Flags&VOICE_HRTF_FFT))
+                ResetHrtfFFTState(&voice->HrtfFFT[chan]);
+            for(send = 0;send < Device->NumAuxSends;send++)
+            {
+                ALfilterState_clear(&voice->Send[send].Params[chan].LowPass);
+                ALfilterState_clear(&voice->Send[send].Params[chan].HighPass);
+            }
+        }
+    }
+
     Counter = (voice->Flags&VOICE_IS_FADING) ? SamplesToDo : 0;
     firstpass = true;
     OutPos = 0;
@@ -374,201 +724,293 @@ ALboolean MixSource(ALvoice *voice, ALuint SourceID, ALCcontext *Context, ALsize
         /* It's impossible to have a buffer list item with no entries. */
         assert(BufferListItem->num_buffers > 0);
 
-        for(chan = 0;chan < NumChannels;chan++)
+        /* A static source stops looping if it's past the loop end. */
+        if(isstatic && BufferLoopItem && DataPosInt >= BufferListItem->buffers[0]->LoopEnd)
+            BufferLoopItem = NULL;
+
+        /* The source data can be read straight from a single buffer when the
+         * history samples are from the same buffer (i.e. the position is far
+         * enough from the start, or the loop start), and the rest doesn't
+         * cross the loop end or into another buffer.
+         */
+        InPlaceBuffer = NULL;
+        InPlaceEnd = 0;
+        InPlaceGuard = false;
+        if(!isvirtual && BufferListItem->num_buffers == 1 && BufferListItem->buffers[0] &&
+           BufferListItem->buffers[0]->data)
         {
-            const ALfloat *ResampledData;
-            ALfloat *SrcData = Device->TempBuffer[SOURCE_DATA_BUF];
-            ALsizei FilledAmt;
+            const ALbuffer *buffer = BufferListItem->buffers[0];
+            ALsizei start = MAX_RESAMPLE_PADDING;
+            if(isstatic && BufferLoopItem)
+            {
+                start += buffer->LoopStart;
+                InPlaceEnd = buffer->LoopEnd;
+            }
+            else
+            {
+                /* Silence follows the last buffer, so it can use the zeroed
+                 * samples after the end.
+                 */
+                InPlaceEnd = buffer->SampleLen;
+                InPlaceGuard = !BufferLoopItem &&
+                               !ATOMIC_LOAD(&BufferListItem->next, almemory_order_acquire);
+            }
+            if(DataPosInt >= start)
+                InPlaceBuffer = buffer;
+        }
 
-            /* Load the previous samples into the source data first, and clear the rest. */
-            memcpy(SrcData, voice->PrevSamples[chan], MAX_RESAMPLE_PADDING*sizeof(ALfloat));
-            memset(SrcData+MAX_RESAMPLE_PADDING, 0, (BUFFERSIZE-MAX_RESAMPLE_PADDING)*
-                                                    sizeof(ALfloat));
-            FilledAmt = MAX_RESAMPLE_PADDING;
+        if(isvirtual)
+        {
+            /* Nothing to load or mix, so just advance through the rest of the
+             * update, up to BUFFERSIZE samples at a time.
+             */
+            DstBufferSize = mini(SamplesToDo - OutPos, BUFFERSIZE);
+        }
+        else for(chan = 0;chan < NumChannels;chan++)
+        {
+            const ALsizei SrcDataEnd = DataPosInt + SrcBufferSize - MAX_RESAMPLE_PADDING;
+            const ALfloat *FilteredData[4];
+            const ALfloat *ResampledData;
+            const ALfloat *SrcSamples;
+            ALsizei guard = 0;
 
-            if(isstatic)
+            SrcSamples = InPlaceBuffer ?
+                GetBufferFloatChannel(InPlaceBuffer, chan, NumChannels, &guard) : NULL;
+            if(SrcSamples && SrcDataEnd <= InPlaceEnd + (InPlaceGuard ? guard : 0))
+            {
+                /* Start from the history samples before the current position. */
+                SrcSamples += DataPosInt - MAX_RESAMPLE_PADDING;
+            }
+            else
             {
-                /* TODO: For static sources, loop points are taken from the
-                 * first buffer (should be adjusted by any buffer offset, to
-                 * possibly be added later).
+                ALfloat *SrcData = TempBuffer[SOURCE_DATA_BUF];
+                ALsizei FilledAmt;
+
+                /* Load the previous samples into the source data first, and
+                 * clear the rest that will be used.
                  */
-                const ALbuffer *Buffer0 = BufferListItem->buffers[0];
-                const ALsizei LoopStart = Buffer0->LoopStart;
-                const ALsizei LoopEnd   = Buffer0->LoopEnd;
-                const ALsizei LoopSize  = LoopEnd - LoopStart;
+                memcpy(SrcData, voice->PrevSamples[chan], MAX_RESAMPLE_PADDING*sizeof(ALfloat));
+                memset(SrcData+MAX_RESAMPLE_PADDING, 0, (SrcBufferSize-MAX_RESAMPLE_PADDING)*
+                                                        sizeof(ALfloat));
+                FilledAmt = MAX_RESAMPLE_PADDING;
 
-                /* If current pos is beyond the loop range, do not loop */
-                if(!BufferLoopItem || DataPosInt >= LoopEnd)
+                if(isstatic)
                 {
-                    ALsizei SizeToDo = SrcBufferSize - FilledAmt;
-                    ALsizei CompLen = 0;
-                    ALsizei i;
-
-                    BufferLoopItem = NULL;
-
-                    for(i = 0;i < BufferListItem->num_buffers;i++)
+                    /* TODO: For static sources, loop points are taken from the
+                     * first buffer (should be adjusted by any buffer offset, to
+                     * possibly be added later).
+                     */
+                    const ALbuffer *Buffer0 = BufferListItem->buffers[0];
+                    const ALsizei LoopStart = Buffer0->LoopStart;
+                    const ALsizei LoopEnd   = Buffer0->LoopEnd;
+                    const ALsizei LoopSize  = LoopEnd - LoopStart;
+
+                    /* If current pos is beyond the loop range, do not loop */
+                    if(!BufferLoopItem || DataPosInt >= LoopEnd)
                     {
-                        const ALbuffer *buffer = BufferListItem->buffers[i];
-                        const ALubyte *Data = buffer->data;
-                        ALsizei DataSize;
-
-                        if(DataPosInt >= buffer->SampleLen)
-                            continue;
+                        ALsizei SizeToDo = SrcBufferSize - FilledAmt;
+                        ALsizei CompLen = 0;
+                        ALsizei i;
 
-                        /* Load what's left to play from the buffer */
-                        DataSize = mini(SizeToDo, buffer->SampleLen - DataPosInt);
-                        CompLen = maxi(CompLen, DataSize);
-
-                        LoadSamples(&SrcData[FilledAmt],
-                            &Data[(DataPosInt*NumChannels + chan)*SampleSize],
-                            NumChannels, buffer->FmtType, DataSize
-                        );
-                    }
-                    FilledAmt += CompLen;
-                }
-                else
-                {
-                    ALsizei SizeToDo = mini(SrcBufferSize - FilledAmt, LoopEnd - DataPosInt);
-                    ALsizei CompLen = 0;
-                    ALsizei i;
+                        BufferLoopItem = NULL;
 
-                    for(i = 0;i < BufferListItem->num_buffers;i++)
-                    {
-                        const ALbuffer *buffer = BufferListItem->buffers[i];
-                        const ALubyte *Data = buffer->data;
-                        ALsizei DataSize;
+                        for(i = 0;i < BufferListItem->num_buffers;i++)
+                        {
+                            const ALbuffer *buffer = BufferListItem->buffers[i];
+                            ALsizei DataSize;
 
-                        if(DataPosInt >= buffer->SampleLen)
-                            continue;
+                            if(DataPosInt >= buffer->SampleLen)
+                                continue;
 
-                        /* Load what's left of this loop iteration */
-                        DataSize = mini(SizeToDo, buffer->SampleLen - DataPosInt);
-                        CompLen = maxi(CompLen, DataSize);
+                            /* Load what's left to play from the buffer */
+                            DataSize = mini(SizeToDo, buffer->SampleLen - DataPosInt);
+                            CompLen = maxi(CompLen, DataSize);
 
-                        LoadSamples(&SrcData[FilledAmt],
-                            &Data[(DataPosInt*NumChannels + chan)*SampleSize],
-                            NumChannels, buffer->FmtType, DataSize
-                        );
+                            LoadBufferSamples(&SrcData[FilledAmt], buffer, DataPosInt, chan,
+                                              NumChannels, SampleSize, DataSize);
+                        }
+                        FilledAmt += CompLen;
                     }
-                    FilledAmt += CompLen;
-
-                    while(SrcBufferSize > FilledAmt)
+                    else
                     {
-                        const ALsizei SizeToDo = mini(SrcBufferSize - FilledAmt, LoopSize);
+                        ALsizei SizeToDo = mini(SrcBufferSize - FilledAmt, LoopEnd - DataPosInt);
+                        ALsizei CompLen = 0;
+                        ALsizei i;
 
-                        CompLen = 0;
                         for(i = 0;i < BufferListItem->num_buffers;i++)
                         {
                             const ALbuffer *buffer = BufferListItem->buffers[i];
-                            const ALubyte *Data = buffer->data;
                             ALsizei DataSize;
 
-                            if(LoopStart >= buffer->SampleLen)
+                            if(DataPosInt >= buffer->SampleLen)
                                 continue;
 
-                            DataSize = mini(SizeToDo, buffer->SampleLen - LoopStart);
+                            /* Load what's left of this loop iteration */
+                            DataSize = mini(SizeToDo, buffer->SampleLen - DataPosInt);
                             CompLen = maxi(CompLen, DataSize);
 
-                            LoadSamples(&SrcData[FilledAmt],
-                                &Data[(LoopStart*NumChannels + chan)*SampleSize],
-                                NumChannels, buffer->FmtType, DataSize
-                            );
+                            LoadBufferSamples(&SrcData[FilledAmt], buffer, DataPosInt, chan,
+                                              NumChannels, SampleSize, DataSize);
                         }
                         FilledAmt += CompLen;
+
+                        while(SrcBufferSize > FilledAmt)
+                        {
+                            const ALsizei SizeToDo = mini(SrcBufferSize - FilledAmt, LoopSize);
+
+                            CompLen = 0;
+                            for(i = 0;i < BufferListItem->num_buffers;i++)
+                            {
+                                const ALbuffer *buffer = BufferListItem->buffers[i];
+                                ALsizei DataSize;
+
+                                if(LoopStart >= buffer->SampleLen)
+                                    continue;
+
+                                DataSize = mini(SizeToDo, buffer->SampleLen - LoopStart);
+                                CompLen = maxi(CompLen, DataSize);
+
+                                LoadBufferSamples(&SrcData[FilledAmt], buffer, LoopStart, chan,
+                                                  NumChannels, SampleSize, DataSize);
+                            }
+                            FilledAmt += CompLen;
+                        }
                     }
                 }
-            }
-            else
-            {
-                /* Crawl the buffer queue to fill in the temp buffer */
-                ALbufferlistitem *tmpiter = BufferListItem;
-                ALsizei pos = DataPosInt;
-
-                while(tmpiter && SrcBufferSize > FilledAmt)
+                else
                 {
-                    ALsizei SizeToDo = SrcBufferSize - FilledAmt;
-                    ALsizei CompLen = 0;
-                    ALsizei i;
+                    /* Crawl the buffer queue to fill in the temp buffer */
+                    ALbufferlistitem *tmpiter = BufferListItem;
+                    ALsizei pos = DataPosInt;
 
-                    for(i = 0;i < tmpiter->num_buffers;i++)
+                    while(tmpiter && SrcBufferSize > FilledAmt)
                     {
-                        const ALbuffer *ALBuffer = tmpiter->buffers[i];
-                        ALsizei DataSize = ALBuffer ? ALBuffer->SampleLen : 0;
-                        CompLen = maxi(CompLen, DataSize);
+                        ALsizei SizeToDo = SrcBufferSize - FilledAmt;
+                        ALsizei CompLen = 0;
+                        ALsizei i;
 
-                        if(DataSize > pos)
+                        for(i = 0;i < tmpiter->num_buffers;i++)
                         {
-                            const ALubyte *Data = ALBuffer->data;
-                            Data += (pos*NumChannels + chan)*SampleSize;
+                            const ALbuffer *ALBuffer = tmpiter->buffers[i];
+                            ALsizei DataSize = ALBuffer ? ALBuffer->SampleLen : 0;
+                            CompLen = maxi(CompLen, DataSize);
 
-                            DataSize = minu(SizeToDo, DataSize - pos);
-                            LoadSamples(&SrcData[FilledAmt], Data, NumChannels,
-                                        ALBuffer->FmtType, DataSize);
+                            if(DataSize > pos)
+                            {
+                                DataSize = minu(SizeToDo, DataSize - pos);
+                                LoadBufferSamples(&SrcData[FilledAmt], ALBuffer, pos, chan,
+                                                  NumChannels, SampleSize, DataSize);
+                            }
+                        }
+                        if(pos > CompLen)
+                            pos -= CompLen;
+                        else
+                        {
+                            FilledAmt += CompLen - pos;
+                            pos = 0;
+                        }
+                        if(SrcBufferSize > FilledAmt)
+                        {
+                            tmpiter = ATOMIC_LOAD(&tmpiter->next, almemory_order_acquire);
+                            if(!tmpiter) tmpiter = BufferLoopItem;
                         }
-                    }
-                    if(pos > CompLen)
-                        pos -= CompLen;
-                    else
-                    {
-                        FilledAmt += CompLen - pos;
-                        pos = 0;
-                    }
-                    if(SrcBufferSize > FilledAmt)
-                    {
-                        tmpiter = ATOMIC_LOAD(&tmpiter->next, almemory_order_acquire);
-                        if(!tmpiter) tmpiter = BufferLoopItem;
                     }
                 }
+
+                SrcSamples = SrcData;
             }
 
             /* Store the last source samples used for next time. */
             memcpy(voice->PrevSamples[chan],
-                &SrcData[(increment*DstBufferSize + DataPosFrac)>>FRACTIONBITS],
+                &SrcSamples[(increment*DstBufferSize + DataPosFrac)>>FRACTIONBITS],
                 MAX_RESAMPLE_PADDING*sizeof(ALfloat)
             );
 
-            /* Now resample, then filter and mix to the appropriate outputs. */
-            ResampledData = Resample(&voice->ResampleState,
-                &SrcData[MAX_RESAMPLE_PADDING], DataPosFrac, increment,
-                Device->TempBuffer[RESAMPLED_BUF], DstBufferSize
-            );
+            if(FusedMixer)
+            {
+                DirectParams *parms = &voice->Direct.Params[chan];
+                ALuint mask;
+                ALsizei first = 0;
+                ALsizei count = 0;
+
+                if(!Counter)
+                {
+                    memcpy(parms->Gains.Current, parms->Gains.Target,
+                           sizeof(parms->Gains.Current));
+                    parms->Gains.ActiveMask = parms->Gains.TargetMask;
+                }
+                /* The fused mixer handles one span of output channels, from
+                 * the first to the last active one.
+                 */
+                if((mask=parms->Gains.ActiveMask) != 0)
+                {
+                    first = CTZ64((ALuint64)mask);
+                    for(mask >>= first;mask;mask >>= 1)
+                        count++;
+                }
+                FusedMixer(&voice->ResampleState, &SrcSamples[MAX_RESAMPLE_PADDING],
+                    DataPosFrac, increment, &parms->LowPass, &parms->HighPass,
+                    HasSends ? TempBuffer[RESAMPLED_BUF] : NULL, count, DirectBuffer+first,
+                    parms->Gains.Current+first, parms->Gains.Target+first, Counter, OutPos,
+                    DstBufferSize
+                );
+                if(Counter <= DstBufferSize)
+                    parms->Gains.ActiveMask = parms->Gains.TargetMask;
+                ResampledData = TempBuffer[RESAMPLED_BUF];
+            }
+            else
             {
                 DirectParams *parms = &voice->Direct.Params[chan];
                 const ALfloat *samples;
 
-                samples = DoFilters(
-                    &parms->LowPass, &parms->HighPass, Device->TempBuffer[FILTERED_BUF],
-                    ResampledData, DstBufferSize, voice->Direct.FilterType
+                /* Now resample, then filter and mix to the appropriate
+                 * outputs.
+                 */
+                ResampledData = Resample(&voice->ResampleState,
+                    &SrcSamples[MAX_RESAMPLE_PADDING], DataPosFrac, increment,
+                    TempBuffer[RESAMPLED_BUF], DstBufferSize
                 );
+
+                /* Filter the direct path together with the first three sends. */
+                DoFilters(voice, chan, 0, NumOutputs, &TempBuffer[FILTERED_BUF], ResampledData,
+                          DstBufferSize, FilteredData);
+                samples = FilteredData[0];
+
                 if(!(voice->Flags&VOICE_HAS_HRTF))
                 {
                     if(!Counter)
+                    {
                         memcpy(parms->Gains.Current, parms->Gains.Target,
                                sizeof(parms->Gains.Current));
+                        parms->Gains.ActiveMask = parms->Gains.TargetMask;
+                    }
                     if(!(voice->Flags&VOICE_HAS_NFC))
-                        MixSamples(samples, voice->Direct.Channels, voice->Direct.Buffer,
+                        MixChannelMask(samples, parms->Gains.ActiveMask, DirectBuffer,
                             parms->Gains.Current, parms->Gains.Target, Counter, OutPos,
                             DstBufferSize
                         );
                     else
                     {
-                        ALfloat *nfcsamples = Device->TempBuffer[NFC_DATA_BUF];
+                        ALfloat *nfcsamples = TempBuffer[NFC_DATA_BUF];
                         ALsizei chanoffset = 0;
+                        ALuint ordermask;
 
-                        MixSamples(samples,
-                            voice->Direct.ChannelsPerOrder[0], voice->Direct.Buffer,
-                            parms->Gains.Current, parms->Gains.Target, Counter, OutPos,
-                            DstBufferSize
+                        ordermask = (1u<<voice->Direct.ChannelsPerOrder[0]) - 1u;
+                        MixChannelMask(samples, parms->Gains.ActiveMask&ordermask,
+                            DirectBuffer, parms->Gains.Current, parms->Gains.Target,
+                            Counter, OutPos, DstBufferSize
                         );
                         chanoffset += voice->Direct.ChannelsPerOrder[0];
 #define APPLY_NFC_MIX(order)                                                  \
     if(voice->Direct.ChannelsPerOrder[order] > 0)                             \
     {                                                                         \
+        ordermask = (1u<<voice->Direct.ChannelsPerOrder[order]) - 1u;         \
         NfcFilterUpdate##order(&parms->NFCtrlFilter, nfcsamples, samples,     \
                                DstBufferSize);                                \
-        MixSamples(nfcsamples, voice->Direct.ChannelsPerOrder[order],         \
-            voice->Direct.Buffer+chanoffset, parms->Gains.Current+chanoffset, \
-            parms->Gains.Target+chanoffset, Counter, OutPos, DstBufferSize    \
+        MixChannelMask(nfcsamples, (parms->Gains.ActiveMask>>chanoffset) &    \
+            ordermask, DirectBuffer+chanoffset,                               \
+            parms->Gains.Current+chanoffset, parms->Gains.Target+chanoffset,  \
+            Counter, OutPos, DstBufferSize                                    \
         );                                                                    \
         chanoffset += voice->Direct.ChannelsPerOrder[order];                  \
     }
@@ -577,6 +1019,35 @@ ALboolean MixSource(ALvoice *voice, ALuint SourceID, ALCcontext *Context, ALsize
                         APPLY_NFC_MIX(3)
 #undef APPLY_NFC_MIX
                     }
+                    if(Counter <= DstBufferSize)
+                        parms->Gains.ActiveMask = parms->Gains.TargetMask;
+                }
+                else if((voice->Flags&VOICE_HRTF_FFT))
+                {
+                    ALfloat gain = parms->Hrtf.Target.Gain;
+                    int lidx, ridx;
+
+                    lidx = GetChannelIdxByName(&Device->RealOut, FrontLeft);
+                    ridx = GetChannelIdxByName(&Device->RealOut, FrontRight);
+                    assert(lidx != -1 && ridx != -1);
+
+                    /* The convolver fades between filters itself, so only the
+                     * gain needs interpolating if the fade lasts longer than
+                     * this mix.
+                     */
+                    if(!Counter)
+                        parms->Hrtf.Old.Gain = gain;
+                    else if(Counter > DstBufferSize)
+                        gain = lerp(parms->Hrtf.Old.Gain, gain,
+                                    (ALfloat)DstBufferSize/Counter);
+
+                    MixHrtfFFTSamples(DirectBuffer[lidx], DirectBuffer[ridx], samples, OutPos,
+                        parms->Hrtf.Target.Filter, parms->Hrtf.Old.Gain,
+                        (gain - parms->Hrtf.Old.Gain) / (ALfloat)DstBufferSize,
+                        &voice->HrtfFFT[chan], DstBufferSize
+                    );
+                    parms->Hrtf.Old.Filter = parms->Hrtf.Target.Filter;
+                    parms->Hrtf.Old.Gain = gain;
                 }
                 else
                 {
@@ -617,14 +1088,14 @@ ALboolean MixSource(ALvoice *voice, ALuint SourceID, ALCcontext *Context, ALsize
                          */
                         gain = lerp(parms->Hrtf.Old.Gain, parms->Hrtf.Target.Gain,
                                     minf(1.0f, (ALfloat)fademix/Counter));
-                        hrtfparams.Coeffs = parms->Hrtf.Target.Coeffs;
-                        hrtfparams.Delay[0] = parms->Hrtf.Target.Delay[0];
-                        hrtfparams.Delay[1] = parms->Hrtf.Target.Delay[1];
+                        hrtfparams.Coeffs = parms->Hrtf.Target.Filter->Coeffs;
+                        hrtfparams.Delay[0] = parms->Hrtf.Target.Filter->Delay[0];
+                        hrtfparams.Delay[1] = parms->Hrtf.Target.Filter->Delay[1];
                         hrtfparams.Gain = 0.0f;
                         hrtfparams.GainStep = gain / (ALfloat)fademix;
 
                         MixHrtfBlendSamples(
-                            voice->Direct.Buffer[lidx], voice->Direct.Buffer[ridx],
+                            DirectBuffer[lidx], DirectBuffer[ridx],
                             samples, voice->Offset, OutPos, IrSize, &parms->Hrtf.Old,
                             &hrtfparams, &parms->Hrtf.State, fademix
                         );
@@ -646,13 +1117,13 @@ ALboolean MixSource(ALvoice *voice, ALuint SourceID, ALCcontext *Context, ALsize
                             gain = lerp(parms->Hrtf.Old.Gain, gain,
                                         (ALfloat)todo/(Counter-fademix));
 
-                        hrtfparams.Coeffs = parms->Hrtf.Target.Coeffs;
-                        hrtfparams.Delay[0] = parms->Hrtf.Target.Delay[0];
-                        hrtfparams.Delay[1] = parms->Hrtf.Target.Delay[1];
+                        hrtfparams.Coeffs = parms->Hrtf.Target.Filter->Coeffs;
+                        hrtfparams.Delay[0] = parms->Hrtf.Target.Filter->Delay[0];
+                        hrtfparams.Delay[1] = parms->Hrtf.Target.Filter->Delay[1];
                         hrtfparams.Gain = parms->Hrtf.Old.Gain;
                         hrtfparams.GainStep = (gain - parms->Hrtf.Old.Gain) / (ALfloat)todo;
                         MixHrtfSamples(
-                            voice->Direct.Buffer[lidx], voice->Direct.Buffer[ridx],
+                            DirectBuffer[lidx], DirectBuffer[ridx],
                             samples+fademix, voice->Offset+fademix, OutPos+fademix, IrSize,
                             &hrtfparams, &parms->Hrtf.State, todo
                         );
@@ -672,20 +1143,25 @@ ALboolean MixSource(ALvoice *voice, ALuint SourceID, ALCcontext *Context, ALsize
                 SendParams *parms = &voice->Send[send].Params[chan];
                 const ALfloat *samples;
 
-                if(!voice->Send[send].Buffer)
+                /* Filter the remaining sends four at a time. */
+                if(((send+1-FilterBase)&3) == 0)
+                    DoFilters(voice, chan, send+1, NumOutputs, &TempBuffer[FILTERED_BUF],
+                              ResampledData, DstBufferSize, FilteredData);
+                if(!SendBuffer[send])
                     continue;
-
-                samples = DoFilters(
-                    &parms->LowPass, &parms->HighPass, Device->TempBuffer[FILTERED_BUF],
-                    ResampledData, DstBufferSize, voice->Send[send].FilterType
-                );
+                samples = FilteredData[(send+1-FilterBase)&3];
 
                 if(!Counter)
+                {
                     memcpy(parms->Gains.Current, parms->Gains.Target,
                            sizeof(parms->Gains.Current));
-                MixSamples(samples, voice->Send[send].Channels, voice->Send[send].Buffer,
+                    parms->Gains.ActiveMask = parms->Gains.TargetMask;
+                }
+                MixChannelMask(samples, parms->Gains.ActiveMask, SendBuffer[send],
                     parms->Gains.Current, parms->Gains.Target, Counter, OutPos, DstBufferSize
                 );
+                if(Counter <= DstBufferSize)
+                    parms->Gains.ActiveMask = parms->Gains.TargetMask;
             }
         }
         /* Update positions */
@@ -764,18 +1240,21 @@ ALboolean MixSource(ALvoice *voice, ALuint SourceID, ALCcontext *Context, ALsize
     } while(isplaying && OutPos < SamplesToDo);
 
     voice->Flags |= VOICE_IS_FADING;
+    /* With silent targets, the current gains are now silent too. */
+    if((voice->Flags&VOICE_IS_SILENT))
+        voice->Flags |= VOICE_IS_VIRTUAL;
+    else
+        voice->Flags &= ~VOICE_IS_VIRTUAL;
 
     /* Update source info */
     ATOMIC_STORE(&voice->position,          DataPosInt, almemory_order_relaxed);
     ATOMIC_STORE(&voice->position_fraction, DataPosFrac, almemory_order_relaxed);
     ATOMIC_STORE(&voice->current_buffer,    BufferListItem, almemory_order_release);
 
-    /* Send any events now, after the position/buffer info was updated. */
-    enabledevt = ATOMIC_LOAD(&Context->EnabledEvts, almemory_order_acquire);
-    if(buffers_done > 0 && (enabledevt&EventType_BufferCompleted))
-        SendAsyncEvent(Context, EventType_BufferCompleted,
-            AL_EVENT_TYPE_BUFFER_COMPLETED_SOFT, SourceID, buffers_done, "Buffer completed"
-        );
+    /* Leave any events for the mixer thread to send, after the position/buffer
+     * info was updated.
+     */
+    voice->BuffersDone = buffers_done;
 
     return isplaying;
 }
@@ -0,0 +1,345 @@
+#include "config.h"
+
+#include <immintrin.h>
+
+#include "AL/al.h"
+#include "AL/alc.h"
+#include "alMain.h"
+#include "alu.h"
+
+#include "alSource.h"
+#include "alAuxEffectSlot.h"
+#include "mixer_defs.h"
+
+
+/* NOTE: The mixing buffers are only guaranteed 16-byte alignment, so all
+ * 256-bit loads and stores here are unaligned.
+ */
+
+const ALfloat *Resample_lerp_AVX2(const InterpState* UNUSED(state),
+  const ALfloat *restrict src, ALsizei frac, ALint increment,
+  ALfloat *restrict dst, ALsizei numsamples)
+{
+    const __m256i increment8 = _mm256_set1_epi32(increment*8);
+    const __m256 fracOne8 = _mm256_set1_ps(1.0f/FRACTIONONE);
+    const __m256i fracMask8 = _mm256_set1_epi32(FRACTIONMASK);
+    union { alignas(32) ALint i[8]; float f[8]; } pos_;
+    union { alignas(32) ALsizei i[8]; float f[8]; } frac_;
+    __m256i frac8, pos8;
+    ALint pos;
+    ALsizei i;
+
+    InitiatePositionArrays(frac, increment, frac_.i, pos_.i, 8);
+
+    frac8 = _mm256_castps_si256(_mm256_load_ps(frac_.f));
+    pos8 = _mm256_castps_si256(_mm256_load_ps(pos_.f));
+
+    for(i = 0;numsamples-i > 7;i += 8)
+    {
+        const __m256 val1 = _mm256_i32gather_ps(src, pos8, 4);
+        const __m256 val2 = _mm256_i32gather_ps(src+1, pos8, 4);
+
+        /* val1 + (val2-val1)*mu */
+        const __m256 r0 = _mm256_sub_ps(val2, val1);
+        const __m256 mu = _mm256_mul_ps(_mm256_cvtepi32_ps(frac8), fracOne8);
+        const __m256 out = _mm256_fmadd_ps(mu, r0, val1);
+
+        _mm256_storeu_ps(&dst[i], out);
+
+        frac8 = _mm256_add_epi32(frac8, increment8);
+        pos8 = _mm256_add_epi32(pos8, _mm256_srli_epi32(frac8, FRACTIONBITS));
+        frac8 = _mm256_and_si256(frac8, fracMask8);
+    }
+
+    /* NOTE: These eight elements represent the position *after* the last
+     * eight samples, so the lowest element is the next position to resample.
+     */
+    pos = _mm_cvtsi128_si32(_mm256_castsi256_si128(pos8));
+    frac = _mm_cvtsi128_si32(_mm256_castsi256_si128(frac8));
+
+    for(;i < numsamples;i++)
+    {
+        dst[i] = lerp(src[pos], src[pos+1], frac * (1.0f/FRACTIONONE));
+
+        frac += increment;
+        pos  += frac>>FRACTIONBITS;
+        frac &= FRACTIONMASK;
+    }
+    return dst;
+}
+
+const ALfloat *Resample_bsinc_AVX2(const InterpState *state, const ALfloat *restrict src,
+                                   ALsizei frac, ALint increment, ALfloat *restrict dst,
+                                   ALsizei dstlen)
+{
+    const ALfloat *const filter = state->bsinc.filter;
+    const __m256 sf8 = _mm256_set1_ps(state->bsinc.sf);
+    const ALsizei m = state->bsinc.m;
+    const ALfloat *fil, *scd, *phd, *spd;
+    ALsizei pi, i, j, offset;
+    ALfloat pf;
+    __m256 r8;
+    __m128 r4;
+
+    src += state->bsinc.l;
+    for(i = 0;i < dstlen;i++)
+    {
+        // Calculate the phase index and factor.
+#define FRAC_PHASE_BITDIFF (FRACTIONBITS-BSINC_PHASE_BITS)
+        pi = frac >> FRAC_PHASE_BITDIFF;
+        pf = (frac & ((1<<FRAC_PHASE_BITDIFF)-1)) * (1.0f/(1<<FRAC_PHASE_BITDIFF));
+#undef FRAC_PHASE_BITDIFF
+
+        offset = m*pi*4;
+        fil = filter + offset; offset += m;
+        scd = filter + offset; offset += m;
+        phd = filter + offset; offset += m;
+        spd = filter + offset;
+
+        // Apply the scale and phase interpolated filter.
+        r8 = _mm256_setzero_ps();
+        {
+            const __m256 pf8 = _mm256_set1_ps(pf);
+            for(j = 0;m-j > 7;j += 8)
+            {
+                /* f = ((fil + sf*scd) + pf*(phd + sf*spd)) */
+                const __m256 f8 = _mm256_fmadd_ps(pf8,
+                    _mm256_fmadd_ps(sf8, _mm256_loadu_ps(&spd[j]), _mm256_loadu_ps(&phd[j])),
+                    _mm256_fmadd_ps(sf8, _mm256_loadu_ps(&scd[j]), _mm256_loadu_ps(&fil[j]))
+                );
+                /* r += f*src */
+                r8 = _mm256_fmadd_ps(f8, _mm256_loadu_ps(&src[j]), r8);
+            }
+            r4 = _mm_add_ps(_mm256_castps256_ps128(r8), _mm256_extractf128_ps(r8, 1));
+            /* The filter length is a multiple of 4, so there may be 4 left. */
+            if(j < m)
+            {
+                const __m128 sf4 = _mm256_castps256_ps128(sf8);
+                const __m128 pf4 = _mm256_castps256_ps128(pf8);
+                const __m128 f4 = _mm_fmadd_ps(pf4,
+                    _mm_fmadd_ps(sf4, _mm_load_ps(&spd[j]), _mm_load_ps(&phd[j])),
+                    _mm_fmadd_ps(sf4, _mm_load_ps(&scd[j]), _mm_load_ps(&fil[j]))
+                );
+                r4 = _mm_fmadd_ps(f4, _mm_loadu_ps(&src[j]), r4);
+            }
+        }
+        r4 = _mm_add_ps(r4, _mm_shuffle_ps(r4, r4, _MM_SHUFFLE(0, 1, 2, 3)));
+        r4 = _mm_add_ps(r4, _mm_movehl_ps(r4, r4));
+        dst[i] = _mm_cvtss_f32(r4);
+
+        frac += increment;
+        src  += frac>>FRACTIONBITS;
+        frac &= FRACTIONMASK;
+    }
+    return dst;
+}
+
+
+static inline void ApplyCoeffsRun(ALfloat *restrict vals, const ALfloat *restrict coeffs,
+                                  ALsizei count, ALfloat left, ALfloat right)
+{
+    const __m256 lrlr8 = _mm256_setr_ps(left, right, left, right, left, right, left, right);
+    ALsizei i = 0;
+
+    for(;count-i > 3;i += 4)
+    {
+        __m256 vals8 = _mm256_loadu_ps(&vals[i*2]);
+        vals8 = _mm256_fmadd_ps(lrlr8, _mm256_loadu_ps(&coeffs[i*2]), vals8);
+        _mm256_storeu_ps(&vals[i*2], vals8);
+    }
+    for(;i < count;i++)
+    {
+        vals[i*2 + 0] += coeffs[i*2 + 0] * left;
+        vals[i*2 + 1] += coeffs[i*2 + 1] * right;
+    }
+}
+
+static inline void ApplyCoeffs(ALsizei Offset, ALfloat (*restrict Values)[2],
+                               const ALsizei IrSize,
+                               const ALfloat (*restrict Coeffs)[2],
+                               ALfloat left, ALfloat right)
+{
+    const ALsizei o0 = Offset&HRIR_MASK;
+    const ALsizei count = mini(IrSize, HRIR_LENGTH-o0);
+
+    /* The values are a ring buffer, so apply the coefficients in up to two
+     * contiguous runs.
+     */
+    ApplyCoeffsRun(&Values[o0][0], &Coeffs[0][0], count, left, right);
+    if(count < IrSize)
+        ApplyCoeffsRun(&Values[0][0], &Coeffs[count][0], IrSize-count, left, right);
+}
+
+static inline void ApplyFFTStages(ALfloat *restrict re, ALfloat *restrict im, ALsizei n)
+{
+    ALsizei h, k, j;
+
+    HrtfFFTRadix4(re, im, n);
+    /* The 4-point stage is too small for 8-wide vectors. */
+    for(k = 0;k < n;k += 8)
+    {
+        const __m128 wr = _mm_load_ps(&HrtfFFTTwiddles[0][4]);
+        const __m128 wi = _mm_load_ps(&HrtfFFTTwiddles[1][4]);
+        const __m128 xr = _mm_load_ps(&re[k+4]);
+        const __m128 xi = _mm_load_ps(&im[k+4]);
+        const __m128 yr = _mm_load_ps(&re[k]);
+        const __m128 yi = _mm_load_ps(&im[k]);
+        const __m128 tr = _mm_fmsub_ps(xr, wr, _mm_mul_ps(xi, wi));
+        const __m128 ti = _mm_fmadd_ps(xr, wi, _mm_mul_ps(xi, wr));
+        _mm_store_ps(&re[k+4], _mm_sub_ps(yr, tr));
+        _mm_store_ps(&im[k+4], _mm_sub_ps(yi, ti));
+        _mm_store_ps(&re[k], _mm_add_ps(yr, tr));
+        _mm_store_ps(&im[k], _mm_add_ps(yi, ti));
+    }
+    for(h = 8;h < n;h <<= 1)
+    {
+        const ALfloat *restrict twr = &HrtfFFTTwiddles[0][h];
+        const ALfloat *restrict twi = &HrtfFFTTwiddles[1][h];
+        for(k = 0;k < n;k += h*2)
+        {
+            ALfloat *restrict ar = &re[k], *restrict ai = &im[k];
+            ALfloat *restrict br = &re[k+h], *restrict bi = &im[k+h];
+            for(j = 0;j < h;j += 8)
+            {
+                const __m256 wr = _mm256_loadu_ps(&twr[j]);
+                const __m256 wi = _mm256_loadu_ps(&twi[j]);
+                const __m256 xr = _mm256_loadu_ps(&br[j]);
+                const __m256 xi = _mm256_loadu_ps(&bi[j]);
+                const __m256 yr = _mm256_loadu_ps(&ar[j]);
+                const __m256 yi = _mm256_loadu_ps(&ai[j]);
+                const __m256 tr = _mm256_fmsub_ps(xr, wr, _mm256_mul_ps(xi, wi));
+                const __m256 ti = _mm256_fmadd_ps(xr, wi, _mm256_mul_ps(xi, wr));
+                _mm256_storeu_ps(&br[j], _mm256_sub_ps(yr, tr));
+                _mm256_storeu_ps(&bi[j], _mm256_sub_ps(yi, ti));
+                _mm256_storeu_ps(&ar[j], _mm256_add_ps(yr, tr));
+                _mm256_storeu_ps(&ai[j], _mm256_add_ps(yi, ti));
+            }
+        }
+    }
+}
+
+static inline void ApplySpectrum(HrtfSpectrum *restrict output,
+                                 const HrtfSpectrum *restrict input,
+                                 const HrtfSpectrum *restrict coeffs)
+{
+    ALsizei i;
+    for(i = 0;i < HRTF_FFT_SIZE;i += 8)
+    {
+        const __m256 xr = _mm256_loadu_ps(&input->Real[i]);
+        const __m256 xi = _mm256_loadu_ps(&input->Imag[i]);
+        const __m256 cr = _mm256_loadu_ps(&coeffs->Real[i]);
+        const __m256 ci = _mm256_loadu_ps(&coeffs->Imag[i]);
+        __m256 yr = _mm256_loadu_ps(&output->Real[i]);
+        __m256 yi = _mm256_loadu_ps(&output->Imag[i]);
+        yr = _mm256_fmadd_ps(xr, cr, yr);
+        yr = _mm256_fnmadd_ps(xi, ci, yr);
+        yi = _mm256_fmadd_ps(xr, ci, yi);
+        yi = _mm256_fmadd_ps(xi, cr, yi);
+        _mm256_storeu_ps(&output->Real[i], yr);
+        _mm256_storeu_ps(&output->Imag[i], yi);
+    }
+}
+
+#define MixHrtf MixHrtf_AVX2
+#define MixHrtfBlend MixHrtfBlend_AVX2
+#define MixHrtfFFT MixHrtfFFT_AVX2
+#define MixDirectHrtf MixDirectHrtf_AVX2
+#include "mixer_inc.c"
+#undef MixHrtf
+
+
+void Mix_AVX2(const ALfloat *data, ALsizei OutChans, ALfloat *const *restrict OutBuffer,
+              ALfloat *CurrentGains, const ALfloat *TargetGains, ALsizei Counter, ALsizei OutPos,
+              ALsizei BufferSize)
+{
+    ALfloat gain, delta, step;
+    __m256 gain8;
+    ALsizei c;
+
+    delta = (Counter > 0) ? 1.0f/(ALfloat)Counter : 0.0f;
+
+    for(c = 0;c < OutChans;c++)
+    {
+        ALfloat *restrict dst = &OutBuffer[c][OutPos];
+        ALsizei pos = 0;
+        gain = CurrentGains[c];
+        step = (TargetGains[c] - gain) * delta;
+        if(fabsf(step) > FLT_EPSILON)
+        {
+            ALsizei minsize = mini(BufferSize, Counter);
+            /* Mix with applying gain steps in multiples of 8. */
+            if(minsize-pos > 7)
+            {
+                __m256 step8;
+                gain8 = _mm256_setr_ps(
+                    gain,          gain + step,   gain + step*2.0f, gain + step*3.0f,
+                    gain + step*4.0f, gain + step*5.0f, gain + step*6.0f, gain + step*7.0f
+                );
+                step8 = _mm256_set1_ps(step * 8.0f);
+                do {
+                    const __m256 val8 = _mm256_loadu_ps(&data[pos]);
+                    __m256 dry8 = _mm256_loadu_ps(&dst[pos]);
+                    dry8 = _mm256_fmadd_ps(val8, gain8, dry8);
+                    gain8 = _mm256_add_ps(gain8, step8);
+                    _mm256_storeu_ps(&dst[pos], dry8);
+                    pos += 8;
+                } while(minsize-pos > 7);
+                /* NOTE: gain8 now represents the next eight gains after the
+                 * last eight mixed samples, so the lowest element represents
+                 * the next gain to apply.
+                 */
+                gain = _mm256_cvtss_f32(gain8);
+            }
+            /* Mix with applying left over gain steps that aren't multiples of
+             * 8.
+             */
+            for(;pos < minsize;pos++)
+            {
+                dst[pos] += data[pos]*gain;
+                gain += step;
+            }
+            if(pos == Counter)
+                gain = TargetGains[c];
+            CurrentGains[c] = gain;
+        }
+
+        if(!(fabsf(gain) > GAIN_SILENCE_THRESHOLD))
+            continue;
+        gain8 = _mm256_set1_ps(gain);
+        for(;BufferSize-pos > 7;pos += 8)
+        {
+            const __m256 val8 = _mm256_loadu_ps(&data[pos]);
+            __m256 dry8 = _mm256_loadu_ps(&dst[pos]);
+            dry8 = _mm256_fmadd_ps(val8, gain8, dry8);
+            _mm256_storeu_ps(&dst[pos], dry8);
+        }
+        for(;pos < BufferSize;pos++)
+            dst[pos] += data[pos]*gain;
+    }
+}
+
+void MixRow_AVX2(ALfloat *OutBuffer, const ALfloat *Gains, ALfloat *const *restrict data, ALsizei InChans, ALsizei InPos, ALsizei BufferSize)
+{
+    __m256 gain8;
+    ALsizei c;
+
+    for(c = 0;c < InChans;c++)
+    {
+        const ALfloat *restrict src = &data[c][InPos];
+        ALsizei pos = 0;
+        ALfloat gain = Gains[c];
+        if(!(fabsf(gain) > GAIN_SILENCE_THRESHOLD))
+            continue;
+
+        gain8 = _mm256_set1_ps(gain);
+        for(;BufferSize-pos > 7;pos += 8)
+        {
+            const __m256 val8 = _mm256_loadu_ps(&src[pos]);
+            __m256 dry8 = _mm256_loadu_ps(&OutBuffer[pos]);
+            dry8 = _mm256_fmadd_ps(val8, gain8, dry8);
+            _mm256_storeu_ps(&OutBuffer[pos], dry8);
+        }
+        for(;pos < BufferSize;pos++)
+            OutBuffer[pos] += src[pos]*gain;
+    }
+}
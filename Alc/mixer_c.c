@@ -130,6 +130,78 @@ void ALfilterState_processC(ALfilterState *filter, ALfloat *restrict dst, const
     }
 }
 
+void MultiFilter_C(ALfilterState *const *filters, ALfloat *const *dst,
+                   const ALfloat *const *src, ALsizei numfilters, ALsizei numsamples)
+{
+    ALsizei f, i;
+
+    for(f = 0;f < numfilters;f++)
+    {
+        ALfilterState *filter = filters[f];
+        const ALfloat b0 = filter->b0;
+        const ALfloat b1 = filter->b1;
+        const ALfloat b2 = filter->b2;
+        const ALfloat a1 = filter->a1;
+        const ALfloat a2 = filter->a2;
+        ALfloat x0 = filter->x[0];
+        ALfloat x1 = filter->x[1];
+        ALfloat y0 = filter->y[0];
+        ALfloat y1 = filter->y[1];
+        const ALfloat *in = src[f];
+        ALfloat *out = dst[f];
+
+        /* The input is read before the output is written, so this can work
+         * in place.
+         */
+        for(i = 0;i < numsamples;i++)
+        {
+            const ALfloat x = in[i];
+            const ALfloat y = b0*x + b1*x0 + b2*x1 - a1*y0 - a2*y1;
+            out[i] = y;
+            y1 = y0; y0 = y;
+            x1 = x0; x0 = x;
+        }
+
+        filter->x[0] = x0;
+        filter->x[1] = x1;
+        filter->y[0] = y0;
+        filter->y[1] = y1;
+    }
+}
+
+void CalcVoiceBatchVectors_C(VoiceBatch *restrict batch, ALsizei start, ALsizei end,
+                             const ALfloat *restrict lvelocity)
+{
+    ALsizei i;
+
+    for(i = start;i < end;i++)
+    {
+        ALfloat dx = batch->DirX[i], dy = batch->DirY[i], dz = batch->DirZ[i];
+        ALfloat tx = -batch->PosX[i], ty = -batch->PosY[i], tz = -batch->PosZ[i];
+        ALfloat len, scale;
+
+        /* Normalize the direction and the source-to-listener vector, leaving
+         * a zero-length vector as is.
+         */
+        len = sqrtf(dx*dx + dy*dy + dz*dz);
+        scale = (len > 0.0f) ? (1.0f/len) : 1.0f;
+        dx *= scale; dy *= scale; dz *= scale;
+        batch->DirLength[i] = len;
+
+        len = sqrtf(tx*tx + ty*ty + tz*tz);
+        scale = (len > 0.0f) ? (1.0f/len) : 1.0f;
+        tx *= scale; ty *= scale; tz *= scale;
+        batch->Distance[i] = len;
+        batch->ToListenerX[i] = tx;
+        batch->ToListenerY[i] = ty;
+        batch->ToListenerZ[i] = tz;
+
+        batch->ConeCos[i] = dx*tx + dy*ty + dz*tz;
+        batch->SourceVel[i] = batch->VelX[i]*tx + batch->VelY[i]*ty + batch->VelZ[i]*tz;
+        batch->ListenerVel[i] = lvelocity[0]*tx + lvelocity[1]*ty + lvelocity[2]*tz;
+    }
+}
+
 
 static inline void ApplyCoeffs(ALsizei Offset, ALfloat (*restrict Values)[2],
                                const ALsizei IrSize,
@@ -145,14 +217,32 @@ static inline void ApplyCoeffs(ALsizei Offset, ALfloat (*restrict Values)[2],
     }
 }
 
+static inline void ApplyFFTStages(ALfloat *restrict re, ALfloat *restrict im, ALsizei n)
+{
+    HrtfFFTStages(re, im, n);
+}
+
+static inline void ApplySpectrum(HrtfSpectrum *restrict output,
+                                 const HrtfSpectrum *restrict input,
+                                 const HrtfSpectrum *restrict coeffs)
+{
+    ALsizei i;
+    for(i = 0;i < HRTF_FFT_SIZE;i++)
+    {
+        output->Real[i] += input->Real[i]*coeffs->Real[i] - input->Imag[i]*coeffs->Imag[i];
+        output->Imag[i] += input->Real[i]*coeffs->Imag[i] + input->Imag[i]*coeffs->Real[i];
+    }
+}
+
 #define MixHrtf MixHrtf_C
 #define MixHrtfBlend MixHrtfBlend_C
+#define MixHrtfFFT MixHrtfFFT_C
 #define MixDirectHrtf MixDirectHrtf_C
 #include "mixer_inc.c"
 #undef MixHrtf
 
 
-void Mix_C(const ALfloat *data, ALsizei OutChans, ALfloat (*restrict OutBuffer)[BUFFERSIZE],
+void Mix_C(const ALfloat *data, ALsizei OutChans, ALfloat *const *restrict OutBuffer,
            ALfloat *CurrentGains, const ALfloat *TargetGains, ALsizei Counter, ALsizei OutPos,
            ALsizei BufferSize)
 {
@@ -192,7 +282,7 @@ void Mix_C(const ALfloat *data, ALsizei OutChans, ALfloat (*restrict OutBuffer)[
  * transform. And as the matrices are more or less static once set up, no
  * stepping is necessary.
  */
-void MixRow_C(ALfloat *OutBuffer, const ALfloat *Gains, const ALfloat (*restrict data)[BUFFERSIZE], ALsizei InChans, ALsizei InPos, ALsizei BufferSize)
+void MixRow_C(ALfloat *OutBuffer, const ALfloat *Gains, ALfloat *const *restrict data, ALsizei InChans, ALsizei InPos, ALsizei BufferSize)
 {
     ALsizei c, i;
 
@@ -33,12 +33,20 @@ void MixDirectHrtf_C(ALfloat *restrict LeftOut, ALfloat *restrict RightOut,
                      const ALfloat *data, ALsizei Offset, const ALsizei IrSize,
                      const ALfloat (*restrict Coeffs)[2], ALfloat (*restrict Values)[2],
                      ALsizei BufferSize);
-void Mix_C(const ALfloat *data, ALsizei OutChans, ALfloat (*restrict OutBuffer)[BUFFERSIZE],
+void MixHrtfFFT_C(ALfloat *restrict LeftOut, ALfloat *restrict RightOut,
+                  const ALfloat *data, ALsizei OutPos, HrtfFilter *filter,
+                  ALfloat gain, ALfloat gainstep, HrtfFFTState *state,
+                  ALsizei BufferSize);
+void Mix_C(const ALfloat *data, ALsizei OutChans, ALfloat *const *restrict OutBuffer,
            ALfloat *CurrentGains, const ALfloat *TargetGains, ALsizei Counter, ALsizei OutPos,
            ALsizei BufferSize);
 void MixRow_C(ALfloat *OutBuffer, const ALfloat *Gains,
-              const ALfloat (*restrict data)[BUFFERSIZE], ALsizei InChans,
+              ALfloat *const *restrict data, ALsizei InChans,
               ALsizei InPos, ALsizei BufferSize);
+void MultiFilter_C(ALfilterState *const *filters, ALfloat *const *dst,
+                   const ALfloat *const *src, ALsizei numfilters, ALsizei numsamples);
+void CalcVoiceBatchVectors_C(VoiceBatch *restrict batch, ALsizei start, ALsizei end,
+                             const ALfloat *restrict lvelocity);
 
 /* SSE mixers */
 void MixHrtf_SSE(ALfloat *restrict LeftOut, ALfloat *restrict RightOut,
@@ -50,16 +58,62 @@ void MixHrtfBlend_SSE(ALfloat *restrict LeftOut, ALfloat *restrict RightOut,
                       const ALsizei IrSize, const HrtfParams *oldparams,
                       MixHrtfParams *newparams, HrtfState *hrtfstate,
                       ALsizei BufferSize);
+void MixHrtfFFT_SSE(ALfloat *restrict LeftOut, ALfloat *restrict RightOut,
+                    const ALfloat *data, ALsizei OutPos, HrtfFilter *filter,
+                    ALfloat gain, ALfloat gainstep, HrtfFFTState *state,
+                    ALsizei BufferSize);
 void MixDirectHrtf_SSE(ALfloat *restrict LeftOut, ALfloat *restrict RightOut,
                        const ALfloat *data, ALsizei Offset, const ALsizei IrSize,
                        const ALfloat (*restrict Coeffs)[2], ALfloat (*restrict Values)[2],
                        ALsizei BufferSize);
-void Mix_SSE(const ALfloat *data, ALsizei OutChans, ALfloat (*restrict OutBuffer)[BUFFERSIZE],
+void Mix_SSE(const ALfloat *data, ALsizei OutChans, ALfloat *const *restrict OutBuffer,
              ALfloat *CurrentGains, const ALfloat *TargetGains, ALsizei Counter, ALsizei OutPos,
              ALsizei BufferSize);
 void MixRow_SSE(ALfloat *OutBuffer, const ALfloat *Gains,
-                const ALfloat (*restrict data)[BUFFERSIZE], ALsizei InChans,
+                ALfloat *const *restrict data, ALsizei InChans,
                 ALsizei InPos, ALsizei BufferSize);
+void MultiFilter_SSE(ALfilterState *const *filters, ALfloat *const *dst,
+                     const ALfloat *const *src, ALsizei numfilters, ALsizei numsamples);
+void CalcVoiceBatchVectors_SSE(VoiceBatch *restrict batch, ALsizei start, ALsizei end,
+                               const ALfloat *restrict lvelocity);
+
+/* SSE fused resample, filter, and mix for mono voices */
+void MixFused_point_SSE(const InterpState *state, const ALfloat *restrict src,
+                        ALsizei frac, ALint increment, ALfilterState *lowpass,
+                        ALfilterState *highpass, ALfloat *restrict resampled,
+                        ALsizei OutChans, ALfloat *const *restrict OutBuffer,
+                        ALfloat *CurrentGains, const ALfloat *TargetGains, ALsizei Counter,
+                        ALsizei OutPos, ALsizei BufferSize);
+void MixFused_point_lp_SSE(const InterpState *state, const ALfloat *restrict src,
+                           ALsizei frac, ALint increment, ALfilterState *lowpass,
+                           ALfilterState *highpass, ALfloat *restrict resampled,
+                           ALsizei OutChans, ALfloat *const *restrict OutBuffer,
+                           ALfloat *CurrentGains, const ALfloat *TargetGains, ALsizei Counter,
+                           ALsizei OutPos, ALsizei BufferSize);
+void MixFused_lerp_SSE(const InterpState *state, const ALfloat *restrict src,
+                       ALsizei frac, ALint increment, ALfilterState *lowpass,
+                       ALfilterState *highpass, ALfloat *restrict resampled,
+                       ALsizei OutChans, ALfloat *const *restrict OutBuffer,
+                       ALfloat *CurrentGains, const ALfloat *TargetGains, ALsizei Counter,
+                       ALsizei OutPos, ALsizei BufferSize);
+void MixFused_lerp_lp_SSE(const InterpState *state, const ALfloat *restrict src,
+                          ALsizei frac, ALint increment, ALfilterState *lowpass,
+                          ALfilterState *highpass, ALfloat *restrict resampled,
+                          ALsizei OutChans, ALfloat *const *restrict OutBuffer,
+                          ALfloat *CurrentGains, const ALfloat *TargetGains, ALsizei Counter,
+                          ALsizei OutPos, ALsizei BufferSize);
+void MixFused_bsinc_SSE(const InterpState *state, const ALfloat *restrict src,
+                        ALsizei frac, ALint increment, ALfilterState *lowpass,
+                        ALfilterState *highpass, ALfloat *restrict resampled,
+                        ALsizei OutChans, ALfloat *const *restrict OutBuffer,
+                        ALfloat *CurrentGains, const ALfloat *TargetGains, ALsizei Counter,
+                        ALsizei OutPos, ALsizei BufferSize);
+void MixFused_bsinc_lp_SSE(const InterpState *state, const ALfloat *restrict src,
+                           ALsizei frac, ALint increment, ALfilterState *lowpass,
+                           ALfilterState *highpass, ALfloat *restrict resampled,
+                           ALsizei OutChans, ALfloat *const *restrict OutBuffer,
+                           ALfloat *CurrentGains, const ALfloat *TargetGains, ALsizei Counter,
+                           ALsizei OutPos, ALsizei BufferSize);
 
 /* SSE resamplers */
 inline void InitiatePositionArrays(ALsizei frac, ALint increment, ALsizei *restrict frac_arr, ALint *restrict pos_arr, ALsizei size)
@@ -87,6 +141,39 @@ const ALfloat *Resample_bsinc_SSE(const InterpState *state, const ALfloat *restr
                                   ALsizei frac, ALint increment, ALfloat *restrict dst,
                                   ALsizei dstlen);
 
+/* AVX2 mixers */
+void MixHrtf_AVX2(ALfloat *restrict LeftOut, ALfloat *restrict RightOut,
+                  const ALfloat *data, ALsizei Offset, ALsizei OutPos,
+                  const ALsizei IrSize, struct MixHrtfParams *hrtfparams,
+                  struct HrtfState *hrtfstate, ALsizei BufferSize);
+void MixHrtfBlend_AVX2(ALfloat *restrict LeftOut, ALfloat *restrict RightOut,
+                       const ALfloat *data, ALsizei Offset, ALsizei OutPos,
+                       const ALsizei IrSize, const HrtfParams *oldparams,
+                       MixHrtfParams *newparams, HrtfState *hrtfstate,
+                       ALsizei BufferSize);
+void MixHrtfFFT_AVX2(ALfloat *restrict LeftOut, ALfloat *restrict RightOut,
+                     const ALfloat *data, ALsizei OutPos, HrtfFilter *filter,
+                     ALfloat gain, ALfloat gainstep, HrtfFFTState *state,
+                     ALsizei BufferSize);
+void MixDirectHrtf_AVX2(ALfloat *restrict LeftOut, ALfloat *restrict RightOut,
+                        const ALfloat *data, ALsizei Offset, const ALsizei IrSize,
+                        const ALfloat (*restrict Coeffs)[2], ALfloat (*restrict Values)[2],
+                        ALsizei BufferSize);
+void Mix_AVX2(const ALfloat *data, ALsizei OutChans, ALfloat *const *restrict OutBuffer,
+              ALfloat *CurrentGains, const ALfloat *TargetGains, ALsizei Counter, ALsizei OutPos,
+              ALsizei BufferSize);
+void MixRow_AVX2(ALfloat *OutBuffer, const ALfloat *Gains,
+                 ALfloat *const *restrict data, ALsizei InChans,
+                 ALsizei InPos, ALsizei BufferSize);
+
+/* AVX2 resamplers */
+const ALfloat *Resample_lerp_AVX2(const InterpState *state, const ALfloat *restrict src,
+                                  ALsizei frac, ALint increment, ALfloat *restrict dst,
+                                  ALsizei numsamples);
+const ALfloat *Resample_bsinc_AVX2(const InterpState *state, const ALfloat *restrict src,
+                                   ALsizei frac, ALint increment, ALfloat *restrict dst,
+                                   ALsizei dstlen);
+
 /* Neon mixers */
 void MixHrtf_Neon(ALfloat *restrict LeftOut, ALfloat *restrict RightOut,
                   const ALfloat *data, ALsizei Offset, ALsizei OutPos,
@@ -97,16 +184,22 @@ void MixHrtfBlend_Neon(ALfloat *restrict LeftOut, ALfloat *restrict RightOut,
                        const ALsizei IrSize, const HrtfParams *oldparams,
                        MixHrtfParams *newparams, HrtfState *hrtfstate,
                        ALsizei BufferSize);
+void MixHrtfFFT_Neon(ALfloat *restrict LeftOut, ALfloat *restrict RightOut,
+                     const ALfloat *data, ALsizei OutPos, HrtfFilter *filter,
+                     ALfloat gain, ALfloat gainstep, HrtfFFTState *state,
+                     ALsizei BufferSize);
 void MixDirectHrtf_Neon(ALfloat *restrict LeftOut, ALfloat *restrict RightOut,
                         const ALfloat *data, ALsizei Offset, const ALsizei IrSize,
                         const ALfloat (*restrict Coeffs)[2], ALfloat (*restrict Values)[2],
                         ALsizei BufferSize);
-void Mix_Neon(const ALfloat *data, ALsizei OutChans, ALfloat (*restrict OutBuffer)[BUFFERSIZE],
+void Mix_Neon(const ALfloat *data, ALsizei OutChans, ALfloat *const *restrict OutBuffer,
               ALfloat *CurrentGains, const ALfloat *TargetGains, ALsizei Counter, ALsizei OutPos,
               ALsizei BufferSize);
 void MixRow_Neon(ALfloat *OutBuffer, const ALfloat *Gains,
-                 const ALfloat (*restrict data)[BUFFERSIZE], ALsizei InChans,
+                 ALfloat *const *restrict data, ALsizei InChans,
                  ALsizei InPos, ALsizei BufferSize);
+void MultiFilter_Neon(ALfilterState *const *filters, ALfloat *const *dst,
+                      const ALfloat *const *src, ALsizei numfilters, ALsizei numsamples);
 
 /* Neon resamplers */
 const ALfloat *Resample_lerp_Neon(const InterpState *state, const ALfloat *restrict src,
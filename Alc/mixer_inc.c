@@ -13,6 +13,10 @@ static inline void ApplyCoeffs(ALsizei Offset, ALfloat (*restrict Values)[2],
                                const ALsizei irSize,
                                const ALfloat (*restrict Coeffs)[2],
                                ALfloat left, ALfloat right);
+static inline void ApplyFFTStages(ALfloat *restrict re, ALfloat *restrict im, ALsizei n);
+static inline void ApplySpectrum(HrtfSpectrum *restrict output,
+                                 const HrtfSpectrum *restrict input,
+                                 const HrtfSpectrum *restrict coeffs);
 
 
 void MixHrtf(ALfloat *restrict LeftOut, ALfloat *restrict RightOut,
@@ -54,8 +58,9 @@ void MixHrtfBlend(ALfloat *restrict LeftOut, ALfloat *restrict RightOut,
                   MixHrtfParams *newparams, HrtfState *hrtfstate,
                   ALsizei BufferSize)
 {
-    const ALfloat (*OldCoeffs)[2] = ASSUME_ALIGNED(oldparams->Coeffs, 16);
-    const ALsizei OldDelay[2] = { oldparams->Delay[0], oldparams->Delay[1] };
+    const HrtfFilter *OldFilter = oldparams->Filter;
+    const ALfloat (*OldCoeffs)[2] = ASSUME_ALIGNED(OldFilter->Coeffs, 16);
+    const ALsizei OldDelay[2] = { OldFilter->Delay[0], OldFilter->Delay[1] };
     ALfloat oldGain = oldparams->Gain;
     ALfloat oldGainStep = -oldGain / (ALfloat)BufferSize;
     const ALfloat (*NewCoeffs)[2] = ASSUME_ALIGNED(newparams->Coeffs, 16);
@@ -112,3 +117,116 @@ void MixDirectHrtf(ALfloat *restrict LeftOut, ALfloat *restrict RightOut,
         *(RightOut++) += Values[Offset&HRIR_MASK][1];
     }
 }
+
+
+/* Sets a slot's filter, moving the reference from the old one. */
+static inline void SetSlotFilter(HrtfFilter **slot, HrtfFilter *filter)
+{
+    if(*slot != filter)
+    {
+        HrtfFilter_IncRef(filter);
+        HrtfFilter_DecRef(*slot);
+        *slot = filter;
+    }
+}
+
+/* Calculates the spectrum of the zero-padded input block, weighted by a
+ * linear ramp.
+ */
+static inline void CalcBlockSpectrum(const ALfloat *restrict input, ALfloat weight,
+                                     ALfloat step, HrtfSpectrum *restrict spectrum)
+{
+    alignas(16) ALfloat re[HRTF_FFT_BLOCK];
+    alignas(16) ALfloat im[HRTF_FFT_BLOCK];
+
+    HrtfFFTLoadReal(input, weight, step, re, im);
+    ApplyFFTStages(re, im, HRTF_FFT_BLOCK);
+    HrtfFFTUnpackReal(re, im, spectrum);
+}
+
+static void ProcessHrtfFFTBlock(HrtfFFTState *state, HrtfFilter *filter)
+{
+    HrtfSpectrum output;
+    ALsizei p, f, i;
+
+    state->Cur = (state->Cur+1) % HRTF_FFT_PARTS;
+    if(!state->LastFilter || state->LastFilter == filter)
+    {
+        CalcBlockSpectrum(state->Input, 1.0f, 0.0f, &state->Slots[state->Cur].Input[0]);
+        SetSlotFilter(&state->Slots[state->Cur].Filter[0], filter);
+        SetSlotFilter(&state->Slots[state->Cur].Filter[1], NULL);
+    }
+    else
+    {
+        /* Fade the input from the last filter to the new one. */
+        CalcBlockSpectrum(state->Input, 1.0f, -1.0f/HRTF_FFT_BLOCK,
+                          &state->Slots[state->Cur].Input[0]);
+        SetSlotFilter(&state->Slots[state->Cur].Filter[0], state->LastFilter);
+        CalcBlockSpectrum(state->Input, 0.0f, 1.0f/HRTF_FFT_BLOCK,
+                          &state->Slots[state->Cur].Input[1]);
+        SetSlotFilter(&state->Slots[state->Cur].Filter[1], filter);
+    }
+    state->LastFilter = filter;
+
+    /* Accumulate the input spectra with the filter partitions for their age. */
+    memset(&output, 0, sizeof(output));
+    for(p = 0;p < HRTF_FFT_PARTS;p++)
+    {
+        const ALsizei s = (state->Cur+HRTF_FFT_PARTS-p) % HRTF_FFT_PARTS;
+        for(f = 0;f < 2;f++)
+        {
+            const HrtfFilter *slotfilter = state->Slots[s].Filter[f];
+            if(slotfilter && p < slotfilter->NumParts)
+                ApplySpectrum(&output, &state->Slots[s].Input[f], &slotfilter->Spectrum[p]);
+        }
+    }
+
+    /* Swapping the real and imaginary parts does the inverse transform, with
+     * the left and right outputs coming back as the real and imaginary parts
+     * (the filter spectra are prescaled). The first half completes the next
+     * output block, and the second half overlaps the one after.
+     */
+    ApplyFFTStages(output.Imag, output.Real, HRTF_FFT_SIZE);
+    for(i = 0;i < HRTF_FFT_BLOCK;i++)
+    {
+        state->Output[0][i] = output.Real[i] + state->Overlap[0][i];
+        state->Output[1][i] = output.Imag[i] + state->Overlap[1][i];
+    }
+    memcpy(state->Overlap[0], &output.Real[HRTF_FFT_BLOCK], sizeof(state->Overlap[0]));
+    memcpy(state->Overlap[1], &output.Imag[HRTF_FFT_BLOCK], sizeof(state->Overlap[1]));
+}
+
+void MixHrtfFFT(ALfloat *restrict LeftOut, ALfloat *restrict RightOut,
+                const ALfloat *data, ALsizei OutPos, HrtfFilter *filter,
+                ALfloat gain, ALfloat gainstep, HrtfFFTState *state,
+                ALsizei BufferSize)
+{
+    ALsizei pos = 0;
+    ALsizei i;
+
+    LeftOut  += OutPos;
+    RightOut += OutPos;
+    while(pos < BufferSize)
+    {
+        ALsizei todo = mini(HRTF_FFT_BLOCK-state->Pos, BufferSize-pos);
+        ALfloat *restrict input = state->Input + state->Pos;
+        const ALfloat *restrict left = state->Output[0] + state->Pos;
+        const ALfloat *restrict right = state->Output[1] + state->Pos;
+
+        for(i = 0;i < todo;i++)
+        {
+            input[i] = data[pos+i] * gain;
+            gain += gainstep;
+            LeftOut[pos+i]  += left[i];
+            RightOut[pos+i] += right[i];
+        }
+        pos += todo;
+
+        state->Pos += todo;
+        if(state->Pos == HRTF_FFT_BLOCK)
+        {
+            ProcessHrtfFFTBlock(state, filter);
+            state->Pos = 0;
+        }
+    }
+}
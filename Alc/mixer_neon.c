@@ -150,14 +150,67 @@ static inline void ApplyCoeffs(ALsizei Offset, ALfloat (*restrict Values)[2],
     }
 }
 
+static inline void ApplyFFTStages(ALfloat *restrict re, ALfloat *restrict im, ALsizei n)
+{
+    ALsizei h, k, j;
+
+    HrtfFFTRadix4(re, im, n);
+    for(h = 4;h < n;h <<= 1)
+    {
+        const ALfloat *restrict twr = &HrtfFFTTwiddles[0][h];
+        const ALfloat *restrict twi = &HrtfFFTTwiddles[1][h];
+        for(k = 0;k < n;k += h*2)
+        {
+            ALfloat *restrict ar = &re[k], *restrict ai = &im[k];
+            ALfloat *restrict br = &re[k+h], *restrict bi = &im[k+h];
+            for(j = 0;j < h;j += 4)
+            {
+                const float32x4_t wr = vld1q_f32(&twr[j]);
+                const float32x4_t wi = vld1q_f32(&twi[j]);
+                const float32x4_t xr = vld1q_f32(&br[j]);
+                const float32x4_t xi = vld1q_f32(&bi[j]);
+                const float32x4_t yr = vld1q_f32(&ar[j]);
+                const float32x4_t yi = vld1q_f32(&ai[j]);
+                const float32x4_t tr = vmlsq_f32(vmulq_f32(xr, wr), xi, wi);
+                const float32x4_t ti = vmlaq_f32(vmulq_f32(xr, wi), xi, wr);
+                vst1q_f32(&br[j], vsubq_f32(yr, tr));
+                vst1q_f32(&bi[j], vsubq_f32(yi, ti));
+                vst1q_f32(&ar[j], vaddq_f32(yr, tr));
+                vst1q_f32(&ai[j], vaddq_f32(yi, ti));
+            }
+        }
+    }
+}
+
+static inline void ApplySpectrum(HrtfSpectrum *restrict output,
+                                 const HrtfSpectrum *restrict input,
+                                 const HrtfSpectrum *restrict coeffs)
+{
+    ALsizei i;
+    for(i = 0;i < HRTF_FFT_SIZE;i += 4)
+    {
+        const float32x4_t xr = vld1q_f32(&input->Real[i]);
+        const float32x4_t xi = vld1q_f32(&input->Imag[i]);
+        const float32x4_t cr = vld1q_f32(&coeffs->Real[i]);
+        const float32x4_t ci = vld1q_f32(&coeffs->Imag[i]);
+        float32x4_t yr = vld1q_f32(&output->Real[i]);
+        float32x4_t yi = vld1q_f32(&output->Imag[i]);
+        yr = vmlsq_f32(vmlaq_f32(yr, xr, cr), xi, ci);
+        yi = vmlaq_f32(vmlaq_f32(yi, xr, ci), xi, cr);
+        vst1q_f32(&output->Real[i], yr);
+        vst1q_f32(&output->Imag[i], yi);
+    }
+}
+
 #define MixHrtf MixHrtf_Neon
 #define MixHrtfBlend MixHrtfBlend_Neon
+#define MixHrtfFFT MixHrtfFFT_Neon
 #define MixDirectHrtf MixDirectHrtf_Neon
 #include "mixer_inc.c"
 #undef MixHrtf
 
 
-void Mix_Neon(const ALfloat *data, ALsizei OutChans, ALfloat (*restrict OutBuffer)[BUFFERSIZE],
+void Mix_Neon(const ALfloat *data, ALsizei OutChans, ALfloat *const *restrict OutBuffer,
               ALfloat *CurrentGains, const ALfloat *TargetGains, ALsizei Counter, ALsizei OutPos,
               ALsizei BufferSize)
 {
@@ -232,7 +285,7 @@ void Mix_Neon(const ALfloat *data, ALsizei OutChans, ALfloat (*restrict OutBuffe
     }
 }
 
-void MixRow_Neon(ALfloat *OutBuffer, const ALfloat *Gains, const ALfloat (*restrict data)[BUFFERSIZE], ALsizei InChans, ALsizei InPos, ALsizei BufferSize)
+void MixRow_Neon(ALfloat *OutBuffer, const ALfloat *Gains, ALfloat *const *restrict data, ALsizei InChans, ALsizei InPos, ALsizei BufferSize)
 {
     float32x4_t gain4;
     ALsizei c;
@@ -259,3 +312,105 @@ void MixRow_Neon(ALfloat *OutBuffer, const ALfloat *Gains, const ALfloat (*restr
             OutBuffer[pos] += data[c][InPos+pos]*gain;
     }
 }
+
+void MultiFilter_Neon(ALfilterState *const *filters, ALfloat *const *dst,
+                      const ALfloat *const *src, ALsizei numfilters, ALsizei numsamples)
+{
+    ALsizei base, i, j;
+
+    /* Run groups of up to four filters in parallel, one per lane. A lone
+     * filter gains nothing from this, so it's left to the C version.
+     */
+    for(base = 0;numfilters-base > 1;base += 4)
+    {
+        const ALsizei count = mini(numfilters-base, 4);
+        alignas(16) ALfloat vals[9][4];
+        float32x4_t b0, b1, b2, a1, a2, x0, x1, y0, y1;
+
+        memset(vals, 0, sizeof(vals));
+        for(j = 0;j < count;j++)
+        {
+            const ALfilterState *filter = filters[base+j];
+            vals[0][j] = filter->b0;
+            vals[1][j] = filter->b1;
+            vals[2][j] = filter->b2;
+            vals[3][j] = filter->a1;
+            vals[4][j] = filter->a2;
+            vals[5][j] = filter->x[0];
+            vals[6][j] = filter->x[1];
+            vals[7][j] = filter->y[0];
+            vals[8][j] = filter->y[1];
+        }
+        b0 = vld1q_f32(vals[0]); b1 = vld1q_f32(vals[1]); b2 = vld1q_f32(vals[2]);
+        a1 = vld1q_f32(vals[3]); a2 = vld1q_f32(vals[4]);
+        x0 = vld1q_f32(vals[5]); x1 = vld1q_f32(vals[6]);
+        y0 = vld1q_f32(vals[7]); y1 = vld1q_f32(vals[8]);
+
+        /* Same operation order as the C version, so the results match. */
+#define BIQUAD_STEP(s) do {                                                   \
+    float32x4_t out = vaddq_f32(vmulq_f32(b0, (s)), vmulq_f32(b1, x0));       \
+    out = vaddq_f32(out, vmulq_f32(b2, x1));                                  \
+    out = vsubq_f32(out, vmulq_f32(a1, y0));                                  \
+    out = vsubq_f32(out, vmulq_f32(a2, y1));                                  \
+    x1 = x0; x0 = (s);                                                        \
+    y1 = y0; y0 = out;                                                        \
+    (s) = out;                                                                \
+} while(0)
+#define TRANSPOSE4(r0, r1, r2, r3) do {                                       \
+    const float32x4x2_t t0 = vtrnq_f32((r0), (r1));                           \
+    const float32x4x2_t t1 = vtrnq_f32((r2), (r3));                           \
+    (r0) = vcombine_f32(vget_low_f32(t0.val[0]), vget_low_f32(t1.val[0]));    \
+    (r1) = vcombine_f32(vget_low_f32(t0.val[1]), vget_low_f32(t1.val[1]));    \
+    (r2) = vcombine_f32(vget_high_f32(t0.val[0]), vget_high_f32(t1.val[0]));  \
+    (r3) = vcombine_f32(vget_high_f32(t0.val[1]), vget_high_f32(t1.val[1]));  \
+} while(0)
+        for(i = 0;numsamples-i > 3;i += 4)
+        {
+            float32x4_t s[4];
+
+            /* Transpose four samples of each filter's input, so each vector
+             * holds one sample for every filter.
+             */
+            for(j = 0;j < 4;j++)
+                s[j] = (j < count) ? vld1q_f32(&src[base+j][i]) : vdupq_n_f32(0.0f);
+            TRANSPOSE4(s[0], s[1], s[2], s[3]);
+
+            BIQUAD_STEP(s[0]);
+            BIQUAD_STEP(s[1]);
+            BIQUAD_STEP(s[2]);
+            BIQUAD_STEP(s[3]);
+
+            TRANSPOSE4(s[0], s[1], s[2], s[3]);
+            for(j = 0;j < count;j++)
+                vst1q_f32(&dst[base+j][i], s[j]);
+        }
+        for(;i < numsamples;i++)
+        {
+            alignas(16) ALfloat in[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+            float32x4_t s;
+
+            for(j = 0;j < count;j++)
+                in[j] = src[base+j][i];
+            s = vld1q_f32(in);
+            BIQUAD_STEP(s);
+            vst1q_f32(in, s);
+            for(j = 0;j < count;j++)
+                dst[base+j][i] = in[j];
+        }
+#undef TRANSPOSE4
+#undef BIQUAD_STEP
+
+        vst1q_f32(vals[5], x0); vst1q_f32(vals[6], x1);
+        vst1q_f32(vals[7], y0); vst1q_f32(vals[8], y1);
+        for(j = 0;j < count;j++)
+        {
+            ALfilterState *filter = filters[base+j];
+            filter->x[0] = vals[5][j];
+            filter->x[1] = vals[6][j];
+            filter->y[0] = vals[7][j];
+            filter->y[1] = vals[8][j];
+        }
+    }
+    if(base < numfilters)
+        MultiFilter_C(filters+base, dst+base, src+base, numfilters-base, numsamples);
+}
@@ -12,53 +12,64 @@
 #include "mixer_defs.h"
 
 
-const ALfloat *Resample_bsinc_SSE(const InterpState *state, const ALfloat *restrict src,
-                                  ALsizei frac, ALint increment, ALfloat *restrict dst,
-                                  ALsizei dstlen)
+/* Applies the bsinc filter for the given position. src is the sample at the
+ * filter's start (offset by state->bsinc.l).
+ */
+static inline ALfloat do_bsinc(const InterpState *state, const ALfloat *restrict src,
+                               ALsizei frac)
 {
     const ALfloat *const filter = state->bsinc.filter;
     const __m128 sf4 = _mm_set1_ps(state->bsinc.sf);
     const ALsizei m = state->bsinc.m;
     const __m128 *fil, *scd, *phd, *spd;
-    ALsizei pi, i, j, offset;
+    ALsizei pi, j, offset;
     ALfloat pf;
     __m128 r4;
 
-    src += state->bsinc.l;
-    for(i = 0;i < dstlen;i++)
-    {
-        // Calculate the phase index and factor.
+    // Calculate the phase index and factor.
 #define FRAC_PHASE_BITDIFF (FRACTIONBITS-BSINC_PHASE_BITS)
-        pi = frac >> FRAC_PHASE_BITDIFF;
-        pf = (frac & ((1<<FRAC_PHASE_BITDIFF)-1)) * (1.0f/(1<<FRAC_PHASE_BITDIFF));
+    pi = frac >> FRAC_PHASE_BITDIFF;
+    pf = (frac & ((1<<FRAC_PHASE_BITDIFF)-1)) * (1.0f/(1<<FRAC_PHASE_BITDIFF));
 #undef FRAC_PHASE_BITDIFF
 
-        offset = m*pi*4;
-        fil = (const __m128*)ASSUME_ALIGNED(filter + offset, 16); offset += m;
-        scd = (const __m128*)ASSUME_ALIGNED(filter + offset, 16); offset += m;
-        phd = (const __m128*)ASSUME_ALIGNED(filter + offset, 16); offset += m;
-        spd = (const __m128*)ASSUME_ALIGNED(filter + offset, 16);
+    offset = m*pi*4;
+    fil = (const __m128*)ASSUME_ALIGNED(filter + offset, 16); offset += m;
+    scd = (const __m128*)ASSUME_ALIGNED(filter + offset, 16); offset += m;
+    phd = (const __m128*)ASSUME_ALIGNED(filter + offset, 16); offset += m;
+    spd = (const __m128*)ASSUME_ALIGNED(filter + offset, 16);
 
-        // Apply the scale and phase interpolated filter.
-        r4 = _mm_setzero_ps();
-        {
-            const __m128 pf4 = _mm_set1_ps(pf);
+    // Apply the scale and phase interpolated filter.
+    r4 = _mm_setzero_ps();
+    {
+        const __m128 pf4 = _mm_set1_ps(pf);
 #define MLA4(x, y, z) _mm_add_ps(x, _mm_mul_ps(y, z))
-            for(j = 0;j < m;j+=4,fil++,scd++,phd++,spd++)
-            {
-                /* f = ((fil + sf*scd) + pf*(phd + sf*spd)) */
-                const __m128 f4 = MLA4(
-                    MLA4(*fil, sf4, *scd),
-                    pf4, MLA4(*phd, sf4, *spd)
-                );
-                /* r += f*src */
-                r4 = MLA4(r4, f4, _mm_loadu_ps(&src[j]));
-            }
-#undef MLA4
+        for(j = 0;j < m;j+=4,fil++,scd++,phd++,spd++)
+        {
+            /* f = ((fil + sf*scd) + pf*(phd + sf*spd)) */
+            const __m128 f4 = MLA4(
+                MLA4(*fil, sf4, *scd),
+                pf4, MLA4(*phd, sf4, *spd)
+            );
+            /* r += f*src */
+            r4 = MLA4(r4, f4, _mm_loadu_ps(&src[j]));
         }
-        r4 = _mm_add_ps(r4, _mm_shuffle_ps(r4, r4, _MM_SHUFFLE(0, 1, 2, 3)));
-        r4 = _mm_add_ps(r4, _mm_movehl_ps(r4, r4));
-        dst[i] = _mm_cvtss_f32(r4);
+#undef MLA4
+    }
+    r4 = _mm_add_ps(r4, _mm_shuffle_ps(r4, r4, _MM_SHUFFLE(0, 1, 2, 3)));
+    r4 = _mm_add_ps(r4, _mm_movehl_ps(r4, r4));
+    return _mm_cvtss_f32(r4);
+}
+
+const ALfloat *Resample_bsinc_SSE(const InterpState *state, const ALfloat *restrict src,
+                                  ALsizei frac, ALint increment, ALfloat *restrict dst,
+                                  ALsizei dstlen)
+{
+    ALsizei i;
+
+    src += state->bsinc.l;
+    for(i = 0;i < dstlen;i++)
+    {
+        dst[i] = do_bsinc(state, src, frac);
 
         frac += increment;
         src  += frac>>FRACTIONBITS;
@@ -122,14 +133,67 @@ static inline void ApplyCoeffs(ALsizei Offset, ALfloat (*restrict Values)[2],
     }
 }
 
+static inline void ApplyFFTStages(ALfloat *restrict re, ALfloat *restrict im, ALsizei n)
+{
+    ALsizei h, k, j;
+
+    HrtfFFTRadix4(re, im, n);
+    for(h = 4;h < n;h <<= 1)
+    {
+        const ALfloat *restrict twr = &HrtfFFTTwiddles[0][h];
+        const ALfloat *restrict twi = &HrtfFFTTwiddles[1][h];
+        for(k = 0;k < n;k += h*2)
+        {
+            ALfloat *restrict ar = &re[k], *restrict ai = &im[k];
+            ALfloat *restrict br = &re[k+h], *restrict bi = &im[k+h];
+            for(j = 0;j < h;j += 4)
+            {
+                const __m128 wr = _mm_load_ps(&twr[j]);
+                const __m128 wi = _mm_load_ps(&twi[j]);
+                const __m128 xr = _mm_load_ps(&br[j]);
+                const __m128 xi = _mm_load_ps(&bi[j]);
+                const __m128 yr = _mm_load_ps(&ar[j]);
+                const __m128 yi = _mm_load_ps(&ai[j]);
+                const __m128 tr = _mm_sub_ps(_mm_mul_ps(xr, wr), _mm_mul_ps(xi, wi));
+                const __m128 ti = _mm_add_ps(_mm_mul_ps(xr, wi), _mm_mul_ps(xi, wr));
+                _mm_store_ps(&br[j], _mm_sub_ps(yr, tr));
+                _mm_store_ps(&bi[j], _mm_sub_ps(yi, ti));
+                _mm_store_ps(&ar[j], _mm_add_ps(yr, tr));
+                _mm_store_ps(&ai[j], _mm_add_ps(yi, ti));
+            }
+        }
+    }
+}
+
+static inline void ApplySpectrum(HrtfSpectrum *restrict output,
+                                 const HrtfSpectrum *restrict input,
+                                 const HrtfSpectrum *restrict coeffs)
+{
+    ALsizei i;
+    for(i = 0;i < HRTF_FFT_SIZE;i += 4)
+    {
+        const __m128 xr = _mm_load_ps(&input->Real[i]);
+        const __m128 xi = _mm_load_ps(&input->Imag[i]);
+        const __m128 cr = _mm_load_ps(&coeffs->Real[i]);
+        const __m128 ci = _mm_load_ps(&coeffs->Imag[i]);
+        __m128 yr = _mm_load_ps(&output->Real[i]);
+        __m128 yi = _mm_load_ps(&output->Imag[i]);
+        yr = _mm_add_ps(yr, _mm_sub_ps(_mm_mul_ps(xr, cr), _mm_mul_ps(xi, ci)));
+        yi = _mm_add_ps(yi, _mm_add_ps(_mm_mul_ps(xr, ci), _mm_mul_ps(xi, cr)));
+        _mm_store_ps(&output->Real[i], yr);
+        _mm_store_ps(&output->Imag[i], yi);
+    }
+}
+
 #define MixHrtf MixHrtf_SSE
 #define MixHrtfBlend MixHrtfBlend_SSE
+#define MixHrtfFFT MixHrtfFFT_SSE
 #define MixDirectHrtf MixDirectHrtf_SSE
 #include "mixer_inc.c"
 #undef MixHrtf
 
 
-void Mix_SSE(const ALfloat *data, ALsizei OutChans, ALfloat (*restrict OutBuffer)[BUFFERSIZE],
+void Mix_SSE(const ALfloat *data, ALsizei OutChans, ALfloat *const *restrict OutBuffer,
              ALfloat *CurrentGains, const ALfloat *TargetGains, ALsizei Counter, ALsizei OutPos,
              ALsizei BufferSize)
 {
@@ -203,7 +267,7 @@ void Mix_SSE(const ALfloat *data, ALsizei OutChans, ALfloat (*restrict OutBuffer
     }
 }
 
-void MixRow_SSE(ALfloat *OutBuffer, const ALfloat *Gains, const ALfloat (*restrict data)[BUFFERSIZE], ALsizei InChans, ALsizei InPos, ALsizei BufferSize)
+void MixRow_SSE(ALfloat *OutBuffer, const ALfloat *Gains, ALfloat *const *restrict data, ALsizei InChans, ALsizei InPos, ALsizei BufferSize)
 {
     __m128 gain4;
     ALsizei c;
@@ -227,3 +291,353 @@ void MixRow_SSE(ALfloat *OutBuffer, const ALfloat *Gains, const ALfloat (*restri
             OutBuffer[pos] += data[c][InPos+pos]*gain;
     }
 }
+
+void MultiFilter_SSE(ALfilterState *const *filters, ALfloat *const *dst,
+                     const ALfloat *const *src, ALsizei numfilters, ALsizei numsamples)
+{
+    ALsizei base, i, j;
+
+    /* Run groups of up to four filters in parallel, one per lane. A lone
+     * filter gains nothing from this, so it's left to the C version.
+     */
+    for(base = 0;numfilters-base > 1;base += 4)
+    {
+        const ALsizei count = mini(numfilters-base, 4);
+        union { alignas(16) ALfloat f[9][4]; __m128 v[9]; } vals;
+        __m128 b0, b1, b2, a1, a2, x0, x1, y0, y1;
+
+        memset(&vals, 0, sizeof(vals));
+        for(j = 0;j < count;j++)
+        {
+            const ALfilterState *filter = filters[base+j];
+            vals.f[0][j] = filter->b0;
+            vals.f[1][j] = filter->b1;
+            vals.f[2][j] = filter->b2;
+            vals.f[3][j] = filter->a1;
+            vals.f[4][j] = filter->a2;
+            vals.f[5][j] = filter->x[0];
+            vals.f[6][j] = filter->x[1];
+            vals.f[7][j] = filter->y[0];
+            vals.f[8][j] = filter->y[1];
+        }
+        b0 = vals.v[0]; b1 = vals.v[1]; b2 = vals.v[2];
+        a1 = vals.v[3]; a2 = vals.v[4];
+        x0 = vals.v[5]; x1 = vals.v[6];
+        y0 = vals.v[7]; y1 = vals.v[8];
+
+        /* Same operation order as the C version, so the results match. */
+#define BIQUAD_STEP(s) do {                                                   \
+    __m128 out = _mm_add_ps(_mm_mul_ps(b0, (s)), _mm_mul_ps(b1, x0));         \
+    out = _mm_add_ps(out, _mm_mul_ps(b2, x1));                                \
+    out = _mm_sub_ps(out, _mm_mul_ps(a1, y0));                                \
+    out = _mm_sub_ps(out, _mm_mul_ps(a2, y1));                                \
+    x1 = x0; x0 = (s);                                                        \
+    y1 = y0; y0 = out;                                                        \
+    (s) = out;                                                                \
+} while(0)
+        for(i = 0;numsamples-i > 3;i += 4)
+        {
+            __m128 s[4];
+
+            /* Transpose four samples of each filter's input, so each vector
+             * holds one sample for every filter.
+             */
+            for(j = 0;j < 4;j++)
+                s[j] = (j < count) ? _mm_loadu_ps(&src[base+j][i]) : _mm_setzero_ps();
+            _MM_TRANSPOSE4_PS(s[0], s[1], s[2], s[3]);
+
+            BIQUAD_STEP(s[0]);
+            BIQUAD_STEP(s[1]);
+            BIQUAD_STEP(s[2]);
+            BIQUAD_STEP(s[3]);
+
+            _MM_TRANSPOSE4_PS(s[0], s[1], s[2], s[3]);
+            for(j = 0;j < count;j++)
+                _mm_storeu_ps(&dst[base+j][i], s[j]);
+        }
+        for(;i < numsamples;i++)
+        {
+            union { alignas(16) ALfloat f[4]; __m128 v; } s = { { 0.0f, 0.0f, 0.0f, 0.0f } };
+
+            for(j = 0;j < count;j++)
+                s.f[j] = src[base+j][i];
+            BIQUAD_STEP(s.v);
+            for(j = 0;j < count;j++)
+                dst[base+j][i] = s.f[j];
+        }
+#undef BIQUAD_STEP
+
+        vals.v[5] = x0; vals.v[6] = x1;
+        vals.v[7] = y0; vals.v[8] = y1;
+        for(j = 0;j < count;j++)
+        {
+            ALfilterState *filter = filters[base+j];
+            filter->x[0] = vals.f[5][j];
+            filter->x[1] = vals.f[6][j];
+            filter->y[0] = vals.f[7][j];
+            filter->y[1] = vals.f[8][j];
+        }
+    }
+    if(base < numfilters)
+        MultiFilter_C(filters+base, dst+base, src+base, numfilters-base, numsamples);
+}
+
+
+static inline ALfloat do_point(const InterpState* UNUSED(state), const ALfloat *restrict src,
+                               ALsizei UNUSED(frac))
+{ return src[0]; }
+static inline ALfloat do_lerp(const InterpState* UNUSED(state), const ALfloat *restrict src,
+                              ALsizei frac)
+{ return lerp(src[0], src[1], frac * (1.0f/FRACTIONONE)); }
+
+/* Normalizes a 3-component vector for four voices at once, leaving zero-
+ * length vectors as is, and returns the lengths.
+ */
+static inline __m128 Normalize3_SSE(__m128 *x, __m128 *y, __m128 *z)
+{
+    const __m128 one4 = _mm_set1_ps(1.0f);
+    __m128 len4, scale4, mask4;
+
+    len4 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(*x, *x), _mm_mul_ps(*y, *y)),
+                      _mm_mul_ps(*z, *z));
+    len4 = _mm_sqrt_ps(len4);
+    mask4 = _mm_cmpgt_ps(len4, _mm_setzero_ps());
+    scale4 = _mm_div_ps(one4, _mm_or_ps(_mm_and_ps(mask4, len4), _mm_andnot_ps(mask4, one4)));
+    *x = _mm_mul_ps(*x, scale4);
+    *y = _mm_mul_ps(*y, scale4);
+    *z = _mm_mul_ps(*z, scale4);
+    return len4;
+}
+
+static inline __m128 Dot3_SSE(__m128 ax, __m128 ay, __m128 az, __m128 bx, __m128 by, __m128 bz)
+{
+    return _mm_add_ps(_mm_add_ps(_mm_mul_ps(ax, bx), _mm_mul_ps(ay, by)),
+                      _mm_mul_ps(az, bz));
+}
+
+void CalcVoiceBatchVectors_SSE(VoiceBatch *restrict batch, ALsizei start, ALsizei end,
+                               const ALfloat *restrict lvelocity)
+{
+    const __m128 lvx4 = _mm_set1_ps(lvelocity[0]);
+    const __m128 lvy4 = _mm_set1_ps(lvelocity[1]);
+    const __m128 lvz4 = _mm_set1_ps(lvelocity[2]);
+    const __m128 sign4 = _mm_set1_ps(-0.0f);
+    ALsizei i;
+
+    for(i = start;end-i > 3;i += 4)
+    {
+        __m128 dx4 = _mm_loadu_ps(&batch->DirX[i]);
+        __m128 dy4 = _mm_loadu_ps(&batch->DirY[i]);
+        __m128 dz4 = _mm_loadu_ps(&batch->DirZ[i]);
+        __m128 tx4 = _mm_xor_ps(_mm_loadu_ps(&batch->PosX[i]), sign4);
+        __m128 ty4 = _mm_xor_ps(_mm_loadu_ps(&batch->PosY[i]), sign4);
+        __m128 tz4 = _mm_xor_ps(_mm_loadu_ps(&batch->PosZ[i]), sign4);
+
+        _mm_storeu_ps(&batch->DirLength[i], Normalize3_SSE(&dx4, &dy4, &dz4));
+        _mm_storeu_ps(&batch->Distance[i], Normalize3_SSE(&tx4, &ty4, &tz4));
+        _mm_storeu_ps(&batch->ToListenerX[i], tx4);
+        _mm_storeu_ps(&batch->ToListenerY[i], ty4);
+        _mm_storeu_ps(&batch->ToListenerZ[i], tz4);
+
+        _mm_storeu_ps(&batch->ConeCos[i], Dot3_SSE(dx4, dy4, dz4, tx4, ty4, tz4));
+        _mm_storeu_ps(&batch->SourceVel[i], Dot3_SSE(_mm_loadu_ps(&batch->VelX[i]),
+            _mm_loadu_ps(&batch->VelY[i]), _mm_loadu_ps(&batch->VelZ[i]), tx4, ty4, tz4));
+        _mm_storeu_ps(&batch->ListenerVel[i], Dot3_SSE(lvx4, lvy4, lvz4, tx4, ty4, tz4));
+    }
+    CalcVoiceBatchVectors_C(batch, i, end, lvelocity);
+}
+
+/* Gain ramp state for mixing to one output channel with fused mixing. */
+typedef struct FusedGains {
+    __m128 gain4, step4;
+    ALfloat gain, step;
+    /* End of the vectorized gain ramp, and the end of the whole ramp. RampEnd
+     * is -1 when not ramping.
+     */
+    ALsizei VecEnd, RampEnd;
+} FusedGains;
+
+static void InitFusedGains(FusedGains *restrict gains, const ALfloat *CurrentGains,
+                           const ALfloat *TargetGains, ALsizei OutChans, ALsizei Counter,
+                           ALsizei BufferSize)
+{
+    const ALfloat delta = (Counter > 0) ? 1.0f/(ALfloat)Counter : 0.0f;
+    ALsizei c;
+
+    for(c = 0;c < OutChans;c++)
+    {
+        const ALfloat gain = CurrentGains[c];
+        const ALfloat step = (TargetGains[c] - gain) * delta;
+
+        gains[c].gain = gain;
+        gains[c].step = step;
+        gains[c].VecEnd = 0;
+        gains[c].RampEnd = -1;
+        if(fabsf(step) > FLT_EPSILON)
+        {
+            gains[c].RampEnd = mini(BufferSize, Counter);
+            if(gains[c].RampEnd > 3)
+                gains[c].VecEnd = gains[c].RampEnd & ~3;
+            gains[c].gain4 = _mm_setr_ps(
+                gain,
+                gain + step,
+                gain + step + step,
+                gain + step + step + step
+            );
+            gains[c].step4 = _mm_set1_ps(step + step + step + step);
+        }
+    }
+}
+
+/* Mixes a group of up to four samples, at a multiple of 4 from the start, to
+ * each output channel. This applies the same gains as Mix_SSE.
+ */
+static void MixFusedGroup(FusedGains *restrict gains, const __m128 smp4, ALsizei pos,
+                          ALsizei todo, ALsizei OutChans,
+                          ALfloat *const *restrict OutBuffer, ALfloat *CurrentGains,
+                          const ALfloat *TargetGains, ALsizei Counter, ALsizei OutPos)
+{
+    union { alignas(16) ALfloat f[4]; __m128 v; } smp;
+    ALsizei c, i;
+
+    smp.v = smp4;
+    for(c = 0;c < OutChans;c++)
+    {
+        ALfloat *restrict dst = &OutBuffer[c][OutPos+pos];
+
+        if(pos < gains[c].VecEnd)
+        {
+            __m128 dry4 = _mm_loadu_ps(dst);
+            dry4 = _mm_add_ps(dry4, _mm_mul_ps(smp.v, gains[c].gain4));
+            gains[c].gain4 = _mm_add_ps(gains[c].gain4, gains[c].step4);
+            _mm_storeu_ps(dst, dry4);
+            if(pos+4 < gains[c].RampEnd)
+                continue;
+
+            /* The ramp ended with this group. The lowest element of gain4 is
+             * the next gain to apply.
+             */
+            gains[c].gain = _mm_cvtss_f32(gains[c].gain4);
+            if(gains[c].RampEnd == Counter)
+                gains[c].gain = TargetGains[c];
+            CurrentGains[c] = gains[c].gain;
+            gains[c].RampEnd = -1;
+            continue;
+        }
+        if(gains[c].RampEnd >= 0)
+        {
+            const ALsizei rampend = gains[c].RampEnd;
+            ALfloat gain = gains[c].gain;
+
+            /* The ramp ends within this group. Finish it with scalar steps
+             * from the vector ramp's next gain, then use the target gain if
+             * the whole fade is done. The rest of the group gets the new gain
+             * even if it's silent.
+             */
+            if(gains[c].VecEnd > 0)
+                gain = _mm_cvtss_f32(gains[c].gain4);
+            for(i = 0;pos+i < rampend;i++)
+            {
+                dst[i] += smp.f[i]*gain;
+                gain += gains[c].step;
+            }
+            if(rampend == Counter)
+                gain = TargetGains[c];
+            CurrentGains[c] = gain;
+            gains[c].gain = gain;
+            gains[c].RampEnd = -1;
+
+            for(;i < todo;i++)
+                dst[i] += smp.f[i]*gain;
+            continue;
+        }
+
+        if(!(fabsf(gains[c].gain) > GAIN_SILENCE_THRESHOLD))
+            continue;
+        if(todo == 4)
+        {
+            __m128 dry4 = _mm_loadu_ps(dst);
+            dry4 = _mm_add_ps(dry4, _mm_mul_ps(smp.v, _mm_set1_ps(gains[c].gain)));
+            _mm_storeu_ps(dst, dry4);
+        }
+        else for(i = 0;i < todo;i++)
+            dst[i] += smp.f[i]*gains[c].gain;
+    }
+}
+
+/* Mixes a mono voice's direct path in one pass, resampling and filtering four
+ * samples at a time before mixing them to each output channel. The results
+ * match the separate resampler, filter, and Mix_SSE.
+ */
+#define DECL_TEMPLATE(Tag, Sampler, O, LowPass)                               \
+void MixFused_##Tag##_SSE(const InterpState *state,                           \
+  const ALfloat *restrict src, ALsizei frac, ALint increment,                 \
+  ALfilterState *lowpass, ALfilterState *highpass,                            \
+  ALfloat *restrict resampled, ALsizei OutChans,                              \
+  ALfloat *const *restrict OutBuffer, ALfloat *CurrentGains,                 \
+  const ALfloat *TargetGains, ALsizei Counter, ALsizei OutPos,                \
+  ALsizei BufferSize)                                                         \
+{                                                                             \
+    FusedGains gains[MAX_OUTPUT_CHANNELS];                                    \
+    const ALfloat b0 = lowpass->b0, b1 = lowpass->b1, b2 = lowpass->b2;       \
+    const ALfloat a1 = lowpass->a1, a2 = lowpass->a2;                         \
+    ALfloat lx0 = lowpass->x[0], lx1 = lowpass->x[1];                         \
+    ALfloat ly0 = lowpass->y[0], ly1 = lowpass->y[1];                         \
+    ALfloat hx0 = highpass->x[0], hx1 = highpass->x[1];                       \
+    ALfloat hy0 = highpass->y[0], hy1 = highpass->y[1];                       \
+    ALsizei pos, i;                                                           \
+                                                                              \
+    InitFusedGains(gains, CurrentGains, TargetGains, OutChans, Counter,       \
+                   BufferSize);                                               \
+                                                                              \
+    src -= O;                                                                 \
+    for(pos = 0;pos < BufferSize;pos += 4)                                    \
+    {                                                                         \
+        const ALsizei todo = mini(BufferSize-pos, 4);                         \
+        union { alignas(16) ALfloat f[4]; __m128 v; } smp;                    \
+                                                                              \
+        smp.v = _mm_setzero_ps();                                             \
+        for(i = 0;i < todo;i++)                                               \
+        {                                                                     \
+            ALfloat s = Sampler(state, src, frac);                            \
+            frac += increment;                                                \
+            src  += frac>>FRACTIONBITS;                                       \
+            frac &= FRACTIONMASK;                                             \
+                                                                              \
+            if(resampled)                                                     \
+                resampled[pos+i] = s;                                         \
+            if(LowPass)                                                       \
+            {                                                                 \
+                const ALfloat y = b0*s + b1*lx0 + b2*lx1 - a1*ly0 - a2*ly1;   \
+                lx1 = lx0; lx0 = s;                                           \
+                ly1 = ly0; ly0 = y;                                           \
+                s = y;                                                        \
+            }                                                                 \
+            else                                                              \
+            {                                                                 \
+                lx1 = lx0; lx0 = s;                                           \
+                ly1 = ly0; ly0 = s;                                           \
+            }                                                                 \
+            hx1 = hx0; hx0 = s;                                               \
+            hy1 = hy0; hy0 = s;                                               \
+            smp.f[i] = s;                                                     \
+        }                                                                     \
+                                                                              \
+        MixFusedGroup(gains, smp.v, pos, todo, OutChans, OutBuffer,           \
+                      CurrentGains, TargetGains, Counter, OutPos);            \
+    }                                                                         \
+                                                                              \
+    lowpass->x[0] = lx0; lowpass->x[1] = lx1;                                 \
+    lowpass->y[0] = ly0; lowpass->y[1] = ly1;                                 \
+    highpass->x[0] = hx0; highpass->x[1] = hx1;                               \
+    highpass->y[0] = hy0; highpass->y[1] = hy1;                               \
+}
+
+DECL_TEMPLATE(point, do_point, 0, 0)
+DECL_TEMPLATE(point_lp, do_point, 0, 1)
+DECL_TEMPLATE(lerp, do_lerp, 0, 0)
+DECL_TEMPLATE(lerp_lp, do_lerp, 0, 1)
+DECL_TEMPLATE(bsinc, do_bsinc, -state->bsinc.l, 0)
+DECL_TEMPLATE(bsinc_lp, do_bsinc, -state->bsinc.l, 1)
+
+#undef DECL_TEMPLATE
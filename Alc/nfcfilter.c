@@ -220,6 +220,13 @@ void NfcFilterAdjust(NfcFilter *nfc, const float w0)
     NfcFilterAdjust3(&nfc->third, w0);
 }
 
+void NfcFilterClear(NfcFilter *nfc)
+{
+    memset(nfc->first.history, 0, sizeof(nfc->first.history));
+    memset(nfc->second.history, 0, sizeof(nfc->second.history));
+    memset(nfc->third.history, 0, sizeof(nfc->third.history));
+}
+
 
 void NfcFilterUpdate1(NfcFilter *nfc, ALfloat *restrict dst, const float *restrict src, const int count)
 {
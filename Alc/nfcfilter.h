@@ -38,6 +38,8 @@ typedef struct NfcFilter {
 
 void NfcFilterCreate(NfcFilter *nfc, const float w0, const float w1);
 void NfcFilterAdjust(NfcFilter *nfc, const float w0);
+/* Clears the filter history, keeping the current coefficients. */
+void NfcFilterClear(NfcFilter *nfc);
 
 /* Near-field control filter for first-order ambisonic channels (1-3). */
 void NfcFilterUpdate1(NfcFilter *nfc, float *restrict dst, const float *restrict src, const int count);
@@ -40,6 +40,7 @@
 extern inline void CalcAngleCoeffs(ALfloat azimuth, ALfloat elevation, ALfloat spread, ALfloat coeffs[MAX_AMBI_COEFFS]);
 extern inline void ComputeDryPanGains(const DryMixParams *dry, const ALfloat coeffs[MAX_AMBI_COEFFS], ALfloat ingain, ALfloat gains[MAX_OUTPUT_CHANNELS]);
 extern inline void ComputeFirstOrderGains(const BFMixParams *foa, const ALfloat mtx[4], ALfloat ingain, ALfloat gains[MAX_OUTPUT_CHANNELS]);
+extern inline void ApplyPanningGains(const PanningParams *pan, ALfloat ingain, ALfloat gains[MAX_OUTPUT_CHANNELS]);
 
 
 static const ALsizei FuMa2ACN[MAX_AMBI_COEFFS] = {
@@ -161,6 +162,82 @@ void CalcAnglePairwiseCoeffs(ALfloat azimuth, ALfloat elevation, ALfloat spread,
 }
 
 
+static void CalcPanningParams(const ALCdevice *device, ALfloat azimuth, ALfloat elevation,
+                              ALfloat spread, PanningParams *pan)
+{
+    if(device->Render_Mode == StereoPair)
+        CalcAnglePairwiseCoeffs(azimuth, elevation, spread, pan->Coeffs);
+    else
+        CalcAngleCoeffs(azimuth, elevation, spread, pan->Coeffs);
+    ComputeDryPanGains(&device->Dry, pan->Coeffs, 1.0f, pan->Gains);
+}
+
+/* Looks up the panning parameters for the quantized angles, calculating them
+ * if they're not in the cache. The results are calculated from the quantized
+ * angles, so they don't depend on which direction filled the entry.
+ */
+static const PanningParams *GetCachedPanning(const ALCdevice *device, ALfloat azimuth,
+                                             ALfloat elevation, ALfloat spread)
+{
+    PanningCache *cache = device->PanCache;
+    PanningCacheEntry *entry;
+    ALint key[3];
+    ALuint hash;
+
+    key[0] = fastf2i(azimuth * cache->Scale);
+    key[1] = fastf2i(elevation * cache->Scale);
+    key[2] = fastf2i(spread * cache->Scale);
+
+    hash = (ALuint)key[0]*73856093u ^ (ALuint)key[1]*19349663u ^ (ALuint)key[2]*83492791u;
+    entry = &cache->Entries[(hash ^ (hash>>16)) & (PANNING_CACHE_SIZE-1)];
+    if(entry->Valid && entry->Key[0] == key[0] && entry->Key[1] == key[1] &&
+       entry->Key[2] == key[2])
+    {
+        cache->Hits++;
+        return &entry->Params;
+    }
+
+    cache->Misses++;
+    entry->Key[0] = key[0];
+    entry->Key[1] = key[1];
+    entry->Key[2] = key[2];
+    entry->Valid = true;
+    CalcPanningParams(device, (ALfloat)key[0] / cache->Scale, (ALfloat)key[1] / cache->Scale,
+                      (ALfloat)key[2] / cache->Scale, &entry->Params);
+    return &entry->Params;
+}
+
+const PanningParams *GetDirectionPanning(const ALCdevice *device, const ALfloat dir[3],
+                                         ALfloat spread, PanningParams *storage)
+{
+    if(device->PanCache)
+        return GetCachedPanning(device, atan2f(dir[0], -dir[2]),
+            asinf(clampf(dir[1], -1.0f, 1.0f)), spread);
+
+    if(device->Render_Mode == StereoPair)
+    {
+        ALfloat ev = asinf(dir[1]);
+        ALfloat az = atan2f(dir[0], -dir[2]);
+        CalcAnglePairwiseCoeffs(az, ev, spread, storage->Coeffs);
+    }
+    else
+        CalcDirectionCoeffs(dir, spread, storage->Coeffs);
+    ComputeDryPanGains(&device->Dry, storage->Coeffs, 1.0f, storage->Gains);
+    return storage;
+}
+
+const PanningParams *GetAnglePanning(const ALCdevice *device, ALfloat azimuth,
+                                     ALfloat elevation, ALfloat spread,
+                                     PanningParams *storage)
+{
+    if(device->PanCache)
+        return GetCachedPanning(device, azimuth, elevation, spread);
+
+    CalcPanningParams(device, azimuth, elevation, spread, storage);
+    return storage;
+}
+
+
 void ComputePanningGainsMC(const ChannelConfig *chancoeffs, ALsizei numchans, ALsizei numcoeffs, const ALfloat coeffs[MAX_AMBI_COEFFS], ALfloat ingain, ALfloat gains[MAX_OUTPUT_CHANNELS])
 {
     ALsizei i, j;
@@ -761,7 +838,8 @@ static void InitHQPanning(ALCdevice *device, const AmbDecConf *conf, const ALsiz
         (conf->ChanMask > 0xf) ? (conf->ChanMask > 0x1ff) ? "third" : "second" : "first",
         (conf->ChanMask&AMBI_PERIPHONIC_MASK) ? " periphonic" : ""
     );
-    bformatdec_reset(device->AmbiDecoder, conf, count, device->Frequency, speakermap);
+    bformatdec_reset(device->AmbiDecoder, conf, count, device->Frequency, device->MixQuantum,
+                     speakermap);
 
     if(!(conf->ChanMask > 0xf))
     {
@@ -809,6 +887,59 @@ static void InitHQPanning(ALCdevice *device, const AmbDecConf *conf, const ALsiz
     InitDistanceComp(device, conf, speakermap);
 }
 
+/* With automatic selection, voices use FFT convolution for HRTF when the
+ * device can play enough sources, and the HRTF's filters are long enough for
+ * it to be clearly faster than direct convolution. With 300 voices, FFT took
+ * 120% of direct's time with 32-sample filters and 67% with 128-sample
+ * filters, reaching 80% at around 88 samples. With few sources, or little to
+ * gain, the extra latency of FFT convolution isn't worth it. The choice is
+ * made for the whole device, since mixing voices with different latencies
+ * would put them out of sync.
+ */
+#define HRTF_FFT_AUTO_VOICES     32
+#define HRTF_FFT_AUTO_MIN_IRSIZE 96
+
+/* When benchmarking, FFT convolution is used if it takes less than this much
+ * of direct convolution's time.
+ */
+#define HRTF_FFT_BENCHMARK_COST  0.8f
+
+static void InitHrtfConvolution(ALCdevice *device)
+{
+    const char *mode = "auto";
+    ALfloat cost;
+
+    ConfigValueStr(alstr_get_cstr(device->DeviceName), NULL, "hrtf-convolution", &mode);
+    if(strcasecmp(mode, "direct") == 0)
+        device->HrtfFFT = AL_FALSE;
+    else if(strcasecmp(mode, "fft") == 0)
+        device->HrtfFFT = AL_TRUE;
+    else if(strcasecmp(mode, "benchmark") == 0)
+    {
+        cost = GetHrtfFFTCost(device->HrtfHandle);
+        TRACE("FFT HRTF convolution takes %.0f%% of the time of direct convolution\n",
+              cost*100.0f);
+        if(cost < HRTF_FFT_BENCHMARK_COST && device->SourcesMax >= HRTF_FFT_AUTO_VOICES)
+            device->HrtfFFT = AL_TRUE;
+    }
+    else
+    {
+        if(strcasecmp(mode, "auto") != 0)
+            ERR("Unexpected hrtf-convolution: %s\n", mode);
+
+        if(device->HrtfHandle->irSize >= HRTF_FFT_AUTO_MIN_IRSIZE &&
+           device->SourcesMax >= HRTF_FFT_AUTO_VOICES)
+            device->HrtfFFT = AL_TRUE;
+    }
+
+    TRACE("Using %s HRTF convolution\n", device->HrtfFFT ? "FFT" : "direct");
+}
+
+/* The number of voices getting their own HRTF filters with hybrid HRTF
+ * rendering, if not otherwise specified.
+ */
+#define HRTF_HYBRID_DEFAULT_VOICES 16
+
 static void InitHrtfPanning(ALCdevice *device)
 {
     /* NOTE: azimuth goes clockwise. */
@@ -954,7 +1085,7 @@ static void InitUhjPanning(ALCdevice *device)
     device->RealOut.NumChannels = ChannelsFromDevFmt(device->FmtChans, device->AmbiOrder);
 }
 
-void aluInitRenderer(ALCdevice *device, ALint hrtf_id, enum HrtfRequestMode hrtf_appreq, enum HrtfRequestMode hrtf_userreq)
+void aluInitRenderer(ALCdevice *device, ALint hrtf_id, enum HrtfRequestMode hrtf_appreq, enum HrtfRequestMode hrtf_userreq, ALCenum hrtf_mode, ALCint hrtf_voices)
 {
     /* Hold the HRTF the device last used, in case it's used again. */
     struct Hrtf *old_hrtf = device->HrtfHandle;
@@ -968,6 +1099,8 @@ void aluInitRenderer(ALCdevice *device, ALint hrtf_id, enum HrtfRequestMode hrtf
     device->HrtfHandle = NULL;
     alstr_clear(&device->HrtfName);
     device->Render_Mode = NormalRender;
+    device->HrtfFFT = AL_FALSE;
+    device->HrtfDirectVoices = 0;
 
     memset(&device->Dry.Ambi, 0, sizeof(device->Dry.Ambi));
     device->Dry.CoeffCount = 0;
@@ -1075,7 +1208,16 @@ void aluInitRenderer(ALCdevice *device, ALint hrtf_id, enum HrtfRequestMode hrtf
                  * higher).
                  */
                 ALfloat scale = (ALfloat)(5000.0 / device->Frequency);
-                FrontStablizer *stablizer = al_calloc(16, sizeof(*stablizer));
+                const size_t stride = RoundUp(device->MixQuantum, 4);
+                FrontStablizer *stablizer = al_calloc(16, RoundUp(sizeof(*stablizer), 16) +
+                                                          4*stride*sizeof(ALfloat));
+                ALfloat *samples = (ALfloat*)((char*)stablizer +
+                                              RoundUp(sizeof(*stablizer), 16));
+
+                stablizer->LSplit[0] = samples;
+                stablizer->LSplit[1] = samples + stride;
+                stablizer->RSplit[0] = samples + 2*stride;
+                stablizer->RSplit[1] = samples + 3*stride;
 
                 bandsplit_init(&stablizer->LFilter, scale);
                 stablizer->RFilter = stablizer->LFilter;
@@ -1141,7 +1283,7 @@ void aluInitRenderer(ALCdevice *device, ALint hrtf_id, enum HrtfRequestMode hrtf
     if(VECTOR_SIZE(device->HrtfList) == 0)
     {
         VECTOR_DEINIT(device->HrtfList);
-        device->HrtfList = EnumerateHrtf(device->DeviceName);
+        device->HrtfList = GetCachedHrtfList(device->DeviceName);
     }
 
     if(hrtf_id >= 0 && (size_t)hrtf_id < VECTOR_SIZE(device->HrtfList))
@@ -1176,22 +1318,41 @@ void aluInitRenderer(ALCdevice *device, ALint hrtf_id, enum HrtfRequestMode hrtf
             Hrtf_DecRef(old_hrtf);
         old_hrtf = NULL;
 
-        device->Render_Mode = HrtfRender;
+        if(hrtf_mode != ALC_HRTF_BASIC_SOFT && hrtf_mode != ALC_HRTF_HYBRID_SOFT)
+        {
+            if(hrtf_mode != ALC_HRTF_FULL_SOFT && hrtf_mode != ALC_DONT_CARE_SOFT)
+                ERR("Unexpected HRTF mode request: 0x%04x\n", hrtf_mode);
+            hrtf_mode = ALC_HRTF_FULL_SOFT;
+        }
         if(ConfigValueStr(alstr_get_cstr(device->DeviceName), NULL, "hrtf-mode", &mode))
         {
             if(strcasecmp(mode, "full") == 0)
-                device->Render_Mode = HrtfRender;
+                hrtf_mode = ALC_HRTF_FULL_SOFT;
             else if(strcasecmp(mode, "basic") == 0)
-                device->Render_Mode = NormalRender;
+                hrtf_mode = ALC_HRTF_BASIC_SOFT;
+            else if(strcasecmp(mode, "hybrid") == 0)
+                hrtf_mode = ALC_HRTF_HYBRID_SOFT;
             else
                 ERR("Unexpected hrtf-mode: %s\n", mode);
         }
 
-        if(device->Render_Mode == HrtfRender)
+        if(hrtf_mode == ALC_HRTF_HYBRID_SOFT)
+        {
+            ALuint voices;
+            if(ConfigValueUInt(alstr_get_cstr(device->DeviceName), NULL, "hrtf-direct-voices",
+                               &voices))
+                hrtf_voices = (ALCint)minu(voices, INT_MAX);
+            else if(hrtf_voices < 0)
+                hrtf_voices = HRTF_HYBRID_DEFAULT_VOICES;
+            device->HrtfDirectVoices = hrtf_voices;
+        }
+
+        if(hrtf_mode == ALC_HRTF_FULL_SOFT)
         {
             /* Don't bother with HOA when using full HRTF rendering. Nothing
              * needs it, and it eases the CPU/memory load.
              */
+            device->Render_Mode = HrtfRender;
             ambiup_free(&device->AmbiUp);
         }
         else
@@ -1199,11 +1360,18 @@ void aluInitRenderer(ALCdevice *device, ALint hrtf_id, enum HrtfRequestMode hrtf
             if(!device->AmbiUp)
                 device->AmbiUp = ambiup_alloc();
         }
+        if(device->Render_Mode == HrtfRender || device->HrtfDirectVoices > 0)
+            InitHrtfConvolution(device);
 
-        TRACE("%s HRTF rendering enabled, using \"%s\"\n",
-            ((device->Render_Mode == HrtfRender) ? "Full" : "Basic"),
-            alstr_get_cstr(device->HrtfName)
-        );
+        if(device->HrtfDirectVoices > 0)
+            TRACE("Hybrid HRTF rendering enabled with %d direct voices, using \"%s\"\n",
+                device->HrtfDirectVoices, alstr_get_cstr(device->HrtfName)
+            );
+        else
+            TRACE("%s HRTF rendering enabled, using \"%s\"\n",
+                ((device->Render_Mode == HrtfRender) ? "Full" : "Basic"),
+                alstr_get_cstr(device->HrtfName)
+            );
         InitHrtfPanning(device);
         return;
     }
@@ -1268,3 +1436,45 @@ void aluInitEffectPanning(ALeffectslot *slot)
     }
     slot->NumChannels = i;
 }
+
+
+void aluFreePanningCache(ALCdevice *device)
+{
+    PanningCache *cache = device->PanCache;
+    ALuint total;
+
+    if(!cache) return;
+    device->PanCache = NULL;
+
+    total = cache->Hits + cache->Misses;
+    if(total > 0)
+        TRACE("Panning cache: %u hits, %u misses (%.1f%% hit rate)\n", cache->Hits,
+              cache->Misses, (double)cache->Hits * 100.0 / (double)total);
+    al_free(cache);
+}
+
+void aluInitPanningCache(ALCdevice *device)
+{
+    ALfloat resolution = 0.0f;
+
+    aluFreePanningCache(device);
+
+    ConfigValueFloat(alstr_get_cstr(device->DeviceName), NULL, "panning-cache-resolution",
+                     &resolution);
+    if(!(resolution > 0.0f))
+    {
+        TRACE("Panning cache disabled\n");
+        return;
+    }
+    /* Limit the resolution so the quantized angles stay small. */
+    resolution = clampf(resolution, 0.01f, 45.0f);
+
+    device->PanCache = al_calloc(16, sizeof(*device->PanCache));
+    if(!device->PanCache)
+    {
+        ERR("Failed to allocate panning cache\n");
+        return;
+    }
+    device->PanCache->Scale = 180.0f / (resolution * F_PI);
+    TRACE("Panning cache resolution: %.2f degrees\n", resolution);
+}
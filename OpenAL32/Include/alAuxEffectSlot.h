@@ -13,38 +13,71 @@ extern "C" {
 
 struct ALeffectStateVtable;
 struct ALeffectslot;
+struct ALfilterState;
+struct ALbuffer;
 
 typedef struct ALeffectState {
     RefCount Ref;
     const struct ALeffectStateVtable *vtbl;
 
-    ALfloat (*OutBuffer)[BUFFERSIZE];
+    ALfloat **OutBuffer;
     ALsizei OutChannels;
+
+    /* The number of samples the effect keeps producing output for after its
+     * input goes silent, set by the update method. The mixer stops processing
+     * a slot without input once this has played out.
+     */
+    ALsizei TailLength;
 } ALeffectState;
 
 void ALeffectState_Construct(ALeffectState *state);
 void ALeffectState_Destruct(ALeffectState *state);
+ALboolean ALeffectState_prepare(ALeffectState *state, const ALCdevice *device, const union ALeffectProps *props);
+ALboolean ALeffectState_setBuffer(ALeffectState *state, const ALCdevice *device, const struct ALbuffer *buffer);
+
+/* An effect's tail is considered played out once its output decays below
+ * this gain (-90dB), relative to the input.
+ */
+#define EFFECT_TAIL_GAIN 0.0000316227766f
+
+/* Converts a tail length in samples to an integer, saturating endless tails. */
+inline ALsizei ClampTailLength(ALfloat samples)
+{
+    if(samples < (ALfloat)INT_MAX)
+        return (samples > 0.0f) ? fastf2i(samples) : 0;
+    return INT_MAX;
+}
+
+/* Calculates the tail length for a feedback loop with the given delay, in
+ * samples, and feedback gain.
+ */
+ALsizei CalcFeedbackTailLength(ALfloat delay, ALfloat feedback);
+
+/* Calculates the tail length for a filter's impulse response. */
+ALsizei CalcFilterTailLength(const struct ALfilterState *filter);
 
 struct ALeffectStateVtable {
     void (*const Destruct)(ALeffectState *state);
 
     ALboolean (*const deviceUpdate)(ALeffectState *state, ALCdevice *device);
+    ALboolean (*const prepare)(ALeffectState *state, const ALCdevice *device, const union ALeffectProps *props);
+    ALboolean (*const setBuffer)(ALeffectState *state, const ALCdevice *device, const struct ALbuffer *buffer);
     void (*const update)(ALeffectState *state, const ALCcontext *context, const struct ALeffectslot *slot, const union ALeffectProps *props);
-    void (*const process)(ALeffectState *state, ALsizei samplesToDo, const ALfloat (*restrict samplesIn)[BUFFERSIZE], ALfloat (*restrict samplesOut)[BUFFERSIZE], ALsizei numChannels);
+    void (*const process)(ALeffectState *state, ALsizei samplesToDo, ALfloat *const *restrict samplesIn, ALfloat *const *restrict samplesOut, ALsizei numChannels);
+
+    size_t (*const getMemorySize)(ALeffectState *state);
 
     void (*const Delete)(void *ptr);
 };
 
-/* Small hack to use a pointer-to-array types as a normal argument type.
- * Shouldn't be used directly.
- */
-typedef ALfloat ALfloatBUFFERSIZE[BUFFERSIZE];
-
 #define DEFINE_ALEFFECTSTATE_VTABLE(T)                                        \
 DECLARE_THUNK(T, ALeffectState, void, Destruct)                               \
 DECLARE_THUNK1(T, ALeffectState, ALboolean, deviceUpdate, ALCdevice*)         \
+DECLARE_THUNK2(T, ALeffectState, ALboolean, prepare, const ALCdevice*, const ALeffectProps*) \
+DECLARE_THUNK2(T, ALeffectState, ALboolean, setBuffer, const ALCdevice*, const struct ALbuffer*) \
 DECLARE_THUNK3(T, ALeffectState, void, update, const ALCcontext*, const ALeffectslot*, const ALeffectProps*) \
-DECLARE_THUNK4(T, ALeffectState, void, process, ALsizei, const ALfloatBUFFERSIZE*restrict, ALfloatBUFFERSIZE*restrict, ALsizei) \
+DECLARE_THUNK4(T, ALeffectState, void, process, ALsizei, ALfloat*const*restrict, ALfloat*const*restrict, ALsizei) \
+DECLARE_THUNK(T, ALeffectState, size_t, getMemorySize)                        \
 static void T##_ALeffectState_Delete(void *ptr)                               \
 { return T##_Delete(STATIC_UPCAST(T, ALeffectState, (ALeffectState*)ptr)); }  \
                                                                               \
@@ -52,9 +85,13 @@ static const struct ALeffectStateVtable T##_ALeffectState_vtable = {          \
     T##_ALeffectState_Destruct,                                               \
                                                                               \
     T##_ALeffectState_deviceUpdate,                                           \
+    T##_ALeffectState_prepare,                                                \
+    T##_ALeffectState_setBuffer,                                              \
     T##_ALeffectState_update,                                                 \
     T##_ALeffectState_process,                                                \
                                                                               \
+    T##_ALeffectState_getMemorySize,                                          \
+                                                                              \
     T##_ALeffectState_Delete,                                                 \
 }
 
@@ -111,6 +148,11 @@ typedef struct ALeffectslot {
         ALeffectState *State;
     } Effect;
 
+    /* Buffer given to the effect state, such as a convolution reverb's
+     * impulse response. The slot holds a reference to it.
+     */
+    struct ALbuffer *Buffer;
+
     ATOMIC_FLAG PropsClean;
 
     RefCount ref;
@@ -133,6 +175,16 @@ typedef struct ALeffectslot {
         ALfloat AirAbsorptionGainHF;
     } Params;
 
+    /* Mixer-side tracking of the slot's input. WetSamples is how much of the
+     * wet buffer voices wrote to since it was last cleared, InputActive is set
+     * when a voice fed the slot in the current mix, and TailRemaining counts
+     * down the effect's tail once the input stops. A slot whose tail has run
+     * out is dormant, and its effect isn't processed.
+     */
+    ALsizei WetSamples;
+    ALboolean InputActive;
+    ALsizei TailRemaining;
+
     /* Self ID */
     ALuint id;
 
@@ -147,12 +199,16 @@ typedef struct ALeffectslot {
      * channel 0 by itself. Effects that want multichannel can process the
      * ambisonics signal and make a B-Format pan (ComputeFirstOrderGains) for
      * first-order device output (FOAOut).
+     * Each channel holds the device's mixing quantum, allocated as one block
+     * starting at WetBuffer[0] and replaced when the device is reset. The
+     * table itself stays in place for the voices to refer to.
      */
-    alignas(16) ALfloat WetBuffer[MAX_EFFECT_CHANNELS][BUFFERSIZE];
+    ALfloat *WetBuffer[MAX_EFFECT_CHANNELS];
 } ALeffectslot;
 
-ALenum InitEffectSlot(ALeffectslot *slot);
+ALenum InitEffectSlot(ALeffectslot *slot, const ALCdevice *device);
 void DeinitEffectSlot(ALeffectslot *slot);
+ALenum ResizeEffectSlotBuffer(ALeffectslot *slot, const ALCdevice *device);
 void UpdateEffectSlotProps(ALeffectslot *slot, ALCcontext *context);
 void UpdateAllEffectSlotProps(ALCcontext *context);
 ALvoid ReleaseALAuxiliaryEffectSlots(ALCcontext *Context);
@@ -168,6 +224,7 @@ EffectStateFactory *EqualizerStateFactory_getFactory(void);
 EffectStateFactory *FlangerStateFactory_getFactory(void);
 EffectStateFactory *ModulatorStateFactory_getFactory(void);
 EffectStateFactory *PshifterStateFactory_getFactory(void);
+EffectStateFactory *ConvolutionStateFactory_getFactory(void);
 
 EffectStateFactory *DedicatedStateFactory_getFactory(void);
 
@@ -95,9 +95,24 @@ typedef struct ALbuffer {
     ATOMIC(ALsizei) UnpackAlign;
     ATOMIC(ALsizei) PackAlign;
 
+    /* Multi-channel samples may be stored planar (each channel is a run of
+     * SampleLen samples) rather than interleaved. Such buffers are mapped
+     * through an interleaved copy.
+     */
+    ALboolean Planar;
+
     ALbitfieldSOFT MappedAccess;
     ALsizei MappedOffset;
     ALsizei MappedSize;
+    ALvoid *MapShim;
+
+    /* Optional float copy of the samples, deinterleaved so each channel is a
+     * contiguous run of SampleLen samples. The mixer reads this instead of
+     * converting the stored samples when it's set. It's only freed while the
+     * buffer isn't attached to any source.
+     */
+    ATOMIC(ALfloat*) FloatData;
+    ALuint FloatLastUse;
 
     /* Number of times buffer was attached to a source (deletion can only occur when 0) */
     RefCount ref;
@@ -106,6 +121,8 @@ typedef struct ALbuffer {
     ALuint id;
 } ALbuffer;
 
+ALboolean CacheBufferFloatData(ALCdevice *device, ALbuffer *buffer);
+
 ALvoid ReleaseALBuffers(ALCdevice *device);
 
 #ifdef __cplusplus
@@ -21,6 +21,7 @@ enum {
     MODULATOR_EFFECT,
     PSHIFTER_EFFECT,
     DEDICATED_EFFECT,
+    CONVOLUTION_EFFECT,
 
     MAX_EFFECTS
 };
@@ -33,7 +34,7 @@ struct EffectList {
     int type;
     ALenum val;
 };
-#define EFFECTLIST_SIZE 12
+#define EFFECTLIST_SIZE 13
 extern const struct EffectList EffectList[EFFECTLIST_SIZE];
 
 
@@ -69,6 +70,7 @@ extern const struct ALeffectVtable ALmodulator_vtable;
 extern const struct ALeffectVtable ALnull_vtable;
 extern const struct ALeffectVtable ALpshifter_vtable;
 extern const struct ALeffectVtable ALdedicated_vtable;
+extern const struct ALeffectVtable ALconvolution_vtable;
 
 
 typedef union ALeffectProps {
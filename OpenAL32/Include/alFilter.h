@@ -45,7 +45,9 @@ typedef struct ALfilterState {
     ALfloat b0, b1, b2; /* Transfer function coefficients "b" */
     ALfloat a1, a2; /* Transfer function coefficients "a" (a0 is pre-applied) */
 } ALfilterState;
-/* Currently only a C-based filter process method is implemented. */
+/* Single filters use the C-based process method. Multiple independent filters
+ * can be processed together with MultiFilterSamples.
+ */
 #define ALfilterState_process ALfilterState_processC
 
 /**
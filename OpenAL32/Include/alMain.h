@@ -163,6 +163,8 @@ struct HrtfEntry;
 struct DirectHrtfState;
 struct FrontStablizer;
 struct Compressor;
+struct PanningCache;
+struct MixThreadPool;
 struct ALCbackend;
 struct ALbuffer;
 struct ALeffect;
@@ -171,6 +173,7 @@ struct ALsource;
 struct ALcontextProps;
 struct ALlistenerProps;
 struct ALvoiceProps;
+struct VoiceRank;
 struct ALeffectslotProps;
 
 
@@ -428,10 +431,21 @@ typedef struct DistanceComp {
 /* Size for temporary storage of buffer data, in ALfloats. Larger values need
  * more memory, while smaller values may need more iterations. The value needs
  * to be a sensible size, however, as it constrains the max stepping value used
- * for mixing, as well as the maximum number of samples per mixing iteration.
+ * for mixing, as well as the number of source samples a voice loads at once.
+ * It's also the default number of samples per mixing iteration.
  */
 #define BUFFERSIZE 2048
 
+/* Smallest and largest number of samples a device can be set to mix per
+ * iteration. The mixing buffers are allocated for the chosen amount when the
+ * device is reset.
+ */
+#define MIN_MIX_QUANTUM 16
+#define MAX_MIX_QUANTUM 16384
+
+/* Number of temp buffers used for mixing a voice. */
+#define NUM_TEMP_BUFFERS 7
+
 typedef struct DryMixParams {
     AmbiConfig Ambi;
     /* Number of coefficients in each Ambi.Coeffs to mix together (4 for first-
@@ -440,7 +454,7 @@ typedef struct DryMixParams {
      */
     ALsizei CoeffCount;
 
-    ALfloat (*Buffer)[BUFFERSIZE];
+    ALfloat **Buffer;
     ALsizei NumChannels;
     ALsizei NumChannelsPerOrder[MAX_AMBI_ORDER+1];
 } DryMixParams;
@@ -450,14 +464,14 @@ typedef struct BFMixParams {
     /* Will only be 4 or 0. */
     ALsizei CoeffCount;
 
-    ALfloat (*Buffer)[BUFFERSIZE];
+    ALfloat **Buffer;
     ALsizei NumChannels;
 } BFMixParams;
 
 typedef struct RealMixParams {
     enum Channel ChannelName[MAX_OUTPUT_CHANNELS];
 
-    ALfloat (*Buffer)[BUFFERSIZE];
+    ALfloat **Buffer;
     ALsizei NumChannels;
 } RealMixParams;
 
@@ -472,6 +486,10 @@ struct ALCdevice_struct {
     ALuint Frequency;
     ALuint UpdateSize;
     ALuint NumUpdates;
+    /* Maximum number of samples mixed per iteration. Each channel of the
+     * mixing and temp buffers holds this many samples.
+     */
+    ALsizei MixQuantum;
     enum DevFmtChannels FmtChans;
     enum DevFmtType     FmtType;
     ALboolean IsHeadphones;
@@ -499,6 +517,17 @@ struct ALCdevice_struct {
     vector_BufferSubList BufferList;
     almtx_t BufferLock;
 
+    /* Memory cap (in bytes) and current usage of the buffers' float copies,
+     * plus the clock used to stamp them for LRU eviction. Protected by
+     * BufferLock.
+     */
+    size_t FloatCacheLimit;
+    size_t FloatCacheSize;
+    ALuint FloatCacheClock;
+
+    /* Store multi-channel buffer samples planar. */
+    ALboolean PlanarBuffers;
+
     // Map of Effects for this device
     vector_EffectSubList EffectList;
     almtx_t EffectLock;
@@ -531,14 +560,28 @@ struct ALCdevice_struct {
     /* Rendering mode. */
     enum RenderMode Render_Mode;
 
+    /* Whether voices use FFT convolution for HRTF instead of direct
+     * convolution. It's the same for every voice, so they all have the same
+     * latency.
+     */
+    ALboolean HrtfFFT;
+
+    /* For hybrid HRTF rendering, the number of voices in each context ranked
+     * high enough to get their own HRTF filters, with the rest mixed to the
+     * ambisonic buffer. 0 when not used.
+     */
+    ALsizei HrtfDirectVoices;
+
     // Device flags
     ALuint Flags;
 
     ALuint64 ClockBase;
     ALuint SamplesDone;
 
-    /* Temp storage used for mixer processing. */
-    alignas(16) ALfloat TempBuffer[4][BUFFERSIZE];
+    /* Temp storage used for mixer processing, allocated with the mixing
+     * buffers. Each is at least BUFFERSIZE samples long.
+     */
+    ALfloat **TempBuffer;
 
     /* The "dry" path corresponds to the main output. */
     DryMixParams Dry;
@@ -555,6 +598,11 @@ struct ALCdevice_struct {
 
     struct Compressor *Limiter;
 
+    /* Panning results for quantized directions, shared by the voices. NULL
+     * if disabled.
+     */
+    struct PanningCache *PanCache;
+
     /* The average speaker distance as determined by the ambdec configuration
      * (or alternatively, by the NFC-HOA reference delay). Only used for NFC.
      */
@@ -574,6 +622,11 @@ struct ALCdevice_struct {
      */
     RefCount MixCount;
 
+    /* Extra threads to mix voices with. NULL if voices are only mixed on the
+     * mixer thread.
+     */
+    struct MixThreadPool *MixThreads;
+
     // Contexts created on this device
     ATOMIC(ALCcontext*) ContextList;
 
@@ -605,6 +658,10 @@ struct ALCdevice_struct {
  * compatibility with pthread_setname_np limitations. */
 #define MIXER_THREAD_NAME "alsoft-mixer"
 
+#define MIXER_WORKER_THREAD_NAME "alsoft-mixwork"
+
+#define CONVOLUTION_THREAD_NAME "alsoft-conv"
+
 #define RECORD_THREAD_NAME "alsoft-record"
 
 
@@ -674,6 +731,12 @@ struct ALCcontext_struct {
     ALsizei VoiceCount;
     ALsizei MaxVoices;
 
+    /* Maximum number of voices to mix at once (0 for no limit), and storage
+     * for ranking the playing voices when there's more than that.
+     */
+    ALsizei MaxRealVoices;
+    struct VoiceRank *VoiceRanks;
+
     ATOMIC(struct ALeffectslotArray*) ActiveAuxSlots;
 
     almtx_t EventThrdLock;
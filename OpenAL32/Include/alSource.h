@@ -57,6 +57,9 @@ typedef struct ALsource {
     ALfloat RoomRolloffFactor;
     ALfloat DopplerFactor;
 
+    /* Scales the source's audibility when choosing which voices to mix. */
+    ALfloat Priority;
+
     /* NOTE: Stereo pan angles are specified in radians, counter-clockwise
      * rather than clockwise.
      */
@@ -109,6 +112,8 @@ typedef struct ALsource {
 } ALsource;
 
 void UpdateAllSourceProps(ALCcontext *context);
+/* Updates the properties of every active source, including unchanged ones. */
+void RefreshAllSourceProps(ALCcontext *context);
 
 ALvoid ReleaseALSources(ALCcontext *Context);
 
@@ -163,11 +163,20 @@ typedef struct DirectParams {
         HrtfParams Old;
         HrtfParams Target;
         HrtfState State;
+        /* The filters referenced by the voice, which cover both the old and
+         * target parameters while the mixer fades between them.
+         */
+        HrtfFilter *Refs[2];
     } Hrtf;
 
     struct {
         ALfloat Current[MAX_OUTPUT_CHANNELS];
         ALfloat Target[MAX_OUTPUT_CHANNELS];
+        /* Bitmasks of the output channels with non-silent gains. ActiveMask
+         * covers the current fade, and becomes TargetMask once it's done.
+         */
+        ALuint ActiveMask;
+        ALuint TargetMask;
     } Gains;
 } DirectParams;
 
@@ -178,6 +187,11 @@ typedef struct SendParams {
     struct {
         ALfloat Current[MAX_OUTPUT_CHANNELS];
         ALfloat Target[MAX_OUTPUT_CHANNELS];
+        /* Bitmasks of the output channels with non-silent gains. ActiveMask
+         * covers the current fade, and becomes TargetMask once it's done.
+         */
+        ALuint ActiveMask;
+        ALuint TargetMask;
     } Gains;
 } SendParams;
 
@@ -214,10 +228,19 @@ struct ALvoiceProps {
     ALfloat RoomRolloffFactor;
     ALfloat DopplerFactor;
 
+    /* Scales the source's audibility when choosing which voices to mix. */
+    ALfloat Priority;
+
     ALfloat StereoPan[2];
 
     ALfloat Radius;
 
+    /* Referenced HRTF filters for each input channel, looked up from the
+     * source and listener properties when the update is made so the mixer
+     * never has to calculate any. NULL when unused.
+     */
+    HrtfFilter *Hrtf[MAX_INPUT_CHANNELS];
+
     /** Direct filter and auxiliary send info. */
     struct {
         ALfloat Gain;
@@ -240,6 +263,20 @@ struct ALvoiceProps {
 #define VOICE_IS_FADING (1<<1) /* Fading sources use gain stepping for smooth transitions. */
 #define VOICE_HAS_HRTF  (1<<2)
 #define VOICE_HAS_NFC   (1<<3)
+/* All target gains are silent. */
+#define VOICE_IS_SILENT  (1<<4)
+/* Mixing is skipped, with only the position being updated. */
+#define VOICE_IS_VIRTUAL (1<<5)
+/* Outranked by other voices, so the target gains are kept silent. */
+#define VOICE_IS_DEMOTED (1<<6)
+/* All parameters need recalculating, regardless of which properties changed. */
+#define VOICE_NEEDS_UPDATE (1<<7)
+/* HRTF mixing uses partitioned FFT convolution instead of direct filtering. */
+#define VOICE_HRTF_FFT (1<<8)
+/* Ranked high enough for its own HRTF filters with hybrid HRTF rendering. */
+#define VOICE_HRTF_DIRECT (1<<9)
+/* Fading out to switch between HRTF filters and the ambisonic mix. */
+#define VOICE_HRTF_SWITCHING (1<<10)
 
 typedef struct ALvoice {
     struct ALvoiceProps *Props;
@@ -276,11 +313,41 @@ typedef struct ALvoice {
     ALint Step;
 
     ResamplerFunc Resampler;
+    enum Resampler ResamplerType;
 
     ALuint Flags;
 
     ALuint Offset; /* Number of output samples mixed since starting. */
 
+    /* Loudest target gain from the last parameter update. */
+    ALfloat Audibility;
+    /* Direct path gain before panning from the last parameter update, which
+     * doesn't depend on how the voice is rendered.
+     */
+    ALfloat DirectGain;
+
+    /* Listener-relative geometry and doppler shift from the last spatial
+     * update, reused when only the gain or pitch properties change.
+     */
+    ALfloat ToListener[3];
+    ALfloat Distance;
+    ALfloat ConeCos;
+    ALfloat DirLength;
+    ALfloat DopplerShift;
+
+    /* Results of the last mix, used to send events and track effect slot
+     * input from the mixer thread.
+     */
+    ALsizei BuffersDone;
+    bool Stopped;
+    bool Mixed;
+
+    /* FFT convolution state for each channel, allocated when the voice first
+     * uses FFT convolution for HRTF.
+     */
+    HrtfFFTState *HrtfFFT;
+    ALsizei NumHrtfFFT;
+
     alignas(16) ALfloat PrevSamples[MAX_INPUT_CHANNELS][MAX_RESAMPLE_PADDING];
 
     InterpState ResampleState;
@@ -289,7 +356,7 @@ typedef struct ALvoice {
         enum ActiveFilters FilterType;
         DirectParams Params[MAX_INPUT_CHANNELS];
 
-        ALfloat (*Buffer)[BUFFERSIZE];
+        ALfloat **Buffer;
         ALsizei Channels;
         ALsizei ChannelsPerOrder[MAX_AMBI_ORDER+1];
     } Direct;
@@ -298,21 +365,98 @@ typedef struct ALvoice {
         enum ActiveFilters FilterType;
         SendParams Params[MAX_INPUT_CHANNELS];
 
-        ALfloat (*Buffer)[BUFFERSIZE];
+        ALfloat **Buffer;
         ALsizei Channels;
     } Send[];
 } ALvoice;
 
+/* Number of spatialized voices gathered for batched parameter updates. */
+#define VOICE_BATCH_SIZE 64
+
+/* Spatialized voices gathered for a parameter update. The source vectors and
+ * the listener-relative results are kept as structure-of-arrays, so the math
+ * for the whole batch can be vectorized across voices instead of being done
+ * one voice at a time. Voices in world space fill the arrays from the front,
+ * and head-relative voices fill them from the back, so each group can be
+ * processed without per-voice branches.
+ */
+typedef struct VoiceBatch {
+    ALvoice *Voice[VOICE_BATCH_SIZE];
+    const ALbuffer *Buffer[VOICE_BATCH_SIZE];
+    ALsizei NumWorld;
+    ALsizei NumRelative;
+
+    /* Source vectors, transformed in place to listener space. */
+    alignas(16) ALfloat PosX[VOICE_BATCH_SIZE];
+    alignas(16) ALfloat PosY[VOICE_BATCH_SIZE];
+    alignas(16) ALfloat PosZ[VOICE_BATCH_SIZE];
+    alignas(16) ALfloat VelX[VOICE_BATCH_SIZE];
+    alignas(16) ALfloat VelY[VOICE_BATCH_SIZE];
+    alignas(16) ALfloat VelZ[VOICE_BATCH_SIZE];
+    alignas(16) ALfloat DirX[VOICE_BATCH_SIZE];
+    alignas(16) ALfloat DirY[VOICE_BATCH_SIZE];
+    alignas(16) ALfloat DirZ[VOICE_BATCH_SIZE];
+
+    /* Normalized source-to-listener vector and distance, the cosine of the
+     * angle between it and the source direction, the length of the source
+     * direction, and the source and listener velocities along it.
+     */
+    alignas(16) ALfloat ToListenerX[VOICE_BATCH_SIZE];
+    alignas(16) ALfloat ToListenerY[VOICE_BATCH_SIZE];
+    alignas(16) ALfloat ToListenerZ[VOICE_BATCH_SIZE];
+    alignas(16) ALfloat Distance[VOICE_BATCH_SIZE];
+    alignas(16) ALfloat ConeCos[VOICE_BATCH_SIZE];
+    alignas(16) ALfloat DirLength[VOICE_BATCH_SIZE];
+    alignas(16) ALfloat SourceVel[VOICE_BATCH_SIZE];
+    alignas(16) ALfloat ListenerVel[VOICE_BATCH_SIZE];
+} VoiceBatch;
+
+typedef struct VoiceRank {
+    ALfloat Score;
+    ALsizei Index;
+} VoiceRank;
+
 void DeinitVoice(ALvoice *voice);
+/* Releases the HRTF filters referenced by the voice. */
+void ReleaseVoiceHrtf(ALvoice *voice);
+/* Sets up a voice's FFT convolution state if the device uses it for HRTF. */
+void InitVoiceHrtfFFT(ALvoice *voice, const ALCdevice *device);
+/* Releases the HRTF filters referenced by a voice property set. */
+void ReleaseVoicePropsHrtf(struct ALvoiceProps *props);
+/* Gets the HRTF filters a voice property update needs for playing the given
+ * buffer, from the context's current listener properties.
+ */
+void CalcVoicePropsHrtf(struct ALvoiceProps *props, const ALbuffer *buffer, ALCcontext *context);
 
 
 typedef void (*MixerFunc)(const ALfloat *data, ALsizei OutChans,
-                          ALfloat (*restrict OutBuffer)[BUFFERSIZE], ALfloat *CurrentGains,
+                          ALfloat *const *restrict OutBuffer, ALfloat *CurrentGains,
                           const ALfloat *TargetGains, ALsizei Counter, ALsizei OutPos,
                           ALsizei BufferSize);
 typedef void (*RowMixerFunc)(ALfloat *OutBuffer, const ALfloat *gains,
-                             const ALfloat (*restrict data)[BUFFERSIZE], ALsizei InChans,
+                             ALfloat *const *restrict data, ALsizei InChans,
                              ALsizei InPos, ALsizei BufferSize);
+/* Resamples, optionally low-pass filters, and mixes a mono voice's direct path
+ * in one pass. The resampled samples are also written to resampled, if not
+ * NULL, for the sends.
+ */
+typedef void (*FusedMixerFunc)(const InterpState *state, const ALfloat *restrict src,
+                               ALsizei frac, ALint increment, ALfilterState *lowpass,
+                               ALfilterState *highpass, ALfloat *restrict resampled,
+                               ALsizei OutChans, ALfloat *const *restrict OutBuffer,
+                               ALfloat *CurrentGains, const ALfloat *TargetGains,
+                               ALsizei Counter, ALsizei OutPos, ALsizei BufferSize);
+/* Applies each filter to its own source samples. A filter's source and
+ * destination may be the same, but different filters' may not overlap.
+ */
+typedef void (*MultiFilterFunc)(ALfilterState *const *filters, ALfloat *const *dst,
+                                const ALfloat *const *src, ALsizei numfilters,
+                                ALsizei numsamples);
+/* Normalizes the listener-space source vectors of the batch's voices from
+ * start to end, and calculates the values derived from them.
+ */
+typedef void (*VoiceBatchFunc)(VoiceBatch *restrict batch, ALsizei start, ALsizei end,
+                               const ALfloat *restrict lvelocity);
 typedef void (*HrtfMixerFunc)(ALfloat *restrict LeftOut, ALfloat *restrict RightOut,
                               const ALfloat *data, ALsizei Offset, ALsizei OutPos,
                               const ALsizei IrSize, MixHrtfParams *hrtfparams,
@@ -322,6 +466,10 @@ typedef void (*HrtfMixerBlendFunc)(ALfloat *restrict LeftOut, ALfloat *restrict
                                    const ALsizei IrSize, const HrtfParams *oldparams,
                                    MixHrtfParams *newparams, HrtfState *hrtfstate,
                                    ALsizei BufferSize);
+typedef void (*HrtfMixerFFTFunc)(ALfloat *restrict LeftOut, ALfloat *restrict RightOut,
+                                 const ALfloat *data, ALsizei OutPos, HrtfFilter *filter,
+                                 ALfloat gain, ALfloat gainstep, HrtfFFTState *state,
+                                 ALsizei BufferSize);
 typedef void (*HrtfDirectMixerFunc)(ALfloat *restrict LeftOut, ALfloat *restrict RightOut,
                                     const ALfloat *data, ALsizei Offset, const ALsizei IrSize,
                                     const ALfloat (*restrict Coeffs)[2],
@@ -418,19 +566,58 @@ void aluInit(void);
 
 void aluInitMixer(void);
 
+/**
+ * Times the direct and FFT convolution mixers with the HRTF's filter length,
+ * returning how long FFT convolution takes relative to direct convolution.
+ */
+ALfloat aluBenchmarkHrtfFFT(struct Hrtf *Hrtf);
+
 ResamplerFunc SelectResampler(enum Resampler resampler);
 
+/* Converts samples of the given type, taken every srcstep from src, to float
+ * and adds them to dst.
+ */
+void LoadFmtSamples(ALfloat *restrict dst, const ALvoid *restrict src, ALint srcstep,
+                    enum FmtType srctype, ALsizei samples);
+
+/* A buffer's float copy keeps MAX_RESAMPLE_PADDING zeroed samples after each
+ * channel, so the mixer can resample up to the end of a channel in place.
+ */
+inline size_t FloatDataStride(const ALbuffer *buffer)
+{ return (size_t)buffer->SampleLen + MAX_RESAMPLE_PADDING; }
+
 /* aluInitRenderer
  *
  * Set up the appropriate panning method and mixing method given the device
  * properties.
  */
-void aluInitRenderer(ALCdevice *device, ALint hrtf_id, enum HrtfRequestMode hrtf_appreq, enum HrtfRequestMode hrtf_userreq);
+void aluInitRenderer(ALCdevice *device, ALint hrtf_id, enum HrtfRequestMode hrtf_appreq, enum HrtfRequestMode hrtf_userreq, ALCenum hrtf_mode, ALCint hrtf_voices);
 
 void aluInitEffectPanning(struct ALeffectslot *slot);
 
 void aluSelectPostProcess(ALCdevice *device);
 
+/* aluAllocBufferLines
+ *
+ * Allocates a table of numlines sample buffers, each holding length samples,
+ * in a single block freed with al_free. The buffers are cleared, and aligned
+ * for SIMD access.
+ */
+ALfloat **aluAllocBufferLines(ALsizei numlines, ALsizei length);
+
+#define MAX_MIX_THREADS 64
+
+/* aluInitMixThreads
+ *
+ * Starts the given number of threads (including the device's mixer thread)
+ * to mix voices with, when a context has at least min_voices playing. The
+ * device's mix buffers must already be allocated. Each worker's buffers are
+ * allocated here, for the device's mixing quantum and effect slot limit, so
+ * mixing never allocates. Any existing threads are stopped first.
+ */
+void aluInitMixThreads(ALCdevice *device, ALsizei num_threads, ALsizei min_voices);
+void aluDeinitMixThreads(ALCdevice *device);
+
 /**
  * CalcDirectionCoeffs
  *
@@ -485,6 +672,78 @@ inline void ComputeDryPanGains(const DryMixParams *dry, const ALfloat coeffs[MAX
         ComputePanningGainsBF(dry->Ambi.Map, dry->NumChannels, coeffs, ingain, gains);
 }
 
+/* Ambisonic coefficients for a direction, and the resulting dry buffer gains
+ * for a unit input gain.
+ */
+typedef struct PanningParams {
+    alignas(16) ALfloat Coeffs[MAX_AMBI_COEFFS];
+    alignas(16) ALfloat Gains[MAX_OUTPUT_CHANNELS];
+} PanningParams;
+
+/* Number of entries in a device's panning cache. Must be a power of 2. */
+#define PANNING_CACHE_SIZE 1024
+
+typedef struct PanningCacheEntry {
+    /* Quantized azimuth, elevation, and spread of the direction. */
+    ALint Key[3];
+    bool Valid;
+
+    PanningParams Params;
+} PanningCacheEntry;
+
+typedef struct PanningCache {
+    /* Quantization steps per radian. */
+    ALfloat Scale;
+
+    /* Lookup statistics, for tuning the quantization. */
+    ALuint Hits;
+    ALuint Misses;
+
+    PanningCacheEntry Entries[PANNING_CACHE_SIZE];
+} PanningCache;
+
+/**
+ * aluInitPanningCache
+ *
+ * (Re)creates the device's panning cache for the current output, according
+ * to the configured resolution. Must be called after the renderer is set up.
+ */
+void aluInitPanningCache(ALCdevice *device);
+void aluFreePanningCache(ALCdevice *device);
+
+/**
+ * GetDirectionPanning
+ *
+ * Gets the panning coefficients and dry gains for a direction vector and
+ * spread, as with CalcDirectionCoeffs and ComputeDryPanGains. If the device
+ * has a panning cache, the direction is quantized and the cached results are
+ * returned. Otherwise, they're calculated into the given storage.
+ */
+const PanningParams *GetDirectionPanning(const ALCdevice *device, const ALfloat dir[3],
+                                         ALfloat spread, PanningParams *storage);
+
+/**
+ * GetAnglePanning
+ *
+ * Gets the panning coefficients and dry gains for an azimuth, elevation, and
+ * spread, as with CalcAngleCoeffs and ComputeDryPanGains.
+ */
+const PanningParams *GetAnglePanning(const ALCdevice *device, ALfloat azimuth,
+                                     ALfloat elevation, ALfloat spread,
+                                     PanningParams *storage);
+
+/**
+ * ApplyPanningGains
+ *
+ * Scales the unit dry gains from the panning parameters by the input gain.
+ */
+inline void ApplyPanningGains(const PanningParams *pan, ALfloat ingain, ALfloat gains[MAX_OUTPUT_CHANNELS])
+{
+    ALsizei i;
+    for(i = 0;i < MAX_OUTPUT_CHANNELS;i++)
+        gains[i] = pan->Gains[i] * ingain;
+}
+
 void ComputeFirstOrderGainsMC(const ChannelConfig *chancoeffs, ALsizei numchans, const ALfloat mtx[4], ALfloat ingain, ALfloat gains[MAX_OUTPUT_CHANNELS]);
 void ComputeFirstOrderGainsBF(const BFChannelConfig *chanmap, ALsizei numchans, const ALfloat mtx[4], ALfloat ingain, ALfloat gains[MAX_OUTPUT_CHANNELS]);
 /**
@@ -503,7 +762,28 @@ inline void ComputeFirstOrderGains(const BFMixParams *foa, const ALfloat mtx[4],
 }
 
 
-ALboolean MixSource(struct ALvoice *voice, ALuint SourceID, ALCcontext *Context, ALsizei SamplesToDo);
+/* Output and scratch buffers for MixSource. The mixer thread uses the
+ * device's own buffers, while mixing worker threads use private copies that
+ * get added into the device's after all voices are mixed.
+ */
+typedef struct VoiceMixBuffers {
+    /* Scratch space for loading, resampling, filtering, and NFC. */
+    ALfloat **TempBuffer;
+
+    /* Stand-in for the device's mix buffer storage (Dry, FOAOut, and RealOut
+     * are allocated together), or NULL to mix into the device directly.
+     */
+    ALfloat **MixBuffer;
+
+    /* Stand-ins for the wet buffers of each active effect slot, with
+     * MAX_EFFECT_CHANNELS channels per slot, or NULL to mix into the effect
+     * slots directly.
+     */
+    const struct ALeffectslotArray *Slots;
+    ALfloat **WetBuffers;
+} VoiceMixBuffers;
+
+ALboolean MixSource(struct ALvoice *voice, ALCcontext *Context, ALsizei SamplesToDo, const VoiceMixBuffers *buffers);
 
 void aluMixData(ALCdevice *device, ALvoid *OutBuffer, ALsizei NumSamples);
 /* Caller must lock the device, and the mixer must not be running. */
@@ -513,6 +793,7 @@ void UpdateContextProps(ALCcontext *context);
 
 extern MixerFunc MixSamples;
 extern RowMixerFunc MixRowSamples;
+extern MultiFilterFunc MultiFilterSamples;
 
 extern ALfloat ConeScale;
 extern ALfloat ZScale;
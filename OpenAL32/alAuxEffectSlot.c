@@ -27,7 +27,9 @@
 #include "AL/alc.h"
 #include "alMain.h"
 #include "alAuxEffectSlot.h"
+#include "alBuffer.h"
 #include "alError.h"
+#include "alFilter.h"
 #include "alListener.h"
 #include "alSource.h"
 
@@ -37,6 +39,7 @@
 
 extern inline void LockEffectSlotList(ALCcontext *context);
 extern inline void UnlockEffectSlotList(ALCcontext *context);
+extern inline ALsizei ClampTailLength(ALfloat samples);
 
 static void AddActiveEffectSlots(const ALuint *slotids, ALsizei count, ALCcontext *context);
 static void RemoveActiveEffectSlots(const ALuint *slotids, ALsizei count, ALCcontext *context);
@@ -56,6 +59,7 @@ static const struct {
     { AL_EFFECT_FLANGER, FlangerStateFactory_getFactory },
     { AL_EFFECT_RING_MODULATOR, ModulatorStateFactory_getFactory },
     { AL_EFFECT_PITCH_SHIFTER, PshifterStateFactory_getFactory},
+    { AL_EFFECT_CONVOLUTION_REVERB_SOFT, ConvolutionStateFactory_getFactory },
     { AL_EFFECT_DEDICATED_DIALOGUE, DedicatedStateFactory_getFactory },
     { AL_EFFECT_DEDICATED_LOW_FREQUENCY_EFFECT, DedicatedStateFactory_getFactory }
 };
@@ -96,6 +100,20 @@ static inline ALeffect *LookupEffect(ALCdevice *device, ALuint id)
     return sublist->Effects + slidx;
 }
 
+static inline ALbuffer *LookupBuffer(ALCdevice *device, ALuint id)
+{
+    BufferSubList *sublist;
+    ALuint lidx = (id-1) >> 6;
+    ALsizei slidx = (id-1) & 0x3f;
+
+    if(UNLIKELY(lidx >= VECTOR_SIZE(device->BufferList)))
+        return NULL;
+    sublist = &VECTOR_ELEM(device->BufferList, lidx);
+    if(UNLIKELY(sublist->FreeMask & (U64(1)<<slidx)))
+        return NULL;
+    return sublist->Buffers + slidx;
+}
+
 
 #define DO_UPDATEPROPS() do {                                                 \
     if(!ATOMIC_LOAD(&context->DeferUpdates, almemory_order_acquire))          \
@@ -144,7 +162,7 @@ AL_API ALvoid AL_APIENTRY alGenAuxiliaryEffectSlots(ALsizei n, ALuint *effectslo
             iter = &VECTOR_BACK(context->EffectSlotList);
         }
         slot = al_calloc(16, sizeof(ALeffectslot));
-        if(!slot || (err=InitEffectSlot(slot)) != AL_NO_ERROR)
+        if(!slot || (err=InitEffectSlot(slot, device)) != AL_NO_ERROR)
         {
             al_free(slot);
             UnlockEffectSlotList(context);
@@ -232,6 +250,7 @@ AL_API ALvoid AL_APIENTRY alAuxiliaryEffectSloti(ALuint effectslot, ALenum param
     ALCcontext *context;
     ALeffectslot *slot;
     ALeffect *effect = NULL;
+    ALbuffer *buffer = NULL;
     ALenum err;
 
     context = GetContextRef();
@@ -267,6 +286,37 @@ AL_API ALvoid AL_APIENTRY alAuxiliaryEffectSloti(ALuint effectslot, ALenum param
         slot->AuxSendAuto = value;
         break;
 
+    case AL_BUFFER:
+        device = context->Device;
+
+        LockBufferList(device);
+        buffer = (value ? LookupBuffer(device, value) : NULL);
+        if(!(value == 0 || buffer != NULL))
+        {
+            UnlockBufferList(device);
+            SETERR_GOTO(context, AL_INVALID_VALUE, done, "Invalid buffer ID %u", value);
+        }
+        if(buffer && buffer->MappedAccess != 0 &&
+           !(buffer->MappedAccess&AL_MAP_PERSISTENT_BIT_SOFT))
+        {
+            UnlockBufferList(device);
+            SETERR_GOTO(context, AL_INVALID_OPERATION, done,
+                        "Setting non-persistently mapped buffer %u", buffer->id);
+        }
+        if(buffer) IncrementRef(&buffer->ref);
+        UnlockBufferList(device);
+
+        if(V(slot->Effect.State,setBuffer)(device, buffer) == AL_FALSE)
+        {
+            if(buffer) DecrementRef(&buffer->ref);
+            SETERR_GOTO(context, AL_OUT_OF_MEMORY, done, "Failed to set effect slot buffer %u",
+                        value);
+        }
+        if(slot->Buffer)
+            DecrementRef(&slot->Buffer->ref);
+        slot->Buffer = buffer;
+        break;
+
     default:
         SETERR_GOTO(context, AL_INVALID_ENUM, done, "Invalid effect slot integer property 0x%04x",
                     param);
@@ -287,6 +337,7 @@ AL_API ALvoid AL_APIENTRY alAuxiliaryEffectSlotiv(ALuint effectslot, ALenum para
     {
     case AL_EFFECTSLOT_EFFECT:
     case AL_EFFECTSLOT_AUXILIARY_SEND_AUTO:
+    case AL_BUFFER:
         alAuxiliaryEffectSloti(effectslot, param, values[0]);
         return;
     }
@@ -387,6 +438,14 @@ AL_API ALvoid AL_APIENTRY alGetAuxiliaryEffectSloti(ALuint effectslot, ALenum pa
         *value = slot->AuxSendAuto;
         break;
 
+    case AL_EFFECTSLOT_MEMORY_SIZE_SOFT:
+        *value = (ALint)minz(V0(slot->Effect.State,getMemorySize)(), INT_MAX);
+        break;
+
+    case AL_BUFFER:
+        *value = slot->Buffer ? slot->Buffer->id : 0;
+        break;
+
     default:
         alSetError(context, AL_INVALID_ENUM, "Invalid effect slot integer property 0x%04x", param);
     }
@@ -404,6 +463,8 @@ AL_API ALvoid AL_APIENTRY alGetAuxiliaryEffectSlotiv(ALuint effectslot, ALenum p
     {
     case AL_EFFECTSLOT_EFFECT:
     case AL_EFFECTSLOT_AUXILIARY_SEND_AUTO:
+    case AL_EFFECTSLOT_MEMORY_SIZE_SOFT:
+    case AL_BUFFER:
         alGetAuxiliaryEffectSloti(effectslot, param, values);
         return;
     }
@@ -516,6 +577,12 @@ ALenum InitializeEffect(ALCcontext *Context, ALeffectslot *EffectSlot, ALeffect
         almtx_unlock(&Device->BackendLock);
         END_MIXER_MODE();
 
+        if(V(State,setBuffer)(Device, EffectSlot->Buffer) == AL_FALSE)
+        {
+            ALeffectState_DecRef(State);
+            return AL_OUT_OF_MEMORY;
+        }
+
         if(!effect)
         {
             EffectSlot->Effect.Type = AL_EFFECT_NULL;
@@ -569,12 +636,59 @@ void ALeffectState_Construct(ALeffectState *state)
 
     state->OutBuffer = NULL;
     state->OutChannels = 0;
+    state->TailLength = 0;
 }
 
 void ALeffectState_Destruct(ALeffectState *UNUSED(state))
 {
 }
 
+ALboolean ALeffectState_prepare(ALeffectState *UNUSED(state), const ALCdevice *UNUSED(device),
+                                const ALeffectProps *UNUSED(props))
+{
+    return AL_TRUE;
+}
+
+ALboolean ALeffectState_setBuffer(ALeffectState *UNUSED(state), const ALCdevice *UNUSED(device),
+                                  const struct ALbuffer *UNUSED(buffer))
+{
+    return AL_TRUE;
+}
+
+
+ALsizei CalcFeedbackTailLength(ALfloat delay, ALfloat feedback)
+{
+    /* Each trip around the loop attenuates the signal by the feedback gain,
+     * until it falls below the tail gain.
+     */
+    feedback = fabsf(feedback);
+    if(!(feedback > EFFECT_TAIL_GAIN))
+        return ClampTailLength(delay);
+    if(feedback >= 1.0f)
+        return INT_MAX;
+    return ClampTailLength(delay * (1.0f + logf(EFFECT_TAIL_GAIN)/logf(feedback)));
+}
+
+ALsizei CalcFilterTailLength(const ALfilterState *filter)
+{
+    ALfloat disc, radius;
+
+    /* The response decays at the rate of the pole with the largest magnitude.
+     * Complex conjugate poles both have a magnitude of sqrt(a2).
+     */
+    disc = filter->a1*filter->a1 - 4.0f*filter->a2;
+    if(disc < 0.0f)
+        radius = sqrtf(filter->a2);
+    else
+        radius = (fabsf(filter->a1) + sqrtf(disc)) * 0.5f;
+
+    if(!(radius > EFFECT_TAIL_GAIN))
+        return 1;
+    if(radius >= 1.0f)
+        return INT_MAX;
+    return ClampTailLength(logf(EFFECT_TAIL_GAIN)/logf(radius) + 1.0f);
+}
+
 
 static void AddActiveEffectSlots(const ALuint *slotids, ALsizei count, ALCcontext *context)
 {
@@ -664,18 +778,30 @@ static void RemoveActiveEffectSlots(const ALuint *slotids, ALsizei count, ALCcon
 }
 
 
-ALenum InitEffectSlot(ALeffectslot *slot)
+ALenum InitEffectSlot(ALeffectslot *slot, const ALCdevice *device)
 {
     EffectStateFactory *factory;
+    ALsizei c;
 
     slot->Effect.Type = AL_EFFECT_NULL;
 
+    for(c = 0;c < MAX_EFFECT_CHANNELS;c++)
+        slot->WetBuffer[c] = NULL;
+    if(ResizeEffectSlotBuffer(slot, device) != AL_NO_ERROR)
+        return AL_OUT_OF_MEMORY;
+
     factory = getFactoryByType(AL_EFFECT_NULL);
     slot->Effect.State = EffectStateFactory_create(factory);
-    if(!slot->Effect.State) return AL_OUT_OF_MEMORY;
+    if(!slot->Effect.State)
+    {
+        al_free(slot->WetBuffer[0]);
+        slot->WetBuffer[0] = NULL;
+        return AL_OUT_OF_MEMORY;
+    }
 
     slot->Gain = 1.0;
     slot->AuxSendAuto = AL_TRUE;
+    slot->Buffer = NULL;
     ATOMIC_FLAG_TEST_AND_SET(&slot->PropsClean, almemory_order_relaxed);
     InitRef(&slot->ref, 0);
 
@@ -692,6 +818,9 @@ ALenum InitEffectSlot(ALeffectslot *slot)
     slot->Params.DecayHFLimit = AL_FALSE;
     slot->Params.AirAbsorptionGainHF = 1.0f;
 
+    slot->InputActive = AL_FALSE;
+    slot->TailRemaining = 0;
+
     return AL_NO_ERROR;
 }
 
@@ -710,6 +839,31 @@ void DeinitEffectSlot(ALeffectslot *slot)
     ALeffectState_DecRef(slot->Effect.State);
     if(slot->Params.EffectState)
         ALeffectState_DecRef(slot->Params.EffectState);
+
+    if(slot->Buffer)
+        DecrementRef(&slot->Buffer->ref);
+    slot->Buffer = NULL;
+
+    al_free(slot->WetBuffer[0]);
+    slot->WetBuffer[0] = NULL;
+}
+
+ALenum ResizeEffectSlotBuffer(ALeffectslot *slot, const ALCdevice *device)
+{
+    const size_t stride = RoundUp(device->MixQuantum, 4);
+    ALfloat *samples;
+    ALsizei c;
+
+    samples = al_calloc(16, MAX_EFFECT_CHANNELS*stride*sizeof(ALfloat));
+    if(!samples) return AL_OUT_OF_MEMORY;
+
+    al_free(slot->WetBuffer[0]);
+    for(c = 0;c < MAX_EFFECT_CHANNELS;c++)
+        slot->WetBuffer[c] = samples + c*stride;
+    /* The new buffer is already silent. */
+    slot->WetSamples = 0;
+
+    return AL_NO_ERROR;
 }
 
 void UpdateEffectSlotProps(ALeffectslot *slot, ALCcontext *context)
@@ -730,6 +884,12 @@ void UpdateEffectSlotProps(ALeffectslot *slot, ALCcontext *context)
                 almemory_order_seq_cst, almemory_order_acquire) == 0);
     }
 
+    /* Let the effect state get anything it needs for the new properties, so
+     * the mixer doesn't have to.
+     */
+    if(V(slot->Effect.State,prepare)(context->Device, &slot->Effect.Props) == AL_FALSE)
+        WARN("Failed to prepare effect state %p for new properties\n", slot->Effect.State);
+
     /* Copy in current property values. */
     props->Gain = slot->Gain;
     props->AuxSendAuto = slot->AuxSendAuto;
@@ -48,6 +48,14 @@ static void LoadData(ALCcontext *context, ALbuffer *buffer, ALuint freq, ALsizei
                      const ALvoid *data, ALbitfieldSOFT access);
 static ALboolean DecomposeUserFormat(ALenum format, enum UserFmtChannels *chans, enum UserFmtType *type);
 static ALsizei SanitizeAlignment(enum UserFmtType type, ALsizei align);
+static void InterleaveSamples(ALvoid *dst, const ALvoid *src, ALsizei samplesize,
+                              ALsizei numchans, ALsizei stride, ALsizei frames);
+static void DeinterleaveSamples(ALvoid *dst, const ALvoid *src, ALsizei samplesize,
+                                ALsizei numchans, ALsizei stride, ALsizei frames);
+static void FillMapShim(ALbuffer *buffer, ALsizei offset, ALsizei length);
+static void FlushMapShim(ALbuffer *buffer, ALsizei offset, ALsizei length);
+static void DropBufferFloatData(ALCdevice *device, ALbuffer *buffer);
+static void UpdateBufferFloatData(ALbuffer *buffer, ALsizei offset, ALsizei length);
 
 static inline ALbuffer *LookupBuffer(ALCdevice *device, ALuint id)
 {
@@ -237,9 +245,18 @@ AL_API void* AL_APIENTRY alMapBufferSOFT(ALuint buffer, ALsizei offset, ALsizei
                          length <= 0 || length > albuf->OriginalSize - offset))
             alSetError(context, AL_INVALID_VALUE, "Mapping invalid range %d+%d for buffer %u",
                        offset, length, buffer);
+        else if(albuf->Planar && !(albuf->MapShim=al_malloc(16, albuf->OriginalSize)))
+            alSetError(context, AL_OUT_OF_MEMORY, "Failed to allocate mapping for buffer %u",
+                       buffer);
         else
         {
-            retval = (ALbyte*)albuf->data + offset;
+            if(albuf->MapShim)
+            {
+                FillMapShim(albuf, offset, length);
+                retval = (ALbyte*)albuf->MapShim + offset;
+            }
+            else
+                retval = (ALbyte*)albuf->data + offset;
             albuf->MappedAccess = access;
             albuf->MappedOffset = offset;
             albuf->MappedSize = length;
@@ -268,6 +285,13 @@ AL_API void AL_APIENTRY alUnmapBufferSOFT(ALuint buffer)
         alSetError(context, AL_INVALID_OPERATION, "Unmapping unmapped buffer %u", buffer);
     else
     {
+        if(albuf->MapShim)
+        {
+            if((albuf->MappedAccess&AL_MAP_WRITE_BIT_SOFT))
+                FlushMapShim(albuf, albuf->MappedOffset, albuf->MappedSize);
+            al_free(albuf->MapShim);
+            albuf->MapShim = NULL;
+        }
         albuf->MappedAccess = 0;
         albuf->MappedOffset = 0;
         albuf->MappedSize = 0;
@@ -305,6 +329,8 @@ AL_API void AL_APIENTRY alFlushMappedBufferSOFT(ALuint buffer, ALsizei offset, A
          * asynchronously. Currently we just say the app shouldn't write where
          * OpenAL's reading, and hope for the best...
          */
+        if(albuf->MapShim)
+            FlushMapShim(albuf, offset, length);
         ATOMIC_THREAD_FENCE(almemory_order_seq_cst);
     }
     UnlockBufferList(device);
@@ -380,16 +406,49 @@ AL_API ALvoid AL_APIENTRY alBufferSubDataSOFT(ALuint buffer, ALenum format, cons
                 offset = offset/byte_align * align * frame_size;
                 length = length/byte_align * align;
 
-                dst = (ALbyte*)albuf->data + offset;
-                if(srctype == UserFmtIMA4 && albuf->FmtType == FmtShort)
-                    Convert_ALshort_ALima4(dst, data, num_chans, length, align);
-                else if(srctype == UserFmtMSADPCM && albuf->FmtType == FmtShort)
-                    Convert_ALshort_ALmsadpcm(dst, data, num_chans, length, align);
+                if(albuf->Planar)
+                {
+                    const ALsizei sample_size = frame_size / num_chans;
+                    const ALvoid *src = data;
+                    ALvoid *temp = NULL;
+
+                    /* ADPCM decodes to interleaved samples, so decode it to a
+                     * temporary before splitting the channels.
+                     */
+                    if(srctype == UserFmtIMA4 || srctype == UserFmtMSADPCM)
+                    {
+                        src = temp = al_malloc(16, (size_t)length*frame_size);
+                        if(UNLIKELY(!temp))
+                            alSetError(context, AL_OUT_OF_MEMORY,
+                                       "Failed to allocate %d bytes for unpacking",
+                                       length*frame_size);
+                        else if(srctype == UserFmtIMA4)
+                            Convert_ALshort_ALima4(temp, data, num_chans, length, align);
+                        else
+                            Convert_ALshort_ALmsadpcm(temp, data, num_chans, length, align);
+                    }
+                    if(src)
+                    {
+                        dst = (ALbyte*)albuf->data + offset/num_chans;
+                        DeinterleaveSamples(dst, src, sample_size, num_chans, albuf->SampleLen,
+                                            length);
+                    }
+                    al_free(temp);
+                }
                 else
                 {
-                    assert((long)srctype == (long)albuf->FmtType);
-                    memcpy(dst, data, length*frame_size);
+                    dst = (ALbyte*)albuf->data + offset;
+                    if(srctype == UserFmtIMA4 && albuf->FmtType == FmtShort)
+                        Convert_ALshort_ALima4(dst, data, num_chans, length, align);
+                    else if(srctype == UserFmtMSADPCM && albuf->FmtType == FmtShort)
+                        Convert_ALshort_ALmsadpcm(dst, data, num_chans, length, align);
+                    else
+                    {
+                        assert((long)srctype == (long)albuf->FmtType);
+                        memcpy(dst, data, length*frame_size);
+                    }
                 }
+                UpdateBufferFloatData(albuf, offset/frame_size, length);
             }
         }
     }
@@ -555,6 +614,18 @@ AL_API void AL_APIENTRY alBufferi(ALuint buffer, ALenum param, ALint value)
             ATOMIC_STORE_SEQ(&albuf->PackAlign, value);
         break;
 
+    case AL_FLOAT_CACHE_SOFT:
+        if(UNLIKELY(!(value == AL_FALSE || value == AL_TRUE)))
+            alSetError(context, AL_INVALID_VALUE, "Invalid float cache value %d", value);
+        else if(value == AL_TRUE)
+            CacheBufferFloatData(device, albuf);
+        else if(UNLIKELY(ReadRef(&albuf->ref) != 0))
+            alSetError(context, AL_INVALID_OPERATION, "Dropping in-use buffer %u's float cache",
+                       buffer);
+        else
+            DropBufferFloatData(device, albuf);
+        break;
+
     default:
         alSetError(context, AL_INVALID_ENUM, "Invalid buffer integer property 0x%04x", param);
     }
@@ -599,6 +670,7 @@ AL_API void AL_APIENTRY alBufferiv(ALuint buffer, ALenum param, const ALint *val
         {
             case AL_UNPACK_BLOCK_ALIGNMENT_SOFT:
             case AL_PACK_BLOCK_ALIGNMENT_SOFT:
+            case AL_FLOAT_CACHE_SOFT:
                 alBufferi(buffer, param, values[0]);
                 return;
         }
@@ -764,6 +836,10 @@ AL_API ALvoid AL_APIENTRY alGetBufferi(ALuint buffer, ALenum param, ALint *value
         *value = ATOMIC_LOAD_SEQ(&albuf->PackAlign);
         break;
 
+    case AL_FLOAT_CACHE_SOFT:
+        *value = ATOMIC_LOAD(&albuf->FloatData, almemory_order_relaxed) ? AL_TRUE : AL_FALSE;
+        break;
+
     default:
         alSetError(context, AL_INVALID_ENUM, "Invalid buffer integer property 0x%04x", param);
     }
@@ -815,6 +891,7 @@ AL_API void AL_APIENTRY alGetBufferiv(ALuint buffer, ALenum param, ALint *values
     case AL_SAMPLE_LENGTH_SOFT:
     case AL_UNPACK_BLOCK_ALIGNMENT_SOFT:
     case AL_PACK_BLOCK_ALIGNMENT_SOFT:
+    case AL_FLOAT_CACHE_SOFT:
         alGetBufferi(buffer, param, values);
         return;
     }
@@ -871,6 +948,8 @@ static void LoadData(ALCcontext *context, ALbuffer *ALBuf, ALuint freq, ALsizei
     enum FmtChannels DstChannels = FmtMono;
     enum FmtType DstType = FmtUByte;
     ALsizei NumChannels, FrameSize;
+    ALvoid *tmpdata = NULL;
+    ALboolean planar;
     ALsizei SrcByteAlign;
     ALsizei unpackalign;
     ALsizei newsize;
@@ -959,10 +1038,13 @@ static void LoadData(ALCcontext *context, ALbuffer *ALBuf, ALuint freq, ALsizei
      */
     NumChannels = ChannelsFromFmt(DstChannels);
     FrameSize = NumChannels * BytesFromFmt(DstType);
-    if(UNLIKELY(frames > INT_MAX/FrameSize))
+    if(UNLIKELY(frames > INT_MAX/FrameSize - MAX_RESAMPLE_PADDING))
         SETERR_RETURN(context, AL_OUT_OF_MEMORY,,
             "Buffer size overflow, %d frames x %d bytes per frame", frames, FrameSize);
-    newsize = frames*FrameSize;
+    /* Keep some zeroed frames after the samples, so the mixer can resample up
+     * to the end of the buffer in place.
+     */
+    newsize = (frames+MAX_RESAMPLE_PADDING) * FrameSize;
 
     /* Round up to the next 16-byte multiple. This could reallocate only when
      * increasing or the new size is less than half the current, but then the
@@ -972,16 +1054,51 @@ static void LoadData(ALCcontext *context, ALbuffer *ALBuf, ALuint freq, ALsizei
      */
     if(LIKELY(newsize <= INT_MAX-15))
         newsize = (newsize+15) & ~0xf;
-    if(newsize != ALBuf->BytesAlloc)
+
+    planar = (NumChannels > 1 && context->Device->PlanarBuffers);
+    if(planar && data != NULL && (SrcType == UserFmtIMA4 || SrcType == UserFmtMSADPCM))
+    {
+        /* ADPCM decodes to interleaved samples, so decode it to a temporary
+         * before splitting the channels.
+         */
+        tmpdata = al_malloc(16, (size_t)frames*FrameSize);
+        if(UNLIKELY(!tmpdata))
+            SETERR_RETURN(context, AL_OUT_OF_MEMORY,, "Failed to allocate %d bytes for unpacking",
+                          frames*FrameSize);
+    }
+
+    /* The float copy no longer matches once the storage changes. */
+    DropBufferFloatData(context->Device, ALBuf);
+
+    /* Planar storage puts each channel at a multiple of the sample length, so
+     * preserving it with a different length needs the channels moved.
+     */
+    if(newsize != ALBuf->BytesAlloc ||
+       (planar && (access&AL_PRESERVE_DATA_BIT_SOFT) && frames != ALBuf->SampleLen))
     {
         void *temp = al_malloc(16, (size_t)newsize);
         if(UNLIKELY(!temp && newsize))
+        {
+            al_free(tmpdata);
             SETERR_RETURN(context, AL_OUT_OF_MEMORY,, "Failed to allocate %d bytes of storage",
                           newsize);
+        }
         if((access&AL_PRESERVE_DATA_BIT_SOFT))
         {
-            ALsizei tocopy = mini(newsize, ALBuf->BytesAlloc);
-            if(tocopy > 0) memcpy(temp, ALBuf->data, tocopy);
+            if(planar)
+            {
+                const ALsizei SampleSize = BytesFromFmt(DstType);
+                ALsizei tocopy = mini(frames, ALBuf->SampleLen) * SampleSize;
+                ALsizei c;
+                for(c = 0;c < NumChannels && tocopy > 0;c++)
+                    memcpy((ALbyte*)temp + c*frames*SampleSize,
+                           (ALbyte*)ALBuf->data + c*ALBuf->SampleLen*SampleSize, tocopy);
+            }
+            else
+            {
+                ALsizei tocopy = mini(newsize, ALBuf->BytesAlloc);
+                if(tocopy > 0) memcpy(temp, ALBuf->data, tocopy);
+            }
         }
         al_free(ALBuf->data);
         ALBuf->data = temp;
@@ -992,23 +1109,40 @@ static void LoadData(ALCcontext *context, ALbuffer *ALBuf, ALuint freq, ALsizei
     {
         assert(DstType == FmtShort);
         if(data != NULL && ALBuf->data != NULL)
-            Convert_ALshort_ALima4(ALBuf->data, data, NumChannels, frames, align);
+            Convert_ALshort_ALima4(tmpdata ? tmpdata : ALBuf->data, data, NumChannels, frames,
+                                   align);
         ALBuf->OriginalAlign = align;
     }
     else if(SrcType == UserFmtMSADPCM)
     {
         assert(DstType == FmtShort);
         if(data != NULL && ALBuf->data != NULL)
-            Convert_ALshort_ALmsadpcm(ALBuf->data, data, NumChannels, frames, align);
+            Convert_ALshort_ALmsadpcm(tmpdata ? tmpdata : ALBuf->data, data, NumChannels, frames,
+                                      align);
         ALBuf->OriginalAlign = align;
     }
     else
     {
         assert((long)SrcType == (long)DstType);
         if(data != NULL && ALBuf->data != NULL)
-            memcpy(ALBuf->data, data, frames*FrameSize);
+        {
+            if(planar)
+                DeinterleaveSamples(ALBuf->data, data, BytesFromFmt(DstType), NumChannels,
+                                    frames, frames);
+            else
+                memcpy(ALBuf->data, data, frames*FrameSize);
+        }
         ALBuf->OriginalAlign = 1;
     }
+    if(tmpdata)
+    {
+        if(ALBuf->data != NULL)
+            DeinterleaveSamples(ALBuf->data, tmpdata, BytesFromFmt(DstType), NumChannels,
+                                frames, frames);
+        al_free(tmpdata);
+    }
+    if(ALBuf->data != NULL)
+        memset((ALbyte*)ALBuf->data + frames*FrameSize, 0, newsize - frames*FrameSize);
     ALBuf->OriginalSize = size;
     ALBuf->OriginalType = SrcType;
 
@@ -1017,6 +1151,7 @@ static void LoadData(ALCcontext *context, ALbuffer *ALBuf, ALuint freq, ALsizei
     ALBuf->FmtType = DstType;
     ALBuf->Access = access;
 
+    ALBuf->Planar = planar;
     ALBuf->SampleLen = frames;
     ALBuf->LoopStart = 0;
     ALBuf->LoopEnd = ALBuf->SampleLen;
@@ -1267,6 +1402,8 @@ static void FreeBuffer(ALCdevice *device, ALbuffer *buffer)
     ALsizei lidx = id >> 6;
     ALsizei slidx = id & 0x3f;
 
+    DropBufferFloatData(device, buffer);
+    al_free(buffer->MapShim);
     al_free(buffer->data);
     memset(buffer, 0, sizeof(*buffer));
 
@@ -1274,6 +1411,255 @@ static void FreeBuffer(ALCdevice *device, ALbuffer *buffer)
 }
 
 
+#define DECL_TEMPLATE(T)                                                      \
+static void Interleave_##T(T *restrict dst, const T *restrict src,            \
+                           ALsizei numchans, ALsizei stride,                  \
+                           ALsizei frames)                                    \
+{                                                                             \
+    ALsizei c, i;                                                             \
+    for(c = 0;c < numchans;c++)                                               \
+    {                                                                         \
+        for(i = 0;i < frames;i++)                                             \
+            dst[i*numchans + c] = src[i];                                     \
+        src += stride;                                                        \
+    }                                                                         \
+}                                                                             \
+                                                                              \
+static void Deinterleave_##T(T *restrict dst, const T *restrict src,          \
+                             ALsizei numchans, ALsizei stride,                \
+                             ALsizei frames)                                  \
+{                                                                             \
+    ALsizei c, i;                                                             \
+    for(c = 0;c < numchans;c++)                                               \
+    {                                                                         \
+        for(i = 0;i < frames;i++)                                             \
+            dst[i] = src[i*numchans + c];                                     \
+        dst += stride;                                                        \
+    }                                                                         \
+}
+
+DECL_TEMPLATE(ALubyte)
+DECL_TEMPLATE(ALshort)
+DECL_TEMPLATE(ALfloat)
+DECL_TEMPLATE(ALdouble)
+
+#undef DECL_TEMPLATE
+
+/* Interleaves frames from planar samples, where src is the first sample of the
+ * first channel and each channel is stride samples apart.
+ */
+static void InterleaveSamples(ALvoid *dst, const ALvoid *src, ALsizei samplesize,
+                              ALsizei numchans, ALsizei stride, ALsizei frames)
+{
+    switch(samplesize)
+    {
+        case 1: Interleave_ALubyte(dst, src, numchans, stride, frames); break;
+        case 2: Interleave_ALshort(dst, src, numchans, stride, frames); break;
+        case 4: Interleave_ALfloat(dst, src, numchans, stride, frames); break;
+        case 8: Interleave_ALdouble(dst, src, numchans, stride, frames); break;
+    }
+}
+
+/* Splits interleaved frames into planar samples, where dst is the first sample
+ * of the first channel and each channel is stride samples apart.
+ */
+static void DeinterleaveSamples(ALvoid *dst, const ALvoid *src, ALsizei samplesize,
+                                ALsizei numchans, ALsizei stride, ALsizei frames)
+{
+    switch(samplesize)
+    {
+        case 1: Deinterleave_ALubyte(dst, src, numchans, stride, frames); break;
+        case 2: Deinterleave_ALshort(dst, src, numchans, stride, frames); break;
+        case 4: Deinterleave_ALfloat(dst, src, numchans, stride, frames); break;
+        case 8: Deinterleave_ALdouble(dst, src, numchans, stride, frames); break;
+    }
+}
+
+/* Copies the sample frames covering the given byte range of a planar buffer
+ * into its interleaved mapping.
+ */
+static void FillMapShim(ALbuffer *buffer, ALsizei offset, ALsizei length)
+{
+    const ALsizei NumChannels = ChannelsFromFmt(buffer->FmtChannels);
+    const ALsizei SampleSize = BytesFromFmt(buffer->FmtType);
+    const ALsizei FrameSize = NumChannels * SampleSize;
+    const ALsizei start = offset / FrameSize;
+    const ALsizei end = (offset+length + FrameSize-1) / FrameSize;
+
+    InterleaveSamples((ALbyte*)buffer->MapShim + start*FrameSize,
+                      (ALbyte*)buffer->data + start*SampleSize, SampleSize, NumChannels,
+                      buffer->SampleLen, end-start);
+}
+
+/* Writes the sample frames covering the given byte range of a planar buffer's
+ * interleaved mapping back to its storage.
+ */
+static void FlushMapShim(ALbuffer *buffer, ALsizei offset, ALsizei length)
+{
+    const ALsizei NumChannels = ChannelsFromFmt(buffer->FmtChannels);
+    const ALsizei SampleSize = BytesFromFmt(buffer->FmtType);
+    const ALsizei FrameSize = NumChannels * SampleSize;
+    const ALsizei start = offset / FrameSize;
+    const ALsizei end = (offset+length + FrameSize-1) / FrameSize;
+
+    DeinterleaveSamples((ALbyte*)buffer->data + start*SampleSize,
+                        (ALbyte*)buffer->MapShim + start*FrameSize, SampleSize, NumChannels,
+                        buffer->SampleLen, end-start);
+}
+
+
+static inline size_t FloatDataSize(const ALbuffer *buffer)
+{
+    return FloatDataStride(buffer) * ChannelsFromFmt(buffer->FmtChannels) * sizeof(ALfloat);
+}
+
+/* Finds the least recently played buffer with a float copy that isn't
+ * attached to any source, so its copy can be dropped.
+ */
+static ALbuffer *FindEvictableBuffer(ALCdevice *device)
+{
+    BufferSubList *sublist = VECTOR_BEGIN(device->BufferList);
+    BufferSubList *subend = VECTOR_END(device->BufferList);
+    ALbuffer *oldest = NULL;
+    ALuint maxage = 0;
+
+    for(;sublist != subend;++sublist)
+    {
+        ALuint64 usemask = ~sublist->FreeMask;
+        while(usemask)
+        {
+            ALsizei idx = CTZ64(usemask);
+            ALbuffer *buffer = sublist->Buffers + idx;
+            usemask &= ~(U64(1) << idx);
+
+            if(ATOMIC_LOAD(&buffer->FloatData, almemory_order_relaxed) != NULL &&
+               ReadRef(&buffer->ref) == 0)
+            {
+                ALuint age = device->FloatCacheClock - buffer->FloatLastUse;
+                if(!oldest || age > maxage)
+                {
+                    oldest = buffer;
+                    maxage = age;
+                }
+            }
+        }
+    }
+    return oldest;
+}
+
+static void DropBufferFloatData(ALCdevice *device, ALbuffer *buffer)
+{
+    ALfloat *fdata = ATOMIC_EXCHANGE_PTR_SEQ(&buffer->FloatData, NULL);
+    if(fdata)
+    {
+        device->FloatCacheSize -= FloatDataSize(buffer);
+        al_free(fdata);
+    }
+}
+
+/* Rewrites the given range of sample frames in a buffer's float copy, after
+ * the stored samples were updated. The copy may be in use by the mixer, so
+ * the samples are converted in chunks and stored with their final values.
+ */
+static void UpdateBufferFloatData(ALbuffer *buffer, ALsizei offset, ALsizei length)
+{
+    ALfloat *fdata = ATOMIC_LOAD(&buffer->FloatData, almemory_order_relaxed);
+    const ALsizei NumChannels = ChannelsFromFmt(buffer->FmtChannels);
+    const ALsizei SampleSize = BytesFromFmt(buffer->FmtType);
+    const ALubyte *data = buffer->data;
+    ALfloat temp[256];
+    ALsizei c, i;
+
+    if(!fdata) return;
+
+    for(c = 0;c < NumChannels;c++)
+    {
+        ALfloat *dst = fdata + c*FloatDataStride(buffer);
+        for(i = 0;i < length;)
+        {
+            ALsizei todo = mini(length-i, COUNTOF(temp));
+            memset(temp, 0, todo*sizeof(ALfloat));
+            if(buffer->Planar)
+                LoadFmtSamples(temp, &data[(c*buffer->SampleLen + offset+i)*SampleSize], 1,
+                               buffer->FmtType, todo);
+            else
+                LoadFmtSamples(temp, &data[((offset+i)*NumChannels + c)*SampleSize],
+                               NumChannels, buffer->FmtType, todo);
+            memcpy(&dst[offset+i], temp, todo*sizeof(ALfloat));
+            i += todo;
+        }
+    }
+    ATOMIC_THREAD_FENCE(almemory_order_seq_cst);
+}
+
+/* CacheBufferFloatData
+ *
+ * Makes sure the buffer has a float copy of its samples, if the device's cache
+ * limit allows it, evicting the least recently played copies as needed. Must
+ * be called with the device's buffer list locked. Returns whether the buffer
+ * has a float copy.
+ */
+ALboolean CacheBufferFloatData(ALCdevice *device, ALbuffer *buffer)
+{
+    ALsizei NumChannels, SampleSize;
+    const ALubyte *data;
+    ALfloat *fdata;
+    size_t size;
+    ALsizei c;
+
+    if(ATOMIC_LOAD(&buffer->FloatData, almemory_order_relaxed) != NULL)
+    {
+        buffer->FloatLastUse = ++device->FloatCacheClock;
+        return AL_TRUE;
+    }
+
+    /* Storage that can be written through a mapping may change without us
+     * knowing, and mono or planar float samples are already what the copy
+     * would hold.
+     */
+    if(!buffer->data || buffer->SampleLen == 0 || (buffer->Access&AL_MAP_WRITE_BIT_SOFT) ||
+       (buffer->FmtType == FmtFloat && (buffer->FmtChannels == FmtMono || buffer->Planar)))
+        return AL_FALSE;
+
+    size = FloatDataSize(buffer);
+    if(size > device->FloatCacheLimit)
+        return AL_FALSE;
+    while(device->FloatCacheLimit-device->FloatCacheSize < size)
+    {
+        ALbuffer *oldest = FindEvictableBuffer(device);
+        if(!oldest) return AL_FALSE;
+        TRACE("Dropping float copy of buffer %u\n", oldest->id);
+        DropBufferFloatData(device, oldest);
+    }
+
+    fdata = al_calloc(16, size);
+    if(!fdata)
+    {
+        WARN("Failed to allocate "SZFMT" bytes for buffer %u's float copy\n", size, buffer->id);
+        return AL_FALSE;
+    }
+
+    NumChannels = ChannelsFromFmt(buffer->FmtChannels);
+    SampleSize = BytesFromFmt(buffer->FmtType);
+    data = buffer->data;
+    for(c = 0;c < NumChannels;c++)
+    {
+        if(buffer->Planar)
+            LoadFmtSamples(fdata + c*FloatDataStride(buffer),
+                           &data[(size_t)c*buffer->SampleLen*SampleSize], 1, buffer->FmtType,
+                           buffer->SampleLen);
+        else
+            LoadFmtSamples(fdata + c*FloatDataStride(buffer), &data[c*SampleSize],
+                           NumChannels, buffer->FmtType, buffer->SampleLen);
+    }
+
+    device->FloatCacheSize += size;
+    buffer->FloatLastUse = ++device->FloatCacheClock;
+    ATOMIC_STORE(&buffer->FloatData, fdata, almemory_order_release);
+    return AL_TRUE;
+}
+
+
 /*
  *    ReleaseALBuffers()
  *
@@ -1292,6 +1678,8 @@ ALvoid ReleaseALBuffers(ALCdevice *device)
             ALsizei idx = CTZ64(usemask);
             ALbuffer *buffer = sublist->Buffers + idx;
 
+            DropBufferFloatData(device, buffer);
+            al_free(buffer->MapShim);
             al_free(buffer->data);
             memset(buffer, 0, sizeof(*buffer));
             ++leftover;
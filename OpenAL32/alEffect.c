@@ -48,6 +48,7 @@ const struct EffectList EffectList[EFFECTLIST_SIZE] = {
     { "pshifter",   PSHIFTER_EFFECT,   AL_EFFECT_PITCH_SHIFTER },
     { "dedicated",  DEDICATED_EFFECT,  AL_EFFECT_DEDICATED_LOW_FREQUENCY_EFFECT },
     { "dedicated",  DEDICATED_EFFECT,  AL_EFFECT_DEDICATED_DIALOGUE },
+    { "convolution", CONVOLUTION_EFFECT, AL_EFFECT_CONVOLUTION_REVERB_SOFT },
 };
 
 ALboolean DisabledEffects[MAX_EFFECTS];
@@ -600,6 +601,9 @@ static void InitEffectParams(ALeffect *effect, ALenum type)
         effect->Props.Dedicated.Gain = 1.0f;
         effect->vtab = &ALdedicated_vtable;
         break;
+    case AL_EFFECT_CONVOLUTION_REVERB_SOFT:
+        effect->vtab = &ALconvolution_vtable;
+        break;
     default:
         effect->vtab = &ALnull_vtable;
         break;
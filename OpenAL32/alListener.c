@@ -26,9 +26,16 @@
 #include "alListener.h"
 #include "alSource.h"
 
+/* Voice HRTF filters are looked up along with the source properties, so the
+ * sources need updating for a listener change too.
+ */
 #define DO_UPDATEPROPS() do {                                                 \
     if(!ATOMIC_LOAD(&context->DeferUpdates, almemory_order_acquire))          \
+    {                                                                         \
         UpdateListenerProps(context);                                         \
+        if(context->Device->HrtfHandle)                                       \
+            RefreshAllSourceProps(context);                                   \
+    }                                                                         \
     else                                                                      \
         ATOMIC_FLAG_CLEAR(&listener->PropsClean, almemory_order_release);     \
 } while(0)
@@ -170,6 +170,9 @@ typedef enum SourceProp {
     /* AL_SOFT_source_spatialize */
     srcSpatialize = AL_SOURCE_SPATIALIZE_SOFT,
 
+    /* AL_SOFT_source_priority */
+    srcPriority = AL_SOURCE_PRIORITY_SOFT,
+
     /* ALC_SOFT_device_clock */
     srcSampleOffsetClockSOFT = AL_SAMPLE_OFFSET_CLOCK_SOFT,
     srcSecOffsetClockSOFT = AL_SEC_OFFSET_CLOCK_SOFT,
@@ -276,6 +279,7 @@ static ALint FloatValsByProp(ALenum prop)
         case AL_CONE_OUTER_GAINHF:
         case AL_AIR_ABSORPTION_FACTOR:
         case AL_ROOM_ROLLOFF_FACTOR:
+        case AL_SOURCE_PRIORITY_SOFT:
         case AL_DIRECT_FILTER_GAINHF_AUTO:
         case AL_AUXILIARY_SEND_FILTER_GAIN_AUTO:
         case AL_AUXILIARY_SEND_FILTER_GAINHF_AUTO:
@@ -340,6 +344,7 @@ static ALint DoubleValsByProp(ALenum prop)
         case AL_CONE_OUTER_GAINHF:
         case AL_AIR_ABSORPTION_FACTOR:
         case AL_ROOM_ROLLOFF_FACTOR:
+        case AL_SOURCE_PRIORITY_SOFT:
         case AL_DIRECT_FILTER_GAINHF_AUTO:
         case AL_AUXILIARY_SEND_FILTER_GAIN_AUTO:
         case AL_AUXILIARY_SEND_FILTER_GAINHF_AUTO:
@@ -403,6 +408,7 @@ static ALint IntValsByProp(ALenum prop)
         case AL_CONE_OUTER_GAINHF:
         case AL_AIR_ABSORPTION_FACTOR:
         case AL_ROOM_ROLLOFF_FACTOR:
+        case AL_SOURCE_PRIORITY_SOFT:
         case AL_DIRECT_FILTER_GAINHF_AUTO:
         case AL_AUXILIARY_SEND_FILTER_GAIN_AUTO:
         case AL_AUXILIARY_SEND_FILTER_GAINHF_AUTO:
@@ -464,6 +470,7 @@ static ALint Int64ValsByProp(ALenum prop)
         case AL_CONE_OUTER_GAINHF:
         case AL_AIR_ABSORPTION_FACTOR:
         case AL_ROOM_ROLLOFF_FACTOR:
+        case AL_SOURCE_PRIORITY_SOFT:
         case AL_DIRECT_FILTER_GAINHF_AUTO:
         case AL_AUXILIARY_SEND_FILTER_GAIN_AUTO:
         case AL_AUXILIARY_SEND_FILTER_GAINHF_AUTO:
@@ -626,6 +633,13 @@ static ALboolean SetSourcefv(ALsource *Source, ALCcontext *Context, SourceProp p
             DO_UPDATEPROPS();
             return AL_TRUE;
 
+        case AL_SOURCE_PRIORITY_SOFT:
+            CHECKVAL(*values >= 0.0f && isfinite(*values));
+
+            Source->Priority = *values;
+            DO_UPDATEPROPS();
+            return AL_TRUE;
+
         case AL_DOPPLER_FACTOR:
             CHECKVAL(*values >= 0.0f && *values <= 1.0f);
 
@@ -1065,6 +1079,7 @@ static ALboolean SetSourceiv(ALsource *Source, ALCcontext *Context, SourceProp p
         case AL_CONE_OUTER_GAINHF:
         case AL_AIR_ABSORPTION_FACTOR:
         case AL_ROOM_ROLLOFF_FACTOR:
+        case AL_SOURCE_PRIORITY_SOFT:
         case AL_SOURCE_RADIUS:
             fvals[0] = (ALfloat)*values;
             return SetSourcefv(Source, Context, (int)prop, fvals);
@@ -1170,6 +1185,7 @@ static ALboolean SetSourcei64v(ALsource *Source, ALCcontext *Context, SourceProp
         case AL_CONE_OUTER_GAINHF:
         case AL_AIR_ABSORPTION_FACTOR:
         case AL_ROOM_ROLLOFF_FACTOR:
+        case AL_SOURCE_PRIORITY_SOFT:
         case AL_SOURCE_RADIUS:
             fvals[0] = (ALfloat)*values;
             return SetSourcefv(Source, Context, (int)prop, fvals);
@@ -1271,6 +1287,10 @@ static ALboolean GetSourcedv(ALsource *Source, ALCcontext *Context, SourceProp p
             *values = Source->AirAbsorptionFactor;
             return AL_TRUE;
 
+        case AL_SOURCE_PRIORITY_SOFT:
+            *values = Source->Priority;
+            return AL_TRUE;
+
         case AL_ROOM_ROLLOFF_FACTOR:
             *values = Source->RoomRolloffFactor;
             return AL_TRUE;
@@ -1491,6 +1511,7 @@ static ALboolean GetSourceiv(ALsource *Source, ALCcontext *Context, SourceProp p
         case AL_DOPPLER_FACTOR:
         case AL_AIR_ABSORPTION_FACTOR:
         case AL_ROOM_ROLLOFF_FACTOR:
+        case AL_SOURCE_PRIORITY_SOFT:
         case AL_CONE_OUTER_GAINHF:
         case AL_SOURCE_RADIUS:
             if((err=GetSourcedv(Source, Context, prop, dvals)) != AL_FALSE)
@@ -1595,6 +1616,7 @@ static ALboolean GetSourcei64v(ALsource *Source, ALCcontext *Context, SourceProp
         case AL_DOPPLER_FACTOR:
         case AL_AIR_ABSORPTION_FACTOR:
         case AL_ROOM_ROLLOFF_FACTOR:
+        case AL_SOURCE_PRIORITY_SOFT:
         case AL_CONE_OUTER_GAINHF:
         case AL_SOURCE_RADIUS:
             if((err=GetSourcedv(Source, Context, prop, dvals)) != AL_FALSE)
@@ -2389,6 +2411,33 @@ AL_API ALvoid AL_APIENTRY alSourcePlayv(ALsizei n, const ALuint *sources)
     }
 
     device = context->Device;
+    if(device->FloatCacheLimit > 0)
+    {
+        /* Make float copies of the queued buffers before locking the device,
+         * so the conversion doesn't hold up the mixer. Streamed buffers are
+         * normally refilled after playing once, so buffers queued later are
+         * left alone.
+         */
+        LockBufferList(device);
+        for(i = 0;i < n;i++)
+        {
+            ALbufferlistitem *BufferList;
+
+            source = LookupSource(context, sources[i]);
+            BufferList = source->queue;
+            while(BufferList)
+            {
+                for(j = 0;j < BufferList->num_buffers;j++)
+                {
+                    ALbuffer *buffer = BufferList->buffers[j];
+                    if(buffer) CacheBufferFloatData(device, buffer);
+                }
+                BufferList = ATOMIC_LOAD(&BufferList->next, almemory_order_relaxed);
+            }
+        }
+        UnlockBufferList(device);
+    }
+
     ALCdevice_Lock(device);
     /* If the device is disconnected, go right to stopped. */
     if(!ATOMIC_LOAD(&device->Connected, almemory_order_acquire))
@@ -2532,8 +2581,10 @@ AL_API ALvoid AL_APIENTRY alSourcePlayv(ALsizei n, const ALuint *sources)
          */
         voice->Step = 0;
 
-        voice->Flags = start_fading ? VOICE_IS_FADING : 0;
+        voice->Flags = VOICE_NEEDS_UPDATE | (start_fading ? VOICE_IS_FADING : 0);
         if(source->SourceType == AL_STATIC) voice->Flags |= VOICE_IS_STATIC;
+        ReleaseVoiceHrtf(voice);
+        InitVoiceHrtfFFT(voice, device);
         memset(voice->Direct.Params, 0, sizeof(voice->Direct.Params[0])*voice->NumChannels);
         for(s = 0;s < device->NumAuxSends;s++)
             memset(voice->Send[s].Params, 0, sizeof(voice->Send[s].Params[0])*voice->NumChannels);
@@ -2957,6 +3008,7 @@ static void InitSourceParams(ALsource *Source, ALsizei num_sends)
     Source->WetGainAuto = AL_TRUE;
     Source->WetGainHFAuto = AL_TRUE;
     Source->AirAbsorptionFactor = 0.0f;
+    Source->Priority = 1.0f;
     Source->RoomRolloffFactor = 0.0f;
     Source->DopplerFactor = 1.0f;
     Source->HeadRelative = AL_FALSE;
@@ -3036,6 +3088,7 @@ static void DeinitSource(ALsource *source, ALsizei num_sends)
 
 static void UpdateSourceProps(ALsource *source, ALvoice *voice, ALsizei num_sends, ALCcontext *context)
 {
+    ALbufferlistitem *BufferList;
     struct ALvoiceProps *props;
     ALsizei i;
 
@@ -3087,6 +3140,7 @@ static void UpdateSourceProps(ALsource *source, ALvoice *voice, ALsizei num_send
     props->OuterGainHF = source->OuterGainHF;
 
     props->AirAbsorptionFactor = source->AirAbsorptionFactor;
+    props->Priority = source->Priority;
     props->RoomRolloffFactor = source->RoomRolloffFactor;
     props->DopplerFactor = source->DopplerFactor;
 
@@ -3111,6 +3165,17 @@ static void UpdateSourceProps(ALsource *source, ALvoice *voice, ALsizei num_send
         props->Send[i].LFReference = source->Send[i].LFReference;
     }
 
+    /* Get the HRTF filters here, rather than in the mixer. Every buffer in
+     * the queue has the same format, so the first one is enough.
+     */
+    BufferList = source->queue;
+    while(BufferList && !(BufferList->num_buffers >= 1 && BufferList->buffers[0]))
+        BufferList = ATOMIC_LOAD(&BufferList->next, almemory_order_relaxed);
+    if(BufferList)
+        CalcVoicePropsHrtf(props, BufferList->buffers[0], context);
+    else
+        ReleaseVoicePropsHrtf(props);
+
     /* Set the new container for updating internal parameters. */
     props = ATOMIC_EXCHANGE_PTR(&voice->Update, props, almemory_order_acq_rel);
     if(props)
@@ -3136,6 +3201,25 @@ void UpdateAllSourceProps(ALCcontext *context)
     }
 }
 
+void RefreshAllSourceProps(ALCcontext *context)
+{
+    ALsizei num_sends = context->Device->NumAuxSends;
+    ALsizei pos;
+
+    LockSourceList(context);
+    for(pos = 0;pos < context->VoiceCount;pos++)
+    {
+        ALvoice *voice = context->Voices[pos];
+        ALsource *source = ATOMIC_LOAD(&voice->Source, almemory_order_acquire);
+        if(source)
+        {
+            ATOMIC_FLAG_TEST_AND_SET(&source->PropsClean, almemory_order_acq_rel);
+            UpdateSourceProps(source, voice, num_sends, context);
+        }
+    }
+    UnlockSourceList(context);
+}
+
 
 /* GetSourceSampleOffset
  *
@@ -0,0 +1,323 @@
+/*
+ * OpenAL Mixing Quantum Benchmark
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/* This file contains a benchmark that renders a busy scene through a loopback
+ * device as fast as possible, once for each of a set of mixing quantums, and
+ * reports how long each took. Intended to compare the cache-friendliness of
+ * small quantums against the lower per-iteration overhead of large ones for
+ * offline rendering.
+ *
+ * The mix-quantum config option is only read once per process, so each
+ * quantum is measured by re-running this program with an ALSOFT_CONF file
+ * that sets it. The rest of the user's configuration still applies.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <math.h>
+
+#include "AL/al.h"
+#include "AL/alc.h"
+#include "AL/alext.h"
+#include "AL/efx.h"
+
+#include "threads.h"
+
+#ifndef M_PI
+#define M_PI    (3.14159265358979323846)
+#endif
+
+#define BENCH_CONF_NAME "almixbench.conf"
+
+
+static LPALCLOOPBACKOPENDEVICESOFT alcLoopbackOpenDeviceSOFT;
+static LPALCRENDERSAMPLESSOFT alcRenderSamplesSOFT;
+
+static LPALGENEFFECTS alGenEffects;
+static LPALDELETEEFFECTS alDeleteEffects;
+static LPALEFFECTI alEffecti;
+static LPALGENAUXILIARYEFFECTSLOTS alGenAuxiliaryEffectSlots;
+static LPALDELETEAUXILIARYEFFECTSLOTS alDeleteAuxiliaryEffectSlots;
+static LPALAUXILIARYEFFECTSLOTI alAuxiliaryEffectSloti;
+
+
+static inline ALuint dither_rng(ALuint *seed)
+{
+    *seed = (*seed * 96314165) + 907633515;
+    return *seed;
+}
+
+/* Creates a one-second buffer of a tone mixed with some noise, so sources
+ * don't all produce the same signal.
+ */
+static ALuint CreateBuffer(ALuint srate, ALuint freq, ALuint seed)
+{
+    ALfloat *data;
+    ALuint buffer;
+    ALuint i;
+
+    data = calloc(srate, sizeof(ALfloat));
+    for(i = 0;i < srate;i++)
+    {
+        ALuint rng0 = dither_rng(&seed);
+        ALuint rng1 = dither_rng(&seed);
+        data[i] = (ALfloat)(sin(i*2.0*M_PI*freq / srate)*0.5 +
+                            (rng0*(1.0/UINT_MAX) - rng1*(1.0/UINT_MAX))*0.25);
+    }
+
+    buffer = 0;
+    alGenBuffers(1, &buffer);
+    alBufferData(buffer, AL_FORMAT_MONO_FLOAT32, data, srate*sizeof(ALfloat), srate);
+    free(data);
+
+    return buffer;
+}
+
+
+/* Renders the scene with the current configuration, and returns the time it
+ * took in seconds, or a negative value on error.
+ */
+static double RunBenchmark(ALsizei num_sources, ALsizei seconds, ALsizei block_size)
+{
+    const ALCint srate = 48000;
+    ALCint attrs[] = {
+        ALC_FORMAT_CHANNELS_SOFT, ALC_STEREO_SOFT,
+        ALC_FORMAT_TYPE_SOFT, ALC_FLOAT_SOFT,
+        ALC_FREQUENCY, srate,
+        ALC_HRTF_SOFT, ALC_FALSE,
+        0
+    };
+    struct timespec start, end;
+    ALuint buffers[4], effect, slot;
+    ALCcontext *context;
+    ALCdevice *device;
+    ALuint *sources;
+    ALfloat *samples;
+    ALsizei total, done;
+    ALsizei i;
+
+    device = alcLoopbackOpenDeviceSOFT(NULL);
+    if(!device)
+    {
+        fprintf(stderr, "Failed to open loopback device\n");
+        return -1.0;
+    }
+    context = alcCreateContext(device, attrs);
+    if(!context || alcMakeContextCurrent(context) == ALC_FALSE)
+    {
+        fprintf(stderr, "Failed to set up loopback context\n");
+        if(context)
+            alcDestroyContext(context);
+        alcCloseDevice(device);
+        return -1.0;
+    }
+
+#define LOAD_PROC(x)  ((x) = alGetProcAddress(#x))
+    LOAD_PROC(alGenEffects);
+    LOAD_PROC(alDeleteEffects);
+    LOAD_PROC(alEffecti);
+    LOAD_PROC(alGenAuxiliaryEffectSlots);
+    LOAD_PROC(alDeleteAuxiliaryEffectSlots);
+    LOAD_PROC(alAuxiliaryEffectSloti);
+#undef LOAD_PROC
+
+    for(i = 0;i < 4;i++)
+        buffers[i] = CreateBuffer(22050 + i*8000, 220 << i, 22222 + i);
+
+    alGenEffects(1, &effect);
+    alEffecti(effect, AL_EFFECT_TYPE, AL_EFFECT_EAXREVERB);
+    alGenAuxiliaryEffectSlots(1, &slot);
+    alAuxiliaryEffectSloti(slot, AL_EFFECTSLOT_EFFECT, (ALint)effect);
+
+    /* Spread the sources around the listener, with varying pitches so they
+     * need resampling, and send every other one to the reverb.
+     */
+    sources = calloc(num_sources, sizeof(ALuint));
+    alGenSources(num_sources, sources);
+    for(i = 0;i < num_sources;i++)
+    {
+        ALfloat angle = (ALfloat)(i*2.0*M_PI / num_sources);
+        alSourcei(sources[i], AL_BUFFER, (ALint)buffers[i&3]);
+        alSourcei(sources[i], AL_LOOPING, AL_TRUE);
+        alSourcef(sources[i], AL_PITCH, 0.75f + (ALfloat)(i%11)*0.05f);
+        alSource3f(sources[i], AL_POSITION, sinf(angle)*(1.0f + (ALfloat)(i%5)), 0.0f,
+                   -cosf(angle)*(1.0f + (ALfloat)(i%5)));
+        if(!(i&1))
+            alSource3i(sources[i], AL_AUXILIARY_SEND_FILTER, (ALint)slot, 0, AL_FILTER_NULL);
+    }
+    alSourcePlayv(num_sources, sources);
+    if(alGetError() != AL_NO_ERROR)
+        fprintf(stderr, "Failed to set up the scene, results may be inaccurate\n");
+
+    samples = calloc((size_t)block_size*2, sizeof(ALfloat));
+    total = seconds * srate;
+
+    altimespec_get(&start, AL_TIME_UTC);
+    for(done = 0;done < total;done += block_size)
+        alcRenderSamplesSOFT(device, samples, (ALCsizei)block_size);
+    altimespec_get(&end, AL_TIME_UTC);
+
+    free(samples);
+
+    alDeleteSources(num_sources, sources);
+    free(sources);
+    alDeleteAuxiliaryEffectSlots(1, &slot);
+    alDeleteEffects(1, &effect);
+    alDeleteBuffers(4, buffers);
+
+    alcMakeContextCurrent(NULL);
+    alcDestroyContext(context);
+    alcCloseDevice(device);
+
+    return (double)(end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec)/1000000000.0;
+}
+
+
+/* Runs this program again to measure the given quantum, using a config file
+ * that sets it.
+ */
+static int RunQuantum(const char *appname, int quantum, ALsizei num_sources, ALsizei seconds,
+                      ALsizei block_size)
+{
+    char cmd[1024];
+    FILE *conf;
+    int ret;
+
+    conf = fopen(BENCH_CONF_NAME, "w");
+    if(!conf)
+    {
+        fprintf(stderr, "Failed to create %s\n", BENCH_CONF_NAME);
+        return 1;
+    }
+    fprintf(conf, "mix-quantum = %d\n", quantum);
+    fclose(conf);
+
+#ifdef _WIN32
+    _putenv_s("ALSOFT_CONF", BENCH_CONF_NAME);
+#else
+    setenv("ALSOFT_CONF", BENCH_CONF_NAME, 1);
+#endif
+
+    snprintf(cmd, sizeof(cmd), "\"%s\" --run %d %d %d %d", appname, quantum, num_sources,
+             seconds, block_size);
+    fflush(stdout);
+    ret = system(cmd);
+
+    remove(BENCH_CONF_NAME);
+    return ret;
+}
+
+
+int main(int argc, char *argv[])
+{
+    static const int default_quantums[] = { 64, 256, 1024, 2048, 4096, 8192, 16384 };
+    const char *appname = argv[0];
+    const char *quantums = NULL;
+    ALsizei num_sources = 128;
+    ALsizei block_size = 16384;
+    ALsizei seconds = 30;
+    int i;
+
+    alcLoopbackOpenDeviceSOFT = alcGetProcAddress(NULL, "alcLoopbackOpenDeviceSOFT");
+    alcRenderSamplesSOFT = alcGetProcAddress(NULL, "alcRenderSamplesSOFT");
+    if(!alcLoopbackOpenDeviceSOFT || !alcRenderSamplesSOFT)
+    {
+        fprintf(stderr, "Required ALC_SOFT_loopback extension not supported!\n");
+        return 1;
+    }
+
+    /* Internal mode to measure the current config's quantum. */
+    if(argc == 6 && strcmp(argv[1], "--run") == 0)
+    {
+        double secs = RunBenchmark(atoi(argv[3]), atoi(argv[4]), atoi(argv[5]));
+        if(secs < 0.0) return 1;
+        printf("%6s: %7.3f seconds, %6.1fx realtime\n", argv[2], secs, atoi(argv[4])/secs);
+        return 0;
+    }
+
+    for(i = 1;i < argc;i++)
+    {
+        if(strcmp(argv[i], "-h") == 0 || strcmp(argv[i], "--help") == 0)
+        {
+            fprintf(stderr, "OpenAL Mixing Quantum Benchmark\n"
+"\n"
+"Usage: %s <options>\n"
+"\n"
+"Available options:\n"
+"  --help/-h                 This help text\n"
+"  -q <list>                 Comma-separated quantums to measure (default\n"
+"                                64,256,1024,2048,4096,8192,16384)\n"
+"  -n <count>                Number of playing sources (default 128)\n"
+"  -t <seconds>              Seconds of audio to render (default 30)\n"
+"  -b <samples>              Samples rendered per call (default 16384)\n",
+                appname
+            );
+            return 1;
+        }
+        else if(i+1 < argc && strcmp(argv[i], "-q") == 0)
+            quantums = argv[++i];
+        else if(i+1 < argc && strcmp(argv[i], "-n") == 0)
+            num_sources = atoi(argv[++i]);
+        else if(i+1 < argc && strcmp(argv[i], "-t") == 0)
+            seconds = atoi(argv[++i]);
+        else if(i+1 < argc && strcmp(argv[i], "-b") == 0)
+            block_size = atoi(argv[++i]);
+        else
+            fprintf(stderr, "Unhandled option: %s\n", argv[i]);
+    }
+    if(num_sources < 1) num_sources = 1;
+    if(seconds < 1) seconds = 1;
+    if(block_size < 1) block_size = 1;
+
+    printf("Rendering %d seconds of %d sources, %d samples per call...\n", seconds, num_sources,
+           block_size);
+    if(!quantums)
+    {
+        for(i = 0;i < (int)(sizeof(default_quantums)/sizeof(default_quantums[0]));i++)
+        {
+            if(RunQuantum(appname, default_quantums[i], num_sources, seconds, block_size) != 0)
+                return 1;
+        }
+    }
+    else
+    {
+        const char *next = quantums;
+        while(*next)
+        {
+            char *end;
+            long quantum = strtol(next, &end, 10);
+            if(end == next || quantum <= 0)
+            {
+                fprintf(stderr, "Invalid quantum list: %s\n", quantums);
+                return 1;
+            }
+            if(RunQuantum(appname, (int)quantum, num_sources, seconds, block_size) != 0)
+                return 1;
+            next = end;
+            if(*next == ',') next++;
+        }
+    }
+
+    return 0;
+}
@@ -218,6 +218,11 @@ typedef unsigned __int64 uint64_t;
 // response protocol 02.
 #define MHR_FORMAT                   ("MinPHR02")
 
+// The OpenAL Soft native HRTF format marker, for data sets stored in the
+// machine's byte order and float layout so they can be used in place.
+#define MHR_NATIVE_FORMAT            ("MinPHRN0")
+#define MHR_NATIVE_BYTE_ORDER_MARK   (0x01020304u)
+
 // Sample and channel type enum values.
 typedef enum SampleTypeT {
     ST_S16 = 0,
@@ -2039,6 +2044,130 @@ static int StoreMhr(const HrirDataT *hData, const char *filename)
 }
 
 
+// Write a native value of the given size to a file.
+static int WriteNative(const void *in, const size_t size, FILE *fp, const char *filename)
+{
+    if(fwrite(in, 1, size, fp) != size)
+    {
+        fprintf(stderr, "Error: Bad write to file '%s'.\n", filename);
+        return 0;
+    }
+    return 1;
+}
+
+// Pad the file with zeros up to a multiple of the given alignment.
+static int WritePadding(const uint align, FILE *fp, const char *filename)
+{
+    static const uint8 zeros[16];
+    long pos = ftell(fp);
+
+    if(pos < 0)
+    {
+        fprintf(stderr, "Error: Bad write to file '%s'.\n", filename);
+        return 0;
+    }
+    return WriteNative(zeros, (align - (pos%align)) % align, fp, filename);
+}
+
+// Store the OpenAL Soft HRTF data set in the native format.  Mono data sets
+// have their responses mirrored to the right ear, since the native format
+// always holds both.
+static int StoreNativeMhr(const HrirDataT *hData, const char *filename)
+{
+    const HrirFdT *field = &hData->mFds[0];
+    uint32 header[5];
+    uint n = hData->mIrPoints;
+    float distance;
+    FILE *fp;
+    uint ei, ai, ti, i;
+
+    if(hData->mFdCount != 1)
+    {
+        fprintf(stderr, "Error: The native format only supports a single field.\n");
+        return 0;
+    }
+    if((fp=fopen(filename, "wb")) == NULL)
+    {
+        fprintf(stderr, "Error: Could not open MHR file '%s'.\n", filename);
+        return 0;
+    }
+    header[0] = MHR_NATIVE_BYTE_ORDER_MARK;
+    header[1] = hData->mIrRate;
+    header[2] = n;
+    header[3] = field->mIrCount;
+    header[4] = field->mEvCount;
+    distance = (float)field->mDistance;
+    if(!WriteAscii(MHR_NATIVE_FORMAT, fp, filename))
+        goto error;
+    if(!WriteNative(header, sizeof(header), fp, filename) ||
+       !WriteNative(&distance, sizeof(distance), fp, filename))
+        goto error;
+    for(ei = 0;ei < field->mEvCount;ei++)
+    {
+        uint8 azCount = (uint8)field->mEvs[ei].mAzCount;
+        if(!WriteNative(&azCount, 1, fp, filename))
+            goto error;
+    }
+    if(!WritePadding(2, fp, filename))
+        goto error;
+    for(ei = 0, i = 0;ei < field->mEvCount;ei++)
+    {
+        uint16_t evOffset = (uint16_t)i;
+        if(!WriteNative(&evOffset, sizeof(evOffset), fp, filename))
+            goto error;
+        i += field->mEvs[ei].mAzCount;
+    }
+    if(!WritePadding(16, fp, filename))
+        goto error;
+
+    for(ei = 0;ei < field->mEvCount;ei++)
+    {
+        const HrirEvT *evd = &field->mEvs[ei];
+        for(ai = 0;ai < evd->mAzCount;ai++)
+        {
+            const HrirAzT *azs[2] = { &evd->mAzs[ai], &evd->mAzs[ai] };
+            float out[2 * MAX_TRUNCSIZE];
+
+            if(hData->mChannelType != CT_STEREO)
+                azs[1] = &evd->mAzs[(evd->mAzCount-ai) % evd->mAzCount];
+            for(ti = 0;ti < 2;ti++)
+            {
+                const double *ir = azs[ti]->mIrs[(hData->mChannelType == CT_STEREO) ? ti : 0];
+                for(i = 0;i < n;i++)
+                    out[i*2 + ti] = (float)ir[i];
+            }
+            if(!WriteNative(out, sizeof(out[0])*2*n, fp, filename))
+                goto error;
+        }
+    }
+    for(ei = 0;ei < field->mEvCount;ei++)
+    {
+        const HrirEvT *evd = &field->mEvs[ei];
+        for(ai = 0;ai < evd->mAzCount;ai++)
+        {
+            const HrirAzT *azs[2] = { &evd->mAzs[ai], &evd->mAzs[ai] };
+            uint8 delays[2];
+
+            if(hData->mChannelType != CT_STEREO)
+                azs[1] = &evd->mAzs[(evd->mAzCount-ai) % evd->mAzCount];
+            for(ti = 0;ti < 2;ti++)
+            {
+                double delay = azs[ti]->mDelays[(hData->mChannelType == CT_STEREO) ? ti : 0];
+                delays[ti] = (uint8)fmin(round(hData->mIrRate * delay), MAX_HRTD);
+            }
+            if(!WriteNative(delays, sizeof(delays), fp, filename))
+                goto error;
+        }
+    }
+    fclose(fp);
+    return 1;
+
+error:
+    fclose(fp);
+    return 0;
+}
+
+
 /***********************
  *** HRTF processing ***
  ***********************/
@@ -3221,7 +3350,7 @@ error:
  * resulting data set as desired.  If the input name is NULL it will read
  * from standard input.
  */
-static int ProcessDefinition(const char *inName, const uint outRate, const uint fftSize, const int equalize, const int surface, const double limit, const uint truncSize, const HeadModelT model, const double radius, const char *outName)
+static int ProcessDefinition(const char *inName, const uint outRate, const uint fftSize, const int equalize, const int surface, const double limit, const uint truncSize, const HeadModelT model, const double radius, const int native, const char *outName)
 {
     char rateStr[8+1], expName[MAX_PATH_LEN];
     TokenReaderT tr;
@@ -3293,7 +3422,10 @@ static int ProcessDefinition(const char *inName, const uint outRate, const uint
     snprintf(rateStr, 8, "%u", hData.mIrRate);
     StrSubst(outName, "%r", rateStr, MAX_PATH_LEN, expName);
     fprintf(stdout, "Creating MHR data set %s...\n", expName);
-    ret = StoreMhr(&hData, expName);
+    if(native)
+        ret = StoreNativeMhr(&hData, expName);
+    else
+        ret = StoreMhr(&hData, expName);
 
     FreeHrirData(&hData);
     return ret;
@@ -3316,6 +3448,9 @@ static void PrintHelp(const char *argv0, FILE *ofile)
     fprintf(ofile, " -d {dataset|    Specify the model used for calculating the head-delay timing\n");
     fprintf(ofile, "     sphere}     values (default: %s).\n", ((DEFAULT_HEAD_MODEL == HM_DATASET) ? "dataset" : "sphere"));
     fprintf(ofile, " -c <size>       Use a customized head radius measured ear-to-ear in meters.\n");
+    fprintf(ofile, " -n              Store the data set in the native format, which OpenAL Soft\n");
+    fprintf(ofile, "                 can use in place without conversion. The file is specific\n");
+    fprintf(ofile, "                 to the byte order of this machine.\n");
     fprintf(ofile, " -i <filename>   Specify an HRIR definition file to use (defaults to stdin).\n");
     fprintf(ofile, " -o <filename>   Specify an output file. Use of '%%r' will be substituted with\n");
     fprintf(ofile, "                 the data set sample rate.\n");
@@ -3332,6 +3467,7 @@ int main(int argc, char *argv[])
     uint truncSize;
     double radius;
     double limit;
+    int native;
     int opt;
 
     GET_UNICODE_ARGS(&argc, &argv);
@@ -3352,8 +3488,9 @@ int main(int argc, char *argv[])
     truncSize = DEFAULT_TRUNCSIZE;
     model = DEFAULT_HEAD_MODEL;
     radius = DEFAULT_CUSTOM_RADIUS;
+    native = 0;
 
-    while((opt=getopt(argc, argv, "mr:f:e:s:l:w:d:c:e:i:o:h")) != -1)
+    while((opt=getopt(argc, argv, "mr:f:e:s:l:w:d:c:e:ni:o:h")) != -1)
     {
         switch(opt)
         {
@@ -3447,6 +3584,10 @@ int main(int argc, char *argv[])
             }
             break;
 
+        case 'n':
+            native = 1;
+            break;
+
         case 'i':
             inName = optarg;
             break;
@@ -3466,7 +3607,7 @@ int main(int argc, char *argv[])
     }
 
     if(!ProcessDefinition(inName, outRate, fftSize, equalize, surface, limit,
-                          truncSize, model, radius, outName))
+                          truncSize, model, radius, native, outName))
         return -1;
     fprintf(stdout, "Operation completed.\n");
 